@@ -0,0 +1,107 @@
+#include "AdmissionControl.h"
+
+// Rate (tokens/s) and burst per route class. WRITE allows dragging a slider
+// in the web UI / app (about 6-7 requests per second) without throttling.
+// SYNC has its own bucket so a sync session (8 exchanges, 4/s) is never cut
+// short by writes from the same client, which would skew the offset.
+const TokenBucketConfig AdmissionControl::BUCKETS[ROUTE_CLASS_COUNT] = {
+  {10, 20},  // ROUTE_CLASS_LIGHT
+  {8, 16},   // ROUTE_CLASS_WRITE
+  {1, 4},    // ROUTE_CLASS_HEAVY
+  {10, 20}   // ROUTE_CLASS_SYNC
+};
+
+AdmissionControl::AdmissionControl() {
+  for (uint8_t i = 0; i < ADMISSION_MAX_CLIENTS; i++) {
+    clients[i].ip = 0;
+    clients[i].lastSeen = 0;
+  }
+  heavyInFlight = 0;
+}
+
+AdmissionControl::Client& AdmissionControl::findClient(uint32_t ip, uint32_t now) {
+  Client* oldest = &clients[0];
+
+  for (uint8_t i = 0; i < ADMISSION_MAX_CLIENTS; i++) {
+    if (clients[i].ip == ip) {
+      return clients[i];
+    }
+    if (clients[i].ip == 0) {
+      oldest = &clients[i];
+      break;
+    }
+    if ((int32_t)(clients[i].lastSeen - oldest->lastSeen) < 0) {
+      oldest = &clients[i];
+    }
+  }
+
+  // Slot baru (atau client paling lama tidak aktif): mulai dengan bucket penuh
+  oldest->ip = ip;
+  oldest->lastSeen = now;
+  for (uint8_t c = 0; c < ROUTE_CLASS_COUNT; c++) {
+    oldest->milliTokens[c] = BUCKETS[c].burst * 1000UL;
+  }
+  return *oldest;
+}
+
+void AdmissionControl::refill(Client& client, uint32_t now) {
+  uint32_t elapsed = now - client.lastSeen;
+  client.lastSeen = now;
+  if (elapsed == 0) {
+    return;
+  }
+
+  for (uint8_t c = 0; c < ROUTE_CLASS_COUNT; c++) {
+    uint32_t capacity = BUCKETS[c].burst * 1000UL;
+    // ms * token/s = milli-token; batasi elapsed agar tidak overflow
+    uint32_t added = (elapsed > capacity ? capacity : elapsed) * BUCKETS[c].ratePerSecond;
+    client.milliTokens[c] = (client.milliTokens[c] + added > capacity) ? capacity : client.milliTokens[c] + added;
+  }
+}
+
+AdmissionResult AdmissionControl::admit(uint32_t ip, RouteClass routeClass, size_t bodySize, uint32_t now,
+                                        uint32_t freeHeap, uint32_t largestBlock, uint32_t& retryAfter) {
+  retryAfter = 1;
+
+  // Heap dulu: tolak sebelum body atau dokumen JSON dialokasikan
+  if (freeHeap < ADMISSION_HEAP_CRITICAL) {
+    return ADMISSION_LOW_MEMORY;
+  }
+  if (routeClass != ROUTE_CLASS_LIGHT) {
+    uint32_t block = bodySize + (routeClass == ROUTE_CLASS_HEAVY ? ADMISSION_HEAVY_BLOCK : ADMISSION_WRITE_BLOCK);
+    if (freeHeap < ADMISSION_HEAP_MIN_FREE || largestBlock < block) {
+      return ADMISSION_LOW_MEMORY;
+    }
+  }
+
+  if (routeClass == ROUTE_CLASS_HEAVY && heavyInFlight >= ADMISSION_MAX_HEAVY_IN_FLIGHT) {
+    return ADMISSION_BUSY;
+  }
+
+  Client& client = findClient(ip, now);
+  refill(client, now);
+
+  uint32_t& tokens = client.milliTokens[routeClass];
+  if (tokens < 1000) {
+    // Detik sampai satu token tersedia, dibulatkan ke atas
+    uint32_t rate = BUCKETS[routeClass].ratePerSecond;
+    uint32_t waitMs = (1000 - tokens + rate - 1) / rate;
+    retryAfter = (waitMs + 999) / 1000;
+    if (retryAfter == 0) {
+      retryAfter = 1;
+    }
+    return ADMISSION_RATE_LIMITED;
+  }
+
+  tokens -= 1000;
+  if (routeClass == ROUTE_CLASS_HEAVY) {
+    heavyInFlight++;
+  }
+  return ADMISSION_OK;
+}
+
+void AdmissionControl::release(RouteClass routeClass) {
+  if (routeClass == ROUTE_CLASS_HEAVY && heavyInFlight > 0) {
+    heavyInFlight--;
+  }
+}
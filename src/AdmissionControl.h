@@ -0,0 +1,74 @@
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Client slots with their own token buckets (softAP allows 4 stations)
+#define ADMISSION_MAX_CLIENTS        8
+
+// Heavy requests (multi-KB JSON documents) being processed at the same time
+#define ADMISSION_MAX_HEAVY_IN_FLIGHT 2
+
+// Heap watermarks: below these, requests are shed before anything is allocated
+#define ADMISSION_HEAP_MIN_FREE      32768  // Shed write and heavy requests
+#define ADMISSION_HEAP_CRITICAL      16384  // Shed everything
+
+// Contiguous block a request needs on top of its body (JSON document + response)
+#define ADMISSION_WRITE_BLOCK        1024
+#define ADMISSION_HEAVY_BLOCK        8192
+
+// Cost classes of API routes
+enum RouteClass : uint8_t {
+  ROUTE_CLASS_LIGHT,  // Small GETs, static assets
+  ROUTE_CLASS_WRITE,  // Small command bodies (manual, mode, time, one hour)
+  ROUTE_CLASS_HEAVY,  // Full schedule, patch, batch
+  ROUTE_CLASS_SYNC,   // /api/time/sync: bursts of exchanges, never queued
+  ROUTE_CLASS_COUNT
+};
+
+enum AdmissionResult : uint8_t {
+  ADMISSION_OK,
+  ADMISSION_RATE_LIMITED,  // 429 - this client exceeded its bucket
+  ADMISSION_BUSY,          // 503 - too many heavy requests in flight
+  ADMISSION_LOW_MEMORY     // 503 - heap below watermark
+};
+
+struct TokenBucketConfig {
+  uint16_t ratePerSecond;
+  uint16_t burst;
+};
+
+// Token buckets per client IP and route class, plus a global cap on heavy
+// requests and a heap watermark guard. Not thread-safe: all calls come from
+// the AsyncTCP task (canHandle / onDisconnect).
+class AdmissionControl {
+private:
+  struct Client {
+    uint32_t ip;         // 0 = free slot
+    uint32_t lastSeen;   // millis() of the last request
+    uint32_t milliTokens[ROUTE_CLASS_COUNT];
+  };
+
+  Client clients[ADMISSION_MAX_CLIENTS];
+  uint8_t heavyInFlight;
+
+  Client& findClient(uint32_t ip, uint32_t now);
+  void refill(Client& client, uint32_t now);
+
+public:
+  static const TokenBucketConfig BUCKETS[ROUTE_CLASS_COUNT];
+
+  AdmissionControl();
+
+  // Decide whether to process a request. On ADMISSION_OK a token is consumed
+  // and heavy requests take an in-flight slot that must be released with
+  // release(). retryAfter is set (in seconds) for rejections.
+  AdmissionResult admit(uint32_t ip, RouteClass routeClass, size_t bodySize, uint32_t now,
+                        uint32_t freeHeap, uint32_t largestBlock, uint32_t& retryAfter);
+  void release(RouteClass routeClass);
+
+  uint8_t getHeavyInFlight() { return heavyInFlight; }
+};
+
+#endif // ADMISSION_CONTROL_H
@@ -0,0 +1,539 @@
+#include "ApiRequests.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <Arduino.h>
+
+// Nama channel di JSON, urutan sama dengan LedChannel
+static const char* const CHANNEL_NAMES[LED_CHANNEL_COUNT] = {
+  "royalBlue", "blue", "uv", "violet", "red", "green", "white"
+};
+
+// Dokumen bersama untuk handler jadwal, patch dan batch. Semua handler berjalan di
+// task AsyncTCP (satu per satu), jadi satu dokumen statis cukup dan tidak ada
+// alokasi heap multi-KB per request.
+static StaticJsonDocument<REQUEST_JSON_CAPACITY> requestDoc;
+
+JsonDocument& apiRequestDocument() {
+  return requestDoc;
+}
+
+// deserializeJson() dengan pencatatan waktu parse ke metrics.
+// Body request bisa ditulis (milik ApiRequestContext), jadi parse dilakukan in-place
+// (zero-copy): string di dokumen menunjuk ke body, bukan disalin ke pool dokumen.
+static DeserializationError parseJson(JsonDocument& doc, uint8_t* data, size_t len) {
+  TRACE_SCOPE("json", "deserializeJson");
+  uint32_t start = micros();
+  DeserializationError error = deserializeJson(doc, (char*)data, len);
+  metrics.jsonParse.observe(micros() - start);
+  return error;
+}
+
+// {"status":"error","message":"<prefix><detail>"}
+static bool failJson(ApiError& error, const char* prefix, const char* detail = "") {
+  error.status = 400;
+  error.contentType = "application/json";
+  snprintf(error.body, sizeof(error.body), "{\"status\":\"error\",\"message\":\"%s%s\"}", prefix, detail);
+  return false;
+}
+
+// Teks polos "JSON parsing failed: ..." (format lama /api/manual dan /api/mode)
+static bool failParseText(ApiError& error, DeserializationError parseError) {
+  error.status = 400;
+  error.contentType = "text/plain";
+  snprintf(error.body, sizeof(error.body), "JSON parsing failed: %s", parseError.c_str());
+  return false;
+}
+
+static int channelFromName(const char* name) {
+  if (name == nullptr) return -1;
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    if (strcmp(name, CHANNEL_NAMES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+// Baca 7 channel dari object JSON (key yang tidak ada = 0). Nilai yang bukan integer
+// 0-255 ditolak, bukan dipotong ke uint8_t; badChannel = nama channel yang salah
+static bool readProfile(JsonObjectConst obj, LightProfile& profile, const char*& badChannel) {
+  uint8_t* channels = (uint8_t*)&profile;
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    JsonVariantConst value = obj[CHANNEL_NAMES[i]];
+    if (value.isNull()) {
+      channels[i] = 0;
+      continue;
+    }
+    if (!value.is<int>() || value.as<int>() < 0 || value.as<int>() > 255) {
+      badChannel = CHANNEL_NAMES[i];
+      return false;
+    }
+    channels[i] = value.as<int>();
+  }
+  return true;
+}
+
+// {"status":"error","message":"...","<key>":<position>,"channel":"<channel>"}; key boleh nullptr
+static bool failChannel(ApiError& error, const char* channel, const char* key = nullptr, int position = 0) {
+  error.status = 400;
+  error.contentType = "application/json";
+  if (key != nullptr) {
+    snprintf(error.body, sizeof(error.body),
+             "{\"status\":\"error\",\"message\":\"Channel value must be an integer 0-255\",\"%s\":%d,\"channel\":\"%s\"}",
+             key, position, channel);
+  } else {
+    snprintf(error.body, sizeof(error.body),
+             "{\"status\":\"error\",\"message\":\"Channel value must be an integer 0-255\",\"channel\":\"%s\"}",
+             channel);
+  }
+  return false;
+}
+
+static int modeFromName(const char* name) {
+  if (name == nullptr) return -1;
+  if (strcmp(name, "auto") == 0) return MODE_AUTO;
+  if (strcmp(name, "manual") == 0) return MODE_MANUAL;
+  if (strcmp(name, "off") == 0) return MODE_OFF;
+  return -1;
+}
+
+// Baca dan validasi waktu {year, month, day, hour, minute, second}
+static bool readTime(JsonObjectConst obj, CommandTime& time) {
+  if (!obj.containsKey("year") || !obj.containsKey("month") || !obj.containsKey("day") ||
+      !obj.containsKey("hour") || !obj.containsKey("minute") || !obj.containsKey("second")) {
+    return false;
+  }
+
+  int year = obj["year"].as<int>();
+  int month = obj["month"].as<int>();
+  int day = obj["day"].as<int>();
+  int hour = obj["hour"].as<int>();
+  int minute = obj["minute"].as<int>();
+  int second = obj["second"].as<int>();
+
+  if (year < 2000 || year > 2100 || month < 1 || month > 12 || day < 1 || day > 31 ||
+      hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+    return false;
+  }
+
+  time.year = year;
+  time.month = month;
+  time.day = day;
+  time.hour = hour;
+  time.minute = minute;
+  time.second = second;
+  return true;
+}
+
+bool parseManualRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  StaticJsonDocument<256> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  // Check for parsing errors
+  if (parseError) {
+    Serial.print("JSON parsing failed: ");
+    Serial.println(parseError.c_str());
+    return failParseText(error, parseError);
+  }
+
+  // Get LED name
+  if (!doc.containsKey("led")) {
+    Serial.println("Error: Missing 'led' property");
+    return failJson(error, "Missing 'led' property");
+  }
+
+  // Get value
+  if (!doc.containsKey("value")) {
+    Serial.println("Error: Missing 'value' property");
+    return failJson(error, "Missing 'value' property");
+  }
+
+  int value = doc["value"].as<int>();
+
+  // Check for valid value range
+  if (!doc["value"].is<int>() || value < 0 || value > 255) {
+    Serial.println("Error: Value out of range (0-255)");
+    return failJson(error, "Value out of range (0-255)");
+  }
+
+  int channel = channelFromName(doc["led"].as<const char*>());
+  if (channel < 0) {
+    return failJson(error, "Invalid LED type");
+  }
+
+  // Mode manual diaktifkan otomatis oleh lighting loop saat command diterapkan
+  command.type = CMD_SET_CHANNEL;
+  command.channel.channel = channel;
+  command.channel.value = value;
+  return true;
+}
+
+bool parseManualAllRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  // Validasi JSON sebelum memproses
+  StaticJsonDocument<512> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  // Check for parsing errors
+  if (parseError) {
+    Serial.print("JSON parsing failed: ");
+    Serial.println(parseError.c_str());
+    return failJson(error, "JSON parsing failed: ", parseError.c_str());
+  }
+
+  // Jika aplikasi mengirimkan data dengan format yang berbeda (misalnya dengan wrapper),
+  // ambil nilai LED dari wrapper tersebut
+  JsonObjectConst source = doc.as<JsonObject>();
+  static const char* const wrappers[] = {"intensities", "values", "data", "leds"};
+  for (const char* wrapper : wrappers) {
+    if (doc[wrapper].is<JsonObject>()) {
+      Serial.print("Detected wrapper object '");
+      Serial.print(wrapper);
+      Serial.println("', extracting LED values...");
+      source = doc[wrapper].as<JsonObject>();
+      break;
+    }
+  }
+
+  // Periksa apakah semua properti diperlukan ada
+  // (semua nama channel: ~45 karakter + pemisah, muat di buffer)
+  char missing[80] = "";
+  size_t missingLength = 0;
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    if (!source.containsKey(CHANNEL_NAMES[i])) {
+      missingLength += snprintf(missing + missingLength, sizeof(missing) - missingLength, "%s%s",
+                                missingLength ? ", " : "", CHANNEL_NAMES[i]);
+    }
+  }
+
+  // Jika ada properti yang hilang, kirim error
+  if (missingLength > 0) {
+    Serial.print("Missing properties: ");
+    Serial.println(missing);
+    return failJson(error, "Missing properties: ", missing);
+  }
+
+  // Mode manual diaktifkan bersamaan dengan frame baru (tanpa state antara)
+  command.type = CMD_SET_ALL;
+  const char* badChannel;
+  if (!readProfile(source, command.frame, badChannel)) {
+    return failChannel(error, badChannel);
+  }
+  return true;
+}
+
+bool parseTimeRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  StaticJsonDocument<200> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  command.type = CMD_SET_TIME;
+  if (parseError || !readTime(doc.as<JsonObject>(), command.time)) {
+    Serial.println("Failed to update time, invalid format");
+    return failJson(error, "Invalid time format");
+  }
+  return true;
+}
+
+// t1 wajib; id dan t4 hanya bersama-sama (exchange sebelumnya dari client yang sama)
+bool parseTimeSyncRequest(uint8_t* data, size_t len, TimeSyncRequest& request, ApiError& error) {
+  StaticJsonDocument<128> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+  if (parseError) {
+    return failJson(error, "JSON parsing failed: ", parseError.c_str());
+  }
+
+  JsonObjectConst obj = doc.as<JsonObjectConst>();
+  if (!obj["t1"].is<int64_t>()) {
+    return failJson(error, "Missing t1 (client send time, ms)");
+  }
+  request.t1 = obj["t1"].as<int64_t>();
+  request.id = 0;
+  request.t4 = 0;
+  if (obj.containsKey("id")) {
+    if (!obj["id"].is<uint32_t>() || !obj["t4"].is<int64_t>()) {
+      return failJson(error, "id needs t4 (when its response arrived, ms)");
+    }
+    request.id = obj["id"].as<uint32_t>();
+    request.t4 = obj["t4"].as<int64_t>();
+  }
+  return true;
+}
+
+bool parseModeRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  // Parse JSON
+  StaticJsonDocument<100> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  // Check for parsing errors
+  if (parseError) {
+    Serial.print("ERROR: JSON parsing failed: ");
+    Serial.println(parseError.c_str());
+    return failParseText(error, parseError);
+  }
+
+  // Extract mode value
+  if (!doc.containsKey("mode")) {
+    Serial.println("ERROR: Missing 'mode' key in JSON");
+    return failJson(error, "Missing mode key");
+  }
+
+  const char* mode = doc["mode"] | "";
+  int modeCode = modeFromName(mode);
+  if (modeCode < 0) {
+    Serial.print("ERROR: Invalid mode received: ");
+    Serial.println(mode);
+    return failJson(error, "Invalid mode. Valid modes: manual, auto, off");
+  }
+
+  command.type = CMD_SET_MODE;
+  command.mode.mode = modeCode;
+  return true;
+}
+
+// {"minutes": N}: putar jadwal satu hari di lampu dalam N menit; 0 menghentikan preview
+bool parsePreviewRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  StaticJsonDocument<64> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+  if (parseError) {
+    return failJson(error, "JSON parsing failed: ", parseError.c_str());
+  }
+  if (!doc["minutes"].is<float>()) {
+    return failJson(error, "Missing 'minutes' property");
+  }
+
+  float minutes = doc["minutes"].as<float>();
+  if (minutes != 0 && (minutes < 0.1f || minutes > 1440)) {
+    return failJson(error, "minutes must be 0 (stop) or between 0.1 and 1440");
+  }
+  command.type = CMD_PREVIEW;
+  command.preview.durationMs = (uint32_t)(minutes * 60000.0f);
+  return true;
+}
+
+// Beberapa operasi dalam satu request, diterapkan sebagai satu transisi state.
+// Operasi diproses berurutan ke state sementara (operasi yang lebih akhir menimpa yang lebih awal);
+// jika ada satu saja yang tidak valid, tidak ada yang diterapkan.
+bool parseBatchRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  JsonDocument& doc = requestDoc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  if (parseError) {
+    return failJson(error, "Invalid JSON format: ", parseError.c_str());
+  }
+
+  // Terima array langsung atau object dengan key "ops"
+  JsonArrayConst ops;
+  if (doc.is<JsonArray>()) {
+    ops = doc.as<JsonArray>();
+  } else if (doc["ops"].is<JsonArray>()) {
+    ops = doc["ops"].as<JsonArray>();
+  } else {
+    return failJson(error, "Expected an 'ops' array");
+  }
+
+  command.type = CMD_TRANSITION;
+  command.transition.flags = 0;
+  command.transition.hourMask = 0;
+
+  int index = 0;
+  const char* badChannel;
+  for (JsonObjectConst op : ops) {
+    const char* name = op["op"] | "";
+    bool valid = true;
+
+    if (strcmp(name, "mode") == 0) {
+      int mode = modeFromName(op["mode"] | "");
+      if (mode < 0) {
+        valid = false;
+      } else {
+        command.transition.flags |= TRANSITION_MODE;
+        command.transition.mode = mode;
+      }
+    } else if (strcmp(name, "manual") == 0) {
+      // Frame manual juga berarti mode manual
+      command.transition.flags |= TRANSITION_FRAME | TRANSITION_MODE;
+      command.transition.mode = MODE_MANUAL;
+      if (!readProfile(op, command.transition.frame, badChannel)) {
+        return failChannel(error, badChannel, "index", index);
+      }
+    } else if (strcmp(name, "hour") == 0) {
+      int hour = op["hour"] | -1;
+      if (hour < 0 || hour > 23) {
+        valid = false;
+      } else {
+        if (!readProfile(op, command.transition.profiles[hour], badChannel)) {
+          return failChannel(error, badChannel, "index", index);
+        }
+        command.transition.hourMask |= (1UL << hour);
+      }
+    } else if (strcmp(name, "time") == 0) {
+      if (!readTime(op, command.transition.time)) {
+        valid = false;
+      } else {
+        command.transition.flags |= TRANSITION_TIME;
+      }
+    } else {
+      valid = false;
+    }
+
+    if (!valid) {
+      Serial.print("Batch rejected at operation ");
+      Serial.println(index);
+      error.status = 400;
+      error.contentType = "application/json";
+      snprintf(error.body, sizeof(error.body), "{\"status\":\"error\",\"message\":\"Invalid operation\",\"index\":%d}", index);
+      return false;
+    }
+    index++;
+  }
+
+  if (index == 0) {
+    return failJson(error, "Empty batch");
+  }
+  return true;
+}
+
+bool parseScheduleRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  // Parse JSON ke dokumen bersama (cukup untuk 24 jam karena parse zero-copy)
+  JsonDocument& doc = requestDoc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  if (parseError) {
+    Serial.print("JSON parsing failed: ");
+    Serial.println(parseError.c_str());
+    return failJson(error, "Invalid JSON format: ", parseError.c_str());
+  }
+
+  // Terima array langsung atau object dengan key "schedule"
+  JsonArrayConst scheduleArray;
+  if (doc.is<JsonArray>()) {
+    scheduleArray = doc.as<JsonArray>();
+  } else if (doc["schedule"].is<JsonArray>()) {
+    scheduleArray = doc["schedule"].as<JsonArray>();
+  } else {
+    Serial.println("Invalid JSON format for hourly schedule");
+    return failJson(error, "Invalid JSON format for hourly schedule");
+  }
+
+  command.type = CMD_SET_SCHEDULE;
+  command.schedule.hourMask = 0;
+
+  const char* badChannel;
+  for (JsonObjectConst hourObj : scheduleArray) {
+    if (!hourObj.containsKey("hour")) continue;
+    int hour = hourObj["hour"].as<int>();
+    if (hour < 0 || hour > 23) continue;
+
+    // Satu nilai salah menolak seluruh jadwal
+    if (!readProfile(hourObj, command.schedule.profiles[hour], badChannel)) {
+      return failChannel(error, badChannel, "hour", hour);
+    }
+    command.schedule.hourMask |= (1UL << hour);
+  }
+  return true;
+}
+
+// Perubahan sparse: {"baseVersion": N, "changes": [{"hour": 6, "channel": "blue", "value": 120}, ...]}
+// baseVersion adalah "version" dari GET /api/schedule/hourly yang diedit client.
+bool parseSchedulePatchRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  JsonDocument& doc = requestDoc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  if (parseError) {
+    return failJson(error, "Invalid JSON format: ", parseError.c_str());
+  }
+
+  if (!doc["baseVersion"].is<uint32_t>() || !doc["changes"].is<JsonArray>()) {
+    return failJson(error, "Expected 'baseVersion' and a 'changes' array");
+  }
+
+  JsonArrayConst changes = doc["changes"].as<JsonArray>();
+  if (changes.size() == 0 || changes.size() > SCHEDULE_PATCH_MAX) {
+    return failJson(error, "'changes' must hold 1-48 entries");
+  }
+
+  command.type = CMD_PATCH_SCHEDULE;
+  command.patch.baseVersion = doc["baseVersion"].as<uint32_t>();
+  command.patch.count = 0;
+
+  for (JsonObjectConst change : changes) {
+    int hour = change["hour"] | -1;
+    int channel = channelFromName(change["channel"] | "");
+    int value = change["value"] | -1;
+
+    if (hour < 0 || hour > 23 || channel < 0 || value < 0 || value > 255) {
+      error.status = 400;
+      error.contentType = "application/json";
+      snprintf(error.body, sizeof(error.body), "{\"status\":\"error\",\"message\":\"Invalid change\",\"index\":%u}",
+               command.patch.count);
+      return false;
+    }
+
+    ScheduleDelta& delta = command.patch.deltas[command.patch.count++];
+    delta.hour = hour;
+    delta.channel = channel;
+    delta.value = value;
+  }
+  return true;
+}
+
+bool parseHourRequest(uint16_t hour, uint8_t* data, size_t len, ControlCommand& command, ApiError& error) {
+  if (hour > 23) {
+    Serial.println("ERROR: Invalid hour value!");
+    return failJson(error, "Invalid hour (must be 0-23)");
+  }
+
+  // Parse JSON
+  StaticJsonDocument<256> doc;
+  DeserializationError parseError = parseJson(doc, data, len);
+
+  if (parseError) {
+    Serial.print("ERROR: JSON parsing failed: ");
+    Serial.println(parseError.c_str());
+    return failJson(error, "Invalid JSON format: ", parseError.c_str());
+  }
+
+  command.type = CMD_SET_HOUR;
+  command.hour.hour = hour;
+  const char* badChannel;
+  if (!readProfile(doc.as<JsonObject>(), command.hour.profile, badChannel)) {
+    return failChannel(error, badChannel, "hour", hour);
+  }
+  return true;
+}
+
+size_t formatCommandResult(char* buffer, size_t size, uint32_t seq, uint16_t status,
+                           uint32_t value, const char* message) {
+  if (status == 200) {
+    if (message != nullptr) {
+      return snprintf(buffer, size, "{\"status\":\"success\",\"message\":\"%s\",\"seq\":%lu,\"version\":%lu}",
+                      message, (unsigned long)seq, (unsigned long)value);
+    }
+    return snprintf(buffer, size, "{\"status\":\"success\",\"seq\":%lu}", (unsigned long)seq);
+  }
+  if (status == 409) {
+    // value = versi jadwal saat ini, client perlu memuat ulang sebelum mencoba lagi
+    return snprintf(buffer, size, "{\"status\":\"error\",\"message\":\"Schedule version conflict\",\"seq\":%lu,\"version\":%lu}",
+                    (unsigned long)seq, (unsigned long)value);
+  }
+  if (status == COMMAND_STATUS_RESULT_EVICTED) {
+    // Hasil tertimpa sebelum dibaca: client harus memuat ulang state
+    return snprintf(buffer, size, "{\"status\":\"error\",\"error\":\"result_evicted\","
+                    "\"message\":\"Command processed, result lost; reload state\",\"seq\":%lu}",
+                    (unsigned long)seq);
+  }
+  return snprintf(buffer, size, "{\"status\":\"error\",\"message\":\"Command rejected\",\"seq\":%lu}",
+                  (unsigned long)seq);
+}
+
+size_t formatHourProfileJson(char* buffer, size_t size, uint8_t hour, const LightProfile& profile, uint32_t version) {
+  StaticJsonDocument<256> doc;
+  doc["hour"] = hour;
+  doc["royalBlue"] = profile.royalBlue;
+  doc["blue"] = profile.blue;
+  doc["uv"] = profile.uv;
+  doc["violet"] = profile.violet;
+  doc["red"] = profile.red;
+  doc["green"] = profile.green;
+  doc["white"] = profile.white;
+  doc["version"] = version;
+
+  return serializeJson(doc, buffer, size);
+}
@@ -0,0 +1,49 @@
+#ifndef API_REQUESTS_H
+#define API_REQUESTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "ControlCommand.h"
+#include "TimeKeeper.h"
+
+// Shared JSON document for the schedule, patch, batch and health handlers
+// (24 hours of profiles, parsed zero-copy)
+#define REQUEST_JSON_CAPACITY 4608
+
+// Response for a request that was rejected before a command was queued
+struct ApiError {
+  uint16_t status;
+  const char* contentType;
+  char body[160];
+};
+
+// JSON write requests -> ControlCommand. No Arduino/ESP32 networking types,
+// so the same code runs in the firmware handlers and in the native build.
+// The body must be writable: it is parsed in place (strings point into it).
+// Each returns true with command filled in, or false with error filled in.
+bool parseManualRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseManualAllRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseTimeRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseModeRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseBatchRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseScheduleRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseSchedulePatchRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parseHourRequest(uint16_t hour, uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+bool parsePreviewRequest(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+
+// POST /api/time/sync {"t1":..., "id":..., "t4":...}: not a command, the
+// handler passes it to TimeKeeper::sync() directly
+bool parseTimeSyncRequest(uint8_t* data, size_t len, TimeSyncRequest& request, ApiError& error);
+
+// Body sent once a queued command has been applied (status from the lighting loop)
+size_t formatCommandResult(char* buffer, size_t size, uint32_t seq, uint16_t status,
+                           uint32_t value, const char* message);
+
+// GET /api/schedule/hourly/{hour}
+size_t formatHourProfileJson(char* buffer, size_t size, uint8_t hour, const LightProfile& profile, uint32_t version);
+
+// The shared document (one request at a time: all callers run in one task)
+JsonDocument& apiRequestDocument();
+
+#endif // API_REQUESTS_H
@@ -0,0 +1,167 @@
+#include "ApiRouter.h"
+#include <string.h>
+#include <stdio.h>
+
+ApiRouter::ApiRouter() {
+  this->routes = nullptr;
+  this->routeCount = 0;
+  this->nodeCount = 0;
+}
+
+bool ApiRouter::begin(const ApiRoute* routes, size_t count) {
+  if (count > ROUTER_MAX_ROUTES) {
+    return false;
+  }
+
+  this->routes = routes;
+  this->routeCount = count;
+
+  // Node 0 is the root ("/")
+  nodes[0] = {"", 0, false, ROUTER_NO_NODE, ROUTER_NO_NODE, 0};
+  nodeCount = 1;
+
+  for (size_t i = 0; i < count; i++) {
+    const char* p = routes[i].pattern;
+    uint8_t node = 0;
+
+    while (*p) {
+      // Skip separators (also tolerates trailing slashes)
+      while (*p == '/') p++;
+      if (*p == '\0') break;
+
+      const char* start = p;
+      while (*p && *p != '/') p++;
+      uint8_t length = p - start;
+      bool isParam = (start[0] == '{' && start[length - 1] == '}');
+
+      node = findOrAddChild(node, start, length, isParam);
+      if (node == ROUTER_NO_NODE) {
+        return false;
+      }
+    }
+
+    nodes[node].routeMask |= (1UL << i);
+  }
+
+  return true;
+}
+
+uint8_t ApiRouter::findOrAddChild(uint8_t parent, const char* segment, uint8_t length, bool isParam) {
+  for (uint8_t child = nodes[parent].firstChild; child != ROUTER_NO_NODE; child = nodes[child].nextSibling) {
+    if (nodes[child].isParam && isParam) {
+      return child;
+    }
+    if (!nodes[child].isParam && !isParam && nodes[child].segmentLength == length &&
+        memcmp(nodes[child].segment, segment, length) == 0) {
+      return child;
+    }
+  }
+
+  if (nodeCount >= ROUTER_MAX_NODES) {
+    return ROUTER_NO_NODE;
+  }
+
+  uint8_t index = nodeCount++;
+  nodes[index] = {segment, length, isParam, ROUTER_NO_NODE, nodes[parent].firstChild, 0};
+  nodes[parent].firstChild = index;
+  return index;
+}
+
+uint8_t ApiRouter::findChild(uint8_t parent, const char* segment, uint8_t length, uint16_t* paramValue) {
+  uint8_t paramChild = ROUTER_NO_NODE;
+
+  for (uint8_t child = nodes[parent].firstChild; child != ROUTER_NO_NODE; child = nodes[child].nextSibling) {
+    if (nodes[child].isParam) {
+      paramChild = child;
+    } else if (nodes[child].segmentLength == length && memcmp(nodes[child].segment, segment, length) == 0) {
+      // Literal segments take priority over parameters
+      return child;
+    }
+  }
+
+  if (paramChild == ROUTER_NO_NODE || length == 0 || length > 5) {
+    return ROUTER_NO_NODE;
+  }
+
+  // Numeric parameter: digits only
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < length; i++) {
+    if (segment[i] < '0' || segment[i] > '9') {
+      return ROUTER_NO_NODE;
+    }
+    value = value * 10 + (segment[i] - '0');
+  }
+  if (value > 0xFFFF) {
+    return ROUTER_NO_NODE;
+  }
+
+  *paramValue = value;
+  return paramChild;
+}
+
+bool ApiRouter::match(const char* path, uint8_t method, RouteMatch& match) {
+  match.route = ROUTER_NO_ROUTE;
+  match.id = 0;
+  match.allowedMethods = 0;
+  match.paramCount = 0;
+
+  if (nodeCount == 0 || path == nullptr) {
+    return false;
+  }
+
+  const char* p = path;
+  uint8_t node = 0;
+
+  while (*p) {
+    while (*p == '/') p++;
+    if (*p == '\0') break;
+
+    const char* start = p;
+    while (*p && *p != '/') p++;
+    uint8_t length = (p - start) > 0xFF ? 0xFF : (p - start);
+
+    uint16_t paramValue = 0;
+    uint8_t next = findChild(node, start, length, &paramValue);
+    if (next == ROUTER_NO_NODE) {
+      return false;
+    }
+    if (nodes[next].isParam) {
+      if (match.paramCount >= sizeof(match.params) / sizeof(match.params[0])) {
+        return false;
+      }
+      match.params[match.paramCount++] = paramValue;
+    }
+    node = next;
+  }
+
+  uint32_t mask = nodes[node].routeMask;
+  if (mask == 0) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < routeCount; i++) {
+    if (!(mask & (1UL << i))) continue;
+    match.allowedMethods |= routes[i].method;
+    if ((routes[i].method & method) && match.route == ROUTER_NO_ROUTE) {
+      match.route = i;
+      match.id = routes[i].id;
+    }
+  }
+
+  return true;
+}
+
+size_t ApiRouter::formatAllow(uint8_t methods, char* buffer, size_t size) {
+  static const char* const names[] = {"GET", "POST", "DELETE", "PUT", "PATCH", "HEAD", "OPTIONS"};
+  size_t length = 0;
+  buffer[0] = '\0';
+
+  for (uint8_t bit = 0; bit < 7; bit++) {
+    if (!(methods & (1 << bit))) continue;
+    int written = snprintf(buffer + length, size - length, "%s%s", length ? ", " : "", names[bit]);
+    if (written < 0 || (size_t)written >= size - length) break;
+    length += written;
+  }
+
+  return length;
+}
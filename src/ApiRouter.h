@@ -0,0 +1,85 @@
+#ifndef API_ROUTER_H
+#define API_ROUTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Method flags - same bit values as ESPAsyncWebServer's WebRequestMethod,
+// so request->method() can be passed straight to the router
+#define ROUTE_GET     0x01
+#define ROUTE_POST    0x02
+#define ROUTE_DELETE  0x04
+#define ROUTE_PUT     0x08
+#define ROUTE_PATCH   0x10
+#define ROUTE_HEAD    0x20
+#define ROUTE_OPTIONS 0x40
+
+// Limits for the statically allocated trie
+#define ROUTER_MAX_ROUTES  32  // One bit per route in ApiRouteNode::routeMask
+#define ROUTER_MAX_NODES   48
+#define ROUTER_NO_NODE     0xFF
+#define ROUTER_NO_ROUTE    0xFF
+
+// One entry in the route table. Pattern segments in braces (e.g. "{hour}")
+// are numeric path parameters.
+struct ApiRoute {
+  const char* pattern;
+  uint8_t method;
+  uint8_t id;
+};
+
+// Result of matching a request path against the route table
+struct RouteMatch {
+  uint8_t route;          // Index in the route table, ROUTER_NO_ROUTE if method not allowed
+  uint8_t id;             // ApiRoute::id of the matched route
+  uint8_t allowedMethods; // All methods registered for this path (for 405 / Allow)
+  uint8_t paramCount;
+  uint16_t params[2];     // Numeric path parameters in order of appearance
+};
+
+// Compile-time checks for route tables
+constexpr bool routePatternValid(const char* pattern) {
+  return pattern[0] == '/';
+}
+
+constexpr bool routeTableValid(const ApiRoute* routes, size_t count) {
+  return count == 0 || (routePatternValid(routes->pattern) && routeTableValid(routes + 1, count - 1));
+}
+
+// Segment trie built once from a constexpr route table into static storage.
+// Matching walks the path once and never allocates.
+class ApiRouter {
+private:
+  struct Node {
+    const char* segment;  // Points into the route pattern (not NUL-terminated)
+    uint8_t segmentLength;
+    bool isParam;
+    uint8_t firstChild;
+    uint8_t nextSibling;
+    uint32_t routeMask;   // Routes that terminate at this node
+  };
+
+  const ApiRoute* routes;
+  uint8_t routeCount;
+  Node nodes[ROUTER_MAX_NODES];
+  uint8_t nodeCount;
+
+  uint8_t findOrAddChild(uint8_t parent, const char* segment, uint8_t length, bool isParam);
+  uint8_t findChild(uint8_t parent, const char* segment, uint8_t length, uint16_t* paramValue);
+
+public:
+  ApiRouter();
+
+  // Build the trie. Returns false if the table exceeds the static limits.
+  bool begin(const ApiRoute* routes, size_t count);
+
+  // Match a path (without query string) and method.
+  // Returns false if no route is registered for the path at all (404).
+  // Returns true with match.route == ROUTER_NO_ROUTE if the path exists but not for this method (405).
+  bool match(const char* path, uint8_t method, RouteMatch& match);
+
+  // Format allowed methods as an HTTP Allow header value ("GET, POST")
+  static size_t formatAllow(uint8_t methods, char* buffer, size_t size);
+};
+
+#endif // API_ROUTER_H
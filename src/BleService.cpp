@@ -0,0 +1,206 @@
+#include "BleService.h"
+#include "Metrics.h"
+
+BleService::BleService(LedController* ledController, CommandQueue* commandQueue, const char* name, uint32_t passkey)
+  : dispatcher(commandQueue) {
+  this->ledController = ledController;
+  this->commandQueue = commandQueue;
+  this->name = name;
+  this->passkey = passkey;
+  server = nullptr;
+  frameCharacteristic = nullptr;
+  modeCharacteristic = nullptr;
+  timeCharacteristic = nullptr;
+  scheduleCharacteristic = nullptr;
+  commandCharacteristic = nullptr;
+  resultCharacteristic = nullptr;
+  pendingHead.store(0, std::memory_order_relaxed);
+  pendingTail.store(0, std::memory_order_relaxed);
+  clients.store(0, std::memory_order_relaxed);
+}
+
+NimBLECharacteristic* BleService::addCharacteristic(NimBLEService* service, const char* uuid,
+                                                    uint32_t properties, uint16_t maxLength) {
+  NimBLECharacteristic* characteristic = service->createCharacteristic(uuid, properties, maxLength);
+  characteristic->setCallbacks(this);
+  return characteristic;
+}
+
+bool BleService::begin() {
+  NimBLEDevice::init(name);
+  NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+
+  // Passkey statis (perangkat tanpa layar); bond disimpan NimBLE di NVS,
+  // jadi pairing hanya sekali per ponsel
+  NimBLEDevice::setSecurityAuth(true, true, true);
+  NimBLEDevice::setSecurityIOCap(BLE_HS_IO_DISPLAY_ONLY);
+  NimBLEDevice::setSecurityPasskey(passkey);
+
+  server = NimBLEDevice::createServer();
+  if (server == nullptr) {
+    Serial.println("ERROR: BLE server could not be created");
+    return false;
+  }
+  server->setCallbacks(this, false);
+
+  // Tulis butuh link terenkripsi dan terautentikasi; baca terbuka
+  const uint32_t writable = NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN;
+  NimBLEService* service = server->createService(BLE_SERVICE_UUID);
+  frameCharacteristic = addCharacteristic(service, BLE_FRAME_UUID,
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE_NR | writable, CODEC_FRAME_SIZE);
+  modeCharacteristic = addCharacteristic(service, BLE_MODE_UUID,
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE_NR | writable, 1);
+  timeCharacteristic = addCharacteristic(service, BLE_TIME_UUID,
+    NIMBLE_PROPERTY::READ | writable, CODEC_TIME_SIZE);
+  // Jadwal lengkap: satu write jika MTU cukup, selain itu long write (prepare/execute)
+  scheduleCharacteristic = addCharacteristic(service, BLE_SCHEDULE_UUID,
+    NIMBLE_PROPERTY::READ | writable, CODEC_SCHEDULE_SIZE);
+  commandCharacteristic = addCharacteristic(service, BLE_COMMAND_UUID,
+    NIMBLE_PROPERTY::WRITE_NR | writable, CODEC_MESSAGE_MAX_SIZE);
+  resultCharacteristic = addCharacteristic(service, BLE_RESULT_UUID,
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, CODEC_RESULT_SIZE);
+  service->start();
+
+  // UUID 128-bit dan nama tidak muat bersama dalam 31 byte: nama di scan response
+  NimBLEAdvertisementData advertisement;
+  advertisement.setFlags(BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP);
+  advertisement.setCompleteServices(NimBLEUUID(BLE_SERVICE_UUID));
+  NimBLEAdvertisementData scanResponse;
+  scanResponse.setName(name);
+
+  NimBLEAdvertising* advertising = NimBLEDevice::getAdvertising();
+  advertising->setAdvertisementData(advertisement);
+  advertising->setScanResponseData(scanResponse);
+  if (!advertising->start()) {
+    Serial.println("ERROR: BLE advertising could not be started");
+    return false;
+  }
+
+  Serial.print("BLE: advertising as ");
+  Serial.println(name);
+  return true;
+}
+
+// ========== CALLBACKS (NimBLE host task) ==========
+
+void BleService::onConnect(NimBLEServer* server, ble_gap_conn_desc* desc) {
+  clients.fetch_add(1, std::memory_order_relaxed);
+  // Interval pendek: latency write -> hasil ditentukan lighting loop, bukan radio
+  server->updateConnParams(desc->conn_handle, BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX,
+                           0, BLE_SUPERVISION_TIMEOUT);
+  // Advertising tetap jalan agar ponsel kedua bisa terhubung
+  NimBLEDevice::startAdvertising();
+}
+
+void BleService::onDisconnect(NimBLEServer* server) {
+  clients.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32_t BleService::onPassKeyRequest() {
+  return passkey;
+}
+
+void BleService::onWrite(NimBLECharacteristic* characteristic) {
+  uint32_t receivedAt = micros();
+  NimBLEAttValue value = characteristic->getValue();
+  const uint8_t* data = value.data();
+  size_t length = value.length();
+
+  uint8_t opcode;
+  if (characteristic == frameCharacteristic) {
+    opcode = OP_FRAME;
+  } else if (characteristic == modeCharacteristic) {
+    opcode = OP_MODE;
+  } else if (characteristic == timeCharacteristic) {
+    opcode = OP_TIME;
+  } else if (characteristic == scheduleCharacteristic) {
+    opcode = OP_SCHEDULE;
+  } else if (characteristic == commandCharacteristic) {
+    if (length == 0) {
+      queueResult(0, CODEC_BAD_LENGTH, 0, receivedAt);
+      return;
+    }
+    opcode = data[0];
+    data++;
+    length--;
+  } else {
+    return;
+  }
+
+  uint32_t seq;
+  CodecStatus status = dispatcher.dispatch(opcode, data, length, seq);
+  queueResult(opcode, status, seq, receivedAt);
+}
+
+void BleService::onRead(NimBLECharacteristic* characteristic) {
+  // Nilai dari snapshot LedController (task NimBLE, bukan pemilik state), seperti handler GET HTTP
+  if (characteristic == frameCharacteristic) {
+    ControllerSnapshot state;
+    ledController->readSnapshot(state);
+    uint8_t frame[CODEC_FRAME_SIZE];
+    encodeFrame(state.output, frame);
+    characteristic->setValue(frame, sizeof(frame));
+  } else if (characteristic == modeCharacteristic) {
+    ControllerSnapshot state;
+    ledController->readSnapshot(state);
+    uint8_t mode = state.mode;
+    characteristic->setValue(&mode, 1);
+  } else if (characteristic == timeCharacteristic) {
+    CommandTime now;
+    ledController->getCurrentTime(now);
+    uint8_t time[CODEC_TIME_SIZE];
+    encodeTime(now, time);
+    characteristic->setValue(time, sizeof(time));
+  } else if (characteristic == scheduleCharacteristic) {
+    ControllerSnapshot state;
+    ledController->readSnapshot(state);
+    uint8_t schedule[CODEC_SCHEDULE_SIZE];
+    encodeScheduleRead(state.scheduleVersion, state.profiles, schedule);
+    characteristic->setValue(schedule, sizeof(schedule));
+  }
+}
+
+void BleService::queueResult(uint8_t opcode, CodecStatus status, uint32_t seq, uint32_t receivedAt) {
+  uint32_t head = pendingHead.load(std::memory_order_relaxed);
+  if (head - pendingTail.load(std::memory_order_acquire) >= BLE_PENDING_RESULTS) {
+    // Network task tidak menguras antrian; command tetap diterapkan, hasilnya tidak dikirim
+    metrics.bleResultsDropped.add();
+    return;
+  }
+
+  PendingResult& entry = pending[head % BLE_PENDING_RESULTS];
+  entry.seq = seq;
+  entry.receivedAt = receivedAt;
+  entry.status = codecHttpStatus(status);
+  entry.opcode = opcode;
+  pendingHead.store(head + 1, std::memory_order_release);
+}
+
+// ========== RESULTS (network task) ==========
+
+bool BleService::hasPendingResults() {
+  return pendingTail.load(std::memory_order_relaxed) != pendingHead.load(std::memory_order_acquire);
+}
+
+void BleService::update() {
+  uint32_t tail = pendingTail.load(std::memory_order_relaxed);
+  while (tail != pendingHead.load(std::memory_order_acquire)) {
+    PendingResult& entry = pending[tail % BLE_PENDING_RESULTS];
+    uint16_t status = entry.status;
+    uint32_t value = 0;
+
+    // Queue FIFO: hasil dikirim berurutan, berhenti di command pertama yang belum diterapkan
+    if (entry.seq != 0 && !commandQueue->result(entry.seq, status, value)) {
+      break;
+    }
+
+    uint8_t record[CODEC_RESULT_SIZE];
+    encodeResult(entry.opcode, status, entry.seq, value, record);
+    resultCharacteristic->setValue(record, sizeof(record));
+    resultCharacteristic->notify();
+    metrics.bleLatency.observe(micros() - entry.receivedAt);
+
+    tail++;
+    pendingTail.store(tail, std::memory_order_release);
+  }
+}
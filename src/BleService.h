@@ -0,0 +1,92 @@
+#ifndef BLE_SERVICE_H
+#define BLE_SERVICE_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include <atomic>
+#include "LedController.h"
+#include "ControlCommand.h"
+#include "CommandCodec.h"
+
+// GATT layout. Payloads use the binary codec (CommandCodec.h); the frame, mode,
+// time and schedule characteristics are bound to one opcode and carry the
+// payload only, the command characteristic takes framed messages (any opcode).
+#define BLE_SERVICE_UUID          "8f3e0001-6b2a-4c1d-9e57-5a1b0c2d3e4f"
+#define BLE_FRAME_UUID            "8f3e0002-6b2a-4c1d-9e57-5a1b0c2d3e4f"  // R/W  7 bytes
+#define BLE_MODE_UUID             "8f3e0003-6b2a-4c1d-9e57-5a1b0c2d3e4f"  // R/W  1 byte
+#define BLE_TIME_UUID             "8f3e0004-6b2a-4c1d-9e57-5a1b0c2d3e4f"  // R/W  7 bytes
+#define BLE_SCHEDULE_UUID         "8f3e0005-6b2a-4c1d-9e57-5a1b0c2d3e4f"  // R/W  up to 172 bytes
+#define BLE_COMMAND_UUID          "8f3e0006-6b2a-4c1d-9e57-5a1b0c2d3e4f"  // W    opcode + payload
+#define BLE_RESULT_UUID           "8f3e0007-6b2a-4c1d-9e57-5a1b0c2d3e4f"  // R/N  12-byte result
+
+// Connection parameters requested after connect (1.25 ms units): a 7.5-15 ms
+// interval keeps write-to-result latency close to the lighting loop period
+#define BLE_CONN_INTERVAL_MIN     6
+#define BLE_CONN_INTERVAL_MAX     12
+#define BLE_SUPERVISION_TIMEOUT   200   // 10 ms units (2 s)
+
+// A full schedule fits one write with this MTU; smaller MTUs use a long write
+#define BLE_PREFERRED_MTU         185
+
+// Results waiting to be notified (power of two). Larger than the command
+// queue, so it only fills if the network task stops draining it.
+#define BLE_PENDING_RESULTS       16
+
+// NimBLE GATT control service. Writes are decoded and queued from the NimBLE
+// host task; results are notified from the network task once the lighting
+// task has applied the command. Writes need an encrypted, authenticated link
+// (static passkey, bonded after the first pairing); reads are open.
+class BleService : public NimBLEServerCallbacks, public NimBLECharacteristicCallbacks {
+private:
+  struct PendingResult {
+    uint32_t seq;         // 0 = never queued, status is final
+    uint32_t receivedAt;  // micros() when the write arrived
+    uint16_t status;
+    uint8_t opcode;
+  };
+
+  LedController* ledController;
+  CommandQueue* commandQueue;
+  CommandDispatcher dispatcher;
+  const char* name;
+  uint32_t passkey;
+
+  NimBLEServer* server;
+  NimBLECharacteristic* frameCharacteristic;
+  NimBLECharacteristic* modeCharacteristic;
+  NimBLECharacteristic* timeCharacteristic;
+  NimBLECharacteristic* scheduleCharacteristic;
+  NimBLECharacteristic* commandCharacteristic;
+  NimBLECharacteristic* resultCharacteristic;
+
+  // Single producer (NimBLE host task), single consumer (network task)
+  PendingResult pending[BLE_PENDING_RESULTS];
+  std::atomic<uint32_t> pendingHead;
+  std::atomic<uint32_t> pendingTail;
+  std::atomic<uint8_t> clients;
+
+  void queueResult(uint8_t opcode, CodecStatus status, uint32_t seq, uint32_t receivedAt);
+  NimBLECharacteristic* addCharacteristic(NimBLEService* service, const char* uuid, uint32_t properties, uint16_t maxLength);
+
+public:
+  BleService(LedController* ledController, CommandQueue* commandQueue, const char* name, uint32_t passkey);
+
+  // Start the stack, GATT service and advertising. Called once from the network task.
+  bool begin();
+
+  // Notify results of applied commands (network task, non-blocking)
+  void update();
+  bool hasPendingResults();
+
+  uint8_t getClientCount() { return clients.load(std::memory_order_relaxed); }
+  const CommandDispatcher& getDispatcher() { return dispatcher; }
+
+  // NimBLE callbacks (NimBLE host task)
+  void onConnect(NimBLEServer* server, ble_gap_conn_desc* desc) override;
+  void onDisconnect(NimBLEServer* server) override;
+  uint32_t onPassKeyRequest() override;
+  void onWrite(NimBLECharacteristic* characteristic) override;
+  void onRead(NimBLECharacteristic* characteristic) override;
+};
+
+#endif // BLE_SERVICE_H
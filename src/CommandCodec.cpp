@@ -0,0 +1,216 @@
+#include "CommandCodec.h"
+#include <string.h>
+
+const char* const CODEC_STATUS_NAMES[CODEC_STATUS_COUNT] = {
+  "ok", "unknown_opcode", "bad_length", "bad_value", "busy"
+};
+
+static_assert(sizeof(LightProfile) == CODEC_FRAME_SIZE, "LightProfile must be 7 packed channel bytes");
+static_assert(CODEC_PATCH_MAX_SIZE <= CODEC_SCHEDULE_SIZE, "CODEC_MESSAGE_MAX_SIZE must cover a full patch");
+
+static uint16_t readU16(const uint8_t* data) {
+  return (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t readU32(const uint8_t* data) {
+  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void writeU16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = value >> 24;
+}
+
+// Frame disalin per byte: urutan field LightProfile = urutan LedChannel
+static LightProfile readFrame(const uint8_t* data) {
+  LightProfile frame;
+  memcpy(&frame, data, CODEC_FRAME_SIZE);
+  return frame;
+}
+
+static uint8_t countBits(uint32_t value) {
+  uint8_t count = 0;
+  for (; value != 0; value &= value - 1) {
+    count++;
+  }
+  return count;
+}
+
+bool commandTimeValid(const CommandTime& time) {
+  return time.year >= 2000 && time.year <= 2100 &&
+         time.month >= 1 && time.month <= 12 &&
+         time.day >= 1 && time.day <= 31 &&
+         time.hour <= 23 && time.minute <= 59 && time.second <= 59;
+}
+
+uint16_t codecHttpStatus(CodecStatus status) {
+  switch (status) {
+    case CODEC_OK:
+      return 200;
+    case CODEC_BUSY:
+      return 503;
+    default:
+      return 400;
+  }
+}
+
+CodecStatus decodeCommand(uint8_t opcode, const uint8_t* payload, size_t length, ControlCommand& command) {
+  switch (opcode) {
+    case OP_FRAME:
+      if (length != CODEC_FRAME_SIZE) return CODEC_BAD_LENGTH;
+      command.type = CMD_SET_ALL;
+      command.frame = readFrame(payload);
+      return CODEC_OK;
+
+    case OP_CHANNEL:
+      if (length != 2) return CODEC_BAD_LENGTH;
+      if (payload[0] >= LED_CHANNEL_COUNT) return CODEC_BAD_VALUE;
+      command.type = CMD_SET_CHANNEL;
+      command.channel.channel = payload[0];
+      command.channel.value = payload[1];
+      return CODEC_OK;
+
+    case OP_MODE:
+      if (length != 1) return CODEC_BAD_LENGTH;
+      if (payload[0] > MODE_OFF) return CODEC_BAD_VALUE;
+      command.type = CMD_SET_MODE;
+      command.mode.mode = payload[0];
+      return CODEC_OK;
+
+    case OP_TIME:
+      if (length != CODEC_TIME_SIZE) return CODEC_BAD_LENGTH;
+      command.type = CMD_SET_TIME;
+      command.time.year = readU16(payload);
+      command.time.month = payload[2];
+      command.time.day = payload[3];
+      command.time.hour = payload[4];
+      command.time.minute = payload[5];
+      command.time.second = payload[6];
+      return commandTimeValid(command.time) ? CODEC_OK : CODEC_BAD_VALUE;
+
+    case OP_HOUR:
+      if (length != 1 + CODEC_FRAME_SIZE) return CODEC_BAD_LENGTH;
+      if (payload[0] > 23) return CODEC_BAD_VALUE;
+      command.type = CMD_SET_HOUR;
+      command.hour.hour = payload[0];
+      command.hour.profile = readFrame(payload + 1);
+      return CODEC_OK;
+
+    case OP_SCHEDULE: {
+      if (length < 4) return CODEC_BAD_LENGTH;
+      uint32_t hourMask = readU32(payload);
+      if (hourMask == 0 || (hourMask & ~0xFFFFFFUL)) return CODEC_BAD_VALUE;
+      if (length != 4 + (size_t)countBits(hourMask) * CODEC_FRAME_SIZE) return CODEC_BAD_LENGTH;
+
+      // Frame hanya untuk jam yang bit-nya diset, urut dari jam 0
+      command.type = CMD_SET_SCHEDULE;
+      command.schedule.hourMask = hourMask;
+      const uint8_t* frame = payload + 4;
+      for (uint8_t hour = 0; hour < 24; hour++) {
+        if (hourMask & (1UL << hour)) {
+          command.schedule.profiles[hour] = readFrame(frame);
+          frame += CODEC_FRAME_SIZE;
+        }
+      }
+      return CODEC_OK;
+    }
+
+    case OP_PATCH: {
+      if (length < 5) return CODEC_BAD_LENGTH;
+      uint8_t count = payload[4];
+      if (count == 0 || count > SCHEDULE_PATCH_MAX) return CODEC_BAD_VALUE;
+      if (length != 5 + (size_t)count * 3) return CODEC_BAD_LENGTH;
+
+      command.type = CMD_PATCH_SCHEDULE;
+      command.patch.baseVersion = readU32(payload);
+      command.patch.count = count;
+      for (uint8_t i = 0; i < count; i++) {
+        const uint8_t* entry = payload + 5 + i * 3;
+        if (entry[0] > 23 || entry[1] >= LED_CHANNEL_COUNT) return CODEC_BAD_VALUE;
+        command.patch.deltas[i].hour = entry[0];
+        command.patch.deltas[i].channel = entry[1];
+        command.patch.deltas[i].value = entry[2];
+      }
+      return CODEC_OK;
+    }
+
+    default:
+      return CODEC_UNKNOWN_OPCODE;
+  }
+}
+
+CodecStatus decodeCommandMessage(const uint8_t* data, size_t length, ControlCommand& command) {
+  if (length < 1) return CODEC_BAD_LENGTH;
+  return decodeCommand(data[0], data + 1, length - 1, command);
+}
+
+size_t encodeFrame(const LightProfile& frame, uint8_t* out) {
+  memcpy(out, &frame, CODEC_FRAME_SIZE);
+  return CODEC_FRAME_SIZE;
+}
+
+size_t encodeTime(const CommandTime& time, uint8_t* out) {
+  writeU16(out, time.year);
+  out[2] = time.month;
+  out[3] = time.day;
+  out[4] = time.hour;
+  out[5] = time.minute;
+  out[6] = time.second;
+  return CODEC_TIME_SIZE;
+}
+
+size_t encodeScheduleRead(uint32_t version, const LightProfile* profiles, uint8_t* out) {
+  writeU32(out, version);
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    encodeFrame(profiles[hour], out + 4 + hour * CODEC_FRAME_SIZE);
+  }
+  return CODEC_SCHEDULE_SIZE;
+}
+
+size_t encodeResult(uint8_t opcode, uint16_t status, uint32_t seq, uint32_t value, uint8_t* out) {
+  out[0] = opcode;
+  out[1] = 0;
+  writeU16(out + 2, status);
+  writeU32(out + 4, seq);
+  writeU32(out + 8, value);
+  return CODEC_RESULT_SIZE;
+}
+
+// ========== DISPATCHER ==========
+
+CommandDispatcher::CommandDispatcher(CommandSink* sink) {
+  this->sink = sink;
+  for (uint8_t i = 0; i < CODEC_STATUS_COUNT; i++) {
+    counts[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+CodecStatus CommandDispatcher::dispatch(uint8_t opcode, const uint8_t* payload, size_t length, uint32_t& seq) {
+  ControlCommand command;
+  CodecStatus status = decodeCommand(opcode, payload, length, command);
+  seq = 0;
+  if (status == CODEC_OK) {
+    seq = sink->submit(command);
+    if (seq == 0) {
+      status = CODEC_BUSY;
+    }
+  }
+  counts[status].fetch_add(1, std::memory_order_relaxed);
+  return status;
+}
+
+CodecStatus CommandDispatcher::dispatchMessage(const uint8_t* data, size_t length, uint32_t& seq) {
+  if (length < 1) {
+    seq = 0;
+    counts[CODEC_BAD_LENGTH].fetch_add(1, std::memory_order_relaxed);
+    return CODEC_BAD_LENGTH;
+  }
+  return dispatch(data[0], data + 1, length - 1, seq);
+}
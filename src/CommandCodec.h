@@ -0,0 +1,92 @@
+#ifndef COMMAND_CODEC_H
+#define COMMAND_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ControlCommand.h"
+
+// Binary command format shared by every transport (BLE characteristics,
+// POST /api/command). A message is one opcode byte followed by its payload;
+// BLE characteristics that are bound to one opcode carry the payload only.
+// Multi-byte fields are little-endian, frames are 7 bytes in LedChannel order.
+//
+//   Opcode         Payload                                      Command
+//   0x01 frame     7 channel bytes                              CMD_SET_ALL
+//   0x02 channel   channel, value                               CMD_SET_CHANNEL
+//   0x03 mode      mode (0 auto, 1 manual, 2 off)               CMD_SET_MODE
+//   0x04 time      year u16, month, day, hour, minute, second   CMD_SET_TIME
+//   0x05 hour      hour, 7 channel bytes                        CMD_SET_HOUR
+//   0x06 schedule  hourMask u32, one frame per set bit          CMD_SET_SCHEDULE
+//                  (ascending hour order, up to 24)
+//   0x07 patch     baseVersion u32, count, count x              CMD_PATCH_SCHEDULE
+//                  (hour, channel, value)
+enum CommandOpcode : uint8_t {
+  OP_FRAME    = 0x01,
+  OP_CHANNEL  = 0x02,
+  OP_MODE     = 0x03,
+  OP_TIME     = 0x04,
+  OP_HOUR     = 0x05,
+  OP_SCHEDULE = 0x06,
+  OP_PATCH    = 0x07
+};
+
+enum CodecStatus : uint8_t {
+  CODEC_OK,
+  CODEC_UNKNOWN_OPCODE,
+  CODEC_BAD_LENGTH,
+  CODEC_BAD_VALUE,
+  CODEC_BUSY,           // Decoded, but the sink did not accept it
+  CODEC_STATUS_COUNT
+};
+
+extern const char* const CODEC_STATUS_NAMES[CODEC_STATUS_COUNT];
+
+// Encoded sizes
+#define CODEC_FRAME_SIZE         7
+#define CODEC_TIME_SIZE          7
+#define CODEC_SCHEDULE_SIZE      (4 + 24 * CODEC_FRAME_SIZE)  // Mask (write) or version (read) + frames
+#define CODEC_PATCH_MAX_SIZE     (5 + 3 * SCHEDULE_PATCH_MAX)
+#define CODEC_RESULT_SIZE        12
+#define CODEC_MESSAGE_MAX_SIZE   (1 + CODEC_SCHEDULE_SIZE)    // Opcode + largest payload
+
+// Status of a command result in the same codes the HTTP API uses
+// (200 applied, 400 invalid, 409 version conflict, 503 busy)
+uint16_t codecHttpStatus(CodecStatus status);
+
+// Decode one payload for a known opcode. Values are range-checked here so a
+// transport never queues a command the lighting loop would reject as invalid.
+CodecStatus decodeCommand(uint8_t opcode, const uint8_t* payload, size_t length, ControlCommand& command);
+
+// Decode a framed message (opcode byte + payload)
+CodecStatus decodeCommandMessage(const uint8_t* data, size_t length, ControlCommand& command);
+
+bool commandTimeValid(const CommandTime& time);
+
+// Encoders for reads. Each returns the number of bytes written.
+size_t encodeFrame(const LightProfile& frame, uint8_t* out);
+size_t encodeTime(const CommandTime& time, uint8_t* out);
+size_t encodeScheduleRead(uint32_t version, const LightProfile* profiles, uint8_t* out);
+
+// Result record sent back after a command was applied (or refused):
+// opcode, reserved, status u16, seq u32, value u32 (schedule version for
+// schedule commands, 0 otherwise). seq is 0 when the command was never queued.
+size_t encodeResult(uint8_t opcode, uint16_t status, uint32_t seq, uint32_t value, uint8_t* out);
+
+// Decode + submit, with per-status counters. Holds no transport state, so one
+// dispatcher can serve several transports that run in different tasks.
+class CommandDispatcher {
+private:
+  CommandSink* sink;
+  std::atomic<uint32_t> counts[CODEC_STATUS_COUNT];
+
+public:
+  explicit CommandDispatcher(CommandSink* sink);
+
+  // seq is set on CODEC_OK and 0 otherwise
+  CodecStatus dispatch(uint8_t opcode, const uint8_t* payload, size_t length, uint32_t& seq);
+  CodecStatus dispatchMessage(const uint8_t* data, size_t length, uint32_t& seq);
+
+  uint32_t getCount(CodecStatus status) const { return counts[status].load(std::memory_order_relaxed); }
+};
+
+#endif // COMMAND_CODEC_H
@@ -0,0 +1,70 @@
+#include "ConfigStore.h"
+#include "Crc32.h"
+#include "NvsWear.h"
+#include "Trace.h"
+
+static_assert(sizeof(ConfigRecord) == 292, "ConfigRecord layout is stored in NVS");
+
+const char* const CONFIG_SLOT_KEYS[CONFIG_SLOT_COUNT] = {"cfg_a", "cfg_b"};
+
+static uint32_t recordChecksum(const ConfigRecord& record) {
+  return crc32(&record, offsetof(ConfigRecord, checksum));
+}
+
+ConfigStore::ConfigStore(KeyValueStore* store, const char* space) {
+  this->store = store;
+  this->space = space;
+  this->sequence = 0;
+  this->slot = -1;
+  this->invalidSlots = 0;
+  this->writeFailures = 0;
+}
+
+bool ConfigStore::readSlot(uint8_t index, ConfigRecord& record) {
+  if (store->getBytesLength(CONFIG_SLOT_KEYS[index]) != sizeof(record) ||
+      store->getBytes(CONFIG_SLOT_KEYS[index], &record, sizeof(record)) != sizeof(record)) {
+    return false;
+  }
+  return record.magic == CONFIG_RECORD_MAGIC && record.format == CONFIG_RECORD_FORMAT &&
+         record.checksum == recordChecksum(record);
+}
+
+bool ConfigStore::load(ConfigRecord& record) {
+  TRACE_SCOPE("nvs", "loadConfig");
+  ConfigRecord candidate;
+  slot = -1;
+  invalidSlots = 0;
+  for (uint8_t i = 0; i < CONFIG_SLOT_COUNT; i++) {
+    if (!readSlot(i, candidate)) {
+      // Slot kosong (belum pernah ditulis) tidak dihitung sebagai rusak
+      if (store->isKey(CONFIG_SLOT_KEYS[i])) invalidSlots++;
+      continue;
+    }
+    // Perbandingan dengan selisih bertanda: tetap benar setelah sequence wrap
+    if (slot < 0 || (int32_t)(candidate.sequence - sequence) > 0) {
+      record = candidate;
+      sequence = candidate.sequence;
+      slot = i;
+    }
+  }
+  return slot >= 0;
+}
+
+bool ConfigStore::write(ConfigRecord& record) {
+  TRACE_SCOPE("nvs", "writeConfig");
+  uint8_t target = slot < 0 ? 0 : (slot + 1) % CONFIG_SLOT_COUNT;
+  record.magic = CONFIG_RECORD_MAGIC;
+  record.format = CONFIG_RECORD_FORMAT;
+  record.sequence = sequence + 1;
+  record.checksum = recordChecksum(record);
+
+  size_t written = store->putBytes(CONFIG_SLOT_KEYS[target], &record, sizeof(record));
+  nvsWear.recordWrite(space, CONFIG_SLOT_KEYS[target], NVS_VALUE_BLOB, sizeof(record));
+  if (written != sizeof(record)) {
+    writeFailures++;
+    return false;
+  }
+  sequence = record.sequence;
+  slot = target;
+  return true;
+}
@@ -0,0 +1,64 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "LightTypes.h"
+#include "LightingHal.h"
+
+// The whole controller state (mode, manual frame, schedule and versions) as
+// one record, written alternately to two NVS keys. Each write goes to the
+// slot not holding the newest record, with the next sequence number and a
+// CRC32, so the previous record stays intact until the new one is complete.
+// At boot the valid slot with the higher sequence wins; a torn or corrupt
+// slot is skipped.
+#define CONFIG_SLOT_COUNT    2
+#define CONFIG_RECORD_MAGIC  0x31474643UL  // "CFG1"
+#define CONFIG_RECORD_FORMAT 1
+
+extern const char* const CONFIG_SLOT_KEYS[CONFIG_SLOT_COUNT];
+
+struct ConfigRecord {
+  uint32_t magic;
+  uint8_t format;
+  uint8_t mode;              // LightMode
+  uint8_t hasManual;
+  uint8_t reserved;
+  uint32_t sequence;         // Set by ConfigStore::write()
+  LightProfile manual;
+  uint8_t reserved2;
+  uint32_t scheduleVersion;
+  uint32_t hourVersion[24];
+  LightProfile profiles[24];
+  uint32_t checksum;         // CRC32 of everything above
+};
+
+class ConfigStore {
+private:
+  KeyValueStore* store;
+  const char* space;         // Namespace, for NVS write accounting
+  uint32_t sequence;         // Of the newest record (loaded or written)
+  int8_t slot;               // Slot holding it; -1 if none
+  uint8_t invalidSlots;      // Slots that failed validation in load()
+  uint32_t writeFailures;
+
+  bool readSlot(uint8_t index, ConfigRecord& record);
+
+public:
+  // store must already be opened (begin()) on namespace space
+  ConfigStore(KeyValueStore* store, const char* space);
+
+  // Newest valid record into record; false if neither slot is valid
+  bool load(ConfigRecord& record);
+
+  // Stamps magic, format, sequence and checksum, then writes the other slot.
+  // On failure the newest record is unchanged and the next write retries.
+  bool write(ConfigRecord& record);
+
+  uint32_t getSequence() { return sequence; }
+  int8_t getSlot() { return slot; }
+  uint8_t getInvalidSlots() { return invalidSlots; }
+  uint32_t getWriteFailures() { return writeFailures; }
+};
+
+#endif // CONFIG_STORE_H
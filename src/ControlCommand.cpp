@@ -0,0 +1,158 @@
+#include "ControlCommand.h"
+#include <Arduino.h>
+
+CommandQueue::CommandQueue() {
+  for (uint32_t i = 0; i < COMMAND_QUEUE_CAPACITY; i++) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  for (uint32_t i = 0; i < COMMAND_RESULT_SLOTS; i++) {
+    results[i].seq.store(0, std::memory_order_relaxed);
+    results[i].status.store(0, std::memory_order_relaxed);
+    results[i].value.store(0, std::memory_order_relaxed);
+  }
+
+  enqueuePos.store(0, std::memory_order_relaxed);
+  dequeuePos.store(0, std::memory_order_relaxed);
+  nextSeq.store(1, std::memory_order_relaxed); // 0 = push failed
+
+  maxDepth.store(0, std::memory_order_relaxed);
+  pushedCount.store(0, std::memory_order_relaxed);
+  rejectedCount.store(0, std::memory_order_relaxed);
+  appliedCount.store(0, std::memory_order_relaxed);
+  lastLatencyUs.store(0, std::memory_order_relaxed);
+  maxLatencyUs.store(0, std::memory_order_relaxed);
+  avgLatencyUs.store(0, std::memory_order_relaxed);
+}
+
+uint32_t CommandQueue::push(ControlCommand& command) {
+  uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+  Cell* cell;
+
+  for (;;) {
+    cell = &cells[pos & (COMMAND_QUEUE_CAPACITY - 1)];
+    uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(sequence - pos);
+
+    if (diff == 0) {
+      // Slot free - claim it
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Queue full
+      rejectedCount.fetch_add(1, std::memory_order_relaxed);
+      return 0;
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  uint32_t seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+  if (seq == 0) {
+    seq = nextSeq.fetch_add(1, std::memory_order_relaxed); // Skip 0 on wrap-around
+  }
+  command.seq = seq;
+  command.enqueuedAt = micros();
+  cell->command = command;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+
+  pushedCount.fetch_add(1, std::memory_order_relaxed);
+  uint32_t currentDepth = depth();
+  uint32_t previousMax = maxDepth.load(std::memory_order_relaxed);
+  while (currentDepth > previousMax &&
+         !maxDepth.compare_exchange_weak(previousMax, currentDepth, std::memory_order_relaxed)) {
+  }
+
+  return seq;
+}
+
+bool CommandQueue::pop(ControlCommand& command) {
+  uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+  Cell* cell = &cells[pos & (COMMAND_QUEUE_CAPACITY - 1)];
+  uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+  // Single consumer: the cell is either published (pos + 1) or still empty
+  if ((int32_t)(sequence - (pos + 1)) < 0) {
+    return false;
+  }
+
+  command = cell->command;
+  dequeuePos.store(pos + 1, std::memory_order_relaxed);
+  cell->sequence.store(pos + COMMAND_QUEUE_CAPACITY, std::memory_order_release);
+  return true;
+}
+
+void CommandQueue::complete(const ControlCommand& command, uint16_t status, uint32_t value) {
+  Result& slot = results[command.seq % COMMAND_RESULT_SLOTS];
+  slot.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.status.store(status, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.seq.store(command.seq, std::memory_order_release);
+
+  // Latency dari push sampai diterapkan
+  uint32_t latency = micros() - command.enqueuedAt;
+  lastLatencyUs.store(latency, std::memory_order_relaxed);
+  if (latency > maxLatencyUs.load(std::memory_order_relaxed)) {
+    maxLatencyUs.store(latency, std::memory_order_relaxed);
+  }
+  uint32_t avg = avgLatencyUs.load(std::memory_order_relaxed);
+  avgLatencyUs.store(avg == 0 ? latency : avg - avg / 8 + latency / 8, std::memory_order_relaxed);
+  appliedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CommandQueue::result(uint32_t seq, uint16_t& status, uint32_t& value) {
+  Result& slot = results[seq % COMMAND_RESULT_SLOTS];
+  uint32_t slotSeq = slot.seq.load(std::memory_order_acquire);
+
+  if (slotSeq == seq) {
+    status = slot.status.load(std::memory_order_relaxed);
+    value = slot.value.load(std::memory_order_relaxed);
+    // Slot bisa saja ditimpa saat dibaca - validasi ulang
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_acquire) == seq) {
+      return true;
+    }
+  }
+
+  if (slotSeq != 0 && (int32_t)(slotSeq - seq) > 0) {
+    // Slot sudah dipakai command yang lebih baru: sudah diproses, tapi hasilnya hilang.
+    // Jangan dilaporkan sukses - bisa saja ditolak (400) atau konflik versi (409)
+    status = COMMAND_STATUS_RESULT_EVICTED;
+    value = 0;
+    return true;
+  }
+
+  return false;
+}
+
+bool CommandQueue::waitForResult(uint32_t seq, uint32_t timeoutMs, uint16_t& status, uint32_t& value) {
+  unsigned long start = millis();
+  while (!result(seq, status, value)) {
+    if (millis() - start >= timeoutMs) {
+      return false;
+    }
+    delay(1); // vTaskDelay - memberi CPU ke task lain
+  }
+  return true;
+}
+
+uint32_t CommandQueue::depth() {
+  // Baca posisi consumer dulu agar hasil tidak pernah negatif
+  uint32_t head = dequeuePos.load(std::memory_order_acquire);
+  uint32_t tail = enqueuePos.load(std::memory_order_acquire);
+  return tail - head;
+}
+
+CommandQueueStats CommandQueue::stats() {
+  CommandQueueStats stats;
+  stats.depth = depth();
+  stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+  stats.pushed = pushedCount.load(std::memory_order_relaxed);
+  stats.rejected = rejectedCount.load(std::memory_order_relaxed);
+  stats.applied = appliedCount.load(std::memory_order_relaxed);
+  stats.lastLatencyUs = lastLatencyUs.load(std::memory_order_relaxed);
+  stats.maxLatencyUs = maxLatencyUs.load(std::memory_order_relaxed);
+  stats.avgLatencyUs = avgLatencyUs.load(std::memory_order_relaxed);
+  return stats;
+}
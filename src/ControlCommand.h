@@ -0,0 +1,178 @@
+#ifndef CONTROL_COMMAND_H
+#define CONTROL_COMMAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "LightTypes.h"
+
+// Queue capacity (must be a power of two)
+#define COMMAND_QUEUE_CAPACITY 8
+
+// Number of completion slots kept for handlers waiting on a result
+#define COMMAND_RESULT_SLOTS   16
+
+// Reported by CommandQueue::result() when the slot was reused before the
+// result was read: the command was applied, but its outcome is unknown
+#define COMMAND_STATUS_RESULT_EVICTED 504
+
+// Command types pushed by network handlers and applied by the lighting loop
+enum CommandType : uint8_t {
+  CMD_SET_MODE,
+  CMD_SET_CHANNEL,
+  CMD_SET_ALL,
+  CMD_SET_HOUR,
+  CMD_SET_SCHEDULE,
+  CMD_SET_TIME,
+  CMD_TRANSITION,
+  CMD_PATCH_SCHEDULE,
+  CMD_PREVIEW
+};
+
+// Calendar time carried by time commands
+struct CommandTime {
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+};
+
+// One sparse schedule change: set one channel of one hour
+struct ScheduleDelta {
+  uint8_t hour;
+  uint8_t channel;  // LedChannel
+  uint8_t value;
+};
+
+// Upper bound of deltas in one CMD_PATCH_SCHEDULE
+#define SCHEDULE_PATCH_MAX 48
+
+// Parts of a CMD_TRANSITION that are present
+#define TRANSITION_MODE  0x01
+#define TRANSITION_FRAME 0x02
+#define TRANSITION_TIME  0x04
+
+// Small, copyable command. Payload is selected by type.
+struct ControlCommand {
+  CommandType type;
+  uint32_t seq;         // Assigned by CommandQueue::push()
+  uint32_t enqueuedAt;  // micros() at push, for latency metrics
+
+  union {
+    struct {
+      uint8_t mode;     // LightMode
+    } mode;
+    struct {
+      uint8_t channel;  // LedChannel
+      uint8_t value;
+    } channel;
+    LightProfile frame;
+    struct {
+      uint8_t hour;
+      LightProfile profile;
+    } hour;
+    struct {
+      uint32_t hourMask; // Bit N set = profiles[N] is valid
+      LightProfile profiles[24];
+    } schedule;
+    CommandTime time;
+    struct {
+      uint8_t flags;     // TRANSITION_* bits
+      uint8_t mode;      // LightMode, valid with TRANSITION_MODE
+      LightProfile frame; // Manual frame, valid with TRANSITION_FRAME
+      CommandTime time;  // Valid with TRANSITION_TIME
+      uint32_t hourMask; // Hour profiles to replace
+      LightProfile profiles[24];
+    } transition;
+    struct {
+      uint32_t baseVersion; // Schedule version the client edited against
+      uint8_t count;
+      ScheduleDelta deltas[SCHEDULE_PATCH_MAX];
+    } patch;
+    struct {
+      uint32_t durationMs; // Real time for the whole day; 0 stops a running preview
+    } preview;
+  };
+};
+
+// Queue counters exposed to the API
+struct CommandQueueStats {
+  uint32_t depth;
+  uint32_t maxDepth;
+  uint32_t pushed;
+  uint32_t rejected;      // Queue full
+  uint32_t applied;
+  uint32_t lastLatencyUs; // Push -> applied
+  uint32_t maxLatencyUs;
+  uint32_t avgLatencyUs;  // Exponential moving average
+};
+
+// Where decoded commands go: CommandQueue on the device, a recorder when the
+// codec and dispatcher are exercised on a host
+class CommandSink {
+public:
+  virtual ~CommandSink() {}
+
+  // Returns the seq assigned to the command, or 0 if it was not accepted
+  virtual uint32_t submit(ControlCommand& command) = 0;
+};
+
+// Bounded lock-free multi-producer / single-consumer ring (per-cell sequence
+// numbers). Producers are network tasks, the consumer is the lighting loop.
+// Results are published into a small ring of completion slots keyed by seq,
+// so a handler can poll for its own result without locks.
+class CommandQueue : public CommandSink {
+private:
+  struct Cell {
+    std::atomic<uint32_t> sequence;
+    ControlCommand command;
+  };
+
+  struct Result {
+    std::atomic<uint32_t> seq; // Written last (release) - marks the slot valid
+    std::atomic<uint32_t> status;
+    std::atomic<uint32_t> value;
+  };
+
+  Cell cells[COMMAND_QUEUE_CAPACITY];
+  std::atomic<uint32_t> enqueuePos;
+  std::atomic<uint32_t> dequeuePos;
+  std::atomic<uint32_t> nextSeq;
+
+  Result results[COMMAND_RESULT_SLOTS];
+
+  // Metrics
+  std::atomic<uint32_t> maxDepth;
+  std::atomic<uint32_t> pushedCount;
+  std::atomic<uint32_t> rejectedCount;
+  std::atomic<uint32_t> appliedCount;
+  std::atomic<uint32_t> lastLatencyUs;
+  std::atomic<uint32_t> maxLatencyUs;
+  std::atomic<uint32_t> avgLatencyUs;
+
+public:
+  CommandQueue();
+
+  // Producer side. Assigns command.seq and returns it, or 0 if the queue is full.
+  uint32_t push(ControlCommand& command);
+  uint32_t submit(ControlCommand& command) override { return push(command); }
+
+  // Consumer side (single consumer only)
+  bool pop(ControlCommand& command);
+  void complete(const ControlCommand& command, uint16_t status, uint32_t value);
+
+  // Look up the result of a command. Returns false while it is still pending.
+  // If the slot was already reused by a newer command, the status is
+  // COMMAND_STATUS_RESULT_EVICTED (it may have failed with 400 or 409).
+  bool result(uint32_t seq, uint16_t& status, uint32_t& value);
+
+  // Poll for a result for up to timeoutMs (yields between polls)
+  bool waitForResult(uint32_t seq, uint32_t timeoutMs, uint16_t& status, uint32_t& value);
+
+  uint32_t depth();
+  CommandQueueStats stats();
+};
+
+#endif // CONTROL_COMMAND_H
@@ -0,0 +1,14 @@
+#include "Crc32.h"
+
+uint32_t crc32(const void* data, size_t length) {
+  // Tanpa tabel: hanya ~20 byte kode, cukup cepat untuk blob beberapa ratus byte
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFFUL;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= bytes[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
@@ -0,0 +1,11 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE, reflected polynomial 0xEDB88320), bitwise without a table.
+// Used for the warm-restart frame and the NVS config records.
+uint32_t crc32(const void* data, size_t length);
+
+#endif // CRC32_H
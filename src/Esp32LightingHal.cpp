@@ -0,0 +1,166 @@
+#include "Esp32LightingHal.h"
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <Wire.h>
+
+#define DS3231_I2C_ADDRESS  0x68
+#define DS3231_REG_CONTROL  0x0E
+#define DS3231_REG_STATUS   0x0F
+#define DS3231_REG_AGING    0x10
+#define DS3231_CONTROL_CONV 0x20
+#define DS3231_STATUS_BSY   0x04
+
+// ========== PWM (LEDC) ==========
+
+Esp32PwmSink::Esp32PwmSink(const uint8_t* pins, const uint8_t* channels, uint32_t freq, uint8_t resolution) {
+  memcpy(this->pins, pins, LED_CHANNEL_COUNT);
+  memcpy(this->channels, channels, LED_CHANNEL_COUNT);
+  this->freq = freq;
+  this->resolution = resolution;
+}
+
+void Esp32PwmSink::begin() {
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    ledcSetup(channels[i], freq, resolution);
+    ledcAttachPin(pins[i], channels[i]);
+  }
+}
+
+void Esp32PwmSink::write(uint8_t channel, uint8_t duty) {
+  ledcWrite(channels[channel], duty);
+}
+
+uint32_t Esp32PwmSink::read(uint8_t channel) {
+  return ledcRead(channels[channel]);
+}
+
+// PWM tidak bisa ditahan melewati reset (LEDC ikut di-reset); tahan level terdekat.
+// Channel 0 dan penuh tepat; nilai di antaranya sesaat on/off sampai setup() berjalan.
+void Esp32PwmSink::latch(const uint8_t* frame) {
+  uint32_t half = 1UL << (resolution - 1);
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    ledcDetachPin(pins[i]);
+    pinMode(pins[i], OUTPUT);
+    digitalWrite(pins[i], frame[i] >= half ? HIGH : LOW);
+    gpio_hold_en((gpio_num_t)pins[i]);
+  }
+}
+
+// Lepas gpio_hold dari latch(); setelah ini pin mengikuti LEDC
+void Esp32PwmSink::releaseLatch() {
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    gpio_hold_dis((gpio_num_t)pins[i]);
+  }
+}
+
+// ========== NVS (Preferences) ==========
+
+bool Esp32KeyValueStore::begin(const char* name) {
+  return preferences.begin(name, false);
+}
+
+void Esp32KeyValueStore::end() {
+  preferences.end();
+}
+
+bool Esp32KeyValueStore::isKey(const char* key) {
+  return preferences.isKey(key);
+}
+
+size_t Esp32KeyValueStore::getBytesLength(const char* key) {
+  return preferences.getBytesLength(key);
+}
+
+size_t Esp32KeyValueStore::getBytes(const char* key, void* buffer, size_t length) {
+  return preferences.getBytes(key, buffer, length);
+}
+
+size_t Esp32KeyValueStore::putBytes(const char* key, const void* value, size_t length) {
+  return preferences.putBytes(key, value, length);
+}
+
+bool Esp32KeyValueStore::remove(const char* key) {
+  return preferences.remove(key);
+}
+
+bool Esp32KeyValueStore::getBool(const char* key, bool defaultValue) {
+  return preferences.getBool(key, defaultValue);
+}
+
+uint8_t Esp32KeyValueStore::getUChar(const char* key, uint8_t defaultValue) {
+  return preferences.getUChar(key, defaultValue);
+}
+
+size_t Esp32KeyValueStore::getString(const char* key, char* buffer, size_t length) {
+  return preferences.getString(key, buffer, length);
+}
+
+// ========== RTC (DS3231) ==========
+
+CommandTime Ds3231Clock::now() {
+  CommandTime time;
+  // Chip tidak menjawab (kabel lepas, RTC rusak): jam tidak valid, bukan isi buffer lama
+  Wire.beginTransmission(DS3231_I2C_ADDRESS);
+  if (Wire.endTransmission() != 0) {
+    time = {0, 0, 0, 0xFF, 0, 0};
+    return time;
+  }
+  DateTime now = rtc->now();
+  time.year = now.year();
+  time.month = now.month();
+  time.day = now.day();
+  time.hour = now.hour();
+  time.minute = now.minute();
+  time.second = now.second();
+  return time;
+}
+
+void Ds3231Clock::adjust(const CommandTime& time) {
+  rtc->adjust(DateTime(time.year, time.month, time.day, time.hour, time.minute, time.second));
+}
+
+static bool readDs3231Register(uint8_t reg, uint8_t& value) {
+  Wire.beginTransmission(DS3231_I2C_ADDRESS);
+  Wire.write(reg);
+  if (Wire.endTransmission() != 0 || Wire.requestFrom(DS3231_I2C_ADDRESS, 1) != 1) {
+    return false;
+  }
+  value = Wire.read();
+  return true;
+}
+
+static bool writeDs3231Register(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(DS3231_I2C_ADDRESS);
+  Wire.write(reg);
+  Wire.write(value);
+  return Wire.endTransmission() == 0;
+}
+
+bool Ds3231Clock::readAgingOffset(int8_t& value) {
+  uint8_t raw;
+  if (!readDs3231Register(DS3231_REG_AGING, raw)) {
+    return false;
+  }
+  value = (int8_t)raw;
+  return true;
+}
+
+bool Ds3231Clock::writeAgingOffset(int8_t value) {
+  if (!writeDs3231Register(DS3231_REG_AGING, (uint8_t)value)) {
+    return false;
+  }
+  // Konversi suhu paksa (CONV) hanya jika tidak sedang konversi (BSY); jika sibuk,
+  // trim baru dipakai pada konversi otomatis berikutnya
+  uint8_t status, control;
+  if (readDs3231Register(DS3231_REG_STATUS, status) && !(status & DS3231_STATUS_BSY) &&
+      readDs3231Register(DS3231_REG_CONTROL, control)) {
+    writeDs3231Register(DS3231_REG_CONTROL, control | DS3231_CONTROL_CONV);
+  }
+  return true;
+}
+
+// ========== MONOTONIC TIMER ==========
+
+uint64_t EspTimerClock::uptimeUs() {
+  return (uint64_t)esp_timer_get_time();
+}
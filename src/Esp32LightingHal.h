@@ -0,0 +1,72 @@
+#ifndef ESP32_LIGHTING_HAL_H
+#define ESP32_LIGHTING_HAL_H
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include <Preferences.h>
+#include "LightingHal.h"
+
+// LEDC channels, one per LED pin. latch() detaches LEDC and holds each pin
+// with gpio_hold, which survives a software reset (LEDC itself does not).
+class Esp32PwmSink : public PwmSink {
+private:
+  uint8_t pins[LED_CHANNEL_COUNT];
+  uint8_t channels[LED_CHANNEL_COUNT];
+  uint32_t freq;
+  uint8_t resolution;
+
+public:
+  // pins and channels in LedChannel order
+  Esp32PwmSink(const uint8_t* pins, const uint8_t* channels, uint32_t freq, uint8_t resolution);
+
+  void begin() override;
+  void write(uint8_t channel, uint8_t duty) override;
+  uint32_t read(uint8_t channel) override;
+  void latch(const uint8_t* frame) override;
+  void releaseLatch() override;
+};
+
+// KeyValueStore on one Preferences (NVS) namespace
+class Esp32KeyValueStore : public KeyValueStore {
+private:
+  Preferences preferences;
+
+public:
+  bool begin(const char* name) override;
+  void end() override;
+
+  bool isKey(const char* key) override;
+  size_t getBytesLength(const char* key) override;
+  size_t getBytes(const char* key, void* buffer, size_t length) override;
+  size_t putBytes(const char* key, const void* value, size_t length) override;
+  bool remove(const char* key) override;
+
+  bool getBool(const char* key, bool defaultValue) override;
+  uint8_t getUChar(const char* key, uint8_t defaultValue) override;
+  size_t getString(const char* key, char* buffer, size_t length) override;
+};
+
+// DS3231 over I2C (rtc.begin() is called by the sketch). now() checks that
+// the chip answers first: RTClib does not report a failed read.
+class Ds3231Clock : public WallClock {
+private:
+  RTC_DS3231* rtc;
+
+public:
+  explicit Ds3231Clock(RTC_DS3231* rtc) : rtc(rtc) {}
+
+  CommandTime now() override;
+  void adjust(const CommandTime& time) override;
+
+  // Register 0x10; a write also starts a temperature conversion so the new
+  // trim applies right away instead of at the next 64 s conversion
+  bool readAgingOffset(int8_t& value) override;
+  bool writeAgingOffset(int8_t value) override;
+};
+
+class EspTimerClock : public MonotonicClock {
+public:
+  uint64_t uptimeUs() override;
+};
+
+#endif // ESP32_LIGHTING_HAL_H
@@ -0,0 +1,105 @@
+#include "Esp32WiFiDriver.h"
+#include "esp_wifi.h"
+#include "Trace.h"
+
+// IP statis AP
+static const IPAddress AP_LOCAL_IP(192, 168, 4, 1);
+static const IPAddress AP_GATEWAY(192, 168, 4, 1);
+static const IPAddress AP_SUBNET(255, 255, 255, 0);
+
+Esp32WiFiDriver::Esp32WiFiDriver() {
+  this->eventHandlerId = 0;
+  this->handlerRegistered = false;
+}
+
+Esp32WiFiDriver::~Esp32WiFiDriver() {
+  if (handlerRegistered) {
+    WiFi.removeEvent(eventHandlerId);
+  }
+}
+
+void Esp32WiFiDriver::begin() {
+  if (handlerRegistered) return;
+  
+  // Dipanggil dari task event WiFi: hanya set bit event, diproses oleh WiFiLink di loop
+  eventHandlerId = WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+    switch (event) {
+      case ARDUINO_EVENT_WIFI_AP_START:
+        post(WIFI_EVENT_AP_START);
+        break;
+      case ARDUINO_EVENT_WIFI_AP_STOP:
+        post(WIFI_EVENT_AP_STOP);
+        break;
+      case ARDUINO_EVENT_WIFI_AP_STACONNECTED:
+        post(WIFI_EVENT_STA_JOIN);
+        break;
+      case ARDUINO_EVENT_WIFI_AP_STADISCONNECTED:
+        post(WIFI_EVENT_STA_LEAVE);
+        break;
+      default:
+        break;
+    }
+  });
+  handlerRegistered = true;
+}
+
+void Esp32WiFiDriver::shutdown() {
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+}
+
+void Esp32WiFiDriver::resetStep(WiFiResetStep step) {
+  TRACE_SCOPE("wifi", "resetStep");
+  // Reset driver ESP-IDF yang lebih menyeluruh, satu langkah per panggilan
+  switch (step) {
+    case WIFI_RESET_STOP:
+      log("WiFi: performing driver reset...");
+      esp_wifi_stop();
+      break;
+    case WIFI_RESET_DEINIT:
+      esp_wifi_deinit();
+      break;
+    case WIFI_RESET_INIT: {
+      wifi_init_config_t config = WIFI_INIT_CONFIG_DEFAULT();
+      esp_wifi_init(&config);
+      break;
+    }
+    case WIFI_RESET_START:
+      esp_wifi_start();
+      break;
+    default:
+      break;
+  }
+}
+
+bool Esp32WiFiDriver::enableAP() {
+  TRACE_SCOPE("wifi", "enableAP");
+  if (!WiFi.mode(WIFI_AP)) {
+    return false;
+  }
+  WiFi.setTxPower(WIFI_POWER_19_5dBm); // Set TX power ke level maximum
+  return true;
+}
+
+bool Esp32WiFiDriver::configureAP() {
+  TRACE_SCOPE("wifi", "configureAP");
+  return WiFi.softAPConfig(AP_LOCAL_IP, AP_GATEWAY, AP_SUBNET);
+}
+
+bool Esp32WiFiDriver::startAP(const char* ssid, const char* password) {
+  TRACE_SCOPE("wifi", "startAP");
+  // channel=1, ssid_hidden=0, max_connection=4
+  return WiFi.softAP(ssid, password, 1, 0, 4);
+}
+
+bool Esp32WiFiDriver::addressValid() {
+  return WiFi.softAPIP() == AP_LOCAL_IP;
+}
+
+uint8_t Esp32WiFiDriver::stationCount() {
+  return WiFi.softAPgetStationNum();
+}
+
+void Esp32WiFiDriver::log(const char* message) {
+  Serial.println(message);
+}
@@ -0,0 +1,32 @@
+#ifndef ESP32_WIFI_DRIVER_H
+#define ESP32_WIFI_DRIVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "WiFiDriver.h"
+
+// WiFiDriver on top of the Arduino WiFi class and esp_wifi_* calls.
+// AP start/stop and station events arrive through WiFi.onEvent().
+class Esp32WiFiDriver : public WiFiDriver {
+private:
+  wifi_event_id_t eventHandlerId;
+  bool handlerRegistered;
+
+public:
+  Esp32WiFiDriver();
+  ~Esp32WiFiDriver();
+
+  // Register for WiFi events (call once before WiFiLink::start)
+  void begin();
+
+  void shutdown() override;
+  void resetStep(WiFiResetStep step) override;
+  bool enableAP() override;
+  bool configureAP() override;
+  bool startAP(const char* ssid, const char* password) override;
+  bool addressValid() override;
+  uint8_t stationCount() override;
+  void log(const char* message) override;
+};
+
+#endif // ESP32_WIFI_DRIVER_H
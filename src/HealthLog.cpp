@@ -0,0 +1,64 @@
+#include "HealthLog.h"
+#include "NvsWear.h"
+#include "Trace.h"
+
+HealthLog::HealthLog() {
+  memset(&blob, 0, sizeof(blob));
+  blob.format = HEALTH_LOG_FORMAT;
+  opened = false;
+}
+
+void HealthLog::begin() {
+  opened = preferences.begin(HEALTH_LOG_NAMESPACE, false);
+  if (!opened) {
+    Serial.println("WARNING: Health log namespace could not be opened");
+    return;
+  }
+
+  Blob stored;
+  if (preferences.getBytesLength(HEALTH_LOG_KEY) == sizeof(stored) &&
+      preferences.getBytes(HEALTH_LOG_KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+      stored.format == HEALTH_LOG_FORMAT && stored.head < HEALTH_LOG_ENTRIES) {
+    blob = stored;
+  }
+}
+
+void HealthLog::record(const HealthDecision& decision, const HealthSample& sample, uint32_t uptimeSeconds) {
+  // Nomor urut melanjutkan entri terbaru, juga setelah reboot
+  uint8_t newest = (blob.head + HEALTH_LOG_ENTRIES - 1) % HEALTH_LOG_ENTRIES;
+  uint32_t minStack = healthMinStackFree(sample);
+
+  HealthLogEntry& slot = blob.entries[blob.head];
+  slot.sequence = blob.entries[newest].sequence + 1;
+  slot.uptime = uptimeSeconds;
+  slot.freeHeap = sample.freeHeap;
+  slot.largestBlock = sample.largestBlock;
+  slot.action = decision.action;
+  slot.condition = decision.condition;
+  slot.minStackFree = minStack > 0xFFFF ? 0xFFFF : minStack;
+  blob.head = (blob.head + 1) % HEALTH_LOG_ENTRIES;
+
+  if (!opened) return;
+  TRACE_SCOPE("nvs", "writeHealthLog");
+  if (preferences.putBytes(HEALTH_LOG_KEY, &blob, sizeof(blob)) != sizeof(blob)) {
+    Serial.println("WARNING: Failed to write health log");
+  }
+  nvsWear.recordWrite(HEALTH_LOG_NAMESPACE, HEALTH_LOG_KEY, NVS_VALUE_BLOB, sizeof(blob));
+}
+
+uint8_t HealthLog::count() {
+  uint8_t used = 0;
+  for (uint8_t i = 0; i < HEALTH_LOG_ENTRIES; i++) {
+    if (blob.entries[i].sequence != 0) used++;
+  }
+  return used;
+}
+
+bool HealthLog::entry(uint8_t index, HealthLogEntry& out) {
+  uint8_t used = count();
+  if (index >= used) return false;
+  // Ring penuh: yang tertua ada di head; belum penuh: mulai dari slot 0
+  uint8_t first = (used == HEALTH_LOG_ENTRIES) ? blob.head : 0;
+  out = blob.entries[(first + index) % HEALTH_LOG_ENTRIES];
+  return true;
+}
@@ -0,0 +1,52 @@
+#ifndef HEALTH_LOG_H
+#define HEALTH_LOG_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "HealthMonitor.h"
+
+// Recovery decisions kept in NVS as one fixed-size ring blob, so the reason
+// for the last reboots is still readable after them. Written only when the
+// health monitor acts (rare), never on the sampling path.
+#define HEALTH_LOG_NAMESPACE "health"
+#define HEALTH_LOG_KEY       "log"
+#define HEALTH_LOG_FORMAT    1
+#define HEALTH_LOG_ENTRIES   12  // Fits the shared response buffer as JSON
+
+struct HealthLogEntry {
+  uint32_t sequence;      // Increases across reboots, 0 = empty slot
+  uint32_t uptime;        // Seconds since boot when the decision was taken
+  uint32_t freeHeap;
+  uint32_t largestBlock;
+  uint8_t action;         // HealthAction
+  uint8_t condition;      // HealthCondition
+  uint16_t minStackFree;  // Lowest stack high-water mark (bytes) in the sample
+};
+
+class HealthLog {
+private:
+  Preferences preferences;
+
+  struct Blob {
+    uint8_t format;
+    uint8_t head;         // Next slot to write
+    uint16_t reserved;
+    HealthLogEntry entries[HEALTH_LOG_ENTRIES];
+  };
+  Blob blob;
+  bool opened;
+
+public:
+  HealthLog();
+
+  // Open the namespace and load the ring (empty if missing or another format)
+  void begin();
+
+  void record(const HealthDecision& decision, const HealthSample& sample, uint32_t uptimeSeconds);
+
+  // Oldest first. Returns false past the last entry.
+  bool entry(uint8_t index, HealthLogEntry& out);
+  uint8_t count();
+};
+
+#endif // HEALTH_LOG_H
@@ -0,0 +1,196 @@
+#include "HealthMonitor.h"
+
+const char* const HEALTH_TASK_NAMES[HEALTH_TASK_COUNT] = {
+  "lighting", "network", "async_tcp", "persist", "nimble_host"
+};
+
+const char* const HEALTH_ACTION_NAMES[HEALTH_ACTION_COUNT] = {
+  "none", "restart_http", "restart_ap", "restart_lighting", "reboot"
+};
+
+const char* const HEALTH_CONDITION_NAMES[HEALTH_CONDITION_COUNT] = {
+  "ok", "heap_leak", "heap_exhausted", "heap_fragmented", "stack_low",
+  "event_backlog", "ap_down", "output_mismatch", "escalated"
+};
+
+// Jeda minimum antar tindakan per subsistem. Output lampu yang salah harus
+// cepat dibetulkan; restart HTTP/AP perlu waktu untuk terlihat hasilnya.
+static const uint32_t ACTION_COOLDOWN_MS[HEALTH_ACTION_COUNT] = {
+  0, HEALTH_ACTION_COOLDOWN_MS, HEALTH_AP_DOWN_RESTART_MS, 60000UL, 0
+};
+
+// Tunggu sebentar setelah restart HTTP sebelum heap yang masih kritis dianggap gagal pulih
+#define HEALTH_EXHAUSTED_GRACE_MS  60000UL
+
+uint32_t healthMinStackFree(const HealthSample& sample) {
+  uint32_t lowest = 0;
+  for (uint8_t i = 0; i < HEALTH_TASK_COUNT; i++) {
+    uint32_t free = sample.stackFree[i];
+    if (free != 0 && (lowest == 0 || free < lowest)) {
+      lowest = free;
+    }
+  }
+  return lowest;
+}
+
+HealthMonitor::HealthMonitor() {
+  clearWindow();
+  backlogSamples = 0;
+  apDown = false;
+  apDownSince = 0;
+  apRestartedThisOutage = false;
+  for (uint8_t i = 0; i < HEALTH_ACTION_COUNT; i++) {
+    subsystems[i].attempts = 0;
+    subsystems[i].lastAction = 0;
+    actionCounts[i] = 0;
+  }
+  lastUnhealthy = 0;
+  last = HealthSample{0, 0, {0}, 0, false, true};
+  lastDecision = HealthDecision{HEALTH_ACTION_NONE, HEALTH_OK};
+}
+
+void HealthMonitor::clearWindow() {
+  windowCount = 0;
+  windowHead = 0;
+}
+
+void HealthMonitor::push(const HealthSample& sample) {
+  heapWindow[windowHead] = sample.freeHeap;
+  blockWindow[windowHead] = sample.largestBlock;
+  windowHead = (windowHead + 1) % HEALTH_WINDOW;
+  if (windowCount < HEALTH_WINDOW) {
+    windowCount++;
+  }
+}
+
+// Kemiringan least-squares heap bebas (byte per menit) atas seluruh jendela.
+// Satu sampel yang turun-naik (mis. satu request besar) hampir tidak berpengaruh;
+// kebocoran yang konsisten memberi kemiringan negatif yang stabil.
+int32_t HealthMonitor::heapSlopePerMinute() {
+  if (windowCount < HEALTH_WINDOW) {
+    return 0;
+  }
+  int64_t n = HEALTH_WINDOW;
+  int64_t sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+  for (uint8_t i = 0; i < HEALTH_WINDOW; i++) {
+    int64_t x = i;
+    int64_t y = heapWindow[(windowHead + i) % HEALTH_WINDOW];  // Tertua dulu
+    sumX += x;
+    sumY += y;
+    sumXY += x * y;
+    sumXX += x * x;
+  }
+  int64_t denominator = n * sumXX - sumX * sumX;
+  int64_t perSample = n * sumXY - sumX * sumY;
+  return (int32_t)(perSample * (60000 / HEALTH_SAMPLE_INTERVAL_MS) / denominator);
+}
+
+bool HealthMonitor::fragmentedWholeWindow() {
+  if (windowCount < HEALTH_WINDOW) {
+    return false;
+  }
+  for (uint8_t i = 0; i < HEALTH_WINDOW; i++) {
+    uint32_t block = blockWindow[i];
+    if (block >= HEALTH_FRAGMENT_BLOCK || heapWindow[i] < block * HEALTH_FRAGMENT_RATIO) {
+      return false;
+    }
+  }
+  return true;
+}
+
+HealthDecision HealthMonitor::act(HealthAction action, HealthCondition condition, uint32_t now) {
+  Subsystem& subsystem = subsystems[action];
+
+  if (action != HEALTH_ACTION_REBOOT && subsystem.attempts > 0) {
+    if (now - subsystem.lastAction < ACTION_COOLDOWN_MS[action]) {
+      // Sudah ditangani, tunggu hasilnya
+      return HealthDecision{HEALTH_ACTION_NONE, condition};
+    }
+    if (subsystem.attempts >= HEALTH_MAX_RESTARTS) {
+      // Restart subsistem berulang kali tidak menolong -> reboot penuh
+      action = HEALTH_ACTION_REBOOT;
+      condition = HEALTH_ESCALATED;
+    }
+  }
+
+  Subsystem& target = subsystems[action];
+  if (target.attempts < 0xFF) {
+    target.attempts++;
+  }
+  target.lastAction = now;
+  actionCounts[action]++;
+
+  if (action == HEALTH_ACTION_RESTART_HTTP) {
+    // Tren heap harus diukur ulang setelah pemulihan
+    clearWindow();
+    backlogSamples = 0;
+  }
+
+  return HealthDecision{action, condition};
+}
+
+HealthDecision HealthMonitor::update(const HealthSample& sample, uint32_t now) {
+  last = sample;
+  push(sample);
+
+  backlogSamples = sample.eventBacklog >= HEALTH_BACKLOG_LIMIT ? backlogSamples + 1 : 0;
+
+  if (sample.apUp) {
+    apDown = false;
+    apRestartedThisOutage = false;
+  } else if (!apDown) {
+    apDown = true;
+    apDownSince = now;
+  }
+
+  HealthDecision decision = {HEALTH_ACTION_NONE, HEALTH_OK};
+  uint32_t stackFree = healthMinStackFree(sample);
+
+  // Urutan = prioritas: kondisi yang bisa membuat crash dulu
+  if (stackFree != 0 && stackFree < HEALTH_STACK_CRITICAL) {
+    // Stack tidak bisa diperbesar saat runtime; reboot terkendali lebih baik dari overflow
+    decision = act(HEALTH_ACTION_REBOOT, HEALTH_STACK_LOW, now);
+  } else if (sample.freeHeap < HEALTH_HEAP_CRITICAL) {
+    Subsystem& http = subsystems[HEALTH_ACTION_RESTART_HTTP];
+    if (http.attempts > 0 && now - http.lastAction < HEALTH_ACTION_COOLDOWN_MS) {
+      if (now - http.lastAction >= HEALTH_EXHAUSTED_GRACE_MS) {
+        decision = act(HEALTH_ACTION_REBOOT, HEALTH_ESCALATED, now);
+      } else {
+        decision = HealthDecision{HEALTH_ACTION_NONE, HEALTH_HEAP_EXHAUSTED};
+      }
+    } else {
+      decision = act(HEALTH_ACTION_RESTART_HTTP, HEALTH_HEAP_EXHAUSTED, now);
+    }
+  } else if (!sample.outputMatches) {
+    decision = act(HEALTH_ACTION_RESTART_LIGHTING, HEALTH_OUTPUT_MISMATCH, now);
+  } else if (apDown && now - apDownSince >= HEALTH_AP_DOWN_REBOOT_MS) {
+    decision = act(HEALTH_ACTION_REBOOT, HEALTH_AP_DOWN, now);
+  } else if (apDown && now - apDownSince >= HEALTH_AP_DOWN_RESTART_MS) {
+    if (apRestartedThisOutage) {
+      decision = HealthDecision{HEALTH_ACTION_NONE, HEALTH_AP_DOWN};
+    } else {
+      decision = act(HEALTH_ACTION_RESTART_AP, HEALTH_AP_DOWN, now);
+      apRestartedThisOutage = true;
+    }
+  } else if (backlogSamples >= HEALTH_BACKLOG_SAMPLES) {
+    decision = act(HEALTH_ACTION_RESTART_HTTP, HEALTH_EVENT_BACKLOG, now);
+  } else if (sample.freeHeap < HEALTH_HEAP_LOW && heapSlopePerMinute() <= -HEALTH_LEAK_BYTES_PER_MIN) {
+    decision = act(HEALTH_ACTION_RESTART_HTTP, HEALTH_HEAP_LEAK, now);
+  } else if (fragmentedWholeWindow()) {
+    decision = act(HEALTH_ACTION_RESTART_HTTP, HEALTH_HEAP_FRAGMENTED, now);
+  } else if (stackFree != 0 && stackFree < HEALTH_STACK_WARN) {
+    // Dicatat saja; belum ada tindakan yang bisa menolong
+    decision = HealthDecision{HEALTH_ACTION_NONE, HEALTH_STACK_LOW};
+  }
+
+  if (decision.condition != HEALTH_OK) {
+    lastUnhealthy = now;
+  } else if (now - lastUnhealthy >= HEALTH_ATTEMPT_RESET_MS) {
+    for (uint8_t i = 0; i < HEALTH_ACTION_COUNT; i++) {
+      subsystems[i].attempts = 0;
+    }
+  }
+
+  lastDecision = decision;
+  return decision;
+}
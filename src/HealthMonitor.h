@@ -0,0 +1,133 @@
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <stdint.h>
+
+// Sampling
+#define HEALTH_SAMPLE_INTERVAL_MS   10000
+#define HEALTH_WINDOW               30      // Samples in the trend window (5 minutes)
+
+// Heap
+#define HEALTH_HEAP_LOW             65536   // Leak trend only matters below this
+#define HEALTH_HEAP_CRITICAL        20480   // Act immediately below this
+#define HEALTH_LEAK_BYTES_PER_MIN   256     // Sustained loss that counts as a leak
+#define HEALTH_FRAGMENT_BLOCK       12288   // Largest block below this for a whole window...
+#define HEALTH_FRAGMENT_RATIO       4       // ...while free heap is this many times larger
+
+// Stack (bytes left at the high-water mark)
+#define HEALTH_STACK_WARN           1024
+#define HEALTH_STACK_CRITICAL       256
+
+// SSE backlog (average messages waiting per client) sustained for this many samples
+#define HEALTH_BACKLOG_LIMIT        8
+#define HEALTH_BACKLOG_SAMPLES      6
+
+// Access point down (never up, or lost and not recovered by WiFiLink)
+#define HEALTH_AP_DOWN_RESTART_MS   900000UL   // 15 min -> AP restart
+#define HEALTH_AP_DOWN_REBOOT_MS    3600000UL  // 60 min -> reboot
+
+// Escalation
+#define HEALTH_MAX_RESTARTS         3          // Subsystem restarts per hour before rebooting
+#define HEALTH_ACTION_COOLDOWN_MS   600000UL   // Minimum time between actions on one subsystem
+#define HEALTH_ATTEMPT_RESET_MS     3600000UL  // Healthy this long -> attempt counters reset
+
+enum HealthAction : uint8_t {
+  HEALTH_ACTION_NONE,
+  HEALTH_ACTION_RESTART_HTTP,      // Close clients, restart the listener
+  HEALTH_ACTION_RESTART_AP,        // Fresh WiFiLink attempt with driver reset
+  HEALTH_ACTION_RESTART_LIGHTING,  // Re-init LEDC and re-apply the frame
+  HEALTH_ACTION_REBOOT,            // Last resort (warm restart keeps the output)
+  HEALTH_ACTION_COUNT
+};
+
+enum HealthCondition : uint8_t {
+  HEALTH_OK,
+  HEALTH_HEAP_LEAK,
+  HEALTH_HEAP_EXHAUSTED,
+  HEALTH_HEAP_FRAGMENTED,
+  HEALTH_STACK_LOW,
+  HEALTH_EVENT_BACKLOG,
+  HEALTH_AP_DOWN,
+  HEALTH_OUTPUT_MISMATCH,
+  HEALTH_ESCALATED,           // Subsystem restarts did not help
+  HEALTH_CONDITION_COUNT
+};
+
+// Tasks whose stack high-water mark is sampled (see the task plan in main.cpp)
+enum HealthTask : uint8_t {
+  HEALTH_TASK_LIGHTING,
+  HEALTH_TASK_NETWORK,
+  HEALTH_TASK_ASYNC_TCP,
+  HEALTH_TASK_PERSIST,
+  HEALTH_TASK_BLE,
+  HEALTH_TASK_COUNT
+};
+
+extern const char* const HEALTH_TASK_NAMES[HEALTH_TASK_COUNT];
+extern const char* const HEALTH_ACTION_NAMES[HEALTH_ACTION_COUNT];
+extern const char* const HEALTH_CONDITION_NAMES[HEALTH_CONDITION_COUNT];
+
+// One observation of the system, filled in by the caller
+struct HealthSample {
+  uint32_t freeHeap;
+  uint32_t largestBlock;
+  uint32_t stackFree[HEALTH_TASK_COUNT];  // Bytes never used (0 = task not running)
+  uint32_t eventBacklog;      // SSE messages waiting per client (average)
+  bool apUp;
+  bool outputMatches;         // LEDC duty registers equal the last written frame
+};
+
+// Lowest known stack high-water mark in the sample, 0 if none is known
+uint32_t healthMinStackFree(const HealthSample& sample);
+
+struct HealthDecision {
+  HealthAction action;
+  HealthCondition condition;
+};
+
+// Turns periodic samples into recovery decisions. Pure logic: no Arduino
+// calls, time is passed in, so it can run on the host. The caller executes
+// the action and logs it.
+class HealthMonitor {
+private:
+  uint32_t heapWindow[HEALTH_WINDOW];
+  uint32_t blockWindow[HEALTH_WINDOW];
+  uint8_t windowCount;
+  uint8_t windowHead;
+
+  uint8_t backlogSamples;
+  bool apDown;
+  uint32_t apDownSince;
+  bool apRestartedThisOutage;
+
+  struct Subsystem {
+    uint8_t attempts;
+    uint32_t lastAction;      // 0 = never
+  };
+  Subsystem subsystems[HEALTH_ACTION_COUNT];
+
+  uint32_t lastUnhealthy;
+  HealthSample last;
+  HealthDecision lastDecision;
+  uint32_t actionCounts[HEALTH_ACTION_COUNT];
+
+  void push(const HealthSample& sample);
+  void clearWindow();
+  int32_t heapSlopePerMinute();
+  bool fragmentedWholeWindow();
+  HealthDecision act(HealthAction action, HealthCondition condition, uint32_t now);
+
+public:
+  HealthMonitor();
+
+  // Call every HEALTH_SAMPLE_INTERVAL_MS. now = millis().
+  HealthDecision update(const HealthSample& sample, uint32_t now);
+
+  const HealthSample& getLastSample() { return last; }
+  HealthDecision getLastDecision() { return lastDecision; }
+  int32_t getHeapTrend() { return heapSlopePerMinute(); }
+  uint32_t getActionCount(HealthAction action) { return actionCounts[action]; }
+  uint8_t getAttempts(HealthAction action) { return subsystems[action].attempts; }
+};
+
+#endif // HEALTH_MONITOR_H
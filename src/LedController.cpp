@@ -1,243 +1,240 @@
 #include "LedController.h"
+#include "ControlCommand.h"
+#include "CommandCodec.h"
+#include "NvsWear.h"
+#include "WarmRestart.h"
+#include "Trace.h"
+#include <ArduinoJson.h>
 
-LedController::LedController(
-  uint8_t pinRoyalBlue, uint8_t pinBlue, uint8_t pinUV, uint8_t pinViolet,
-  uint8_t pinRed, uint8_t pinGreen, uint8_t pinWhite,
-  uint8_t channelRoyalBlue, uint8_t channelBlue, uint8_t channelUV, uint8_t channelViolet,
-  uint8_t channelRed, uint8_t channelGreen, uint8_t channelWhite,
-  uint32_t freq, uint8_t resolution,
-  RTC_DS3231* rtc
-) {
-  // Store pin configurations
-  this->pinRoyalBlue = pinRoyalBlue;
-  this->pinBlue = pinBlue;
-  this->pinUV = pinUV;
-  this->pinViolet = pinViolet;
-  this->pinRed = pinRed;
-  this->pinGreen = pinGreen;
-  this->pinWhite = pinWhite;
-  
-  // Store channel configurations
-  this->channelRoyalBlue = channelRoyalBlue;
-  this->channelBlue = channelBlue;
-  this->channelUV = channelUV;
-  this->channelViolet = channelViolet;
-  this->channelRed = channelRed;
-  this->channelGreen = channelGreen;
-  this->channelWhite = channelWhite;
-  
-  // Store PWM properties
-  this->freq = freq;
-  this->resolution = resolution;
-  
-  // Store RTC reference
-  this->rtc = rtc;
+LedController::LedController(PwmSink* pwm, KeyValueStore* store, WallClock* clock)
+  : config(store, LED_STORE_NAMESPACE) {
+  // Store hardware references
+  this->pwm = pwm;
+  this->store = store;
+  this->clock = clock;
   
   // Default to auto mode
   this->manualMode = false;
   this->offMode = false;
   
+  // Output awal dan versi jadwal
+  this->outputProfile = {0, 0, 0, 0, 0, 0, 0};
+  this->scheduleVersion = 0;
+  this->manualProfile = {0, 0, 0, 0, 0, 0, 0};
+  this->hasManualProfile = false;
+  this->pendingWrites = 0;
+  this->pendingHourMask = 0;
+  this->stagedWrites = 0;
+  this->stagedHourMask = 0;
+  this->stagedFirstMs = 0;
+  this->stagedLastMs = 0;
+  this->outputRestored = false;
+  this->pwmReady = false;
+  this->warmBoot = false;
+  this->previewActive = false;
+  this->previewStart = 0;
+  this->previewDurationMs = 0;
+  
   // Initialize hourly schedule with all zeros (user must configure)
   for (int i = 0; i < 24; i++) {
     hourlySchedule[i].hour = i;
     hourlySchedule[i].profile = {0, 0, 0, 0, 0, 0, 0};
+    hourVersion[i] = 0;
   }
+  publishSnapshot();
 }
 
-void LedController::begin() {
-  // Configure LED pins for PWM
-  ledcSetup(channelRoyalBlue, freq, resolution);
-  ledcAttachPin(pinRoyalBlue, channelRoyalBlue);
-  
-  ledcSetup(channelBlue, freq, resolution);
-  ledcAttachPin(pinBlue, channelBlue);
-  
-  ledcSetup(channelUV, freq, resolution);
-  ledcAttachPin(pinUV, channelUV);
-  
-  ledcSetup(channelViolet, freq, resolution);
-  ledcAttachPin(pinViolet, channelViolet);
-  
-  ledcSetup(channelRed, freq, resolution);
-  ledcAttachPin(pinRed, channelRed);
+void LedController::setupPwm() {
+  pwm->begin();
+  pwmReady = true;
+}
+
+bool LedController::restoreWarmOutput(bool resetIsWarm) {
+  WarmRestartState& state = warmRestartMemory();
+  if (!warmRestartTake(state, resetIsWarm)) {
+    return false;
+  }
   
-  ledcSetup(channelGreen, freq, resolution);
-  ledcAttachPin(pinGreen, channelGreen);
+  // Duty diset selagi pin masih di-latch, baru latch dilepas: tidak ada glitch ke 0
+  LightProfile frame;
+  static_assert(sizeof(LightProfile) == WARM_RESTART_CHANNELS, "LightProfile layout must match WarmRestartState::frame");
+  memcpy(&frame, state.frame, sizeof(frame));
+  setupPwm();
+  writeOutput(frame);
+  pwm->releaseLatch();
+  warmBoot = true;
+  return true;
+}
+
+void LedController::prepareForRestart() {
+  flushPendingWrites();
+  pwm->latch((const uint8_t*)&outputProfile);
+  warmRestartSetHeld(warmRestartMemory(), true);
+}
+
+bool LedController::outputMatches() {
+  if (!pwmReady) return true;  // Belum ada output yang bisa dibandingkan
+  const uint8_t* frame = (const uint8_t*)&outputProfile;
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    if (pwm->read(i) != frame[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LedController::recoverOutput() {
+  setupPwm();
+  writeOutput(outputProfile);
+  Serial.println("LED output re-initialized");
+}
+
+void LedController::restoreOutput() {
+  if (outputRestored) return;
+  outputRestored = true;
   
-  ledcSetup(channelWhite, freq, resolution);
-  ledcAttachPin(pinWhite, channelWhite);
+  // Setelah warm restart PWM sudah berjalan dengan frame sebelum reset
+  if (!pwmReady) {
+    setupPwm();
+  }
   
   // Initialize preferences
-  preferences.begin("led_ctrl", false);
+  store->begin(LED_STORE_NAMESPACE);
   
-  // Load saved profiles and settings from preferences
-  loadPreferences();
-  
-  // Load hourly schedule from preferences
-  loadHourlyScheduleFromPreferences();
-  
-  // Jika dalam auto mode (bukan manual dan bukan off), terapkan jadwal segera
-  if (!manualMode && !offMode) {
-    Serial.println("Auto mode active on startup - applying scheduled profile");
-    LightProfile currentProfile = getCurrentProfile();
-    setLightProfile(currentProfile);
+  // Satu record berisi mode, nilai manual dan jadwal; format lama dimigrasi sekali
+  if (!loadConfigRecord()) {
+    migrateLegacyConfig();
   }
   
+  writeModeOutput();
+  pwm->releaseLatch();
+}
+
+void LedController::begin() {
+  restoreOutput();
+  
   Serial.println("LED Controller initialized");
+  if (warmBoot) {
+    Serial.print("Warm restart: output kept from before reset (warm boot #");
+    Serial.print(warmRestartMemory().warmBoots);
+    Serial.println(")");
+  }
   Serial.print("Initial mode: ");
   if (offMode) {
     Serial.println("OFF");
   } else if (manualMode) {
-    Serial.println("MANUAL");
+    Serial.println(hasManualProfile ? "MANUAL" : "MANUAL (no saved values, LEDs off)");
   } else {
     Serial.println("AUTO");
   }
+  printCurrentProfile(outputProfile);
+}
+
+void LedController::fillConfigRecord(ConfigRecord& record) {
+  record = {};
+  record.mode = getMode();
+  record.hasManual = hasManualProfile;
+  record.manual = manualProfile;
+  record.scheduleVersion = scheduleVersion;
+  for (int i = 0; i < 24; i++) {
+    record.hourVersion[i] = hourVersion[i];
+    record.profiles[i] = hourlySchedule[i].profile;
+  }
+}
+
+void LedController::applyConfigRecord(const ConfigRecord& record) {
+  offMode = record.mode == MODE_OFF;
+  manualMode = record.mode != MODE_AUTO;
+  hasManualProfile = record.hasManual != 0;
+  manualProfile = record.manual;
+  scheduleVersion = record.scheduleVersion;
+  for (int i = 0; i < 24; i++) {
+    hourlySchedule[i].hour = i;
+    hourlySchedule[i].profile = record.profiles[i];
+    hourVersion[i] = record.hourVersion[i];
+  }
+}
+
+// Dipanggil dari restoreOutput() sebelum output pertama: tanpa logging panjang
+bool LedController::loadConfigRecord() {
+  ConfigRecord record;
+  if (!config.load(record) || record.mode > MODE_OFF) {
+    return false;
+  }
+  applyConfigRecord(record);
+  return true;
 }
 
-// Save mode to preferences
+// Save mode to preferences (langsung, tanpa debounce)
 void LedController::saveModeToPreferences() {
-  preferences.putBool("manual_mode", manualMode);
-  preferences.putBool("off_mode", offMode);
-  
-  Serial.print("Mode saved to preferences - Manual: ");
-  Serial.print(manualMode ? "YES" : "NO");
-  Serial.print(", Off: ");
-  Serial.println(offMode ? "YES" : "NO");
-}
-
-// Ensure all manual channels are initialized in NVS (called before saving individual channel)
-void LedController::ensureAllManualChannelsSaved() {
-  // NVS Key name limit: 15 characters max!
-  // Using shortened keys: m_rb, m_b, m_uv, m_v, m_r, m_g, m_w
-  
-  // Hanya inisialisasi jika belum ada data sama sekali
-  if (!preferences.isKey("m_rb")) {
-    Serial.println(">>> First time setting manual LED - initializing all channels in NVS...");
-    
-    // Baca nilai current dari hardware (PWM) untuk menjaga state yang sedang menyala
-    // Ini memastikan bahwa LED yang sudah menyala tidak tiba-tiba berubah
-    uint8_t currentRoyalBlue = ledcRead(channelRoyalBlue);
-    uint8_t currentBlue = ledcRead(channelBlue);
-    uint8_t currentUV = ledcRead(channelUV);
-    uint8_t currentViolet = ledcRead(channelViolet);
-    uint8_t currentRed = ledcRead(channelRed);
-    uint8_t currentGreen = ledcRead(channelGreen);
-    uint8_t currentWhite = ledcRead(channelWhite);
-    
-    Serial.print(">>> Current PWM values: ");
-    Serial.print("RB="); Serial.print(currentRoyalBlue);
-    Serial.print(" B="); Serial.print(currentBlue);
-    Serial.print(" UV="); Serial.print(currentUV);
-    Serial.print(" V="); Serial.print(currentViolet);
-    Serial.print(" R="); Serial.print(currentRed);
-    Serial.print(" G="); Serial.print(currentGreen);
-    Serial.print(" W="); Serial.println(currentWhite);
-    
-    // Simpan semua channel dengan nilai current (menggunakan key pendek)
-    preferences.putUChar("m_rb", currentRoyalBlue);  // manual_royalBlue
-    preferences.putUChar("m_b", currentBlue);        // manual_blue
-    preferences.putUChar("m_uv", currentUV);         // manual_uv
-    preferences.putUChar("m_v", currentViolet);      // manual_violet
-    preferences.putUChar("m_r", currentRed);         // manual_red
-    preferences.putUChar("m_g", currentGreen);       // manual_green
-    preferences.putUChar("m_w", currentWhite);       // manual_white
-    
-    Serial.println(">>> All manual channels initialized and saved to NVS successfully!");
-  }
-}
-
-// Load all preferences
-void LedController::loadPreferences() {
-  // Load mode if saved
-  if (preferences.isKey("manual_mode")) {
-    manualMode = preferences.getBool("manual_mode", false);
-    Serial.println("Loaded mode from preferences: " + String(manualMode ? "manual" : "auto"));
-  }
-  
-  // Load off mode if saved (independent dari manual_mode)
-  if (preferences.isKey("off_mode")) {
-    offMode = preferences.getBool("off_mode", false);
-    Serial.println("Loaded off mode from preferences: " + String(offMode ? "OFF" : "ON"));
-  }
-  
-  // Terapkan state berdasarkan mode yang dimuat
-  if (offMode) {
-    // Jika off mode, matikan semua LED
-    ledcWrite(channelRoyalBlue, 0);
-    ledcWrite(channelBlue, 0);
-    ledcWrite(channelUV, 0);
-    ledcWrite(channelViolet, 0);
-    ledcWrite(channelRed, 0);
-    ledcWrite(channelGreen, 0);
-    ledcWrite(channelWhite, 0);
-    Serial.println("Applied OFF mode - all LEDs turned off");
-  } else if (manualMode) {
-    // Jika dalam mode manual, muat pengaturan LED manual yang terakhir
-    // Note: Menggunakan key pendek m_rb (manual_royalBlue) sebagai marker
-    // Jika ada, semua 7 channel pasti tersimpan karena disimpan bersamaan
-    if (preferences.isKey("m_rb")) {
-      uint8_t royalBlue = preferences.getUChar("m_rb", 0);   // m_rb = manual_royalBlue
-      uint8_t blue = preferences.getUChar("m_b", 0);         // m_b = manual_blue
-      uint8_t uv = preferences.getUChar("m_uv", 0);          // m_uv = manual_uv
-      uint8_t violet = preferences.getUChar("m_v", 0);       // m_v = manual_violet
-      uint8_t red = preferences.getUChar("m_r", 0);          // m_r = manual_red
-      uint8_t green = preferences.getUChar("m_g", 0);        // m_g = manual_green
-      uint8_t white = preferences.getUChar("m_w", 0);        // m_w = manual_white
-      
-      // Terapkan pengaturan LED terakhir dari aplikasi
-      ledcWrite(channelRoyalBlue, royalBlue);
-      ledcWrite(channelBlue, blue);
-      ledcWrite(channelUV, uv);
-      ledcWrite(channelViolet, violet);
-      ledcWrite(channelRed, red);
-      ledcWrite(channelGreen, green);
-      ledcWrite(channelWhite, white);
-      
-      Serial.println("Applied manual LED settings from preferences (last settings from app)");
-      Serial.print("  RB="); Serial.print(royalBlue);
-      Serial.print(" B="); Serial.print(blue);
-      Serial.print(" UV="); Serial.print(uv);
-      Serial.print(" V="); Serial.print(violet);
-      Serial.print(" R="); Serial.print(red);
-      Serial.print(" G="); Serial.print(green);
-      Serial.print(" W="); Serial.println(white);
-    } else {
-      Serial.println("Manual mode but no saved LED values found (first time manual mode)");
-      // LED akan tetap mati sampai user mengatur via aplikasi
+  pendingWrites |= PENDING_MODE;
+  flushPendingWrites();
+}
+
+void LedController::storeManualChannel(LedChannel channel, uint8_t intensity) {
+  // Belum ada nilai manual: mulai dari output saat ini agar channel lain tidak berubah
+  if (!hasManualProfile) {
+    manualProfile = outputProfile;
+    hasManualProfile = true;
+  }
+  // LightProfile fields are in LedChannel order
+  ((uint8_t*)&manualProfile)[channel] = intensity;
+  pendingWrites |= PENDING_MANUAL;
+  flushPendingWrites();
+}
+
+// Key lama sebelum snapshot boot (NVS key name limit: 15 characters)
+static const char* const LEGACY_MANUAL_KEYS[LED_CHANNEL_COUNT] = {
+  "m_rb", "m_b", "m_uv", "m_v", "m_r", "m_g", "m_w"
+};
+
+// Boot snapshot, atau key terpisah dari firmware yang lebih lama lagi
+bool LedController::loadLegacyMode() {
+  BootSnapshot snapshot;
+  if (store->getBytes(BOOT_SNAPSHOT_KEY, &snapshot, sizeof(snapshot)) == sizeof(snapshot) &&
+      snapshot.format == BOOT_SNAPSHOT_FORMAT && snapshot.mode <= MODE_OFF) {
+    offMode = snapshot.mode == MODE_OFF;
+    manualMode = snapshot.mode != MODE_AUTO;
+    hasManualProfile = snapshot.hasManual != 0;
+    manualProfile = snapshot.manual;
+    return true;
+  }
+  
+  bool found = false;
+  if (store->isKey("manual_mode")) {
+    manualMode = store->getBool("manual_mode", false);
+    found = true;
+  }
+  if (store->isKey("off_mode")) {
+    offMode = store->getBool("off_mode", false);
+    found = true;
+  }
+  if (store->isKey("m_rb")) {
+    uint8_t* channels = (uint8_t*)&manualProfile;
+    for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+      channels[i] = store->getUChar(LEGACY_MANUAL_KEYS[i], 0);
     }
-  } else {
-    // Jika auto mode, terapkan profil jadwal saat ini
-    Serial.println("Auto mode detected - will apply scheduled profile");
-    // Note: Profil akan diterapkan di begin() atau di loop() pertama kali
+    hasManualProfile = true;
+    found = true;
   }
+  return found;
 }
 
 // Save all preferences at once
 void LedController::saveAllPreferences() {
-  saveHourlyScheduleToPreferences();
-  saveModeToPreferences();
+  pendingWrites |= PENDING_MODE | PENDING_MANUAL;
+  pendingHourMask = 0xFFFFFF;
+  flushPendingWrites();
 }
 
-String LedController::profileToJson(LightProfile profile) {
-  // Alokasi memori untuk JSON document
-  StaticJsonDocument<200> doc;
-  
-  // Isi dengan data profile
-  doc["royalBlue"] = profile.royalBlue;
-  doc["blue"] = profile.blue;
-  doc["uv"] = profile.uv;
-  doc["violet"] = profile.violet;
-  doc["red"] = profile.red;
-  doc["green"] = profile.green;
-  doc["white"] = profile.white;
-  
-  // Serialize JSON ke string
-  String output;
-  serializeJson(doc, output);
-  return output;
+size_t LedController::formatProfileJson(LightProfile profile, char* buffer, size_t size) {
+  int written = snprintf(buffer, size,
+    "{\"royalBlue\":%u,\"blue\":%u,\"uv\":%u,\"violet\":%u,\"red\":%u,\"green\":%u,\"white\":%u}",
+    profile.royalBlue, profile.blue, profile.uv, profile.violet, profile.red, profile.green, profile.white);
+  return (written < 0 || (size_t)written >= size) ? 0 : written;
 }
 
-LightProfile LedController::parseProfileJson(String jsonProfile) {
+LightProfile LedController::parseProfileJson(const char* jsonProfile) {
   LightProfile profile = {0, 0, 0, 0, 0, 0, 0}; // Default values
   
   // Parse JSON
@@ -275,44 +272,10 @@ void LedController::enableManualMode(bool enable) {
   // Jika mengubah dari auto ke manual, simpan pengaturan LED saat ini
   if (!manualMode && enable) {
     // Jika tidak ada pengaturan manual sebelumnya, gunakan pengaturan profil saat ini
-    if (!preferences.isKey("m_rb")) {
-      LightProfile currentProfile = getCurrentProfile();
-      
-      preferences.putUChar("m_rb", currentProfile.royalBlue);
-      preferences.putUChar("m_b", currentProfile.blue);
-      preferences.putUChar("m_uv", currentProfile.uv);
-      preferences.putUChar("m_v", currentProfile.violet);
-      preferences.putUChar("m_r", currentProfile.red);
-      preferences.putUChar("m_g", currentProfile.green);
-      preferences.putUChar("m_w", currentProfile.white);
-      
-      // Terapkan pengaturan LED saat ini untuk mode manual
-      ledcWrite(channelRoyalBlue, currentProfile.royalBlue);
-      ledcWrite(channelBlue, currentProfile.blue);
-      ledcWrite(channelUV, currentProfile.uv);
-      ledcWrite(channelViolet, currentProfile.violet);
-      ledcWrite(channelRed, currentProfile.red);
-      ledcWrite(channelGreen, currentProfile.green);
-      ledcWrite(channelWhite, currentProfile.white);
-    } else {
-      // Muat pengaturan manual sebelumnya
-      uint8_t royalBlue = preferences.getUChar("m_rb", 0);
-      uint8_t blue = preferences.getUChar("m_b", 0);
-      uint8_t uv = preferences.getUChar("m_uv", 0);
-      uint8_t violet = preferences.getUChar("m_v", 0);
-      uint8_t red = preferences.getUChar("m_r", 0);
-      uint8_t green = preferences.getUChar("m_g", 0);
-      uint8_t white = preferences.getUChar("m_w", 0);
-      
-      // Terapkan pengaturan LED
-      ledcWrite(channelRoyalBlue, royalBlue);
-      ledcWrite(channelBlue, blue);
-      ledcWrite(channelUV, uv);
-      ledcWrite(channelViolet, violet);
-      ledcWrite(channelRed, red);
-      ledcWrite(channelGreen, green);
-      ledcWrite(channelWhite, white);
-    }
+    // (disimpan bersama mode oleh saveModeToPreferences() di bawah)
+    writeOutput(hasManualProfile ? manualProfile : getCurrentProfile());
+    manualProfile = outputProfile;
+    hasManualProfile = true;
   }
   
   // Jika mengubah dari manual/off ke auto, langsung update LED sesuai jadwal
@@ -323,6 +286,7 @@ void LedController::enableManualMode(bool enable) {
   }
   
   manualMode = enable;
+  publishSnapshot();
   saveModeToPreferences();
   
   Serial.print("Mode changed successfully. New mode: ");
@@ -333,79 +297,509 @@ bool LedController::isInManualMode() {
   return manualMode;
 }
 
+LightMode LedController::getMode() {
+  if (offMode) return MODE_OFF;
+  if (manualMode) return MODE_MANUAL;
+  return MODE_AUTO;
+}
+
+// ========== QUEUED COMMANDS ==========
+
+bool LedController::processCommands(CommandQueue& queue) {
+  ControlCommand command;
+  bool appliedAny = false;
+  
+  while (queue.pop(command)) {
+    // Dicatat per command: iterasi tanpa command tidak mengisi ring trace
+    TRACE_SCOPE("lighting", "applyCommand");
+    uint32_t value = 0;
+    uint16_t status = applyCommand(command, value);
+    // Selesaikan response dulu, baru tulis ke NVS
+    queue.complete(command, status, value);
+    appliedAny = true;
+  }
+  
+  return appliedAny && stagePendingWrites();
+}
+
+// State baru dipublikasikan sebelum pemanggil menyelesaikan response, jadi client
+// yang membaca setelah sukses selalu melihat hasil command
+uint16_t LedController::applyCommand(const ControlCommand& command, uint32_t& value) {
+  uint16_t status = executeCommand(command, value);
+  publishSnapshot();
+  return status;
+}
+
+uint16_t LedController::executeCommand(const ControlCommand& command, uint32_t& value) {
+  value = 0;
+  
+  // Command lain mengakhiri preview: output kembali ke mode saat ini dulu
+  if (previewActive && command.type != CMD_PREVIEW) {
+    stopPreview();
+  }
+  
+  switch (command.type) {
+    case CMD_SET_MODE:
+      if (command.mode.mode > MODE_OFF) {
+        return 400;
+      }
+      enterMode((LightMode)command.mode.mode);
+      return 200;
+      
+    case CMD_SET_CHANNEL: {
+      if (command.channel.channel >= LED_CHANNEL_COUNT) {
+        return 400;
+      }
+      if (getMode() != MODE_MANUAL) {
+        enterMode(MODE_MANUAL);
+      }
+      // LightProfile fields are in LedChannel order
+      uint8_t* channels = (uint8_t*)&manualProfile;
+      channels[command.channel.channel] = command.channel.value;
+      writeOutput(manualProfile);
+      pendingWrites |= PENDING_MANUAL;
+      return 200;
+    }
+      
+    case CMD_SET_ALL:
+      // Langsung ke frame baru tanpa menerapkan nilai manual lama terlebih dahulu
+      manualProfile = command.frame;
+      hasManualProfile = true;
+      if (getMode() != MODE_MANUAL) {
+        manualMode = true;
+        offMode = false;
+        pendingWrites |= PENDING_MODE;
+      }
+      writeOutput(manualProfile);
+      pendingWrites |= PENDING_MANUAL;
+      return 200;
+      
+    case CMD_SET_HOUR:
+      if (command.hour.hour > 23) {
+        return 400;
+      }
+      hourlySchedule[command.hour.hour].profile = command.hour.profile;
+      markHoursChanged(1UL << command.hour.hour);
+      pendingHourMask |= (1UL << command.hour.hour);
+      refreshAutoOutput();
+      value = scheduleVersion;
+      return 200;
+      
+    case CMD_SET_SCHEDULE:
+      for (uint8_t hour = 0; hour < 24; hour++) {
+        if (command.schedule.hourMask & (1UL << hour)) {
+          hourlySchedule[hour].profile = command.schedule.profiles[hour];
+        }
+      }
+      markHoursChanged(command.schedule.hourMask);
+      pendingHourMask |= command.schedule.hourMask;
+      refreshAutoOutput();
+      value = scheduleVersion;
+      return 200;
+      
+    case CMD_SET_TIME:
+      if (!commandTimeValid(command.time)) {
+        return 400;
+      }
+      clock->adjust(command.time);
+      refreshAutoOutput();
+      return 200;
+      
+    case CMD_TRANSITION:
+      return applyTransition(command, value);
+      
+    case CMD_PATCH_SCHEDULE:
+      return applySchedulePatch(command, value);
+      
+    case CMD_PREVIEW:
+      if (command.preview.durationMs == 0) {
+        if (previewActive) stopPreview();
+        return 200;
+      }
+      previewActive = true;
+      previewStart = millis();
+      previewDurationMs = command.preview.durationMs;
+      updatePreview();
+      return 200;
+  }
+  
+  return 400;
+}
+
+// Terapkan beberapa perubahan sebagai satu transisi state: semua bagian divalidasi dulu,
+// lalu state RAM diubah dan output dihitung serta ditulis ke PWM tepat satu kali.
+// NVS ditulis sekali oleh flushPendingWrites() setelah response selesai.
+uint16_t LedController::applyTransition(const ControlCommand& command, uint32_t& value) {
+  uint8_t flags = command.transition.flags;
+  
+  // Validasi semua bagian sebelum ada yang diubah
+  if ((flags & TRANSITION_MODE) && command.transition.mode > MODE_OFF) {
+    return 400;
+  }
+  if ((flags & TRANSITION_TIME) && !commandTimeValid(command.transition.time)) {
+    return 400;
+  }
+  if (command.transition.hourMask & ~0xFFFFFFUL) {
+    return 400;
+  }
+  
+  // Waktu dan jadwal dulu, karena output auto mode bergantung pada keduanya
+  if (flags & TRANSITION_TIME) {
+    clock->adjust(command.transition.time);
+  }
+  
+  if (command.transition.hourMask != 0) {
+    for (uint8_t hour = 0; hour < 24; hour++) {
+      if (command.transition.hourMask & (1UL << hour)) {
+        hourlySchedule[hour].profile = command.transition.profiles[hour];
+      }
+    }
+    markHoursChanged(command.transition.hourMask);
+    pendingHourMask |= command.transition.hourMask;
+  }
+  
+  if (flags & TRANSITION_FRAME) {
+    manualProfile = command.transition.frame;
+    hasManualProfile = true;
+    pendingWrites |= PENDING_MANUAL;
+  }
+  
+  if (flags & TRANSITION_MODE) {
+    LightMode mode = (LightMode)command.transition.mode;
+    if (mode == MODE_MANUAL && !hasManualProfile) {
+      manualProfile = getCurrentProfile();
+      hasManualProfile = true;
+      pendingWrites |= PENDING_MANUAL;
+    }
+    offMode = (mode == MODE_OFF);
+    manualMode = (mode != MODE_AUTO);
+    pendingWrites |= PENDING_MODE;
+  }
+  
+  // Satu frame output untuk state akhir
+  switch (getMode()) {
+    case MODE_OFF:
+      writeOutput({0, 0, 0, 0, 0, 0, 0});
+      break;
+    case MODE_MANUAL:
+      writeOutput(manualProfile);
+      break;
+    case MODE_AUTO:
+      writeOutput(getCurrentProfile());
+      break;
+  }
+  
+  value = scheduleVersion;
+  return 200;
+}
+
+// Terapkan perubahan jadwal sparse (hour, channel, value). Ditolak dengan 409 jika
+// salah satu jam yang disentuh sudah berubah setelah baseVersion milik client;
+// value berisi versi jadwal saat ini agar client bisa memuat ulang.
+uint16_t LedController::applySchedulePatch(const ControlCommand& command, uint32_t& value) {
+  uint8_t count = command.patch.count;
+  if (count > SCHEDULE_PATCH_MAX) {
+    return 400;
+  }
+  
+  uint32_t touchedMask = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const ScheduleDelta& delta = command.patch.deltas[i];
+    if (delta.hour > 23 || delta.channel >= LED_CHANNEL_COUNT) {
+      return 400;
+    }
+    touchedMask |= (1UL << delta.hour);
+  }
+  
+  value = scheduleVersion;
+  if (command.patch.baseVersion > scheduleVersion) {
+    return 409; // Versi dari state lain (mis. sebelum reset NVS)
+  }
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    if ((touchedMask & (1UL << hour)) && hourVersion[hour] > command.patch.baseVersion) {
+      return 409;
+    }
+  }
+  
+  // Hanya byte yang benar-benar berbeda yang ditulis
+  uint32_t changedMask = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const ScheduleDelta& delta = command.patch.deltas[i];
+    uint8_t* channels = (uint8_t*)&hourlySchedule[delta.hour].profile;
+    if (channels[delta.channel] != delta.value) {
+      channels[delta.channel] = delta.value;
+      changedMask |= (1UL << delta.hour);
+    }
+  }
+  
+  if (changedMask != 0) {
+    markHoursChanged(changedMask);
+    pendingHourMask |= changedMask;
+    // Output auto mode hanya bergantung pada segmen jam ini -> jam berikutnya
+    if (activeSegmentTouched(changedMask)) {
+      refreshAutoOutput();
+    }
+  }
+  
+  value = scheduleVersion;
+  return 200;
+}
+
+void LedController::markHoursChanged(uint32_t hourMask) {
+  if (hourMask == 0) {
+    return;
+  }
+  scheduleVersion++;
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    if (hourMask & (1UL << hour)) {
+      hourVersion[hour] = scheduleVersion;
+    }
+  }
+}
+
+// True jika perubahan mengenai segmen interpolasi yang sedang aktif (auto mode)
+bool LedController::activeSegmentTouched(uint32_t hourMask) {
+  if (manualMode || offMode) {
+    return false;
+  }
+  uint8_t hour = clock->now().hour;
+  uint32_t segmentMask = (1UL << hour) | (1UL << ((hour + 1) % 24));
+  return (hourMask & segmentMask) != 0;
+}
+
+void LedController::enterMode(LightMode mode) {
+  switch (mode) {
+    case MODE_OFF:
+      // Nilai manual tetap disimpan, hanya output yang dimatikan
+      offMode = true;
+      manualMode = true;
+      writeOutput({0, 0, 0, 0, 0, 0, 0});
+      break;
+      
+    case MODE_MANUAL:
+      if (!hasManualProfile) {
+        // Belum pernah ada nilai manual: mulai dari profil jadwal saat ini
+        manualProfile = getCurrentProfile();
+        hasManualProfile = true;
+        pendingWrites |= PENDING_MANUAL;
+      }
+      offMode = false;
+      manualMode = true;
+      writeOutput(manualProfile);
+      break;
+      
+    case MODE_AUTO:
+      offMode = false;
+      manualMode = false;
+      writeOutput(getCurrentProfile());
+      break;
+  }
+  
+  pendingWrites |= PENDING_MODE;
+}
+
+// Hitung ulang output jika dalam auto mode (setelah jadwal atau waktu berubah)
+void LedController::refreshAutoOutput() {
+  if (!manualMode && !offMode) {
+    writeOutput(getCurrentProfile());
+  }
+}
+
+// Output sesuai mode tersimpan (boot, akhir preview)
+void LedController::writeModeOutput() {
+  if (offMode) {
+    writeOutput({0, 0, 0, 0, 0, 0, 0});
+  } else if (manualMode) {
+    // Manual tanpa nilai tersimpan: LED tetap mati sampai diatur lewat aplikasi
+    writeOutput(hasManualProfile ? manualProfile : LightProfile{0, 0, 0, 0, 0, 0, 0});
+  } else {
+    writeOutput(scheduledProfile(clock->now()));
+  }
+}
+
+void LedController::stopPreview() {
+  previewActive = false;
+  writeModeOutput();
+}
+
+// Waktu virtual = waktu berjalan x (1 hari / durasi); frame hanya ditulis saat berubah
+void LedController::updatePreview() {
+  if (!previewActive) return;
+  
+  unsigned long elapsed = millis() - previewStart;
+  if (elapsed >= previewDurationMs) {
+    stopPreview();
+    return;
+  }
+  uint32_t second = (uint32_t)((uint64_t)elapsed * 86400 / previewDurationMs);
+  LightProfile frame = scheduleFrame(hourlySchedule, second / 3600, (second / 60) % 60);
+  if (memcmp(&frame, &outputProfile, sizeof(frame)) != 0) {
+    writeOutput(frame);
+  }
+}
+
+// Dipanggil oleh pemilik state (lighting task): hanya menyalin state, tanpa NVS.
+// Perubahan yang belum sempat ditulis digabung; yang terbaru menang.
+bool LedController::stagePendingWrites() {
+  if (pendingWrites == 0 && pendingHourMask == 0) {
+    return false;
+  }
+  
+  uint8_t writes = pendingWrites;
+  if (pendingHourMask != 0) {
+    writes |= PENDING_SCHEDULE;
+  }
+  ConfigRecord record;
+  fillConfigRecord(record);
+  unsigned long now = millis();
+  
+  stagingLock.lock();
+  if (stagedWrites == 0) {
+    stagedFirstMs = now;
+  }
+  stagedLastMs = now;
+  stagedRecord = record;
+  stagedHourMask |= pendingHourMask;
+  stagedWrites |= writes;
+  stagingLock.unlock();
+  
+  pendingWrites = 0;
+  pendingHourMask = 0;
+  return true;
+}
+
+uint32_t LedController::stagedWriteDelay(unsigned long nowMs) {
+  std::lock_guard<std::mutex> guard(stagingLock);
+  if (stagedWrites == 0) {
+    return PERSIST_IDLE;
+  }
+  unsigned long quiet = nowMs - stagedLastMs;
+  unsigned long age = nowMs - stagedFirstMs;
+  if (quiet >= PERSIST_DEBOUNCE_MS || age >= PERSIST_MAX_DELAY_MS) {
+    return 0;
+  }
+  unsigned long untilQuiet = PERSIST_DEBOUNCE_MS - quiet;
+  unsigned long untilMax = PERSIST_MAX_DELAY_MS - age;
+  return untilQuiet < untilMax ? untilQuiet : untilMax;
+}
+
+// Dipanggil dari persistence task (atau langsung oleh flushPendingWrites)
+void LedController::writeStagedState() {
+  TRACE_SCOPE("persist", "writeStagedState");
+  std::lock_guard<std::mutex> writeGuard(writeLock);
+  
+  stagingLock.lock();
+  uint8_t writes = stagedWrites;
+  uint32_t hourMask = stagedHourMask;
+  ConfigRecord record = stagedRecord;
+  stagedWrites = 0;
+  stagedHourMask = 0;
+  stagingLock.unlock();
+  
+  if (writes == 0) {
+    return;
+  }
+  
+  // Seluruh state dalam satu record, bergantian di dua slot: satu penulisan NVS per flush
+  if (!config.write(record)) {
+    Serial.println("ERROR: Failed to save config record to preferences");
+    return;
+  }
+  Serial.print("Config record ");
+  Serial.print(record.sequence);
+  Serial.print(" saved to slot ");
+  Serial.print(CONFIG_SLOT_KEYS[config.getSlot()]);
+  if (writes & PENDING_MODE) {
+    Serial.print(" - Manual: ");
+    Serial.print(record.mode != MODE_AUTO ? "YES" : "NO");
+    Serial.print(", Off: ");
+    Serial.print(record.mode == MODE_OFF ? "YES" : "NO");
+  }
+  if (writes & PENDING_SCHEDULE) {
+    Serial.print(" - schedule changed (mask 0x");
+    Serial.print(hourMask, HEX);
+    Serial.print(")");
+  }
+  Serial.println();
+}
+
+void LedController::flushPendingWrites() {
+  stagePendingWrites();
+  writeStagedState();
+}
+
 void LedController::setRoyalBlue(uint8_t intensity) {
-  ledcWrite(channelRoyalBlue, intensity);
+  pwm->write(LED_ROYAL_BLUE, intensity);
+  outputProfile.royalBlue = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    // Pastikan semua channel lain juga tersimpan (inisialisasi jika belum ada)
-    ensureAllManualChannelsSaved();
-    // Simpan nilai LED ini (key pendek: m_rb = manual_royalBlue)
-    preferences.putUChar("m_rb", intensity);
+    storeManualChannel(LED_ROYAL_BLUE, intensity);
     Serial.print("Royal Blue saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::setBlue(uint8_t intensity) {
-  ledcWrite(channelBlue, intensity);
+  pwm->write(LED_BLUE, intensity);
+  outputProfile.blue = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    ensureAllManualChannelsSaved();
-    preferences.putUChar("m_b", intensity);
+    storeManualChannel(LED_BLUE, intensity);
     Serial.print("Blue saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::setUV(uint8_t intensity) {
-  ledcWrite(channelUV, intensity);
+  pwm->write(LED_UV, intensity);
+  outputProfile.uv = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    ensureAllManualChannelsSaved();
-    preferences.putUChar("m_uv", intensity);
+    storeManualChannel(LED_UV, intensity);
     Serial.print("UV saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::setViolet(uint8_t intensity) {
-  ledcWrite(channelViolet, intensity);
+  pwm->write(LED_VIOLET, intensity);
+  outputProfile.violet = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    ensureAllManualChannelsSaved();
-    preferences.putUChar("m_v", intensity);
+    storeManualChannel(LED_VIOLET, intensity);
     Serial.print("Violet saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::setRed(uint8_t intensity) {
-  ledcWrite(channelRed, intensity);
+  pwm->write(LED_RED, intensity);
+  outputProfile.red = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    ensureAllManualChannelsSaved();
-    preferences.putUChar("m_r", intensity);
+    storeManualChannel(LED_RED, intensity);
     Serial.print("Red saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::setGreen(uint8_t intensity) {
-  ledcWrite(channelGreen, intensity);
+  pwm->write(LED_GREEN, intensity);
+  outputProfile.green = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    ensureAllManualChannelsSaved();
-    preferences.putUChar("m_g", intensity);
+    storeManualChannel(LED_GREEN, intensity);
     Serial.print("Green saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::setWhite(uint8_t intensity) {
-  ledcWrite(channelWhite, intensity);
+  pwm->write(LED_WHITE, intensity);
+  outputProfile.white = intensity;
   // Jika dalam mode manual, simpan pengaturan
   if (manualMode) {
-    ensureAllManualChannelsSaved();
-    preferences.putUChar("m_w", intensity);
+    storeManualChannel(LED_WHITE, intensity);
     Serial.print("White saved: "); Serial.println(intensity);
   }
 }
 
 void LedController::update() {
+#if LED_DEBUG_LOG
   // Debug logging every 10 seconds
   static unsigned long lastDebugLog = 0;
   if (millis() - lastDebugLog > 10000) {
@@ -419,6 +813,7 @@ void LedController::update() {
       Serial.println("AUTO");
     }
   }
+#endif
   
   // In off mode, don't update anything
   if (offMode) {
@@ -430,20 +825,61 @@ void LedController::update() {
     return;
   }
   
-  // Otherwise, update based on time (AUTO MODE)
+  // Preview playback owns the output until it ends
+  if (previewActive) {
+    return;
+  }
+  
+  // Otherwise, update based on time (AUTO MODE). Tanpa setLightProfile():
+  // tick ini berjalan setiap detik di lighting task, log hanya jika LED_DEBUG_LOG
   LightProfile profile = getCurrentProfile();
-  setLightProfile(profile);
+  writeOutput(profile);
+#if LED_DEBUG_LOG
+  printCurrentProfile(profile);
+#endif
+}
+
+void LedController::writeOutput(LightProfile profile) {
+  // LightProfile fields are in LedChannel order
+  const uint8_t* channels = (const uint8_t*)&profile;
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    pwm->write(i, channels[i]);
+  }
+  
+  // Simpan frame terakhir yang benar-benar dikirim ke PWM
+  outputProfile = profile;
+  
+  // Salinan di RTC memory untuk warm restart (beberapa puluh byte, tanpa NVS).
+  // Sebelum config dimuat getMode() masih default (AUTO): mode dari record warm dipertahankan
+  WarmRestartState& warm = warmRestartMemory();
+  warmRestartRecord(warm, (const uint8_t*)&profile, outputRestored ? (uint8_t)getMode() : warm.mode);
+  publishSnapshot();
+}
+
+// Salin state yang dibaca task lain; dipanggil oleh pemilik state setelah setiap perubahan
+void LedController::publishSnapshot() {
+  std::lock_guard<std::mutex> guard(snapshotLock);
+  snapshot.output = outputProfile;
+  snapshot.mode = getMode();
+  snapshot.scheduleVersion = scheduleVersion;
+  for (int i = 0; i < 24; i++) {
+    snapshot.hourVersion[i] = hourVersion[i];
+    snapshot.profiles[i] = hourlySchedule[i].profile;
+  }
+}
+
+void LedController::readSnapshot(ControllerSnapshot& out) {
+  std::lock_guard<std::mutex> guard(snapshotLock);
+  out = snapshot;
+}
+
+LightProfile LedController::getOutputProfile() {
+  return outputProfile;
 }
 
 void LedController::setLightProfile(LightProfile profile) {
   // Set PWM values for each LED
-  ledcWrite(channelRoyalBlue, profile.royalBlue);
-  ledcWrite(channelBlue, profile.blue);
-  ledcWrite(channelUV, profile.uv);
-  ledcWrite(channelViolet, profile.violet);
-  ledcWrite(channelRed, profile.red);
-  ledcWrite(channelGreen, profile.green);
-  ledcWrite(channelWhite, profile.white);
+  writeOutput(profile);
   
   // Print current LED intensities
   Serial.println("===== LED VALUES APPLIED =====");
@@ -451,12 +887,13 @@ void LedController::setLightProfile(LightProfile profile) {
   Serial.println("==============================");
 }
 
-void LedController::setLightProfileFromJson(String jsonProfile) {
+void LedController::setLightProfileFromJson(const char* jsonProfile) {
   LightProfile profile = parseProfileJson(jsonProfile);
   setLightProfile(profile);
 }
 
 void LedController::printCurrentProfile(LightProfile profile) {
+  TRACE_SCOPE("serial", "printCurrentProfile");
   Serial.println("Current LED intensities:");
   Serial.print("Royal Blue: "); Serial.println(profile.royalBlue);
   Serial.print("Blue: "); Serial.println(profile.blue);
@@ -467,31 +904,23 @@ void LedController::printCurrentProfile(LightProfile profile) {
   Serial.print("White: "); Serial.println(profile.white);
 }
 
-String LedController::getCurrentProfileJson() {
-  return profileToJson(getCurrentProfile());
+size_t LedController::formatCurrentProfileJson(char* buffer, size_t size) {
+  return formatProfileJson(getCurrentProfile(), buffer, size);
 }
 
-String LedController::getCurrentTimeJson() {
-  DateTime now = rtc->now();
-  
-  // Alokasi memori untuk JSON document
-  StaticJsonDocument<100> doc;
-  
-  // Isi dengan data waktu
-  doc["year"] = now.year();
-  doc["month"] = now.month();
-  doc["day"] = now.day();
-  doc["hour"] = now.hour();
-  doc["minute"] = now.minute();
-  doc["second"] = now.second();
-  
-  // Serialize JSON ke string
-  String output;
-  serializeJson(doc, output);
-  return output;
+size_t LedController::formatCurrentTimeJson(char* buffer, size_t size) {
+  CommandTime now = clock->now();
+  int written = snprintf(buffer, size,
+    "{\"year\":%u,\"month\":%u,\"day\":%u,\"hour\":%u,\"minute\":%u,\"second\":%u}",
+    now.year, now.month, now.day, now.hour, now.minute, now.second);
+  return (written < 0 || (size_t)written >= size) ? 0 : written;
 }
 
-bool LedController::setCurrentTime(String timeJson) {
+void LedController::getCurrentTime(CommandTime& time) {
+  time = clock->now();
+}
+
+bool LedController::setCurrentTime(const char* timeJson) {
   // Parse JSON time format
   StaticJsonDocument<200> doc;
   DeserializationError error = deserializeJson(doc, timeJson);
@@ -525,8 +954,14 @@ bool LedController::setCurrentTime(String timeJson) {
   }
   
   // Set RTC time
-  DateTime newTime(year, month, day, hour, minute, second);
-  rtc->adjust(newTime);
+  CommandTime newTime;
+  newTime.year = year;
+  newTime.month = month;
+  newTime.day = day;
+  newTime.hour = hour;
+  newTime.minute = minute;
+  newTime.second = second;
+  clock->adjust(newTime);
   
   Serial.print("RTC time set to: ");
   Serial.print(year);
@@ -544,13 +979,28 @@ bool LedController::setCurrentTime(String timeJson) {
   return true;
 }
 
+// Profil jadwal untuk waktu tertentu, tanpa logging (dipakai saat boot)
+LightProfile LedController::scheduledProfile(const CommandTime& now) {
+  if (now.hour > 23) {
+    return {0, 0, 0, 0, 0, 0, 0}; // RTC tidak terbaca
+  }
+  return scheduleFrame(hourlySchedule, now.hour, now.minute);
+}
+
+LightProfile LedController::scheduleFrame(const HourlyProfile* schedule, uint8_t hour, uint8_t minute) {
+  LightProfile current = schedule[hour].profile;
+  LightProfile next = schedule[(hour + 1) % 24].profile;
+  return interpolateProfiles(current, next, minute / 60.0);
+}
+
 LightProfile LedController::getCurrentProfile() {
   // Get current time from RTC
-  DateTime now = rtc->now();
+  CommandTime now = clock->now();
   
-  int hour = now.hour();
-  int minute = now.minute();
+  int hour = now.hour;
+  int minute = now.minute;
   
+#if LED_DEBUG_LOG
   Serial.print("Getting current profile for time: ");
   Serial.print(hour);
   Serial.print(":");
@@ -570,23 +1020,21 @@ LightProfile LedController::getCurrentProfile() {
   Serial.print(currentHourProfile.blue);
   Serial.print(" W=");
   Serial.println(currentHourProfile.white);
+#endif
   
-  // Get the profile for the next hour (with wrap-around)
-  int nextHour = (hour + 1) % 24;
-  LightProfile nextHourProfile = hourlySchedule[nextHour].profile;
-  
-  // Interpolate between current and next hour based on minutes
-  float ratio = minute / 60.0;
-  LightProfile result = interpolateProfiles(currentHourProfile, nextHourProfile, ratio);
+  // Interpolate between current and next hour (with wrap-around) based on minutes
+  LightProfile result = scheduleFrame(hourlySchedule, hour, minute);
   
+#if LED_DEBUG_LOG
   Serial.print("Interpolated result (ratio=");
-  Serial.print(ratio);
+  Serial.print(minute / 60.0);
   Serial.print("): R=");
   Serial.print(result.royalBlue);
   Serial.print(" B=");
   Serial.print(result.blue);
   Serial.print(" W=");
   Serial.println(result.white);
+#endif
   
   return result;
 }
@@ -632,7 +1080,7 @@ void LedController::setAllLeds(uint8_t royalBlue, uint8_t blue, uint8_t uv, uint
   Serial.print("White: "); Serial.println(white);
 }
 
-void LedController::setAllLedsFromJson(String jsonProfile) {
+void LedController::setAllLedsFromJson(const char* jsonProfile) {
   // Parse JSON
   StaticJsonDocument<512> doc;
   DeserializationError error = deserializeJson(doc, jsonProfile);
@@ -669,10 +1117,9 @@ void LedController::setOffMode(bool off) {
   } else {
     Serial.println("OFF mode disabled");
   }
-  // Save state to preferences (gunakan namespace yang sama: "led_ctrl")
-  preferences.putBool("off_mode", offMode);
-  preferences.putBool("manual_mode", manualMode);
-  Serial.println("Off mode and manual mode saved to preferences");
+  publishSnapshot();
+  // Save state to preferences
+  saveModeToPreferences();
 }
 
 bool LedController::isInOffMode() {
@@ -682,7 +1129,7 @@ bool LedController::isInOffMode() {
 // Destructor
 LedController::~LedController() {
   // Free resources
-  preferences.end();
+  store->end();
 }
 
 // ========== HOURLY SCHEDULE FUNCTIONS ==========
@@ -704,21 +1151,16 @@ void LedController::setHourlyProfile(uint8_t hour, LightProfile profile) {
   
   hourlySchedule[hour].hour = hour;
   hourlySchedule[hour].profile = profile;
+  markHoursChanged(1UL << hour);
+  pendingHourMask |= 1UL << hour;
+  publishSnapshot();
   
   // Save immediately to NVS (preferences already opened in begin())
-  String key = "h" + String(hour);
-  String profileJson = profileToJson(profile);
-  preferences.putString(key.c_str(), profileJson);
+  flushPendingWrites();
   
   Serial.print(">>> Hour ");
   Serial.print(hour);
   Serial.println(" SAVED TO NVS (non-volatile storage)");
-  
-  // Verify by reading back
-  String verifyJson = preferences.getString(key.c_str(), "");
-  
-  Serial.print(">>> VERIFICATION: Read back from NVS: ");
-  Serial.println(verifyJson);
 }
 
 LightProfile LedController::getHourlyProfile(uint8_t hour) {
@@ -730,137 +1172,113 @@ LightProfile LedController::getHourlyProfile(uint8_t hour) {
   return hourlySchedule[hour].profile;
 }
 
-void LedController::setHourlySchedule(String jsonSchedule) {
-  // Parse JSON array - INCREASED BUFFER SIZE to 6144 bytes for 24-hour schedule
-  DynamicJsonDocument doc(6144);
-  DeserializationError error = deserializeJson(doc, jsonSchedule);
-  
-  if (error) {
-    Serial.print("JSON parsing failed: ");
-    Serial.println(error.c_str());
-    return;
-  }
-  
-  // Check if the root is an array
-  if (!doc.is<JsonArray>()) {
-    // Maybe it's wrapped in an object with "schedule" key
-    if (doc.containsKey("schedule")) {
-      JsonArray scheduleArray = doc["schedule"].as<JsonArray>();
-      
-      for (JsonObject hourObj : scheduleArray) {
-        if (hourObj.containsKey("hour")) {
-          uint8_t hour = hourObj["hour"];
-          
-          if (hour <= 23) {
-            LightProfile profile;
-            profile.royalBlue = hourObj.containsKey("royalBlue") ? (uint8_t)hourObj["royalBlue"] : 0;
-            profile.blue = hourObj.containsKey("blue") ? (uint8_t)hourObj["blue"] : 0;
-            profile.uv = hourObj.containsKey("uv") ? (uint8_t)hourObj["uv"] : 0;
-            profile.violet = hourObj.containsKey("violet") ? (uint8_t)hourObj["violet"] : 0;
-            profile.red = hourObj.containsKey("red") ? (uint8_t)hourObj["red"] : 0;
-            profile.green = hourObj.containsKey("green") ? (uint8_t)hourObj["green"] : 0;
-            profile.white = hourObj.containsKey("white") ? (uint8_t)hourObj["white"] : 0;
-            
-            setHourlyProfile(hour, profile);
-          }
-        }
-      }
-    } else {
-      Serial.println("Invalid JSON format for hourly schedule");
-      return;
-    }
-  } else {
-    // Process as direct array
-    JsonArray scheduleArray = doc.as<JsonArray>();
-    
-    for (JsonObject hourObj : scheduleArray) {
-      if (hourObj.containsKey("hour")) {
-        uint8_t hour = hourObj["hour"];
-        
-        if (hour <= 23) {
-          LightProfile profile;
-          profile.royalBlue = hourObj.containsKey("royalBlue") ? (uint8_t)hourObj["royalBlue"] : 0;
-          profile.blue = hourObj.containsKey("blue") ? (uint8_t)hourObj["blue"] : 0;
-          profile.uv = hourObj.containsKey("uv") ? (uint8_t)hourObj["uv"] : 0;
-          profile.violet = hourObj.containsKey("violet") ? (uint8_t)hourObj["violet"] : 0;
-          profile.red = hourObj.containsKey("red") ? (uint8_t)hourObj["red"] : 0;
-          profile.green = hourObj.containsKey("green") ? (uint8_t)hourObj["green"] : 0;
-          profile.white = hourObj.containsKey("white") ? (uint8_t)hourObj["white"] : 0;
-          
-          setHourlyProfile(hour, profile);
-        }
-      }
-    }
-  }
-  
-  // Save to preferences
-  saveHourlyScheduleToPreferences();
-  
-  Serial.println("Hourly schedule updated from JSON");
-  
-  // If in auto mode, immediately apply the new schedule
-  if (!manualMode && !offMode) {
-    Serial.println("Auto mode active - applying new schedule immediately");
-    LightProfile currentProfile = getCurrentProfile();
-    setLightProfile(currentProfile);
-  }
+uint32_t LedController::getScheduleVersion() {
+  return scheduleVersion;
 }
 
-String LedController::getHourlyScheduleJson() {
-  // Create JSON document with larger buffer
-  DynamicJsonDocument doc(4096);
-  JsonArray scheduleArray = doc.createNestedArray("schedule");
-  
-  for (int i = 0; i < 24; i++) {
-    JsonObject hourObj = scheduleArray.createNestedObject();
-    hourObj["hour"] = hourlySchedule[i].hour;
-    hourObj["royalBlue"] = hourlySchedule[i].profile.royalBlue;
-    hourObj["blue"] = hourlySchedule[i].profile.blue;
-    hourObj["uv"] = hourlySchedule[i].profile.uv;
-    hourObj["violet"] = hourlySchedule[i].profile.violet;
-    hourObj["red"] = hourlySchedule[i].profile.red;
-    hourObj["green"] = hourlySchedule[i].profile.green;
-    hourObj["white"] = hourlySchedule[i].profile.white;
-  }
-  
-  String output;
-  serializeJson(doc, output);
-  return output;
+uint32_t LedController::getHourVersion(uint8_t hour) {
+  return hour > 23 ? 0 : hourVersion[hour];
 }
 
-void LedController::saveHourlyScheduleToPreferences() {
-  // Preferences already opened in begin() - no need to open/close
+// Tulis seluruh jadwal sebagai JSON ke buffer milik pemanggil (tanpa alokasi heap).
+// Mengembalikan panjang, atau 0 jika buffer terlalu kecil (lihat SCHEDULE_JSON_MAX_SIZE).
+// Dibaca dari snapshot: dipanggil dari handler HTTP di core 0.
+size_t LedController::formatHourlyScheduleJson(char* buffer, size_t size) {
+  ControllerSnapshot state;
+  readSnapshot(state);
+  
+  size_t length = 0;
+  int written = snprintf(buffer, size, "{\"version\":%lu,\"schedule\":[", (unsigned long)state.scheduleVersion);
+  if (written < 0 || (size_t)written >= size) return 0;
+  length += written;
   
-  // Save each hour's profile
   for (int i = 0; i < 24; i++) {
-    String key = "h" + String(i);
-    String profileJson = profileToJson(hourlySchedule[i].profile);
-    preferences.putString(key.c_str(), profileJson);
+    const LightProfile& p = state.profiles[i];
+    written = snprintf(buffer + length, size - length,
+      "%s{\"hour\":%d,\"royalBlue\":%u,\"blue\":%u,\"uv\":%u,\"violet\":%u,\"red\":%u,\"green\":%u,\"white\":%u,\"version\":%lu}",
+      i == 0 ? "" : ",", i, p.royalBlue, p.blue, p.uv, p.violet, p.red, p.green, p.white,
+      (unsigned long)state.hourVersion[i]);
+    if (written < 0 || (size_t)written >= size - length) return 0;
+    length += written;
   }
   
-  Serial.println("Hourly schedule saved to preferences");
+  written = snprintf(buffer + length, size - length, "]}");
+  if (written < 0 || (size_t)written >= size - length) return 0;
+  return length + written;
 }
 
-void LedController::loadHourlyScheduleFromPreferences() {
-  // Preferences already opened in begin() - no need to open/close
+// Blob jadwal, atau satu key JSON per jam (h0..h23) dari firmware yang lebih lama
+bool LedController::loadLegacySchedule() {
+  ScheduleBlob blob;
+  if (store->getBytesLength(SCHEDULE_BLOB_KEY) == sizeof(blob) &&
+      store->getBytes(SCHEDULE_BLOB_KEY, &blob, sizeof(blob)) == sizeof(blob) &&
+      blob.format == SCHEDULE_BLOB_FORMAT) {
+    scheduleVersion = blob.version;
+    for (int i = 0; i < 24; i++) {
+      hourlySchedule[i].hour = i;
+      hourlySchedule[i].profile = blob.profiles[i];
+      hourVersion[i] = blob.hourVersion[i];
+    }
+    return true;
+  }
   
-  // Load each hour's profile
-  bool foundSchedule = false;
+  bool found = false;
   for (int i = 0; i < 24; i++) {
-    String key = "h" + String(i);
-    if (preferences.isKey(key.c_str())) {
-      String profileJson = preferences.getString(key.c_str(), "");
-      if (profileJson.length() > 0) {
+    char key[4];
+    snprintf(key, sizeof(key), "h%d", i);
+    if (store->isKey(key)) {
+      char profileJson[128];
+      if (store->getString(key, profileJson, sizeof(profileJson)) > 0) {
         hourlySchedule[i].hour = i;
         hourlySchedule[i].profile = parseProfileJson(profileJson);
-        foundSchedule = true;
+        found = true;
       }
     }
   }
+  return found;
+}
+
+// Belum ada config record: baca format lama, tulis sebagai record pertama,
+// baru hapus key lama setelah record tersimpan
+void LedController::migrateLegacyConfig() {
+  bool foundMode = loadLegacyMode();
+  bool foundSchedule = loadLegacySchedule();
+  if (!foundMode && !foundSchedule) {
+    Serial.println("No saved settings found, using defaults");
+    return;
+  }
   
+  Serial.println("Migrating saved settings to config record");
+  pendingWrites |= PENDING_MODE | PENDING_MANUAL;
   if (foundSchedule) {
-    Serial.println("Loaded hourly schedule from preferences");
-  } else {
-    Serial.println("No saved hourly schedule found, using defaults");
+    pendingHourMask = 0xFFFFFF;
+  }
+  flushPendingWrites();
+  if (config.getSlot() >= 0) {
+    removeLegacyKeys();
+  }
+}
+
+void LedController::removeLegacyKeys() {
+  static const char* const KEYS[] = {BOOT_SNAPSHOT_KEY, SCHEDULE_BLOB_KEY, "manual_mode", "off_mode"};
+  for (const char* key : KEYS) {
+    if (store->isKey(key)) {
+      store->remove(key);
+      nvsWear.recordRemove(LED_STORE_NAMESPACE, key);
+    }
+  }
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    if (store->isKey(LEGACY_MANUAL_KEYS[i])) {
+      store->remove(LEGACY_MANUAL_KEYS[i]);
+      nvsWear.recordRemove(LED_STORE_NAMESPACE, LEGACY_MANUAL_KEYS[i]);
+    }
+  }
+  for (int i = 0; i < 24; i++) {
+    char key[4];
+    snprintf(key, sizeof(key), "h%d", i);
+    if (store->isKey(key)) {
+      store->remove(key);
+      nvsWear.recordRemove(LED_STORE_NAMESPACE, key);
+    }
   }
 }
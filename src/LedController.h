@@ -2,20 +2,10 @@
 #define LED_CONTROLLER_H
 
 #include <Arduino.h>
-#include <RTClib.h>
-#include <ArduinoJson.h>
-#include <Preferences.h>
-
-// Light profile structure for different times of day
-struct LightProfile {
-  uint8_t royalBlue;
-  uint8_t blue;
-  uint8_t uv;
-  uint8_t violet;
-  uint8_t red;
-  uint8_t green;
-  uint8_t white;
-};
+#include <mutex>
+#include "LightTypes.h"
+#include "LightingHal.h"
+#include "ConfigStore.h"
 
 // Hourly schedule structure
 struct HourlyProfile {
@@ -23,77 +13,221 @@ struct HourlyProfile {
   LightProfile profile;
 };
 
+
+// NVS namespace of the schedule and boot snapshot
+#define LED_STORE_NAMESPACE "led_ctrl"
+
+// Pending NVS writes, flushed after queued commands are applied
+#define PENDING_MODE     0x01
+#define PENDING_MANUAL   0x02
+#define PENDING_SCHEDULE 0x04  // Staged writes only (pendingHourMask otherwise)
+
+// The persistence task writes once changes have been quiet for
+// PERSIST_DEBOUNCE_MS (a slider drag becomes one write), but no later than
+// PERSIST_MAX_DELAY_MS after the first unsaved change
+#define PERSIST_DEBOUNCE_MS  1000
+#define PERSIST_MAX_DELAY_MS 5000
+#define PERSIST_IDLE         UINT32_MAX  // stagedWriteDelay(): nothing staged
+
+// Earlier layouts, read once to migrate to the config record (ConfigStore.h):
+// the schedule blob (which replaced the h0..h23 JSON keys) and the boot
+// snapshot with mode + manual frame (which replaced manual_mode, off_mode and
+// m_rb..m_w)
+#define SCHEDULE_BLOB_KEY    "sched"
+#define SCHEDULE_BLOB_FORMAT 1
+#define BOOT_SNAPSHOT_KEY    "boot"
+#define BOOT_SNAPSHOT_FORMAT 1
+
+struct BootSnapshot {
+  uint8_t format;
+  uint8_t mode;          // LightMode
+  uint8_t hasManual;
+  uint8_t reserved;
+  LightProfile manual;
+};
+
+struct ScheduleBlob {
+  uint8_t format;
+  uint8_t reserved[3];
+  uint32_t version;
+  uint32_t hourVersion[24];
+  LightProfile profiles[24];
+};
+
+// State read by the other tasks (HTTP, SSE, BLE). The lighting task owns the
+// live fields and publishes this copy after every output write and every
+// applied command; readers always get one whole snapshot, never a torn frame.
+struct ControllerSnapshot {
+  LightProfile output;          // Last frame written to the PWM channels
+  uint8_t mode;                 // LightMode
+  uint32_t scheduleVersion;
+  uint32_t hourVersion[24];
+  LightProfile profiles[24];
+};
+
+// Serial logging on the lighting task's tick path: the mode every 10 s, the
+// interpolation inputs and the frame written every tick. Off by default so the
+// 1 s tick stays free of UART work; build with -DLED_DEBUG_LOG=1 to enable.
+#ifndef LED_DEBUG_LOG
+#define LED_DEBUG_LOG 0
+#endif
+
+// Buffer sizes for the format*Json() methods (worst case, all values at maximum)
+#define TIME_JSON_MAX_SIZE      80
+#define PROFILE_JSON_MAX_SIZE   112
+#define SCHEDULE_JSON_MAX_SIZE  2944
+
 class LedController {
 private:
-  // LED control pins
-  uint8_t pinRoyalBlue;
-  uint8_t pinBlue;
-  uint8_t pinUV;
-  uint8_t pinViolet;
-  uint8_t pinRed;
-  uint8_t pinGreen;
-  uint8_t pinWhite;
-  
-  // PWM channels
-  uint8_t channelRoyalBlue;
-  uint8_t channelBlue;
-  uint8_t channelUV;
-  uint8_t channelViolet;
-  uint8_t channelRed;
-  uint8_t channelGreen;
-  uint8_t channelWhite;
-  
-  // PWM properties
-  uint32_t freq;
-  uint8_t resolution;
+  // Hardware (see LightingHal.h)
+  PwmSink* pwm;
+  KeyValueStore* store;
+  WallClock* clock;
   
   // Hourly schedule
   HourlyProfile hourlySchedule[24];
   
-  // RTC instance reference
-  RTC_DS3231* rtc;
-  
   // Current operating mode
   bool manualMode;
   bool offMode; // New flag to track off mode
   
-  // Preferences instance for persistent storage
-  Preferences preferences;
+  // Last frame actually written to the PWM channels
+  LightProfile outputProfile;
+  
+  // Incremented on every hourly schedule change
+  uint32_t scheduleVersion;
+  
+  // scheduleVersion at which each hour last changed (for PATCH conflicts)
+  uint32_t hourVersion[24];
+  
+  // Last manual frame (persisted in the config record)
+  LightProfile manualProfile;
+  bool hasManualProfile;
+  
+  // State changed by applyCommand() that still has to be written to NVS
+  uint8_t pendingWrites;
+  uint32_t pendingHourMask;
+  
+  // Copy of the state waiting for the persistence task. stagingLock is held
+  // only for the copy; writeLock serializes the NVS writes themselves.
+  std::mutex stagingLock;
+  std::mutex writeLock;
+  uint8_t stagedWrites;      // PENDING_* bits
+  uint32_t stagedHourMask;
+  ConfigRecord stagedRecord;
+  unsigned long stagedFirstMs;  // First change not yet written
+  unsigned long stagedLastMs;   // Most recent change
+  
+  // A/B config records in NVS (persistence task only, under writeLock)
+  ConfigStore config;
+  
+  // Published copy for other tasks; snapshotLock is held only for the copy
+  std::mutex snapshotLock;
+  ControllerSnapshot snapshot;
+  void publishSnapshot();
   
   // Helper methods
-  LightProfile interpolateProfiles(LightProfile profile1, LightProfile profile2, float ratio);
+  void writeOutput(LightProfile profile);
+  
+  // Output already restored from the boot snapshot
+  bool outputRestored;
+  bool pwmReady;
+  bool warmBoot;      // Frame taken over from RTC memory after a software reset
+  
+  // Schedule preview playback: a whole day compressed into previewDurationMs
+  bool previewActive;
+  unsigned long previewStart;
+  uint32_t previewDurationMs;
+  
+  void setupPwm();
+  LightProfile scheduledProfile(const CommandTime& now);
   
-  // Ensure all manual LED channels are initialized in NVS
-  void ensureAllManualChannelsSaved();
+  // Legacy per-channel setters: update the manual frame and persist it
+  void storeManualChannel(LedChannel channel, uint8_t intensity);
+  
+  // Command helpers (RAM + PWM only, persistence is deferred)
+  void enterMode(LightMode mode);
+  void refreshAutoOutput();
+  void writeModeOutput();
+  void stopPreview();
+  uint16_t executeCommand(const ControlCommand& command, uint32_t& value);
+  uint16_t applyTransition(const ControlCommand& command, uint32_t& value);
+  uint16_t applySchedulePatch(const ControlCommand& command, uint32_t& value);
+  void markHoursChanged(uint32_t hourMask);
+  bool activeSegmentTouched(uint32_t hourMask);
   
   // Save and load preferences
   void saveModeToPreferences();
-  void loadPreferences();
+  void fillConfigRecord(ConfigRecord& record);
+  void applyConfigRecord(const ConfigRecord& record);
+  bool loadLegacyMode();
+  bool loadLegacySchedule();
+  void migrateLegacyConfig();
+  void removeLegacyKeys();
   
 public:
-  // Constructor
-  LedController(
-    uint8_t pinRoyalBlue, uint8_t pinBlue, uint8_t pinUV, uint8_t pinViolet,
-    uint8_t pinRed, uint8_t pinGreen, uint8_t pinWhite,
-    uint8_t channelRoyalBlue, uint8_t channelBlue, uint8_t channelUV, uint8_t channelViolet,
-    uint8_t channelRed, uint8_t channelGreen, uint8_t channelWhite,
-    uint32_t freq, uint8_t resolution,
-    RTC_DS3231* rtc
-  );
+  // Constructor. The HAL objects are owned by the caller and must outlive
+  // the controller; nothing is touched until restoreOutput()/begin().
+  LedController(PwmSink* pwm, KeyValueStore* store, WallClock* clock);
   
   // Destructor
   ~LedController();
   
+  // Warm restart: if resetIsWarm (the reset kept RTC memory) and the saved
+  // frame is valid, drive it on the LED pins and release the latch set by
+  // prepareForRestart(). Call as the very first thing in setup(). The RTC
+  // record keeps its saved mode until restoreOutput() has loaded the config.
+  bool restoreWarmOutput(bool resetIsWarm);
+  
+  // Before ESP.restart(): flush NVS and latch each output at its nearest
+  // level (off/on) so the tank does not black out during reset
+  void prepareForRestart();
+  bool isWarmBoot() { return warmBoot; }
+  
+  // Health check: the PWM hardware still drives the last written frame
+  bool outputMatches();
+  
+  // Lighting recovery: re-initialize PWM and re-apply the last frame
+  void recoverOutput();
+  
+  // Fast boot: set up PWM and apply the persisted mode/manual frame (or the
+  // scheduled frame for the RTC time) with no logging or JSON. Called first
+  // in setup(); begin() calls it if it has not run yet.
+  void restoreOutput();
+  
   // Initialize LED controller
   void begin();
   
-  // JSON methods for profiles
-  LightProfile parseProfileJson(String jsonProfile);
-  String profileToJson(LightProfile profile);
+  // JSON methods for profiles. format* methods write into a caller-owned buffer
+  // and return the length (0 if it does not fit); nothing is allocated.
+  LightProfile parseProfileJson(const char* jsonProfile);
+  size_t formatProfileJson(LightProfile profile, char* buffer, size_t size);
   
   // Mode control
   void enableManualMode(bool enable);
   bool isInManualMode();
+  LightMode getMode();
+  
+  // Queued commands from network handlers. Applies all pending commands,
+  // completes their results, then stages changed state for NVS. Returns true
+  // if something was staged: the caller hands it to writeStagedState().
+  bool processCommands(CommandQueue& queue);
+  uint16_t applyCommand(const ControlCommand& command, uint32_t& value);
+  
+  // Persistence split: stagePendingWrites() copies the whole state (cheap,
+  // lighting task); writeStagedState() writes it as one config record
+  // (persistence task). flushPendingWrites() does both synchronously.
+  bool stagePendingWrites();
+  void writeStagedState();
+  void flushPendingWrites();
+  
+  // Debounce for the persistence task: ms until the staged state is due
+  // (0 = write now), or PERSIST_IDLE if nothing is staged
+  uint32_t stagedWriteDelay(unsigned long nowMs);
+  
+  // Newest valid config record from NVS into RAM; false if there is none
+  bool loadConfigRecord();
+  ConfigStore& getConfigStore() { return config; }
   
   // Set individual LED intensities directly (for manual control)
   void setRoyalBlue(uint8_t intensity);
@@ -107,27 +241,47 @@ public:
   // Set all LED intensities at once
   void setAllLeds(uint8_t royalBlue, uint8_t blue, uint8_t uv, uint8_t violet, 
                   uint8_t red, uint8_t green, uint8_t white);
-  void setAllLedsFromJson(String jsonProfile);
+  void setAllLedsFromJson(const char* jsonProfile);
   
   // Update lighting based on current time (auto mode) or do nothing (manual mode)
   void update();
   
   // Set a specific light profile directly
   void setLightProfile(LightProfile profile);
-  void setLightProfileFromJson(String jsonProfile);
+  void setLightProfileFromJson(const char* jsonProfile);
+  
+  // Linear blend between two hourly profiles (ratio 0..1). Pure; public for benchmarks.
+  static LightProfile interpolateProfiles(LightProfile profile1, LightProfile profile2, float ratio);
+  
+  // Auto-mode frame for a time of day. Pure: the lighting loop, the schedule
+  // simulator and preview playback all compute frames through this.
+  static LightProfile scheduleFrame(const HourlyProfile* schedule, uint8_t hour, uint8_t minute);
+  
+  // Consistent copy of the published state. The only way other tasks may read
+  // the controller; the getters below read live state (lighting task only).
+  void readSnapshot(ControllerSnapshot& out);
+  
+  // Preview playback (CMD_PREVIEW): the schedule's day from 00:00 on the real
+  // output, then back to the current mode. Call every lighting iteration.
+  void updatePreview();
+  bool isPreviewing() { return previewActive; }
   
   // Get current profile based on time
   LightProfile getCurrentProfile();
-  String getCurrentProfileJson();
+  size_t formatCurrentProfileJson(char* buffer, size_t size);
+  
+  // Get the frame currently applied to the LEDs (live state)
+  LightProfile getOutputProfile();
   
   // Print current profile values to Serial
   void printCurrentProfile(LightProfile profile);
   
-  // Get current time from RTC as formatted string
-  String getCurrentTimeJson();
+  // Get current time from the clock as JSON
+  size_t formatCurrentTimeJson(char* buffer, size_t size);
+  void getCurrentTime(CommandTime& time);
   
-  // Set current time on RTC
-  bool setCurrentTime(String timeJson);
+  // Set current time on the clock
+  bool setCurrentTime(const char* timeJson);
   
   // Save all settings to persistent storage
   void saveAllPreferences();
@@ -136,13 +290,13 @@ public:
   void setOffMode(bool off);
   bool isInOffMode();
   
-  // Hourly schedule control
-  void setHourlySchedule(String jsonSchedule);
-  String getHourlyScheduleJson();
+  // Hourly schedule control. formatHourlyScheduleJson() renders the published
+  // snapshot and is safe from any task; the getters read live state.
+  size_t formatHourlyScheduleJson(char* buffer, size_t size);
   void setHourlyProfile(uint8_t hour, LightProfile profile);
   LightProfile getHourlyProfile(uint8_t hour);
-  void saveHourlyScheduleToPreferences();
-  void loadHourlyScheduleFromPreferences();
+  uint32_t getScheduleVersion();
+  uint32_t getHourVersion(uint8_t hour);
 };
 
 #endif // LED_CONTROLLER_H 
\ No newline at end of file
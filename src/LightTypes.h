@@ -0,0 +1,36 @@
+#ifndef LIGHT_TYPES_H
+#define LIGHT_TYPES_H
+
+#include <stdint.h>
+
+// Light profile structure for different times of day
+struct LightProfile {
+  uint8_t royalBlue;
+  uint8_t blue;
+  uint8_t uv;
+  uint8_t violet;
+  uint8_t red;
+  uint8_t green;
+  uint8_t white;
+};
+
+// Operating modes
+enum LightMode : uint8_t {
+  MODE_AUTO,
+  MODE_MANUAL,
+  MODE_OFF
+};
+
+// LED channels, in LightProfile field order
+enum LedChannel : uint8_t {
+  LED_ROYAL_BLUE,
+  LED_BLUE,
+  LED_UV,
+  LED_VIOLET,
+  LED_RED,
+  LED_GREEN,
+  LED_WHITE,
+  LED_CHANNEL_COUNT
+};
+
+#endif // LIGHT_TYPES_H
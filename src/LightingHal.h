@@ -0,0 +1,75 @@
+#ifndef LIGHTING_HAL_H
+#define LIGHTING_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "LightTypes.h"
+#include "ControlCommand.h"
+
+// Hardware used by LedController. The ESP32 implementations are in
+// Esp32LightingHal.h (LEDC, Preferences, DS3231, esp_timer); SimulatedLightingHal.h has
+// in-memory versions for the native build.
+
+// PWM outputs, indexed by LedChannel
+class PwmSink {
+public:
+  virtual ~PwmSink() {}
+
+  // Configure and attach all channels. Called again to recover a channel that
+  // stopped following writes, so it must be safe to repeat.
+  virtual void begin() = 0;
+  virtual void write(uint8_t channel, uint8_t duty) = 0;
+  virtual uint32_t read(uint8_t channel) = 0;           // Duty the hardware is driving
+
+  // Drive each channel at its nearest full level (off/on) and keep it there
+  // across a software reset; releaseLatch() hands the pins back to PWM
+  virtual void latch(const uint8_t* frame) = 0;
+  virtual void releaseLatch() = 0;
+};
+
+// Non-volatile key-value store with the subset of the Preferences API used by
+// LedController. Keys are at most 15 characters (NVS limit).
+class KeyValueStore {
+public:
+  virtual ~KeyValueStore() {}
+
+  virtual bool begin(const char* name) = 0;
+  virtual void end() = 0;
+
+  virtual bool isKey(const char* key) = 0;
+  virtual size_t getBytesLength(const char* key) = 0;
+  virtual size_t getBytes(const char* key, void* buffer, size_t length) = 0;
+  virtual size_t putBytes(const char* key, const void* value, size_t length) = 0;
+  virtual bool remove(const char* key) = 0;
+
+  // Legacy (pre-blob) values, read once for migration
+  virtual bool getBool(const char* key, bool defaultValue) = 0;
+  virtual uint8_t getUChar(const char* key, uint8_t defaultValue) = 0;
+  virtual size_t getString(const char* key, char* buffer, size_t length) = 0;
+};
+
+// Wall clock for the schedule. now() returns hour > 23 if the clock cannot be
+// read, which LedController treats as "no valid time".
+class WallClock {
+public:
+  virtual ~WallClock() {}
+
+  virtual CommandTime now() = 0;
+  virtual void adjust(const CommandTime& time) = 0;
+
+  // Crystal trim (the DS3231 aging offset register): each step of +1 slows
+  // the oscillator by about 0.1 ppm. Clocks without one keep the defaults.
+  virtual bool readAgingOffset(int8_t& /*value*/) { return false; }
+  virtual bool writeAgingOffset(int8_t /*value*/) { return false; }
+};
+
+// Free-running microsecond counter since boot (esp_timer on the ESP32). It is
+// never set or stepped, so it keeps counting when the wall clock fails.
+class MonotonicClock {
+public:
+  virtual ~MonotonicClock() {}
+
+  virtual uint64_t uptimeUs() = 0;
+};
+
+#endif // LIGHTING_HAL_H
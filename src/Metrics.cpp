@@ -0,0 +1,182 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+// Handler latency: dominated by JSON parsing and response building.
+// Kept short because there is one histogram per route.
+const HistogramBuckets HTTP_LATENCY_BUCKETS = {
+  5,
+  {1000, 5000, 10000, 25000, 100000},
+  {"0.001", "0.005", "0.01", "0.025", "0.1"},
+  1000000
+};
+
+const HistogramBuckets JSON_PARSE_BUCKETS = {
+  7,
+  {100, 250, 500, 1000, 2500, 5000, 10000},
+  {"0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005", "0.01"},
+  1000000
+};
+
+// update() includes an RTC read over I2C and Serial logging
+const HistogramBuckets TICK_DURATION_BUCKETS = {
+  8,
+  {100, 250, 500, 1000, 2500, 5000, 10000, 50000},
+  {"0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.05"},
+  1000000
+};
+
+const HistogramBuckets TICK_JITTER_BUCKETS = {
+  8,
+  {500, 1000, 2500, 5000, 10000, 25000, 50000, 100000},
+  {"0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1"},
+  1000000
+};
+
+// Heap deltas: the "0" bucket counts observations that allocated nothing
+const HistogramBuckets HEAP_BYTES_BUCKETS = {
+  7,
+  {0, 64, 256, 1024, 2048, 4096, 8192},
+  {"0", "64", "256", "1024", "2048", "4096", "8192"},
+  1
+};
+
+// BLE write -> result notify: lighting loop period (5 ms) + apply + network task wake-up
+const HistogramBuckets BLE_LATENCY_BUCKETS = {
+  7,
+  {1000, 2500, 5000, 10000, 25000, 50000, 100000},
+  {"0.001", "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1"},
+  1000000
+};
+
+const char* const BOOT_PHASE_NAMES[BOOT_PHASE_COUNT] = {
+  "setup", "rtc", "first_frame", "controller", "loop", "network", "ap_up"
+};
+
+MetricsRegistry metrics;
+
+Histogram::Histogram() : Histogram(HTTP_LATENCY_BUCKETS) {
+}
+
+Histogram::Histogram(const HistogramBuckets& layout) {
+  this->layout = &layout;
+  for (uint8_t i = 0; i < METRICS_MAX_BUCKETS; i++) {
+    buckets[i].store(0, std::memory_order_relaxed);
+  }
+  total.store(0, std::memory_order_relaxed);
+}
+
+void Histogram::observe(uint32_t value) {
+  uint8_t index = 0;
+  while (index < layout->count && value > layout->upper[index]) {
+    index++;
+  }
+  buckets[index].fetch_add(1, std::memory_order_relaxed);
+  total.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint32_t Histogram::count() const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i <= layout->count; i++) {
+    total += bucket(i);
+  }
+  return total;
+}
+
+MetricsRegistry::MetricsRegistry()
+  : jsonParse(JSON_PARSE_BUCKETS),
+    tickDuration(TICK_DURATION_BUCKETS),
+    tickJitter(TICK_JITTER_BUCKETS),
+    tickHeap(HEAP_BYTES_BUCKETS),
+    requestHeap(HEAP_BYTES_BUCKETS),
+    bleLatency(BLE_LATENCY_BUCKETS) {
+  // httpLatency[] memakai layout default (HTTP_LATENCY_BUCKETS)
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    bootPhaseUs[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void MetricsRegistry::markBootPhase(BootPhase phase, uint32_t nowUs) {
+  if (nowUs == 0) {
+    nowUs = 1; // 0 berarti "belum tercapai"
+  }
+  uint32_t expected = 0;
+  bootPhaseUs[phase].compare_exchange_strong(expected, nowUs, std::memory_order_relaxed);
+}
+
+MetricsWriter::MetricsWriter(char* buffer, size_t size) {
+  this->buffer = buffer;
+  this->size = size;
+  this->length = 0;
+  this->overflow = false;
+  if (size > 0) {
+    buffer[0] = '\0';
+  }
+}
+
+void MetricsWriter::append(const char* format, ...) {
+  if (overflow) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(buffer + length, size - length, format, args);
+  va_end(args);
+
+  if (written < 0 || (size_t)written >= size - length) {
+    // Buang baris yang terpotong agar output tetap valid
+    buffer[length] = '\0';
+    overflow = true;
+    return;
+  }
+  length += written;
+}
+
+void MetricsWriter::header(const char* name, const char* type, const char* help) {
+  append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void MetricsWriter::value(const char* name, const char* labels, uint32_t value) {
+  if (labels != nullptr && labels[0] != '\0') {
+    append("%s{%s} %lu\n", name, labels, (unsigned long)value);
+  } else {
+    append("%s %lu\n", name, (unsigned long)value);
+  }
+}
+
+void MetricsWriter::seconds(const char* name, const char* labels, uint32_t micros) {
+  const char* open = (labels != nullptr && labels[0] != '\0') ? "{" : "";
+  const char* close = open[0] != '\0' ? "}" : "";
+  append("%s%s%s%s %lu.%06lu\n", name, open, open[0] != '\0' ? labels : "", close,
+         (unsigned long)(micros / 1000000), (unsigned long)(micros % 1000000));
+}
+
+void MetricsWriter::histogram(const char* name, const char* labels, const Histogram& histogram) {
+  const HistogramBuckets& layout = histogram.getLayout();
+  const char* separator = (labels != nullptr && labels[0] != '\0') ? "," : "";
+  if (labels == nullptr) {
+    labels = "";
+  }
+
+  // Bucket Prometheus bersifat kumulatif; _count diambil dari total yang sama
+  // agar konsisten walaupun ada observe() di tengah render
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < layout.count; i++) {
+    cumulative += histogram.bucket(i);
+    append("%s_bucket{%s%sle=\"%s\"} %lu\n", name, labels, separator, layout.labels[i], (unsigned long)cumulative);
+  }
+  cumulative += histogram.bucket(layout.count);
+  append("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, separator, (unsigned long)cumulative);
+
+  uint32_t sum = histogram.sum();
+  const char* open = labels[0] != '\0' ? "{" : "";
+  const char* close = labels[0] != '\0' ? "}" : "";
+  if (layout.unitsPerExported == 1000000) {
+    append("%s_sum%s%s%s %lu.%06lu\n", name, open, labels, close,
+           (unsigned long)(sum / 1000000), (unsigned long)(sum % 1000000));
+  } else {
+    append("%s_sum%s%s%s %lu\n", name, open, labels, close, (unsigned long)(sum / layout.unitsPerExported));
+  }
+  append("%s_count%s%s%s %lu\n", name, open, labels, close, (unsigned long)cumulative);
+}
@@ -0,0 +1,129 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Buckets per histogram, including the implicit +Inf bucket
+#define METRICS_MAX_BUCKETS 10
+
+// Per-route HTTP histograms, indexed by route table index
+#define METRICS_MAX_ROUTES  32
+
+// Static text buffer used to render /api/metrics
+#define METRICS_BUFFER_SIZE 16384
+
+// Bucket layout shared by histograms of the same kind.
+// Values are recorded in integer units (microseconds or bytes); +Inf is implicit.
+struct HistogramBuckets {
+  uint8_t count;                                // Finite bounds
+  uint32_t upper[METRICS_MAX_BUCKETS - 1];
+  const char* labels[METRICS_MAX_BUCKETS - 1];  // Same bounds in exported units, for "le"
+  uint32_t unitsPerExported;                    // 1000000 for us -> seconds, 1 for bytes
+};
+
+extern const HistogramBuckets HTTP_LATENCY_BUCKETS;
+extern const HistogramBuckets JSON_PARSE_BUCKETS;
+extern const HistogramBuckets TICK_DURATION_BUCKETS;
+extern const HistogramBuckets TICK_JITTER_BUCKETS;
+extern const HistogramBuckets HEAP_BYTES_BUCKETS;
+extern const HistogramBuckets BLE_LATENCY_BUCKETS;
+
+// Boot milestones, recorded once as microseconds since the app started
+// (esp_timer; ROM and second-stage bootloader time is not included)
+enum BootPhase : uint8_t {
+  BOOT_PHASE_SETUP,        // setup() entered
+  BOOT_PHASE_RTC,          // RTC readable
+  BOOT_PHASE_FIRST_FRAME,  // Correct output applied from the boot snapshot
+  BOOT_PHASE_CONTROLLER,   // LedController::begin() done
+  BOOT_PHASE_LOOP,         // First lighting task iteration
+  BOOT_PHASE_NETWORK,      // WiFi service and HTTP server started (background task)
+  BOOT_PHASE_AP_UP,        // Access point verified up
+  BOOT_PHASE_COUNT
+};
+
+extern const char* const BOOT_PHASE_NAMES[BOOT_PHASE_COUNT];
+
+// Monotonic counter
+class Counter {
+private:
+  std::atomic<uint32_t> value;
+
+public:
+  Counter() : value(0) {}
+  void add(uint32_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+  uint32_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Fixed-bucket histogram. observe() is a few relaxed atomic adds and never
+// allocates. A microsecond sum wraps after ~71 minutes of observed time;
+// Prometheus treats that like a counter reset.
+class Histogram {
+private:
+  const HistogramBuckets* layout;
+  std::atomic<uint32_t> buckets[METRICS_MAX_BUCKETS]; // Not cumulative
+  std::atomic<uint32_t> total;
+
+public:
+  Histogram(); // HTTP_LATENCY_BUCKETS
+  explicit Histogram(const HistogramBuckets& layout);
+
+  void observe(uint32_t value);
+
+  const HistogramBuckets& getLayout() const { return *layout; }
+  uint32_t bucket(uint8_t index) const { return buckets[index].load(std::memory_order_relaxed); }
+  uint32_t sum() const { return total.load(std::memory_order_relaxed); }
+  uint32_t count() const;
+};
+
+// All hot-path metrics. Each histogram has a single writer task
+// (HTTP histograms: AsyncTCP, tick histograms: lighting loop).
+struct MetricsRegistry {
+  Histogram httpLatency[METRICS_MAX_ROUTES]; // Handler time per route
+  Histogram jsonParse;                       // deserializeJson() in request handlers
+  Histogram tickDuration;                    // LedController::update()
+  Histogram tickJitter;                      // |tick interval - nominal interval|
+  Histogram tickHeap;                        // Free heap lost across one lighting tick
+  Histogram requestHeap;                     // Free heap still held when a handler returns
+  Histogram bleLatency;                      // BLE write received -> result notified (network task)
+  Counter apRestarts;
+  Counter rateLimited;                       // 429 from admission control
+  Counter shedBusy;                          // 503: heavy in-flight cap
+  Counter shedLowMemory;                     // 503: heap watermark
+  Counter notFound;                          // 404: no route for the path
+  Counter bleResultsDropped;                 // BLE result ring full, command applied without a reply
+  std::atomic<uint32_t> bootPhaseUs[BOOT_PHASE_COUNT]; // 0 = not reached yet
+
+  MetricsRegistry();
+
+  // Record a boot milestone; only the first call per phase counts
+  void markBootPhase(BootPhase phase, uint32_t nowUs);
+};
+
+extern MetricsRegistry metrics;
+
+// Renders Prometheus text exposition format into a caller-owned buffer.
+// Output that does not fit is dropped and truncated() returns true.
+class MetricsWriter {
+private:
+  char* buffer;
+  size_t size;
+  size_t length;
+  bool overflow;
+
+public:
+  MetricsWriter(char* buffer, size_t size);
+
+  void append(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  void header(const char* name, const char* type, const char* help);
+  void value(const char* name, const char* labels, uint32_t value);
+  void seconds(const char* name, const char* labels, uint32_t micros); // Gauge in seconds
+  // Emits _bucket, _sum and _count lines. labels may be nullptr.
+  void histogram(const char* name, const char* labels, const Histogram& histogram);
+
+  size_t getLength() const { return length; }
+  bool truncated() const { return overflow; }
+};
+
+#endif // METRICS_H
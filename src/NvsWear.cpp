@@ -0,0 +1,101 @@
+#include "NvsWear.h"
+#include <Arduino.h>
+#include <string.h>
+
+#define HOUR_MS 3600000UL
+
+const char* const NVS_VALUE_KIND_NAMES[3] = {"primitive", "string", "blob"};
+
+NvsWear nvsWear;
+
+uint16_t nvsEntriesFor(NvsValueKind kind, size_t length) {
+  uint16_t data = (uint16_t)((length + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE);
+  switch (kind) {
+    case NVS_VALUE_PRIMITIVE:
+      return 1;
+    case NVS_VALUE_STRING:
+      return 1 + data;
+    case NVS_VALUE_BLOB:
+    default:
+      return 2 + data;
+  }
+}
+
+uint32_t nvsEstimatedErases(uint32_t entries) {
+  return entries / NVS_PAGE_ENTRIES;
+}
+
+uint32_t nvsProjectedLifetimeDays(float entriesPerHour) {
+  if (entriesPerHour <= 0) return UINT32_MAX;
+  // Erase per page per jam: halaman dipakai bergiliran (wear leveling NVS)
+  float erasesPerPageHour = entriesPerHour / NVS_PAGE_ENTRIES / NVS_PARTITION_PAGES;
+  float days = NVS_FLASH_ENDURANCE / erasesPerPageHour / 24.0f;
+  return days >= (float)UINT32_MAX ? UINT32_MAX : (uint32_t)days;
+}
+
+NvsWear::NvsWear() {
+  memset(keys, 0, sizeof(keys));
+  keyCount = 0;
+  hourStartMs = 0;
+}
+
+// Baris untuk namespace/key; key yang tidak muat lagi dihitung di baris terakhir
+NvsKeyUsage* NvsWear::slot(const char* space, const char* key) {
+  for (uint8_t i = 0; i < keyCount; i++) {
+    if (strcmp(keys[i].space, space) == 0 && strcmp(keys[i].key, key) == 0) {
+      return &keys[i];
+    }
+  }
+  if (keyCount == NVS_WEAR_MAX_KEYS) {
+    NvsKeyUsage* other = &keys[NVS_WEAR_MAX_KEYS - 1];
+    strcpy(other->space, "*");
+    strcpy(other->key, "other");
+    return other;
+  }
+  NvsKeyUsage* usage = &keys[keyCount++];
+  strncpy(usage->space, space, sizeof(usage->space) - 1);
+  strncpy(usage->key, key, sizeof(usage->key) - 1);
+  return usage;
+}
+
+// Tutup jam yang sudah lewat; jam tanpa tulis (gap) juga dihitung sebagai 0
+void NvsWear::roll(uint32_t nowMs) {
+  uint32_t hours = (nowMs - hourStartMs) / HOUR_MS;
+  if (hours == 0) return;
+  for (uint8_t i = 0; i < keyCount; i++) {
+    NvsKeyUsage& usage = keys[i];
+    usage.lastHourWrites = hours == 1 ? usage.hourWrites : 0;
+    if (usage.hourWrites > usage.peakHourWrites) {
+      usage.peakHourWrites = usage.hourWrites;
+    }
+    usage.hourWrites = 0;
+  }
+  hourStartMs += hours * HOUR_MS;
+}
+
+void NvsWear::recordWrite(const char* space, const char* key, NvsValueKind kind, size_t length) {
+  std::lock_guard<std::mutex> guard(lock);
+  roll(millis());
+  NvsKeyUsage* usage = slot(space, key);
+  usage->kind = kind;
+  usage->valueBytes = length > UINT16_MAX ? UINT16_MAX : (uint16_t)length;
+  usage->writes++;
+  usage->bytes += length;
+  usage->entries += nvsEntriesFor(kind, length);
+  usage->hourWrites++;
+}
+
+// Hapus hanya menandai entry di bitmap halaman: tidak memakai entry baru
+void NvsWear::recordRemove(const char* space, const char* key) {
+  std::lock_guard<std::mutex> guard(lock);
+  roll(millis());
+  slot(space, key)->removes++;
+}
+
+uint8_t NvsWear::snapshot(NvsKeyUsage* out, uint8_t max) {
+  std::lock_guard<std::mutex> guard(lock);
+  roll(millis());
+  uint8_t count = keyCount < max ? keyCount : max;
+  memcpy(out, keys, count * sizeof(NvsKeyUsage));
+  return count;
+}
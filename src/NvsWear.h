@@ -0,0 +1,89 @@
+#ifndef NVS_WEAR_H
+#define NVS_WEAR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+
+// ESP-IDF NVS layout: 4 KB pages, each with a 32-byte header and a 32-byte
+// entry state bitmap, then 126 entries of 32 bytes. Every write appends new
+// entries and marks the old ones erased; a page is erased only when it is
+// garbage-collected.
+#define NVS_PAGE_SIZE        4096
+#define NVS_ENTRY_SIZE       32
+#define NVS_PAGE_ENTRIES     126
+
+// "nvs" partition of the default partition table (0x5000). One page is
+// always kept free for garbage collection.
+#define NVS_PARTITION_PAGES  5
+
+// Rated erase cycles per flash sector
+#define NVS_FLASH_ENDURANCE  100000
+
+// Keys with their own row; any further key is counted in the last row
+#define NVS_WEAR_MAX_KEYS    8
+
+// Writes per key in one hour above which the key is reported as over budget.
+// At this rate a 12-byte blob alone would wear out the partition in ~40 years.
+#define NVS_KEY_HOURLY_BUDGET 60
+
+enum NvsValueKind : uint8_t {
+  NVS_VALUE_PRIMITIVE,  // putBool/putUChar/...: one entry
+  NVS_VALUE_STRING,     // One header entry + data entries
+  NVS_VALUE_BLOB        // Index entry + chunk header + data entries
+};
+
+extern const char* const NVS_VALUE_KIND_NAMES[3];
+
+// Entries one write of length bytes takes in flash
+uint16_t nvsEntriesFor(NvsValueKind kind, size_t length);
+
+// Page erases implied by entries written (one per NVS_PAGE_ENTRIES, before
+// garbage-collection copies)
+uint32_t nvsEstimatedErases(uint32_t entries);
+
+// Days until the partition reaches NVS_FLASH_ENDURANCE at a steady
+// entriesPerHour, with erases spread over all pages. An upper bound: the
+// host model (SimulatedNvsFlash.h) also counts garbage-collection copies.
+uint32_t nvsProjectedLifetimeDays(float entriesPerHour);
+
+// Usage of one namespace/key since boot
+struct NvsKeyUsage {
+  char space[16];
+  char key[16];
+  NvsValueKind kind;       // Of the last write
+  uint16_t valueBytes;     // Size of the last write
+  uint32_t writes;         // put calls
+  uint32_t removes;
+  uint32_t bytes;          // Payload bytes written
+  uint32_t entries;        // 32-byte entries written
+  uint32_t hourWrites;     // Writes in the current hour
+  uint32_t lastHourWrites; // Writes in the last complete hour
+  uint32_t peakHourWrites; // Most writes in any complete hour since boot
+};
+
+// Accounting for every NVS put/remove, called next to the Preferences or
+// KeyValueStore call. Hours are counted from boot (millis()).
+class NvsWear {
+private:
+  std::mutex lock;
+  NvsKeyUsage keys[NVS_WEAR_MAX_KEYS];
+  uint8_t keyCount;
+  uint32_t hourStartMs;
+
+  NvsKeyUsage* slot(const char* space, const char* key);
+  void roll(uint32_t nowMs);
+
+public:
+  NvsWear();
+
+  void recordWrite(const char* space, const char* key, NvsValueKind kind, size_t length);
+  void recordRemove(const char* space, const char* key);
+
+  // Copies up to max rows (hour counters brought up to date); returns the count
+  uint8_t snapshot(NvsKeyUsage* out, uint8_t max);
+};
+
+extern NvsWear nvsWear;
+
+#endif // NVS_WEAR_H
@@ -0,0 +1,98 @@
+#include "ScheduleSimulator.h"
+#include <stdio.h>
+#include <string.h>
+
+static_assert(sizeof(SimBinaryHeader) == 16, "SimBinaryHeader layout is part of the trace format");
+
+ScheduleSimulation::ScheduleSimulation() {
+  memset(schedule, 0, sizeof(schedule));
+  scheduleVersion = 0;
+  stepSeconds = 60;
+  format = SIM_FORMAT_CSV;
+  frameCount = 0;
+  next = 0;
+  headerDone = true;
+  pendingLength = 0;
+  pendingOffset = 0;
+}
+
+void ScheduleSimulation::begin(LedController* controller, SimFormat format, uint16_t stepSeconds) {
+  // Dari snapshot: simulasi dimulai di handler HTTP, bukan di lighting task
+  ControllerSnapshot state;
+  controller->readSnapshot(state);
+  HourlyProfile copy[24];
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    copy[hour].hour = hour;
+    copy[hour].profile = state.profiles[hour];
+  }
+  begin(copy, state.scheduleVersion, format, stepSeconds);
+}
+
+void ScheduleSimulation::begin(const HourlyProfile* schedule, uint32_t scheduleVersion, SimFormat format,
+                               uint16_t stepSeconds) {
+  memcpy(this->schedule, schedule, sizeof(this->schedule));
+  this->scheduleVersion = scheduleVersion;
+  this->format = format;
+  if (stepSeconds < 1) stepSeconds = 1;
+  if (stepSeconds > SIM_MAX_STEP_SECONDS) stepSeconds = SIM_MAX_STEP_SECONDS;
+  this->stepSeconds = stepSeconds;
+  frameCount = (SIM_DAY_SECONDS + stepSeconds - 1) / stepSeconds;
+  next = 0;
+  headerDone = false;
+  pendingLength = 0;
+  pendingOffset = 0;
+}
+
+LightProfile ScheduleSimulation::frame(uint32_t index) {
+  // Jam virtual: detik ke-N hari ini, tanpa RTC
+  uint32_t second = (index * (uint32_t)stepSeconds) % SIM_DAY_SECONDS;
+  return LedController::scheduleFrame(schedule, second / 3600, (second / 60) % 60);
+}
+
+// Render satu item berikutnya ke pending; false jika trace sudah selesai
+bool ScheduleSimulation::render() {
+  int length;
+  if (!headerDone) {
+    headerDone = true;
+    if (format == SIM_FORMAT_BINARY) {
+      SimBinaryHeader header = {SIM_BINARY_MAGIC, SIM_BINARY_FORMAT, LED_CHANNEL_COUNT,
+                                stepSeconds, frameCount, scheduleVersion};
+      memcpy(pending, &header, sizeof(header));
+      length = sizeof(header);
+    } else {
+      length = snprintf(pending, sizeof(pending), "second,royalBlue,blue,uv,violet,red,green,white\n");
+    }
+  } else if (next < frameCount) {
+    LightProfile profile = frame(next);
+    if (format == SIM_FORMAT_BINARY) {
+      memcpy(pending, &profile, LED_CHANNEL_COUNT);
+      length = LED_CHANNEL_COUNT;
+    } else {
+      length = snprintf(pending, sizeof(pending), "%lu,%u,%u,%u,%u,%u,%u,%u\n",
+                        (unsigned long)next * stepSeconds, profile.royalBlue, profile.blue, profile.uv,
+                        profile.violet, profile.red, profile.green, profile.white);
+    }
+    next++;
+  } else {
+    return false;
+  }
+
+  pendingLength = length < (int)sizeof(pending) ? length : sizeof(pending) - 1;
+  pendingOffset = 0;
+  return true;
+}
+
+size_t ScheduleSimulation::read(uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    if (pendingOffset >= pendingLength && !render()) {
+      break;
+    }
+    size_t chunk = pendingLength - pendingOffset;
+    if (chunk > size - written) chunk = size - written;
+    memcpy(buffer + written, pending + pendingOffset, chunk);
+    pendingOffset += chunk;
+    written += chunk;
+  }
+  return written;
+}
@@ -0,0 +1,73 @@
+#ifndef SCHEDULE_SIMULATOR_H
+#define SCHEDULE_SIMULATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "LedController.h"
+
+// Full-day output trace of an hourly schedule on a virtual clock. Every frame
+// comes from LedController::scheduleFrame(), the function the lighting loop
+// uses in auto mode, so the trace is what the fixture would drive at each
+// time of day. Used by GET /api/schedule/preview and by the native driver's
+// "simulate" command.
+//
+// The trace is rendered in pieces (like TraceExport), so it can be streamed
+// in chunks of any size: a day at 1 s resolution is ~600 KB binary or
+// ~1.8 MB CSV and is never held in memory.
+
+#define SIM_DAY_SECONDS      86400
+#define SIM_MAX_STEP_SECONDS 3600
+
+enum SimFormat : uint8_t {
+  SIM_FORMAT_CSV,     // "second,royalBlue,...,white" header, one line per frame
+  SIM_FORMAT_BINARY   // SimBinaryHeader, then LED_CHANNEL_COUNT bytes per frame
+};
+
+#define SIM_BINARY_MAGIC  0x4D534C53  // "SLSM" little-endian
+#define SIM_BINARY_FORMAT 1
+
+// Binary trace header (little-endian). Frame i is the output at second
+// i * stepSeconds of the day; channels in LedChannel order.
+struct SimBinaryHeader {
+  uint32_t magic;
+  uint8_t format;
+  uint8_t channels;
+  uint16_t stepSeconds;
+  uint32_t frameCount;
+  uint32_t scheduleVersion;
+};
+
+class ScheduleSimulation {
+private:
+  HourlyProfile schedule[24];  // Copy taken by begin()
+  uint32_t scheduleVersion;
+  uint16_t stepSeconds;
+  SimFormat format;
+  uint32_t frameCount;
+  uint32_t next;               // Next frame to render
+  bool headerDone;
+  char pending[64];            // Rendered item that did not fit the last chunk
+  size_t pendingLength;
+  size_t pendingOffset;
+
+  bool render();
+
+public:
+  ScheduleSimulation();
+
+  // stepSeconds is clamped to 1..SIM_MAX_STEP_SECONDS. The controller variant
+  // copies the published snapshot, so any task may start a simulation.
+  void begin(LedController* controller, SimFormat format, uint16_t stepSeconds);
+  void begin(const HourlyProfile* schedule, uint32_t scheduleVersion, SimFormat format, uint16_t stepSeconds);
+
+  // Fills up to size bytes; returns 0 when the trace is complete
+  size_t read(uint8_t* buffer, size_t size);
+
+  LightProfile frame(uint32_t index);
+  uint32_t getFrameCount() { return frameCount; }
+  uint16_t getStepSeconds() { return stepSeconds; }
+  // Exact size of the binary trace (CSV lines vary in length)
+  size_t binaryLength() { return sizeof(SimBinaryHeader) + (size_t)frameCount * LED_CHANNEL_COUNT; }
+};
+
+#endif // SCHEDULE_SIMULATOR_H
@@ -0,0 +1,238 @@
+#ifndef SIMULATED_LIGHTING_HAL_H
+#define SIMULATED_LIGHTING_HAL_H
+
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "LightingHal.h"
+
+// In-memory LightingHal implementations for the native build. Header-only
+// and not used by the firmware build. Each one keeps counters of what was
+// called so a host program can check the effect of a command.
+
+// PWM channels as plain duty values
+class SimulatedPwmSink : public PwmSink {
+public:
+  uint8_t duty[LED_CHANNEL_COUNT] = {};
+  bool latched = false;
+  uint32_t begins = 0;
+  uint32_t writes = 0;
+
+  // Make read() disagree with the last write on one channel (LEDC fault)
+  int8_t stuckChannel = -1;
+
+  void begin() override {
+    begins++;
+    stuckChannel = -1;
+  }
+
+  void write(uint8_t channel, uint8_t value) override {
+    writes++;
+    duty[channel] = value;
+  }
+
+  uint32_t read(uint8_t channel) override {
+    return channel == stuckChannel ? duty[channel] ^ 0xFF : duty[channel];
+  }
+
+  void latch(const uint8_t* frame) override {
+    for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+      duty[i] = frame[i] >= 128 ? 255 : 0;
+    }
+    latched = true;
+  }
+
+  void releaseLatch() override {
+    latched = false;
+  }
+
+  LightProfile frame() const {
+    LightProfile profile;
+    memcpy(&profile, duty, sizeof(profile));
+    return profile;
+  }
+};
+
+// Every value is stored as raw bytes, like an NVS blob. Survives a
+// simulated reboot as long as the same instance is handed to the new
+// LedController.
+class MemoryKeyValueStore : public KeyValueStore {
+public:
+  std::map<std::string, std::vector<uint8_t>> values;
+  uint32_t writes = 0;     // putBytes + remove
+  bool open = false;
+
+  bool begin(const char* name) override {
+    (void)name;
+    open = true;
+    return true;
+  }
+
+  void end() override {
+    open = false;
+  }
+
+  bool isKey(const char* key) override {
+    return values.count(key) != 0;
+  }
+
+  size_t getBytesLength(const char* key) override {
+    auto it = values.find(key);
+    return it == values.end() ? 0 : it->second.size();
+  }
+
+  size_t getBytes(const char* key, void* buffer, size_t length) override {
+    auto it = values.find(key);
+    if (it == values.end() || it->second.size() > length) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+  size_t putBytes(const char* key, const void* value, size_t length) override {
+    if (strlen(key) > 15) return 0;
+    const uint8_t* bytes = (const uint8_t*)value;
+    values[key].assign(bytes, bytes + length);
+    writes++;
+    return length;
+  }
+
+  bool remove(const char* key) override {
+    writes++;
+    return values.erase(key) != 0;
+  }
+
+  bool getBool(const char* key, bool defaultValue) override {
+    return getUChar(key, defaultValue ? 1 : 0) != 0;
+  }
+
+  uint8_t getUChar(const char* key, uint8_t defaultValue) override {
+    auto it = values.find(key);
+    return it == values.end() || it->second.size() != 1 ? defaultValue : it->second[0];
+  }
+
+  // Stored with the terminating NUL, as NVS does
+  size_t getString(const char* key, char* buffer, size_t length) override {
+    auto it = values.find(key);
+    if (it == values.end() || it->second.empty() || it->second.size() > length) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    buffer[it->second.size() - 1] = '\0';
+    return it->second.size();
+  }
+
+  // Legacy values as written by older firmware
+  void putString(const char* key, const char* value) {
+    putBytes(key, value, strlen(value) + 1);
+  }
+
+  void putUChar(const char* key, uint8_t value) {
+    putBytes(key, &value, 1);
+  }
+};
+
+// DS3231 aging offset: rate change per step at 25 °C
+#define SIMULATED_AGING_STEP_PPB 100
+
+// Clock that only moves when told to. failed makes reads fail like a DS3231
+// that stopped answering; lostPower is cleared by adjust(), like the OSF flag.
+// advanceMs() runs it at a drifting rate that the aging offset trims.
+class ManualClock : public WallClock {
+public:
+  CommandTime time = {2024, 1, 1, 0, 0, 0};
+  uint32_t adjustments = 0;
+  bool failed = false;
+  bool lostPower = false;
+  int32_t ratePpb = 0;       // Oscillator error, positive: runs fast
+  int8_t aging = 0;          // Aging offset register
+  int64_t subsecondNs = 0;   // Into the current second
+
+  CommandTime now() override {
+    if (failed) return {0, 0, 0, 0xFF, 0, 0};
+    return time;
+  }
+
+  // Like the DS3231, a write restarts the current second
+  void adjust(const CommandTime& value) override {
+    time = value;
+    subsecondNs = 0;
+    lostPower = false;
+    adjustments++;
+  }
+
+  // Battery removed: the oscillator restarts from its reset value
+  void losePower() {
+    time = {2000, 1, 1, 0, 0, 0};
+    aging = 0;
+    lostPower = true;
+  }
+
+  void set(uint8_t hour, uint8_t minute, uint8_t second = 0) {
+    time.hour = hour;
+    time.minute = minute;
+    time.second = second;
+  }
+
+  // Move forward, rolling over into the next days and months
+  void advance(uint32_t seconds) {
+    uint32_t total = time.second + time.minute * 60UL + time.hour * 3600UL + seconds;
+    time.second = total % 60;
+    time.minute = (total / 60) % 60;
+    time.hour = (total / 3600) % 24;
+    for (uint32_t days = total / 86400; days > 0; days--) {
+      if (++time.day > daysInMonth(time.year, time.month)) {
+        time.day = 1;
+        if (++time.month > 12) {
+          time.month = 1;
+          time.year++;
+        }
+      }
+    }
+  }
+
+  // Move forward by ms of real time, at the oscillator's rate (ratePpb,
+  // slowed by SIMULATED_AGING_STEP_PPB per aging step)
+  void advanceMs(uint64_t ms) {
+    int64_t rate = ratePpb - aging * SIMULATED_AGING_STEP_PPB;
+    subsecondNs += (int64_t)ms * 1000000 + (int64_t)ms * rate / 1000;
+    advance((uint32_t)(subsecondNs / 1000000000));
+    subsecondNs %= 1000000000;
+  }
+
+  bool readAgingOffset(int8_t& value) override {
+    if (failed) return false;
+    value = aging;
+    return true;
+  }
+
+  bool writeAgingOffset(int8_t value) override {
+    if (failed) return false;
+    aging = value;
+    return true;
+  }
+
+  static uint8_t daysInMonth(uint16_t year, uint8_t month) {
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) return 29;
+    return days[(month - 1) % 12];
+  }
+};
+
+// Uptime counter that only moves when told to
+class ManualTimer : public MonotonicClock {
+public:
+  uint64_t us = 0;
+
+  uint64_t uptimeUs() override {
+    return us;
+  }
+
+  void advance(uint32_t seconds) {
+    us += seconds * 1000000ULL;
+  }
+
+  void advanceMs(uint64_t ms) {
+    us += ms * 1000ULL;
+  }
+};
+
+#endif // SIMULATED_LIGHTING_HAL_H
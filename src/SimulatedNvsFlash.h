@@ -0,0 +1,153 @@
+#ifndef SIMULATED_NVS_FLASH_H
+#define SIMULATED_NVS_FLASH_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "NvsWear.h"
+
+// Page-level model of ESP-IDF NVS for projecting flash wear from a write mix
+// on the host. Header-only and not used by the firmware build.
+//
+// Follows nvs_flash's allocation: writes append entries to the active page
+// and mark the previous copy of the key erased. A value that does not fit
+// closes the page (blobs are split into chunks instead). When only the
+// reserved free page is left, the full page with the most erased entries is
+// garbage-collected: its live entries are copied into the reserved page,
+// which becomes active, and the victim is erased and becomes the new free
+// page.
+class SimulatedNvsFlash {
+private:
+  struct Page {
+    uint16_t used = 0;      // Entries written (or skipped) since the last erase
+    uint16_t erased = 0;    // Of those, superseded entries
+    uint32_t eraseCount = 0;
+  };
+
+  struct Span {
+    uint8_t page;
+    uint16_t entries;
+  };
+
+  std::vector<Page> pages;
+  std::vector<uint8_t> freePages;
+  std::map<std::string, std::vector<Span>> items;
+  uint8_t active;
+
+  uint16_t room() const { return NVS_PAGE_ENTRIES - pages[active].used; }
+
+  // Close the active page and open the next one; false if NVS is full
+  bool nextPage() {
+    pages[active].used = NVS_PAGE_ENTRIES;
+    if (freePages.size() > 1) {
+      active = freePages.front();
+      freePages.erase(freePages.begin());
+      return true;
+    }
+
+    uint8_t victim = active;
+    uint16_t mostErased = 0;
+    for (uint8_t i = 0; i < pages.size(); i++) {
+      if (i != active && pages[i].used > 0 && pages[i].erased > mostErased) {
+        victim = i;
+        mostErased = pages[i].erased;
+      }
+    }
+    if (mostErased == 0 || freePages.empty()) return false;
+
+    active = freePages.front();
+    freePages.erase(freePages.begin());
+    for (auto& item : items) {
+      for (Span& span : item.second) {
+        if (span.page == victim) {
+          span.page = active;
+          pages[active].used += span.entries;
+          copies += span.entries;
+        }
+      }
+    }
+    pages[victim] = Page{0, 0, pages[victim].eraseCount + 1};
+    erases++;
+    freePages.push_back(victim);
+    return true;
+  }
+
+  void release(const std::vector<Span>& spans) {
+    for (const Span& span : spans) {
+      pages[span.page].erased += span.entries;
+    }
+  }
+
+public:
+  uint32_t erases = 0;       // Page erases
+  uint32_t copies = 0;       // Entries moved by garbage collection
+  uint32_t entries = 0;      // Entries written by write()
+  uint32_t failures = 0;     // Writes that found no space
+
+  explicit SimulatedNvsFlash(uint8_t pageCount = NVS_PARTITION_PAGES) {
+    pages.resize(pageCount);
+    active = 0;
+    for (uint8_t i = 1; i < pageCount; i++) {
+      freePages.push_back(i);
+    }
+  }
+
+  bool write(const std::string& key, NvsValueKind kind, size_t length) {
+    uint16_t need = nvsEntriesFor(kind, length);
+    std::vector<Span> spans;
+
+    if (kind == NVS_VALUE_BLOB) {
+      // Chunk = header + data; the index entry goes last
+      uint16_t data = need - 2;
+      while (data > 0) {
+        while (room() < 2) {
+          if (!nextPage()) {
+            failures++;
+            return false;
+          }
+        }
+        uint16_t chunk = room() - 1 < data ? room() - 1 : data;
+        spans.push_back({active, (uint16_t)(chunk + 1)});
+        pages[active].used += chunk + 1;
+        entries += chunk + 1;
+        data -= chunk;
+      }
+      need = 1;
+    }
+
+    while (room() < need) {
+      if (!nextPage()) {
+        failures++;
+        return false;
+      }
+    }
+    spans.push_back({active, need});
+    pages[active].used += need;
+    entries += need;
+
+    std::vector<Span>& item = items[key];
+    release(item);
+    item = spans;
+    return true;
+  }
+
+  void remove(const std::string& key) {
+    auto it = items.find(key);
+    if (it == items.end()) return;
+    release(it->second);
+    items.erase(it);
+  }
+
+  uint8_t pageCount() const { return (uint8_t)pages.size(); }
+  uint32_t pageErases(uint8_t page) const { return pages[page].eraseCount; }
+
+  uint32_t maxPageErases() const {
+    uint32_t most = 0;
+    for (const Page& page : pages) {
+      if (page.eraseCount > most) most = page.eraseCount;
+    }
+    return most;
+  }
+};
+
+#endif // SIMULATED_NVS_FLASH_H
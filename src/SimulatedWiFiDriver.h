@@ -0,0 +1,96 @@
+#ifndef SIMULATED_WIFI_DRIVER_H
+#define SIMULATED_WIFI_DRIVER_H
+
+#include <stdio.h>
+#include "WiFiDriver.h"
+
+// Host-side WiFiDriver for exercising WiFiLink without a radio.
+// Failures are injected by counters: each one makes the next N calls of that
+// kind fail, then the driver behaves normally again. Header-only and not
+// used by the firmware build.
+class SimulatedWiFiDriver : public WiFiDriver {
+public:
+  // Failure injection
+  uint8_t failEnableAP = 0;     // enableAP() returns false
+  uint8_t failStartAP = 0;      // startAP() returns false
+  uint8_t dropStartEvent = 0;   // startAP() succeeds but no AP_START event is posted
+  uint8_t stopAfterStart = 0;   // AP_START immediately followed by AP_STOP
+  uint8_t wrongAddress = 0;     // addressValid() returns false
+
+  // Observed calls
+  uint32_t shutdowns = 0;
+  uint32_t resetSteps = 0;
+  uint32_t apStarts = 0;
+  bool apRunning = false;
+  uint8_t stations = 0;
+  bool verbose = false;
+
+  // Same call sequence as Esp32WiFiDriver; there are no events to register
+  void begin() {}
+
+  // Simulate the AP going down on its own (e.g. driver crash)
+  void dropAP() {
+    apRunning = false;
+    post(WIFI_EVENT_AP_STOP);
+  }
+
+  void shutdown() override {
+    shutdowns++;
+    apRunning = false;
+    stations = 0;
+  }
+
+  void resetStep(WiFiResetStep step) override {
+    (void)step;
+    resetSteps++;
+  }
+
+  bool enableAP() override {
+    return !consume(failEnableAP);
+  }
+
+  bool configureAP() override {
+    return true;
+  }
+
+  bool startAP(const char* ssid, const char* password) override {
+    (void)ssid;
+    (void)password;
+    if (consume(failStartAP)) {
+      return false;
+    }
+    apStarts++;
+    if (consume(dropStartEvent)) {
+      return true;
+    }
+    apRunning = true;
+    post(WIFI_EVENT_AP_START);
+    if (consume(stopAfterStart)) {
+      dropAP();
+    }
+    return true;
+  }
+
+  bool addressValid() override {
+    return apRunning && !consume(wrongAddress);
+  }
+
+  uint8_t stationCount() override {
+    return stations;
+  }
+
+  void log(const char* message) override {
+    if (verbose) {
+      printf("%s\n", message);
+    }
+  }
+
+private:
+  static bool consume(uint8_t& counter) {
+    if (counter == 0) return false;
+    counter--;
+    return true;
+  }
+};
+
+#endif // SIMULATED_WIFI_DRIVER_H
@@ -0,0 +1,755 @@
+#include "TimeKeeper.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include "CommandCodec.h"
+#include "NvsWear.h"
+
+#define DAY_MS 86400000LL
+
+// Selisih pembacaan RTC terhadap estimasi yang masih dianggap cocok
+#define RTC_AGREE_MS 2000
+
+// RTC yang mundur lebih dari ini dari waktu terakhir yang disimpan sudah pernah reset
+#define RTC_BEHIND_LIMIT_MS 60000
+
+// Estimasi boleh keluar dari detik yang ditunjukkan RTC sebanyak ini (RTC ditulis
+// sampai TIME_RTC_WRITE_WINDOW_MS setelah batas detik, jadi tertinggal sebanyak itu)
+#define RTC_PHASE_MARGIN_MS 50
+
+// Ukuran record format 1 (sebelum pembelajaran laju RTC), dimigrasi saat boot
+#define TIME_RECORD_V1_SIZE 24
+
+const char* const RTC_STATE_NAMES[4] = {"ok", "missing", "lost_power", "read_error"};
+const char* const TIME_SOURCE_NAMES[2] = {"rtc", "timer"};
+const char* const TIME_SYNC_RESULT_NAMES[3] = {"none", "accepted", "rejected"};
+
+// Hari sejak 1970-01-01 untuk tanggal sipil (algoritme days_from_civil)
+static int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+  year -= month <= 2;
+  int32_t era = (year >= 0 ? year : year - 399) / 400;
+  uint32_t yearOfEra = (uint32_t)(year - era * 400);
+  uint32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+static const int32_t EPOCH_DAYS = daysFromCivil(2000, 1, 1);
+
+int64_t timeToEpochMs(const CommandTime& time) {
+  int64_t days = daysFromCivil(time.year, time.month, time.day) - EPOCH_DAYS;
+  return days * DAY_MS + (time.hour * 3600L + time.minute * 60L + time.second) * 1000LL;
+}
+
+CommandTime epochMsToTime(int64_t epochMs) {
+  if (epochMs < 0) epochMs = 0;
+  int32_t days = (int32_t)(epochMs / DAY_MS) + EPOCH_DAYS;
+  uint32_t seconds = (uint32_t)((epochMs % DAY_MS) / 1000);
+
+  // Kebalikan daysFromCivil (civil_from_days)
+  days += 719468;
+  int32_t era = days / 146097;
+  uint32_t dayOfEra = (uint32_t)(days - era * 146097);
+  uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  uint32_t monthIndex = (5 * dayOfYear + 2) / 153;
+
+  CommandTime time;
+  time.day = (uint8_t)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+  time.month = (uint8_t)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+  time.year = (uint16_t)(yearOfEra + era * 400 + (time.month <= 2));
+  time.hour = seconds / 3600;
+  time.minute = (seconds / 60) % 60;
+  time.second = seconds % 60;
+  return time;
+}
+
+TimeKeeper::TimeKeeper(WallClock* rtc, MonotonicClock* timer, KeyValueStore* store) {
+  this->rtc = rtc;
+  this->timer = timer;
+  this->store = store;
+  this->rtcState = RTC_STATE_MISSING;
+  this->source = TIME_SOURCE_TIMER;
+  this->anchorMs = 0;
+  this->anchorUs = 0;
+  this->anchorErrorMs = TIME_ERROR_UNKNOWN;
+  this->setValid = false;
+  this->setMs = 0;
+  this->setUs = 0;
+  this->setErrorMs = 0;
+  this->rtcSetMs = 0;
+  this->rtcSetErrorMs = 0;
+  this->rtcSetOffsetMs = 0;
+  this->rtcSetAging = 0;
+  this->rtcDriftPpb = 0;
+  this->rtcDriftWeight = 0;
+  this->rtcDriftSamples = 0;
+  this->aging = 0;
+  this->edgeValid = false;
+  this->edgeMs = 0;
+  this->edgeUs = 0;
+  this->edgeErrorMs = 0;
+  this->captureActive = false;
+  this->captureMs = 0;
+  this->captureUs = 0;
+  this->captureStartUs = 0;
+  this->lastCaptureUs = 0;
+  this->driftPpb = 0;
+  this->driftWeight = 0;
+  this->driftSamples = 0;
+  this->lastSaveUs = 0;
+  this->lastRetryUs = 0;
+  this->saveDue = false;
+  this->slewMs = 0;
+  this->slewStartUs = 0;
+  this->rtcWritePending = false;
+  this->nextSyncId = 1;
+  this->syncAccuracyMs = TIME_ERROR_UNKNOWN;
+  this->syncOffsetMs = 0;
+  this->syncCorrections = 0;
+  resetSync();
+}
+
+// Sesi sync baru: sampel dan exchange yang tertunda dibuang
+void TimeKeeper::resetSync() {
+  for (uint8_t i = 0; i < TIME_SYNC_PENDING; i++) {
+    exchanges[i].id = 0;
+  }
+  nextExchange = 0;
+  sampleCount = 0;
+  nextSample = 0;
+  lastSampleUs = 0;
+  shiftMs = 0;
+}
+
+// Dipanggil sebelum output pertama: tanpa logging
+void TimeKeeper::begin(RtcState rtcAtBoot, const CommandTime& buildTime) {
+  std::lock_guard<std::mutex> guard(lock);
+  uint64_t nowUs = timer->uptimeUs();
+  lastSaveUs = nowUs;
+  lastRetryUs = nowUs;
+  setValid = false;
+  saveDue = false;
+  slewMs = 0;
+  rtcWritePending = false;
+  resetSync();
+  edgeValid = false;
+  captureActive = false;
+  lastCaptureUs = nowUs - TIME_RTC_EDGE_INTERVAL_S * 1000000ULL;  // Tepi detik pertama segera dicari
+
+  Record record = {};
+  store->begin(TIME_STORE_NAMESPACE);
+  size_t length = store->getBytesLength(TIME_RECORD_KEY);
+  if (length == TIME_RECORD_V1_SIZE) {
+    // Format 1: bagian format 2 tetap nol (laju RTC belum dipelajari, aging 0)
+    if (store->getBytes(TIME_RECORD_KEY, &record, length) != length || record.format != 1) {
+      record = {};
+    }
+    record.rtcSetOffsetMs = 0;
+  } else if (length != sizeof(record) ||
+             store->getBytes(TIME_RECORD_KEY, &record, sizeof(record)) != sizeof(record) ||
+             record.format != TIME_RECORD_FORMAT) {
+    record = {};
+  }
+  rtcSetMs = record.rtcSetSeconds * 1000LL + record.rtcSetMillis;
+  rtcSetErrorMs = record.rtcSetErrorMs;
+  rtcSetOffsetMs = record.rtcSetOffsetMs;
+  rtcSetAging = record.rtcSetAging;
+  rtcDriftPpb = record.rtcDriftPpb;
+  rtcDriftWeight = record.rtcDriftWeight;
+  rtcDriftSamples = record.rtcDriftSamples;
+  aging = record.aging;
+  driftPpb = record.driftPpb;
+  driftWeight = record.driftWeight;
+  driftSamples = record.driftSamples;
+
+  // Register aging di chip yang berlaku; hilang bersama daya (kembali 0)
+  int8_t chipAging;
+  if (rtcAtBoot != RTC_STATE_MISSING && rtc->readAgingOffset(chipAging) && chipAging != aging) {
+    aging = chipAging;
+  }
+  if (rtcAtBoot == RTC_STATE_LOST_POWER) rtcSetMs = 0;
+
+  // Waktu tidak pernah lebih awal dari build firmware maupun waktu terakhir yang disimpan
+  int64_t lastKnownMs = record.seconds * 1000LL;
+  int64_t buildMs = timeToEpochMs(buildTime);
+  if (buildMs > lastKnownMs) lastKnownMs = buildMs;
+
+  rtcState = rtcAtBoot;
+  int64_t rtcMs;
+  if (rtcState == RTC_STATE_OK) {
+    if (!readRtc(rtcMs)) {
+      rtcState = RTC_STATE_READ_ERROR;
+    } else if (rtcMs + RTC_BEHIND_LIMIT_MS < lastKnownMs) {
+      // Flag OSF tidak terpasang, tapi waktunya mundur: baterai lemah atau reset
+      rtcState = RTC_STATE_LOST_POWER;
+      rtcSetMs = 0;
+    } else {
+      useRtc(rtcMs, nowUs);
+      return;
+    }
+  }
+
+  // Tanpa RTC: lanjut dari waktu terakhir; lama padam tidak diketahui
+  source = TIME_SOURCE_TIMER;
+  anchorMs = lastKnownMs;
+  anchorUs = nowUs;
+  anchorErrorMs = TIME_ERROR_UNKNOWN;
+}
+
+bool TimeKeeper::readRtcRaw(int64_t& ms) {
+  CommandTime time = rtc->now();
+  if (!commandTimeValid(time)) {
+    return false;
+  }
+  ms = timeToEpochMs(time);
+  return true;
+}
+
+// Sisa laju RTC setelah register aging, dikoreksi di software
+int32_t TimeKeeper::rtcCorrectionPpb() {
+  if (rtcDriftSamples == 0) return 0;
+  return rtcDriftPpb - aging * TIME_AGING_STEP_PPB;
+}
+
+// Pembacaan RTC dikoreksi: fase saat ditulis dan sisa laju sejak set terakhir
+bool TimeKeeper::readRtc(int64_t& ms) {
+  if (!readRtcRaw(ms)) return false;
+  if (rtcSetMs != 0) {
+    ms -= rtcSetOffsetMs;
+    ms -= (ms - rtcSetMs) * rtcCorrectionPpb() / 1000000000LL;
+  }
+  return true;
+}
+
+// Waktu RTC mentah saat ini dengan resolusi ms: dari tepi detik terakhir jika masih
+// cocok dengan detik yang terbaca, kalau tidak tengah detik itu (±500 ms)
+bool TimeKeeper::rtcMsNow(uint64_t nowUs, int64_t& ms, uint32_t& error) {
+  int64_t second;
+  if (!readRtcRaw(second)) return false;
+  if (edgeValid) {
+    int64_t elapsedMs = (int64_t)((nowUs - edgeUs) / 1000);
+    int64_t fromEdge = edgeMs + elapsedMs + elapsedMs * driftPpb / 1000000000LL;
+    if (fromEdge >= second - RTC_PHASE_MARGIN_MS && fromEdge < second + 1000 + RTC_PHASE_MARGIN_MS) {
+      ms = fromEdge < second ? second : fromEdge > second + 999 ? second + 999 : fromEdge;
+      error = edgeErrorMs + (uint32_t)(elapsedMs * TIME_TIMER_TOLERANCE_PPB / 1000000000LL);
+      return true;
+    }
+  }
+  ms = second + 500;
+  error = 500;
+  return true;
+}
+
+// Dipanggil tiap update(): sekali per TIME_RTC_EDGE_INTERVAL_S, RTC dibaca terus sampai
+// detiknya berganti; tepi detik ada di antara dua pembacaan terakhir
+void TimeKeeper::captureEdge(uint64_t nowUs) {
+  if (rtcState != RTC_STATE_OK) {
+    captureActive = false;
+    return;
+  }
+  int64_t second;
+  if (!captureActive) {
+    if (nowUs - lastCaptureUs < TIME_RTC_EDGE_INTERVAL_S * 1000000ULL) return;
+    if (!readRtcRaw(second)) return;
+    captureActive = true;
+    captureMs = second;
+    captureUs = nowUs;
+    captureStartUs = nowUs;
+    return;
+  }
+  if (!readRtcRaw(second)) {
+    captureActive = false;
+    lastCaptureUs = nowUs;
+    return;
+  }
+  if (second == captureMs + 1000) {
+    edgeValid = true;
+    edgeMs = second;
+    edgeUs = captureUs + (nowUs - captureUs) / 2;
+    edgeErrorMs = (uint32_t)((nowUs - captureUs) / 2000) + 1;
+    captureActive = false;
+    lastCaptureUs = nowUs;
+  } else if (second != captureMs) {
+    // RTC ditulis di tengah pengukuran: mulai lagi dari detik ini
+    captureMs = second;
+    captureUs = nowUs;
+  } else if (nowUs - captureStartUs > TIME_RTC_EDGE_TIMEOUT_MS * 1000ULL) {
+    captureActive = false;
+    lastCaptureUs = nowUs;
+  } else {
+    captureUs = nowUs;
+  }
+}
+
+// RTC baru ditulis dengan rawMs (detik penuh, mulai berdetak sekarang) untuk referensi referenceMs.
+// Aging hanya diubah di sini: setiap interval pengukuran berjalan dengan satu nilai aging
+void TimeKeeper::markRtcSet(int64_t referenceMs, int64_t rawMs, uint32_t error, uint64_t nowUs) {
+  trimAging();
+  rtcSetMs = referenceMs;
+  rtcSetErrorMs = error;
+  rtcSetOffsetMs = (int16_t)(rawMs - referenceMs);
+  rtcSetAging = aging;
+  edgeValid = true;
+  edgeMs = rawMs;
+  edgeUs = nowUs;
+  edgeErrorMs = 1;
+  captureActive = false;
+  lastCaptureUs = nowUs;
+}
+
+// Sebelum RTC ditulis ulang: (waktu RTC, waktu referensi) terhadap set terakhir = laju RTC
+void TimeKeeper::learnRtcDrift(int64_t referenceMs, uint32_t error, uint64_t nowUs) {
+  if (rtcSetMs == 0 || rtcState != RTC_STATE_OK || rtcSetAging != aging) return;
+  int64_t rtcMs;
+  uint32_t rtcError;
+  if (!rtcMsNow(nowUs, rtcMs, rtcError)) return;
+  int64_t elapsedMs = referenceMs - rtcSetMs;
+  if (elapsedMs <= 0) return;
+  int64_t uncertaintyPpb = (int64_t)(error + rtcSetErrorMs + rtcError) * 1000000000LL / elapsedMs;
+  if (uncertaintyPpb > TIME_RTC_DRIFT_MAX_UNCERTAINTY_PPB) return;
+
+  // Laju alami kristal: seolah register aging 0 (aging positif memperlambat)
+  int64_t gainedMs = rtcMs - referenceMs - rtcSetOffsetMs;
+  int64_t ppb = gainedMs * 1000000000LL / elapsedMs + aging * TIME_AGING_STEP_PPB;
+  if (ppb > TIME_RTC_DRIFT_MAX_PPB || ppb < -TIME_RTC_DRIFT_MAX_PPB) return;
+
+  float uncertaintyPpm = uncertaintyPpb < 100 ? 0.1f : uncertaintyPpb / 1000.0f;
+  float weight = 1.0f / (uncertaintyPpm * uncertaintyPpm);
+  rtcDriftPpb = (int32_t)((rtcDriftPpb * rtcDriftWeight + ppb * weight) / (rtcDriftWeight + weight));
+  rtcDriftWeight += weight;
+  if (rtcDriftWeight > TIME_RTC_DRIFT_MAX_WEIGHT) rtcDriftWeight = TIME_RTC_DRIFT_MAX_WEIGHT;
+  if (rtcDriftSamples < UINT8_MAX) rtcDriftSamples++;
+}
+
+// Laju yang sudah cukup pasti dibatalkan di chip; pecahan langkah tetap dikoreksi di software
+void TimeKeeper::trimAging() {
+  float minWeight = (1000.0f / TIME_AGING_MAX_UNCERTAINTY_PPB) * (1000.0f / TIME_AGING_MAX_UNCERTAINTY_PPB);
+  if (rtcDriftWeight < minWeight) return;
+  int32_t target = rtcDriftPpb >= 0
+    ? (rtcDriftPpb + TIME_AGING_STEP_PPB / 2) / TIME_AGING_STEP_PPB
+    : (rtcDriftPpb - TIME_AGING_STEP_PPB / 2) / TIME_AGING_STEP_PPB;
+  if (target > INT8_MAX) target = INT8_MAX;
+  if (target < INT8_MIN) target = INT8_MIN;
+  if (target == aging) return;
+  if (rtc->writeAgingOffset((int8_t)target)) {
+    Serial.printf("RTC aging offset %d -> %d (fitted rate %+.3f ppm)\n", aging, (int)target, rtcDriftPpb / 1000.0);
+    aging = (int8_t)target;
+    saveDue = true;
+  }
+}
+
+// Pembacaan RTC yang baik menjadi anchor baru untuk timer (detik penuh: +1 s error)
+void TimeKeeper::useRtc(int64_t ms, uint64_t nowUs) {
+  rtcState = RTC_STATE_OK;
+  source = TIME_SOURCE_RTC;
+  anchorMs = ms;
+  anchorUs = nowUs;
+  slewMs = 0;
+  anchorErrorMs = rtcSetMs == 0 ? TIME_ERROR_UNKNOWN : errorMs(nowUs) + 1000;
+}
+
+// RTC hanya menunjukkan detik penuh: estimasi (resolusi ms, misalnya dari sync) tetap
+// dipakai selama berada di detik yang ditunjukkan RTC, dan digeser ke batasnya jika keluar
+void TimeKeeper::followRtc(int64_t ms, uint64_t nowUs) {
+  int64_t estimate = estimateMs(nowUs);
+  if (estimate < ms - RTC_AGREE_MS || estimate >= ms + 1000 + RTC_AGREE_MS) {
+    useRtc(ms, nowUs);  // RTC diubah dari luar: ikuti
+    return;
+  }
+  if (estimate >= ms - RTC_PHASE_MARGIN_MS && estimate < ms + 1000 + RTC_PHASE_MARGIN_MS) {
+    return;
+  }
+  foldSlew(nowUs);
+  anchorMs = estimate < ms ? ms : ms + 999;
+  anchorErrorMs = errorMs(nowUs);
+}
+
+// Bagian slew yang sudah diterapkan: naik TIME_SLEW_RATE_PPM sampai slewMs
+int32_t TimeKeeper::slewAppliedMs(uint64_t nowUs) {
+  if (slewMs == 0) return 0;
+  int64_t stepMs = (int64_t)(nowUs - slewStartUs) * TIME_SLEW_RATE_PPM / 1000000000LL;
+  if (stepMs >= (slewMs > 0 ? slewMs : -slewMs)) return slewMs;
+  return slewMs > 0 ? (int32_t)stepMs : -(int32_t)stepMs;
+}
+
+// Waktu dari anchor + uptime, dikoreksi dengan drift yang sudah dipelajari dan slew
+int64_t TimeKeeper::estimateMs(uint64_t nowUs) {
+  int64_t elapsedMs = (int64_t)((nowUs - anchorUs) / 1000);
+  return anchorMs + elapsedMs + elapsedMs * driftPpb / 1000000000LL + slewAppliedMs(nowUs);
+}
+
+// Pindahkan anchor ke sekarang tanpa mengubah estimasi; sisa slew dilanjutkan dari sini
+void TimeKeeper::foldSlew(uint64_t nowUs) {
+  int64_t estimate = estimateMs(nowUs);
+  int32_t applied = slewAppliedMs(nowUs);
+  if (anchorErrorMs != TIME_ERROR_UNKNOWN) {
+    TimeSource current = source;
+    source = TIME_SOURCE_TIMER;
+    anchorErrorMs = errorMs(nowUs);
+    source = current;
+  }
+  anchorMs = estimate;
+  anchorUs = nowUs;
+  slewMs -= applied;
+  slewStartUs = nowUs;
+}
+
+uint32_t TimeKeeper::errorMs(uint64_t nowUs) {
+  int64_t error;
+  if (source == TIME_SOURCE_RTC) {
+    if (rtcSetMs == 0) return TIME_ERROR_UNKNOWN;
+    int64_t sinceSetMs = estimateMs(nowUs) - rtcSetMs;
+    if (sinceSetMs < 0) sinceSetMs = 0;
+    int64_t tolerance = rtcDriftSamples > 0 ? TIME_RTC_LEARNED_PPB : TIME_RTC_TOLERANCE_PPB;
+    error = rtcSetErrorMs + sinceSetMs * tolerance / 1000000000LL;
+  } else {
+    if (anchorErrorMs == TIME_ERROR_UNKNOWN) return TIME_ERROR_UNKNOWN;
+    int64_t elapsedMs = (int64_t)((nowUs - anchorUs) / 1000);
+    int64_t tolerance = driftSamples > 0 ? TIME_TIMER_LEARNED_PPB : TIME_TIMER_TOLERANCE_PPB;
+    int32_t remaining = slewMs - slewAppliedMs(nowUs);
+    error = anchorErrorMs + elapsedMs * tolerance / 1000000000LL + (remaining > 0 ? remaining : -remaining);
+  }
+  return error >= TIME_ERROR_UNKNOWN ? TIME_ERROR_UNKNOWN - 1 : (uint32_t)error;
+}
+
+CommandTime TimeKeeper::now() {
+  std::lock_guard<std::mutex> guard(lock);
+  uint64_t nowUs = timer->uptimeUs();
+  if (source == TIME_SOURCE_RTC) {
+    int64_t ms;
+    if (readRtc(ms)) {
+      followRtc(ms, nowUs);
+      return epochMsToTime(estimateMs(nowUs));
+    }
+    // Lanjut dengan timer dari pembacaan baik terakhir; RTC dicoba lagi oleh update()
+    rtcState = RTC_STATE_READ_ERROR;
+    source = TIME_SOURCE_TIMER;
+    lastRetryUs = nowUs;
+    Serial.println("RTC read failed, running on the uptime timer");
+  }
+  return epochMsToTime(estimateMs(nowUs));
+}
+
+// Dua set waktu dalam satu boot: selisih waktu referensi vs uptime = drift timer
+void TimeKeeper::learnDrift(int64_t ms, uint64_t nowUs, uint32_t error) {
+  if (!setValid) return;
+  int64_t timerMs = (int64_t)((nowUs - setUs) / 1000);
+  if (timerMs <= 0) return;
+  int64_t uncertaintyPpb = (int64_t)(error + setErrorMs) * 1000000000LL / timerMs;
+  if (uncertaintyPpb > TIME_DRIFT_MAX_UNCERTAINTY_PPB) return;
+  int64_t ppb = (ms - setMs - timerMs) * 1000000000LL / timerMs;
+  if (ppb > TIME_DRIFT_MAX_PPB || ppb < -TIME_DRIFT_MAX_PPB) return;
+
+  // Rata-rata berbobot 1/ketidakpastian²; bobot dibatasi agar suhu yang berubah tetap terkejar
+  float uncertaintyPpm = uncertaintyPpb < 1000 ? 1.0f : uncertaintyPpb / 1000.0f;
+  float weight = 1.0f / (uncertaintyPpm * uncertaintyPpm);
+  driftPpb = (int32_t)((driftPpb * driftWeight + ppb * weight) / (driftWeight + weight));
+  driftWeight += weight;
+  if (driftWeight > 1.0f) driftWeight = 1.0f;
+  if (driftSamples < UINT8_MAX) driftSamples++;
+}
+
+void TimeKeeper::setTime(int64_t ms, uint32_t error) {
+  uint64_t nowUs = timer->uptimeUs();
+  learnDrift(ms, nowUs, error);
+  learnRtcDrift(ms, error, nowUs);
+  slewMs = 0;
+  rtcWritePending = false;
+  resetSync();
+  setValid = true;
+  setMs = ms;
+  setUs = nowUs;
+  setErrorMs = error;
+
+  anchorMs = ms;
+  anchorUs = nowUs;
+  anchorErrorMs = error;
+  source = TIME_SOURCE_TIMER;
+  saveDue = true;
+
+  // Tulis ke RTC juga (menghapus flag lost power); dipakai lagi hanya jika terbaca kembali
+  rtc->adjust(epochMsToTime(ms));
+  int64_t rtcMs;
+  if (readRtcRaw(rtcMs) && rtcMs - ms < RTC_AGREE_MS && ms - rtcMs < RTC_AGREE_MS) {
+    markRtcSet(ms, ms - ms % 1000, error, nowUs);
+    useRtc(rtcMs, nowUs);
+    anchorMs = ms;
+    anchorErrorMs = error;
+  } else if (rtcState != RTC_STATE_MISSING) {
+    rtcState = RTC_STATE_READ_ERROR;
+  }
+}
+
+void TimeKeeper::adjust(const CommandTime& time) {
+  std::lock_guard<std::mutex> guard(lock);
+  setTime(timeToEpochMs(time), TIME_SET_ERROR_MS);
+}
+
+// DS3231 mulai menghitung detik baru saat ditulis: tulis tepat setelah batas detik
+// agar fasenya sama dengan jam yang sudah dikoreksi (tertinggal paling lama sebesar window)
+void TimeKeeper::writeRtcOnBoundary(uint64_t nowUs) {
+  int64_t estimate = estimateMs(nowUs);
+  uint32_t phaseMs = (uint32_t)(estimate % 1000);
+  if (phaseMs >= TIME_RTC_WRITE_WINDOW_MS) return;
+
+  rtcWritePending = false;
+  rtc->adjust(epochMsToTime(estimate));
+  int64_t rtcMs;
+  if (readRtcRaw(rtcMs) && rtcMs >= estimate - phaseMs && rtcMs <= estimate - phaseMs + 1000) {
+    // Fase yang tertinggal dicatat sebagai offset: pembacaan RTC mengoreksinya
+    markRtcSet(estimate, estimate - phaseMs, errorMs(nowUs), nowUs);
+    rtcState = RTC_STATE_OK;
+    source = TIME_SOURCE_RTC;
+    saveDue = true;
+  } else if (rtcState != RTC_STATE_MISSING) {
+    rtcState = RTC_STATE_READ_ERROR;
+  }
+}
+
+int64_t TimeKeeper::syncTimestamp() {
+  std::lock_guard<std::mutex> guard(lock);
+  return estimateMs(timer->uptimeUs()) + TIME_UNIX_OFFSET_MS;
+}
+
+// Lengkapi exchange sebelumnya dari client dengan t4-nya menjadi satu sampel offset/delay
+TimeSyncResult TimeKeeper::completeExchange(const TimeSyncRequest& request, uint64_t nowUs) {
+  // Exchange pertama dari client memulai sesi baru: sampel client lain (jam lain) dibuang
+  if (request.id == 0) {
+    sampleCount = 0;
+    nextSample = 0;
+    return TIME_SYNC_NO_SAMPLE;
+  }
+  SyncExchange* exchange = nullptr;
+  for (uint8_t i = 0; i < TIME_SYNC_PENDING; i++) {
+    if (exchanges[i].id == request.id) exchange = &exchanges[i];
+  }
+  if (exchange == nullptr) return TIME_SYNC_REJECTED;
+  exchange->id = 0;
+
+  int64_t delay = (request.t4 - exchange->t1) - (exchange->t3 - exchange->t2);
+  if (nowUs - exchange->sentUs > TIME_SYNC_SESSION_MS * 1000ULL ||
+      delay < 0 || delay > TIME_SYNC_MAX_DELAY_MS) {
+    return TIME_SYNC_REJECTED;
+  }
+  if (sampleCount > 0 && nowUs - lastSampleUs > TIME_SYNC_SESSION_MS * 1000ULL) {
+    sampleCount = 0;
+    nextSample = 0;
+  }
+  lastSampleUs = nowUs;
+
+  // Offset NTP: rata-rata selisih kedua arah; asimetri jaringan masuk ke error (delay/2)
+  int64_t offset = ((exchange->t2 - exchange->t1) + (exchange->t3 - request.t4)) / 2;
+  samples[nextSample].offsetMs = offset + exchange->frameMs;
+  samples[nextSample].delayMs = (uint32_t)delay;
+  nextSample = (nextSample + 1) % TIME_SYNC_SAMPLES;
+  if (sampleCount < TIME_SYNC_SAMPLES) sampleCount++;
+  if (sampleCount >= TIME_SYNC_MIN_SAMPLES) {
+    applySync(nowUs);
+  }
+  return TIME_SYNC_ACCEPTED;
+}
+
+// Koreksi dari sampel dengan delay terkecil (paling sedikit antrian di jaringan)
+void TimeKeeper::applySync(uint64_t nowUs) {
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < sampleCount; i++) {
+    if (samples[i].delayMs < samples[best].delayMs) best = i;
+  }
+  int64_t offset = samples[best].offsetMs + shiftMs;
+  uint32_t accuracy = samples[best].delayMs / 2 + TIME_SYNC_RESOLUTION_MS;
+
+  foldSlew(nowUs);
+  int64_t change = slewMs - offset;
+  int64_t reference = anchorMs + change;
+
+  // Drift dari sampel pertama setiap sesi, seperti set waktu biasa
+  if (sampleCount == TIME_SYNC_MIN_SAMPLES) {
+    learnDrift(reference, nowUs, accuracy);
+    learnRtcDrift(reference, accuracy, nowUs);
+    setValid = true;
+    setMs = reference;
+    setUs = nowUs;
+    setErrorMs = accuracy;
+  }
+
+  if (change > TIME_SLEW_MAX_MS || change < -TIME_SLEW_MAX_MS) {
+    anchorMs = reference;
+    slewMs = 0;
+    saveDue = true;
+  } else {
+    slewMs = (int32_t)change;
+  }
+  slewStartUs = nowUs;
+  anchorErrorMs = accuracy;
+  shiftMs -= offset;
+
+  syncAccuracyMs = accuracy;
+  syncOffsetMs = offset;
+  syncCorrections++;
+
+  // Sampai RTC ditulis ulang, estimasi (bukan detik RTC) yang dipakai
+  source = TIME_SOURCE_TIMER;
+  rtcWritePending = rtcState != RTC_STATE_MISSING;
+}
+
+size_t TimeKeeper::sync(const TimeSyncRequest& request, int64_t t2, char* buffer, size_t size) {
+  std::lock_guard<std::mutex> guard(lock);
+  uint64_t nowUs = timer->uptimeUs();
+
+  // t3 sebelum koreksi: exchange ini diukur dengan jam yang sama dengan t2
+  SyncExchange& exchange = exchanges[nextExchange];
+  nextExchange = (nextExchange + 1) % TIME_SYNC_PENDING;
+  exchange.id = nextSyncId++;
+  if (nextSyncId == 0) nextSyncId = 1;
+  exchange.t1 = request.t1;
+  exchange.t2 = t2;
+  exchange.t3 = estimateMs(nowUs) + TIME_UNIX_OFFSET_MS;
+  exchange.frameMs = (slewMs - slewAppliedMs(nowUs)) - shiftMs;
+  exchange.sentUs = nowUs;
+
+  TimeSyncResult result = completeExchange(request, nowUs);
+
+  uint32_t delay = 0;
+  for (uint8_t i = 0; i < sampleCount; i++) {
+    if (i == 0 || samples[i].delayMs < delay) delay = samples[i].delayMs;
+  }
+  const char* state = sampleCount < TIME_SYNC_MIN_SAMPLES ? "collecting" : slewMs != 0 ? "slewing" : "synced";
+  char accuracy[12];
+  if (syncAccuracyMs == TIME_ERROR_UNKNOWN) {
+    snprintf(accuracy, sizeof(accuracy), "null");
+  } else {
+    snprintf(accuracy, sizeof(accuracy), "%lu", (unsigned long)syncAccuracyMs);
+  }
+  int written = snprintf(buffer, size,
+    "{\"id\":%lu,\"t1\":%lld,\"t2\":%lld,\"t3\":%lld,\"sample\":\"%s\",\"samples\":%u,"
+    "\"state\":\"%s\",\"offsetMs\":%lld,\"delayMs\":%lu,\"accuracyMs\":%s,\"slewMs\":%ld}",
+    (unsigned long)exchange.id, (long long)exchange.t1, (long long)exchange.t2, (long long)exchange.t3,
+    TIME_SYNC_RESULT_NAMES[result], sampleCount, state, (long long)syncOffsetMs, (unsigned long)delay,
+    accuracy, (long)(slewMs - slewAppliedMs(nowUs)));
+  return (written < 0 || (size_t)written >= size) ? 0 : written;
+}
+
+void TimeKeeper::fillRecord(Record& record, uint64_t nowUs) {
+  record = {};
+  record.format = TIME_RECORD_FORMAT;
+  record.driftSamples = driftSamples;
+  record.rtcSetOffsetMs = rtcSetOffsetMs;
+  record.seconds = (uint32_t)(estimateMs(nowUs) / 1000);
+  record.rtcSetSeconds = (uint32_t)(rtcSetMs / 1000);
+  record.rtcSetMillis = (uint16_t)(rtcSetMs % 1000);
+  record.rtcSetErrorMs = rtcSetErrorMs;
+  record.driftPpb = driftPpb;
+  record.driftWeight = driftWeight;
+  record.rtcDriftPpb = rtcDriftPpb;
+  record.rtcDriftWeight = rtcDriftWeight;
+  record.rtcDriftSamples = rtcDriftSamples;
+  record.aging = aging;
+  record.rtcSetAging = rtcSetAging;
+}
+
+void TimeKeeper::update() {
+  Record record;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    uint64_t nowUs = timer->uptimeUs();
+
+    if (slewMs != 0 && slewAppliedMs(nowUs) == slewMs) {
+      foldSlew(nowUs);
+    }
+    if (rtcWritePending && slewMs == 0) {
+      writeRtcOnBoundary(nowUs);
+    }
+    captureEdge(nowUs);
+
+    // RTC yang hilang/gagal dicoba lagi; dipakai hanya jika waktunya cocok dengan estimasi
+    if ((rtcState == RTC_STATE_MISSING || rtcState == RTC_STATE_READ_ERROR) &&
+        nowUs - lastRetryUs >= TIME_RTC_RETRY_MS * 1000ULL) {
+      lastRetryUs = nowUs;
+      int64_t rtcMs;
+      if (readRtc(rtcMs)) {
+        int64_t estimate = estimateMs(nowUs);
+        uint32_t error = errorMs(nowUs);
+        bool agrees = error == TIME_ERROR_UNKNOWN
+          ? rtcMs + RTC_AGREE_MS >= estimate  // Waktu terakhir yang diketahui adalah batas bawah
+          : rtcMs - estimate <= (int64_t)error + RTC_AGREE_MS && estimate - rtcMs <= (int64_t)error + RTC_AGREE_MS;
+        if (agrees) {
+          useRtc(rtcMs, nowUs);
+          Serial.println("RTC is answering again, using it");
+        } else {
+          rtcState = RTC_STATE_LOST_POWER;
+          rtcSetMs = 0;
+          Serial.println("RTC is answering again but its time is off, waiting for a time set");
+        }
+      }
+    }
+
+    uint32_t intervalS = source == TIME_SOURCE_RTC ? TIME_SAVE_INTERVAL_S : TIME_HOLDOVER_SAVE_INTERVAL_S;
+    if (!saveDue && nowUs - lastSaveUs < intervalS * 1000000ULL) {
+      return;
+    }
+    fillRecord(record, nowUs);
+    lastSaveUs = nowUs;
+    saveDue = false;
+  }
+
+  // NVS ditulis di luar lock: lighting task tidak menunggu flash
+  store->putBytes(TIME_RECORD_KEY, &record, sizeof(record));
+  nvsWear.recordWrite(TIME_STORE_NAMESPACE, TIME_RECORD_KEY, NVS_VALUE_BLOB, sizeof(record));
+}
+
+void TimeKeeper::save() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    saveDue = true;
+  }
+  update();
+}
+
+void TimeKeeper::status(TimeStatus& out) {
+  std::lock_guard<std::mutex> guard(lock);
+  uint64_t nowUs = timer->uptimeUs();
+  out.time = epochMsToTime(estimateMs(nowUs));
+  out.source = source;
+  out.rtc = rtcState;
+  out.errorMs = errorMs(nowUs);
+  out.driftPpb = driftPpb;
+  out.driftSamples = driftSamples;
+  out.syncAccuracyMs = syncAccuracyMs;
+  out.syncOffsetMs = syncOffsetMs;
+  out.syncCorrections = syncCorrections;
+  out.slewMs = slewMs - slewAppliedMs(nowUs);
+  out.rtcDriftPpb = rtcDriftPpb;
+  out.rtcDriftSamples = rtcDriftSamples;
+  out.agingOffset = aging;
+  out.rtcCorrectionPpb = rtcCorrectionPpb();
+}
+
+size_t TimeKeeper::formatTimeJson(char* buffer, size_t size) {
+  now();  // Baca RTC dulu: status mencerminkan pembacaan ini
+  TimeStatus current;
+  status(current);
+  char error[12];
+  if (current.errorMs == TIME_ERROR_UNKNOWN) {
+    snprintf(error, sizeof(error), "null");
+  } else {
+    snprintf(error, sizeof(error), "%lu", (unsigned long)current.errorMs);
+  }
+  char accuracy[12];
+  if (current.syncAccuracyMs == TIME_ERROR_UNKNOWN) {
+    snprintf(accuracy, sizeof(accuracy), "null");
+  } else {
+    snprintf(accuracy, sizeof(accuracy), "%lu", (unsigned long)current.syncAccuracyMs);
+  }
+  int written = snprintf(buffer, size,
+    "{\"year\":%u,\"month\":%u,\"day\":%u,\"hour\":%u,\"minute\":%u,\"second\":%u,"
+    "\"source\":\"%s\",\"rtc\":\"%s\",\"errorMs\":%s,\"driftPpm\":%.3f,\"driftSamples\":%u,"
+    "\"syncAccuracyMs\":%s,\"slewMs\":%ld,\"rtcDriftPpm\":%.3f,\"rtcDriftSamples\":%u,"
+    "\"agingOffset\":%d,\"rtcCorrectionPpm\":%.3f}",
+    current.time.year, current.time.month, current.time.day,
+    current.time.hour, current.time.minute, current.time.second,
+    TIME_SOURCE_NAMES[current.source], RTC_STATE_NAMES[current.rtc], error,
+    current.driftPpb / 1000.0, current.driftSamples, accuracy, (long)current.slewMs,
+    current.rtcDriftPpb / 1000.0, current.rtcDriftSamples, current.agingOffset,
+    current.rtcCorrectionPpb / 1000.0);
+  return (written < 0 || (size_t)written >= size) ? 0 : written;
+}
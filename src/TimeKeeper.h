@@ -0,0 +1,300 @@
+#ifndef TIME_KEEPER_H
+#define TIME_KEEPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#include "LightingHal.h"
+
+// Wall clock for the schedule that keeps running when the DS3231 does not.
+// Time is the uptime timer from an anchor, corrected by a drift rate learned
+// from successive client time sets. While the RTC is healthy, now() reads it
+// and keeps the estimate within the second it shows. When it is missing,
+// stops answering or lost power, the timer carries time forward from the
+// last good reading (or the last time saved in NVS). now() always returns a
+// valid time; status() reports how far off it may be.
+#define TIME_STORE_NAMESPACE "time"
+#define TIME_RECORD_KEY      "clock"
+#define TIME_RECORD_FORMAT   2
+
+// Last-known time is saved by update(): hourly while the RTC keeps time,
+// every 10 min while the timer is the only clock
+#define TIME_SAVE_INTERVAL_S          3600
+#define TIME_HOLDOVER_SAVE_INTERVAL_S 600
+
+// A missing or failing RTC is probed again this often
+#define TIME_RTC_RETRY_MS 60000
+
+// Rate error bounds for the error estimate: DS3231 at 0..40 °C, and the
+// ESP32 crystal before and after its drift has been learned
+#define TIME_RTC_TOLERANCE_PPB     2000
+#define TIME_TIMER_TOLERANCE_PPB   40000
+#define TIME_TIMER_LEARNED_PPB     5000
+
+// Error of a whole-second time set (POST /api/time, BLE): truncation plus
+// request latency
+#define TIME_SET_ERROR_MS 1000
+
+// Two time sets in the same boot give a drift sample if their combined error
+// over the interval is within TIME_DRIFT_MAX_UNCERTAINTY_PPB (about 28 h
+// apart with whole-second sets). A larger apparent rate is a step (the user
+// corrected the time), not drift.
+#define TIME_DRIFT_MAX_UNCERTAINTY_PPB 20000
+#define TIME_DRIFT_MAX_PPB             200000
+
+// POST /api/time/sync: NTP-style exchanges with millisecond timestamps in
+// local time (ms since 1970-01-01 on the wall clock POST /api/time uses).
+// Once a session has TIME_SYNC_MIN_SAMPLES exchanges, the one with the
+// lowest round-trip delay gives the offset and half its delay is the
+// achieved accuracy. Offsets up to TIME_SLEW_MAX_MS are slewed at
+// TIME_SLEW_RATE_PPM (500 ms take about 17 min), larger ones stepped. When
+// the slew is done the DS3231 is written on a second boundary.
+#define TIME_SYNC_SAMPLES        8
+#define TIME_SYNC_MIN_SAMPLES    4
+#define TIME_SYNC_PENDING        4       // Exchanges waiting for their t4 (one per client)
+#define TIME_SYNC_SESSION_MS     60000   // A longer gap, or a request without id, starts a new session
+#define TIME_SYNC_MAX_DELAY_MS   2000    // Slower exchanges are rejected
+#define TIME_SYNC_RESOLUTION_MS  1       // Both ends stamp whole milliseconds
+#define TIME_SLEW_MAX_MS         500
+#define TIME_SLEW_RATE_PPM       500
+#define TIME_RTC_WRITE_WINDOW_MS 20      // RTC written at most this late after a second boundary
+#define TIME_UNIX_OFFSET_MS      946684800000LL  // 1970-01-01 to 2000-01-01
+
+// DS3231 rate learning. Right before a client time set or sync writes the
+// RTC, the RTC time is compared with the reference: against the previous set
+// this gives the rate over that interval. The rates, weighted by
+// 1/uncertainty², are averaged into the natural rate of the crystal (as with
+// aging offset 0). The rest of the fitted rate after the aging offset is
+// corrected in software from the first sample on. Once the fit is known to
+// TIME_AGING_MAX_UNCERTAINTY_PPB, the next RTC write also programs the aging
+// offset to cancel it.
+#define TIME_RTC_DRIFT_MAX_UNCERTAINTY_PPB 5000
+#define TIME_RTC_DRIFT_MAX_PPB             50000   // More is a step (RTC set elsewhere), not drift
+#define TIME_RTC_DRIFT_MAX_WEIGHT          100.0f  // 1/ppm², capped so temperature and aging are followed
+#define TIME_RTC_LEARNED_PPB               1000
+#define TIME_AGING_MAX_UNCERTAINTY_PPB     500
+#define TIME_AGING_STEP_PPB                100     // Rate change per aging step at 25 °C
+
+// The RTC only shows whole seconds. update() polls it every call for up to
+// TIME_RTC_EDGE_TIMEOUT_MS once a minute to catch a second edge, which gives
+// the RTC time to a few ms in between.
+#define TIME_RTC_EDGE_INTERVAL_S 60
+#define TIME_RTC_EDGE_TIMEOUT_MS 1500
+
+// Error reported when no reference has been seen (time restored from NVS
+// after an outage of unknown length, or the firmware build time)
+#define TIME_ERROR_UNKNOWN UINT32_MAX
+
+enum RtcState : uint8_t {
+  RTC_STATE_OK,
+  RTC_STATE_MISSING,     // Not found at boot
+  RTC_STATE_LOST_POWER,  // Answers, but its time is not trusted until set
+  RTC_STATE_READ_ERROR   // Stopped answering after boot
+};
+
+enum TimeSource : uint8_t {
+  TIME_SOURCE_RTC,
+  TIME_SOURCE_TIMER
+};
+
+extern const char* const RTC_STATE_NAMES[4];
+extern const char* const TIME_SOURCE_NAMES[2];
+
+// Milliseconds since 2000-01-01 00:00:00 (the DS3231 epoch)
+int64_t timeToEpochMs(const CommandTime& time);
+CommandTime epochMsToTime(int64_t epochMs);
+
+enum TimeSyncResult : uint8_t {
+  TIME_SYNC_NO_SAMPLE,   // First exchange of a client: nothing to complete
+  TIME_SYNC_ACCEPTED,
+  TIME_SYNC_REJECTED     // Unknown or stale id, negative or excessive delay
+};
+
+extern const char* const TIME_SYNC_RESULT_NAMES[3];
+
+// One exchange from the client: t1 when it sent this request, and the t4
+// (when the response arrived) of its previous exchange, identified by the id
+// the device returned. id 0: no previous exchange.
+struct TimeSyncRequest {
+  int64_t t1;
+  uint32_t id;
+  int64_t t4;
+};
+
+struct TimeStatus {
+  CommandTime time;
+  TimeSource source;
+  RtcState rtc;
+  uint32_t errorMs;      // Estimated error bound, or TIME_ERROR_UNKNOWN
+  int32_t driftPpb;      // Learned timer rate error (positive: timer runs slow)
+  uint8_t driftSamples;
+  uint32_t syncAccuracyMs;   // Of the last sync correction, or TIME_ERROR_UNKNOWN
+  int64_t syncOffsetMs;      // Offset it corrected (device minus client)
+  uint32_t syncCorrections;
+  int32_t slewMs;            // Part of the correction not yet slewed in
+  int32_t rtcDriftPpb;       // Fitted natural rate of the RTC (positive: fast)
+  uint8_t rtcDriftSamples;
+  int8_t agingOffset;        // Programmed into the DS3231
+  int32_t rtcCorrectionPpb;  // Left after the aging offset, corrected in software
+};
+
+class TimeKeeper : public WallClock {
+private:
+  // Saved in NVS: survives a reboot without the RTC
+  struct Record {
+    uint8_t format;
+    uint8_t driftSamples;
+    int16_t rtcSetOffsetMs;  // Format 1: reserved (0)
+    uint32_t seconds;        // Last-known time (TimeKeeper epoch)
+    uint32_t rtcSetSeconds;  // When the RTC was last set; 0 if unknown
+    uint32_t rtcSetErrorMs;
+    int32_t driftPpb;
+    float driftWeight;       // Sum of sample weights (1/ppm²), capped
+    // Format 2
+    int32_t rtcDriftPpb;
+    float rtcDriftWeight;
+    int8_t aging;
+    int8_t rtcSetAging;
+    uint8_t rtcDriftSamples;
+    uint8_t reserved;
+    uint16_t rtcSetMillis;
+    uint16_t reserved2;
+  };
+  static_assert(sizeof(Record) == 40, "Record layout is stored in NVS");
+
+  // Sent, waiting for the client's t4. Offsets are kept relative to the
+  // total correction applied so far (shiftMs), so an exchange that spans a
+  // correction still measures the corrected clock.
+  struct SyncExchange {
+    uint32_t id;             // 0: free
+    int64_t t1, t2, t3;
+    int64_t frameMs;         // Slew still to come minus shiftMs, at t3
+    uint64_t sentUs;
+  };
+
+  struct SyncSample {
+    int64_t offsetMs;        // Device minus client, plus shiftMs at sampling
+    uint32_t delayMs;
+  };
+
+  WallClock* rtc;
+  MonotonicClock* timer;
+  KeyValueStore* store;
+  std::mutex lock;
+
+  RtcState rtcState;
+  TimeSource source;
+
+  // Timer source: the time at anchorUs and its error
+  int64_t anchorMs;
+  uint64_t anchorUs;
+  uint32_t anchorErrorMs;
+
+  // Last time set in this boot, for drift learning
+  bool setValid;
+  int64_t setMs;
+  uint64_t setUs;
+  uint32_t setErrorMs;
+
+  int64_t rtcSetMs;          // 0 if unknown
+  uint32_t rtcSetErrorMs;
+  int16_t rtcSetOffsetMs;    // Raw RTC minus reference right after the set
+  int8_t rtcSetAging;        // Aging offset since the set; a change ends the interval
+
+  int32_t rtcDriftPpb;
+  float rtcDriftWeight;
+  uint8_t rtcDriftSamples;
+  int8_t aging;
+
+  // Last RTC second edge seen by update(), against the timer
+  bool edgeValid;
+  int64_t edgeMs;
+  uint64_t edgeUs;
+  uint32_t edgeErrorMs;
+  bool captureActive;
+  int64_t captureMs;
+  uint64_t captureUs;
+  uint64_t captureStartUs;
+  uint64_t lastCaptureUs;
+
+  int32_t driftPpb;
+  float driftWeight;
+  uint8_t driftSamples;
+
+  uint64_t lastSaveUs;
+  uint64_t lastRetryUs;
+  bool saveDue;
+
+  // Slew: slewMs added to the estimate at TIME_SLEW_RATE_PPM from slewStartUs
+  int32_t slewMs;
+  uint64_t slewStartUs;
+  bool rtcWritePending;      // Write the RTC on the next second boundary
+
+  SyncExchange exchanges[TIME_SYNC_PENDING];
+  uint8_t nextExchange;
+  uint32_t nextSyncId;
+  SyncSample samples[TIME_SYNC_SAMPLES];
+  uint8_t sampleCount;
+  uint8_t nextSample;
+  uint64_t lastSampleUs;
+  int64_t shiftMs;           // Sum of sync corrections
+  uint32_t syncAccuracyMs;
+  int64_t syncOffsetMs;
+  uint32_t syncCorrections;
+
+  bool readRtcRaw(int64_t& ms);
+  bool readRtc(int64_t& ms);
+  int32_t rtcCorrectionPpb();
+  bool rtcMsNow(uint64_t nowUs, int64_t& ms, uint32_t& error);
+  void captureEdge(uint64_t nowUs);
+  void markRtcSet(int64_t referenceMs, int64_t rawMs, uint32_t error, uint64_t nowUs);
+  void learnRtcDrift(int64_t referenceMs, uint32_t error, uint64_t nowUs);
+  void trimAging();
+  int32_t slewAppliedMs(uint64_t nowUs);
+  int64_t estimateMs(uint64_t nowUs);
+  uint32_t errorMs(uint64_t nowUs);
+  void foldSlew(uint64_t nowUs);
+  void useRtc(int64_t ms, uint64_t nowUs);
+  void followRtc(int64_t ms, uint64_t nowUs);
+  void resetSync();
+  TimeSyncResult completeExchange(const TimeSyncRequest& request, uint64_t nowUs);
+  void applySync(uint64_t nowUs);
+  void writeRtcOnBoundary(uint64_t nowUs);
+  void learnDrift(int64_t ms, uint64_t nowUs, uint32_t error);
+  void setTime(int64_t ms, uint32_t error);
+  void fillRecord(Record& record, uint64_t nowUs);
+
+public:
+  TimeKeeper(WallClock* rtc, MonotonicClock* timer, KeyValueStore* store);
+
+  // rtcAtBoot from rtc.begin()/lostPower(). Without a usable RTC the clock
+  // starts from the saved last-known time, or buildTime if that is later.
+  void begin(RtcState rtcAtBoot, const CommandTime& buildTime);
+
+  CommandTime now() override;
+
+  // Client time set: stepped immediately and written to the RTC; ends a
+  // sync session and any slew
+  void adjust(const CommandTime& time) override;
+
+  // Network task: finishes a slew, writes the RTC on a second boundary after
+  // a sync, watches for RTC second edges, probes a failed RTC and saves the
+  // last-known time
+  void update();
+
+  // Local time in ms since 1970, for the sync timestamps (t2)
+  int64_t syncTimestamp();
+
+  // POST /api/time/sync. t2 from syncTimestamp() when the request arrived.
+  // Stamps t3, completes the client's previous exchange (which may correct
+  // the clock) and writes the response.
+  size_t sync(const TimeSyncRequest& request, int64_t t2, char* buffer, size_t size);
+
+  // Save now, e.g. right before a restart
+  void save();
+
+  void status(TimeStatus& out);
+  size_t formatTimeJson(char* buffer, size_t size);
+};
+
+#endif // TIME_KEEPER_H
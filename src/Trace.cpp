@@ -0,0 +1,237 @@
+#include "Trace.h"
+
+#if TRACE_ENABLED
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+TraceRecorder traceRecorder;
+
+// ========== PLATFORM ==========
+
+#if defined(ESP_PLATFORM)
+
+uint32_t TraceRecorder::nowUs() {
+  return (uint32_t)esp_timer_get_time();
+}
+
+uint64_t TraceRecorder::nowUs64() {
+  return (uint64_t)esp_timer_get_time();
+}
+
+static uintptr_t currentThread() {
+  return (uintptr_t)xTaskGetCurrentTaskHandle();
+}
+
+static const char* threadName(uintptr_t thread, char* buffer, size_t size) {
+  // Task di firmware ini tidak pernah dihapus, jadi handle tetap valid
+  snprintf(buffer, size, "%s", pcTaskGetName((TaskHandle_t)thread));
+  return buffer;
+}
+
+#else
+
+uint32_t TraceRecorder::nowUs() {
+  return (uint32_t)micros();
+}
+
+uint64_t TraceRecorder::nowUs64() {
+  return (uint64_t)micros();
+}
+
+// Nomor thread host, dibagikan saat thread pertama kali mencatat event
+static std::atomic<uintptr_t> nextHostThread(1);
+
+static uintptr_t currentThread() {
+  static thread_local uintptr_t thread = nextHostThread.fetch_add(1, std::memory_order_relaxed);
+  return thread;
+}
+
+static const char* threadName(uintptr_t thread, char* buffer, size_t size) {
+  snprintf(buffer, size, "thread-%lu", (unsigned long)thread);
+  return buffer;
+}
+
+#endif
+
+// ========== RECORDER ==========
+
+TraceRecorder::TraceRecorder() : head(0) {
+  for (uint32_t i = 0; i < TRACE_CAPACITY; i++) {
+    slots[i].seq.store(0, std::memory_order_relaxed);
+  }
+}
+
+void TraceRecorder::record(const char* category, const char* name, uint32_t startUs, uint32_t durationUs) {
+  uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+  TraceSlot& slot = slots[index % TRACE_CAPACITY];
+
+  // Slot ditandai sedang ditulis; pembaca yang melihat seq berubah membuang salinannya
+  slot.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.startUs.store(startUs, std::memory_order_relaxed);
+  slot.durationUs.store(durationUs, std::memory_order_relaxed);
+  slot.category.store(category, std::memory_order_relaxed);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.thread.store(currentThread(), std::memory_order_relaxed);
+  slot.seq.store(index + 1, std::memory_order_release);
+}
+
+size_t TraceRecorder::snapshot(TraceEvent* events, size_t maxEvents) {
+  uint32_t end = head.load(std::memory_order_acquire);
+  uint32_t available = end < TRACE_CAPACITY ? end : TRACE_CAPACITY;
+  if (available > maxEvents) available = maxEvents;
+
+  size_t count = 0;
+  for (uint32_t index = end - available; index != end; index++) {
+    const TraceSlot& slot = slots[index % TRACE_CAPACITY];
+    uint32_t before = slot.seq.load(std::memory_order_acquire);
+    if (before != index + 1) {
+      continue; // Belum selesai ditulis atau sudah ditimpa event yang lebih baru
+    }
+    TraceEvent& event = events[count];
+    event.startUs = slot.startUs.load(std::memory_order_relaxed);
+    event.durationUs = slot.durationUs.load(std::memory_order_relaxed);
+    event.category = slot.category.load(std::memory_order_relaxed);
+    event.name = slot.name.load(std::memory_order_relaxed);
+    event.thread = slot.thread.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == before) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// ========== EXPORT ==========
+
+enum TraceExportStage : uint8_t {
+  EXPORT_HEADER,
+  EXPORT_THREADS,
+  EXPORT_EVENTS,
+  EXPORT_FOOTER,
+  EXPORT_DONE
+};
+
+TraceExport::TraceExport() {
+  count = 0;
+  threadCount = 0;
+  stage = EXPORT_DONE;
+  next = 0;
+  pendingLength = 0;
+  pendingOffset = 0;
+}
+
+uint8_t TraceExport::threadId(uintptr_t thread) {
+  for (uint8_t i = 0; i < threadCount; i++) {
+    if (threads[i] == thread) return i + 1;
+  }
+  if (threadCount < TRACE_MAX_THREADS) {
+    threads[threadCount++] = thread;
+    return threadCount;
+  }
+  return 0;
+}
+
+void TraceExport::begin() {
+  count = traceRecorder.snapshot(events, TRACE_CAPACITY);
+  recorded = traceRecorder.getRecorded();
+  endTs = TraceRecorder::nowUs64();
+  endUs = (uint32_t)endTs;
+
+  threadCount = 0;
+  for (size_t i = 0; i < count; i++) {
+    threadId(events[i].thread);
+  }
+
+  stage = EXPORT_HEADER;
+  next = 0;
+  pendingLength = 0;
+  pendingOffset = 0;
+}
+
+// Render satu item berikutnya ke pending; false jika dokumen sudah selesai
+bool TraceExport::render() {
+  int length = 0;
+  switch (stage) {
+    case EXPORT_HEADER:
+      length = snprintf(pending, sizeof(pending), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+      stage = threadCount > 0 ? EXPORT_THREADS : EXPORT_EVENTS;
+      next = 0;
+      break;
+
+    case EXPORT_THREADS: {
+      char name[24];
+      length = snprintf(pending, sizeof(pending),
+        "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+        next == 0 ? "" : ",", (unsigned)(next + 1), threadName(threads[next], name, sizeof(name)));
+      if (++next >= threadCount) {
+        stage = EXPORT_EVENTS;
+        next = 0;
+      }
+      break;
+    }
+
+    case EXPORT_EVENTS: {
+      if (next >= count) {
+        stage = EXPORT_FOOTER;
+        return render();
+      }
+      const TraceEvent& event = events[next];
+      const char* separator = (next == 0 && threadCount == 0) ? "" : ",";
+      // Waktu 32-bit di-unwrap relatif ke waktu export (ring mencakup jauh < 71 menit)
+      uint64_t ts = endTs - (uint32_t)(endUs - event.startUs);
+      uint8_t tid = threadId(event.thread);
+      if (event.durationUs == TRACE_INSTANT_DURATION) {
+        length = snprintf(pending, sizeof(pending),
+          "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+          separator, event.name, event.category, (unsigned long long)ts, tid);
+      } else {
+        length = snprintf(pending, sizeof(pending),
+          "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%lu,\"pid\":1,\"tid\":%u}",
+          separator, event.name, event.category, (unsigned long long)ts,
+          (unsigned long)event.durationUs, tid);
+      }
+      next++;
+      break;
+    }
+
+    case EXPORT_FOOTER:
+      length = snprintf(pending, sizeof(pending),
+        "],\"otherData\":{\"recorded\":%lu,\"exported\":%lu,\"capacity\":%u}}",
+        (unsigned long)recorded, (unsigned long)count, (unsigned)TRACE_CAPACITY);
+      stage = EXPORT_DONE;
+      break;
+
+    default:
+      return false;
+  }
+
+  pendingLength = length < (int)sizeof(pending) ? length : sizeof(pending) - 1;
+  pendingOffset = 0;
+  return true;
+}
+
+size_t TraceExport::read(char* buffer, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    if (pendingOffset >= pendingLength && !render()) {
+      break;
+    }
+    size_t chunk = pendingLength - pendingOffset;
+    if (chunk > size - written) chunk = size - written;
+    memcpy(buffer + written, pending + pendingOffset, chunk);
+    pendingOffset += chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+#endif // TRACE_ENABLED
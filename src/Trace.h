@@ -0,0 +1,139 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Hot-path trace recorder. Scoped trace points record a name, the task, a
+// microsecond start time (esp_timer) and a duration into a fixed-size ring;
+// GET /api/trace renders the ring as Chrome trace_event JSON (open it in
+// chrome://tracing or ui.perfetto.dev).
+//
+// Build with -DTRACE_ENABLED=1 ([env:esp32dev-trace]). Otherwise the macros
+// expand to nothing and no ring is allocated.
+//
+//   TRACE_SCOPE("nvs", "writeConfig");         // Until the end of the block
+//   TRACE_INSTANT("wifi", "restartRequested");  // Zero-length marker
+//
+// Category and name must be string literals (or other static strings): only
+// the pointers are stored.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+// Events kept; oldest are overwritten (24 bytes each on the ESP32)
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY 256
+#endif
+
+// Distinct tasks named in one export; events of further tasks share tid 0
+#define TRACE_MAX_THREADS 12
+
+#if TRACE_ENABLED
+
+// One slot of the ring. seq is a per-slot sequence lock: 0 while a writer
+// is filling the slot, otherwise the event index + 1, so a reader can detect
+// a slot that was overwritten while it was being copied.
+struct TraceSlot {
+  std::atomic<uint32_t> seq;
+  std::atomic<uint32_t> startUs;
+  std::atomic<uint32_t> durationUs;
+  std::atomic<const char*> category;
+  std::atomic<const char*> name;
+  std::atomic<uintptr_t> thread;  // FreeRTOS task handle (host: thread number)
+};
+
+#define TRACE_INSTANT_DURATION 0xFFFFFFFF
+
+// Event copied out of the ring for export
+struct TraceEvent {
+  uint32_t startUs;
+  uint32_t durationUs;
+  const char* category;
+  const char* name;
+  uintptr_t thread;
+};
+
+// Lock-free multi-writer ring. record() is a fetch_add and a few relaxed
+// stores; it never blocks or allocates, so it is safe from any task.
+class TraceRecorder {
+private:
+  TraceSlot slots[TRACE_CAPACITY];
+  std::atomic<uint32_t> head;
+
+public:
+  TraceRecorder();
+
+  static uint32_t nowUs();
+  static uint64_t nowUs64();
+
+  // durationUs == TRACE_INSTANT_DURATION marks an instant event
+  void record(const char* category, const char* name, uint32_t startUs, uint32_t durationUs);
+  void instant(const char* category, const char* name) { record(category, name, nowUs(), TRACE_INSTANT_DURATION); }
+
+  // Copies up to maxEvents of the newest events, oldest first.
+  // Slots overwritten during the copy are skipped.
+  size_t snapshot(TraceEvent* events, size_t maxEvents);
+
+  uint32_t getRecorded() { return head.load(std::memory_order_relaxed); }
+};
+
+extern TraceRecorder traceRecorder;
+
+class TraceScope {
+private:
+  const char* category;
+  const char* name;
+  uint32_t start;
+
+public:
+  TraceScope(const char* category, const char* name)
+    : category(category), name(name), start(TraceRecorder::nowUs()) {}
+  ~TraceScope() { traceRecorder.record(category, name, start, TraceRecorder::nowUs() - start); }
+};
+
+// Renders a snapshot as {"traceEvents":[...]} in pieces, so the output can
+// be streamed in chunks of any size without one large buffer. One export at
+// a time; begin() takes the snapshot.
+class TraceExport {
+private:
+  TraceEvent events[TRACE_CAPACITY];
+  size_t count;
+  uintptr_t threads[TRACE_MAX_THREADS]; // Exported as tid 1..threadCount
+  uint8_t threadCount;
+  uint32_t endUs;     // Export time, for unwrapping the 32-bit event times
+  uint64_t endTs;     // Same instant in 64-bit time
+  uint32_t recorded;
+  uint8_t stage;      // Header, thread names, events, footer, done
+  size_t next;        // Next thread or event of the current stage
+  char pending[192];  // Rendered item that did not fit the last chunk
+  size_t pendingLength;
+  size_t pendingOffset;
+
+  uint8_t threadId(uintptr_t thread);
+  bool render();
+
+public:
+  TraceExport();
+
+  void begin();
+  // Fills up to size bytes; returns 0 when the document is complete
+  size_t read(char* buffer, size_t size);
+  size_t getEventCount() { return count; }
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#define TRACE_INSTANT(category, name) traceRecorder.instant(category, name)
+
+#else
+
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_INSTANT(category, name) ((void)0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
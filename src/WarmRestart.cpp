@@ -0,0 +1,57 @@
+#include "WarmRestart.h"
+#include "Crc32.h"
+
+#if defined(ESP_PLATFORM)
+#include <esp_attr.h>
+#else
+#define RTC_NOINIT_ATTR
+#endif
+
+// Tidak di-nol-kan oleh startup code; isinya acak setelah power-on
+static RTC_NOINIT_ATTR WarmRestartState warmRestartState;
+
+WarmRestartState& warmRestartMemory() {
+  return warmRestartState;
+}
+
+uint32_t warmRestartChecksum(const WarmRestartState& state) {
+  return crc32(&state, offsetof(WarmRestartState, checksum));
+}
+
+bool warmRestartValid(const WarmRestartState& state) {
+  return state.magic == WARM_RESTART_MAGIC && state.checksum == warmRestartChecksum(state);
+}
+
+void warmRestartRecord(WarmRestartState& state, const uint8_t* frame, uint8_t mode) {
+  if (!warmRestartValid(state)) {
+    // Isi acak dari power-on: mulai dari nol
+    state = WarmRestartState();
+    state.magic = WARM_RESTART_MAGIC;
+  }
+  for (uint8_t i = 0; i < WARM_RESTART_CHANNELS; i++) {
+    state.frame[i] = frame[i];
+  }
+  state.mode = mode;
+  state.checksum = warmRestartChecksum(state);
+}
+
+void warmRestartSetHeld(WarmRestartState& state, bool held) {
+  state.held = held;
+  state.checksum = warmRestartChecksum(state);
+}
+
+void warmRestartInvalidate(WarmRestartState& state) {
+  state.magic = 0;
+  state.checksum = 0;
+}
+
+bool warmRestartTake(WarmRestartState& state, bool resetIsWarm) {
+  if (!resetIsWarm || !warmRestartValid(state)) {
+    warmRestartInvalidate(state);
+    return false;
+  }
+  state.warmBoots++;
+  state.held = 0;
+  state.checksum = warmRestartChecksum(state);
+  return true;
+}
@@ -0,0 +1,38 @@
+#ifndef WARM_RESTART_H
+#define WARM_RESTART_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WARM_RESTART_MAGIC    0x57524D31UL  // "WRM1"
+#define WARM_RESTART_CHANNELS 7             // LED_CHANNEL_COUNT
+
+// Last output frame, kept in RTC no-init memory so it survives a software
+// reset (ESP.restart(), panic, watchdog) but not a power cycle. Updated on
+// every PWM write; validated by magic + CRC32 on the next boot.
+struct WarmRestartState {
+  uint32_t magic;
+  uint32_t warmBoots;                       // Consecutive warm boots since the last cold boot
+  uint8_t frame[WARM_RESTART_CHANNELS];     // LightProfile field order
+  uint8_t mode;                             // LightMode when the frame was written
+  uint8_t held;                             // Outputs were latched with gpio_hold before reset
+  uint8_t reserved[3];
+  uint32_t checksum;                        // CRC32 of everything above
+};
+
+uint32_t warmRestartChecksum(const WarmRestartState& state);
+bool warmRestartValid(const WarmRestartState& state);
+void warmRestartRecord(WarmRestartState& state, const uint8_t* frame, uint8_t mode);
+void warmRestartSetHeld(WarmRestartState& state, bool held);
+void warmRestartInvalidate(WarmRestartState& state);
+
+// Boot-time handoff. resetIsWarm: the reset reason keeps RTC memory and is not
+// a power/brownout reset. Returns true if state.frame should be applied; the
+// warm boot is counted and the held flag cleared. Otherwise the state is
+// invalidated and the normal (cold) boot path runs.
+bool warmRestartTake(WarmRestartState& state, bool resetIsWarm);
+
+// The instance in RTC no-init memory (a plain static on the host)
+WarmRestartState& warmRestartMemory();
+
+#endif // WARM_RESTART_H
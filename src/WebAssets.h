@@ -0,0 +1,132 @@
+// Generated by tools/embed_web.py from web/ - do not edit.
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// Asset      source / minified / gzip bytes
+// index.html   1531 /   1242 /    651
+// app.js       3470 /   2967 /   1065
+
+#define WEB_INDEX_ETAG "\"c022a21b9af1\""
+#define WEB_INDEX_RAW_LEN 1242
+#define WEB_INDEX_GZ_LEN 651
+alignas(4) static constexpr uint8_t WEB_INDEX_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x54, 0x4d, 0x73, 0x9b, 0x30,
+  0x10, 0xfd, 0x2b, 0xaa, 0x7c, 0x2d, 0x60, 0xf0, 0x47, 0x1d, 0x0c, 0xcc, 0xa4, 0x49, 0x6e, 0xc9,
+  0xb4, 0x33, 0xed, 0xa5, 0xc7, 0xb5, 0x24, 0x8c, 0x5a, 0x21, 0x51, 0x49, 0x24, 0x76, 0x3d, 0xfc,
+  0xf7, 0x4a, 0x88, 0xc4, 0xce, 0x24, 0xd3, 0x5e, 0x90, 0xd9, 0x7d, 0xfb, 0x76, 0xdf, 0xea, 0xe1,
+  0xe2, 0xc3, 0xed, 0x97, 0x9b, 0xef, 0x3f, 0xbe, 0xde, 0xa1, 0xc6, 0xb6, 0xa2, 0x2a, 0xfc, 0x13,
+  0x09, 0x90, 0xfb, 0x12, 0x33, 0x89, 0xdd, 0x3b, 0x03, 0x5a, 0x15, 0x2d, 0xb3, 0x80, 0x48, 0x03,
+  0xda, 0x30, 0x5b, 0xe2, 0xde, 0xd6, 0xd1, 0x06, 0x4f, 0x51, 0x09, 0x2d, 0x2b, 0xf1, 0x23, 0x67,
+  0x4f, 0x9d, 0xd2, 0x16, 0x23, 0xa2, 0xa4, 0x65, 0xd2, 0xa1, 0x9e, 0x38, 0xb5, 0x4d, 0x49, 0xd9,
+  0x23, 0x27, 0x2c, 0x1a, 0x5f, 0x3e, 0x22, 0x2e, 0xb9, 0xe5, 0x20, 0x22, 0x43, 0x40, 0xb0, 0x32,
+  0x75, 0x1c, 0x96, 0x5b, 0xc1, 0xaa, 0x6f, 0xf7, 0xd7, 0x9f, 0xd1, 0xf5, 0xef, 0x1e, 0x34, 0xef,
+  0x5b, 0x74, 0x7f, 0x77, 0x8b, 0x6e, 0x1c, 0x8d, 0x56, 0x42, 0x30, 0x5d, 0x24, 0x01, 0x53, 0x18,
+  0x7b, 0x74, 0xc7, 0x4e, 0xd1, 0xe3, 0xa9, 0x76, 0xd9, 0xa8, 0x86, 0x96, 0x8b, 0x63, 0x6e, 0x40,
+  0x9a, 0xc8, 0x30, 0xcd, 0xeb, 0x6d, 0x0b, 0x7a, 0xcf, 0x65, 0x3e, 0xdf, 0xee, 0x80, 0xfc, 0xda,
+  0x6b, 0xd5, 0x4b, 0x9a, 0xcf, 0xe6, 0xbb, 0x94, 0x66, 0xb0, 0x25, 0x4a, 0x28, 0x9d, 0xcf, 0xd8,
+  0xba, 0x9e, 0xd7, 0xab, 0xc1, 0xcb, 0x62, 0xfa, 0xd4, 0x01, 0xa5, 0x5c, 0xee, 0xf3, 0x34, 0xeb,
+  0x0e, 0x28, 0x5d, 0x77, 0x87, 0x57, 0x95, 0x69, 0xb6, 0xc8, 0x96, 0x30, 0x34, 0x69, 0xe8, 0x67,
+  0xf8, 0x1f, 0x96, 0xa7, 0x1b, 0x07, 0x7a, 0xee, 0x33, 0xb4, 0xc0, 0xe5, 0x99, 0x64, 0x3d, 0xa6,
+  0x0e, 0x41, 0x6c, 0xbe, 0xca, 0xe6, 0x17, 0x50, 0x04, 0xbd, 0x55, 0x83, 0x61, 0xc4, 0x72, 0x25,
+  0x4f, 0x21, 0x1a, 0xed, 0x94, 0xb5, 0xaa, 0xcd, 0x3d, 0x70, 0x68, 0xb2, 0xcb, 0x2e, 0xab, 0xcb,
+  0xd2, 0x39, 0xf2, 0x4d, 0x27, 0x01, 0x9b, 0x9a, 0x2c, 0xd8, 0x7c, 0x88, 0x5b, 0x45, 0x99, 0x41,
+  0xbb, 0xde, 0x31, 0x9c, 0x47, 0xd8, 0x78, 0x19, 0xcb, 0x97, 0xda, 0x48, 0xf3, 0x7d, 0x63, 0xf3,
+  0x51, 0x97, 0xd2, 0x4e, 0x70, 0x9e, 0x3a, 0x80, 0x51, 0x82, 0x53, 0x34, 0x5b, 0xc0, 0xba, 0xbe,
+  0x4a, 0xa7, 0x44, 0xa4, 0x81, 0xf2, 0xde, 0xe4, 0xcb, 0x77, 0x57, 0x30, 0xf5, 0xe6, 0xb2, 0x71,
+  0x6b, 0xb6, 0xaf, 0x7b, 0xc7, 0xae, 0xfd, 0x65, 0x45, 0xb6, 0xdb, 0xac, 0xc9, 0x6a, 0x88, 0xb5,
+  0x7a, 0x3a, 0x51, 0x6e, 0x3a, 0x01, 0xc7, 0xbc, 0x16, 0xec, 0xb0, 0x05, 0xc1, 0xf7, 0x32, 0xe2,
+  0x96, 0xb5, 0x26, 0x27, 0xce, 0x21, 0x4c, 0x3f, 0x2b, 0x74, 0xf3, 0xa1, 0xf9, 0x58, 0xe1, 0x9c,
+  0xb7, 0x63, 0xe2, 0x14, 0x16, 0xb8, 0x71, 0xc3, 0x84, 0x28, 0x97, 0x5d, 0x6f, 0x4f, 0x9e, 0x25,
+  0x4f, 0x43, 0xc4, 0x74, 0x20, 0x27, 0xd8, 0xc2, 0xcb, 0xb3, 0xec, 0x60, 0xa3, 0xb1, 0x43, 0x3e,
+  0x6a, 0x1e, 0x66, 0xc6, 0x82, 0xed, 0xcd, 0xe5, 0x4e, 0x17, 0x6f, 0x96, 0x58, 0x24, 0xc1, 0x53,
+  0x45, 0x12, 0x6c, 0xee, 0xbd, 0x15, 0x2c, 0xcf, 0xb4, 0x3b, 0xd3, 0xb7, 0xbe, 0x74, 0xc8, 0xb4,
+  0x2a, 0x28, 0x7f, 0x44, 0x9c, 0x96, 0x38, 0xf4, 0xc0, 0x95, 0x33, 0xab, 0xf4, 0x37, 0x2b, 0xf7,
+  0x71, 0x1c, 0x17, 0x89, 0x4b, 0x4f, 0x94, 0x9e, 0xc6, 0x7b, 0xc4, 0x99, 0x37, 0xdc, 0xbc, 0x63,
+  0xcd, 0xaa, 0x07, 0xb7, 0x3e, 0x97, 0xcf, 0x02, 0x11, 0x11, 0x60, 0x4c, 0x89, 0xc7, 0x9d, 0xba,
+  0x0f, 0x22, 0x6c, 0x15, 0x51, 0xb0, 0x10, 0xf9, 0x58, 0x89, 0xbd, 0x73, 0x70, 0x75, 0xed, 0x9e,
+  0x45, 0x12, 0xb2, 0xef, 0xa1, 0x5a, 0x90, 0x3d, 0x08, 0x5c, 0x3d, 0x8c, 0xe7, 0xbf, 0x90, 0xaa,
+  0xae, 0x71, 0xf5, 0xa5, 0xae, 0xcf, 0x98, 0x69, 0xe2, 0x97, 0x19, 0x2f, 0x87, 0xbd, 0x69, 0xc0,
+  0x89, 0x13, 0xe6, 0x3c, 0xb0, 0x57, 0x4e, 0xa6, 0x28, 0xfe, 0x4f, 0xf1, 0xcb, 0x57, 0x8c, 0x2c,
+  0x6f, 0xd9, 0x6b, 0x0e, 0x1f, 0xc1, 0x55, 0xf4, 0x86, 0x20, 0x99, 0x36, 0x46, 0x34, 0xef, 0x2c,
+  0x32, 0x9a, 0x94, 0x38, 0x71, 0x2b, 0x62, 0xd6, 0x24, 0xd0, 0x75, 0xf1, 0x12, 0x56, 0xf4, 0x6a,
+  0x45, 0xd8, 0x27, 0xc2, 0x36, 0xf1, 0xcf, 0x71, 0x82, 0x00, 0x75, 0x3f, 0xc2, 0x05, 0x26, 0xe3,
+  0x5f, 0xd9, 0x5f, 0x3a, 0xb3, 0x00, 0x5f, 0xda, 0x04, 0x00, 0x00,
+};
+
+#define WEB_APP_JS_PATH "/assets/app.4a5d95ce7ce8.js"
+#define WEB_APP_JS_ETAG "\"4a5d95ce7ce8\""
+#define WEB_APP_JS_RAW_LEN 2967
+#define WEB_APP_JS_GZ_LEN 1065
+alignas(4) static constexpr uint8_t WEB_APP_JS_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x56, 0xdd, 0x6f, 0xdb, 0x36,
+  0x10, 0x7f, 0xd7, 0x5f, 0x41, 0x10, 0x7d, 0x90, 0x10, 0x47, 0xf1, 0x06, 0xe4, 0xc5, 0x59, 0x30,
+  0x24, 0x41, 0xb6, 0x75, 0xc8, 0xd2, 0x22, 0x4e, 0xdb, 0x87, 0x20, 0x0f, 0xb4, 0x74, 0xb6, 0xb8,
+  0xd1, 0xa4, 0x47, 0x52, 0x4e, 0x8d, 0xd4, 0xff, 0xfb, 0xee, 0x48, 0xc9, 0x91, 0xfc, 0x55, 0x14,
+  0x18, 0x12, 0x88, 0xf4, 0xf1, 0xf8, 0xbb, 0xef, 0x3b, 0x2e, 0x85, 0x65, 0x37, 0x7f, 0x5c, 0xdd,
+  0xdf, 0xdf, 0xde, 0x8d, 0xd9, 0x25, 0x7b, 0xe2, 0xd6, 0xac, 0x84, 0xba, 0x56, 0x35, 0xf0, 0x01,
+  0xe3, 0x93, 0x66, 0xad, 0x97, 0xf4, 0x5d, 0x4a, 0xa3, 0xc0, 0xd3, 0xce, 0x42, 0x49, 0xcb, 0xcc,
+  0x02, 0x68, 0xda, 0xbc, 0x54, 0xd2, 0x03, 0x7f, 0xbe, 0x48, 0x96, 0x08, 0x77, 0x77, 0x75, 0xdd,
+  0x82, 0x3d, 0x10, 0x18, 0x6b, 0xd1, 0xda, 0xf5, 0xd3, 0x67, 0xfa, 0x7e, 0xde, 0xa0, 0x3d, 0x44,
+  0xb4, 0xdf, 0x5b, 0xb4, 0x2f, 0x5d, 0x34, 0xa7, 0x64, 0x09, 0xd6, 0x21, 0xdc, 0xeb, 0x3a, 0x52,
+  0x4a, 0x2b, 0x66, 0x33, 0xa9, 0x67, 0x48, 0x9a, 0x0a, 0xe5, 0xa0, 0xe1, 0x03, 0x5d, 0x3e, 0xca,
+  0x39, 0x58, 0x24, 0xeb, 0x5a, 0xa9, 0x8b, 0x64, 0x5a, 0xeb, 0xc2, 0x4b, 0xa3, 0xd9, 0xbb, 0x54,
+  0x96, 0x19, 0x7b, 0x4d, 0x2c, 0xf8, 0xda, 0x6a, 0x56, 0x9a, 0xa2, 0x9e, 0x83, 0xf6, 0xf9, 0x0c,
+  0xfc, 0xad, 0x02, 0xda, 0x5e, 0xaf, 0xde, 0x97, 0xc4, 0x74, 0x91, 0xac, 0xdf, 0xae, 0x2d, 0x8c,
+  0xf3, 0xe9, 0x42, 0xf8, 0x6a, 0xc0, 0x26, 0xa6, 0x5c, 0x75, 0x10, 0xa6, 0xe0, 0x8b, 0xaa, 0x39,
+  0x7a, 0x4d, 0xe6, 0xe0, 0x2b, 0x53, 0x8e, 0x18, 0xff, 0xf8, 0x61, 0xfc, 0xc8, 0x07, 0x49, 0x05,
+  0x82, 0x34, 0x1e, 0xb1, 0x57, 0xc6, 0x6f, 0x8c, 0xf6, 0x88, 0x7f, 0xfa, 0xb8, 0x5a, 0x00, 0x47,
+  0x16, 0xb1, 0x58, 0x28, 0x59, 0x08, 0xc2, 0x3f, 0xfb, 0xdb, 0x19, 0xcd, 0xd9, 0x7a, 0x90, 0x10,
+  0xfa, 0x88, 0xfd, 0x39, 0xfe, 0x70, 0x9f, 0x3b, 0x6f, 0xd1, 0x32, 0x39, 0x5d, 0xa5, 0x41, 0x64,
+  0xb2, 0xee, 0xab, 0xe4, 0x2a, 0xf3, 0xf2, 0x97, 0x29, 0x21, 0x9d, 0xe3, 0x87, 0x14, 0x22, 0xcb,
+  0x27, 0xb5, 0xf7, 0x46, 0x93, 0x87, 0x36, 0x96, 0xfd, 0x5b, 0x83, 0x5d, 0x8d, 0x41, 0x41, 0xe1,
+  0x8d, 0xbd, 0x52, 0x2a, 0xe5, 0x39, 0xdd, 0x70, 0x0d, 0x2f, 0x47, 0xd4, 0xa9, 0xb1, 0x2c, 0xa5,
+  0xeb, 0x12, 0x2f, 0x0e, 0x2f, 0x70, 0xf9, 0xa5, 0x45, 0xca, 0x15, 0xe8, 0x99, 0xaf, 0x90, 0x76,
+  0x72, 0x42, 0x42, 0x1a, 0xf2, 0x93, 0x7c, 0xce, 0x0b, 0x25, 0x9c, 0xbb, 0x17, 0x73, 0xc0, 0x4b,
+  0x1d, 0x32, 0x7a, 0xf2, 0xca, 0xa3, 0xea, 0x48, 0x82, 0x94, 0x97, 0xc2, 0x8b, 0x53, 0x92, 0xc7,
+  0x33, 0x76, 0x79, 0x79, 0xc9, 0x68, 0xcb, 0x7e, 0x65, 0x9c, 0xcc, 0x45, 0x1f, 0x70, 0x32, 0x69,
+  0xcb, 0xa8, 0xdf, 0x2c, 0x62, 0xa6, 0x53, 0xfa, 0x92, 0x44, 0x39, 0x65, 0x69, 0x1b, 0xe6, 0x37,
+  0xbf, 0x07, 0x57, 0xec, 0x51, 0xbb, 0xcd, 0xdf, 0x6d, 0xbd, 0x89, 0x6d, 0x29, 0x30, 0xe9, 0x28,
+  0x53, 0x08, 0xfa, 0xa9, 0xe5, 0x44, 0x9d, 0x9f, 0xd9, 0xb7, 0x6f, 0x08, 0x90, 0x34, 0xf9, 0xd5,
+  0x3b, 0xca, 0xa5, 0x5e, 0xd4, 0x3e, 0x6f, 0xef, 0x86, 0xf5, 0x00, 0xa7, 0xa9, 0x3d, 0xb1, 0x7a,
+  0xf8, 0xea, 0x9b, 0x58, 0xbf, 0x5d, 0xe8, 0x59, 0xb9, 0x10, 0x65, 0x1a, 0xe8, 0x9d, 0x3c, 0x8a,
+  0x04, 0xb4, 0xe0, 0xa7, 0x21, 0xf9, 0x67, 0x18, 0xdd, 0x93, 0xb1, 0x93, 0x37, 0x84, 0x9e, 0x97,
+  0x28, 0xbf, 0x53, 0x2f, 0xa3, 0x8f, 0xde, 0xa5, 0x9c, 0xb6, 0x3c, 0xdb, 0x12, 0x4e, 0xc4, 0x7c,
+  0x05, 0x68, 0xfb, 0x09, 0xe3, 0xa7, 0x1c, 0xbf, 0x24, 0x3a, 0x50, 0xe7, 0xc8, 0x54, 0x65, 0xbb,
+  0xf4, 0x52, 0xac, 0x02, 0x15, 0xff, 0x4e, 0x92, 0x0d, 0xb5, 0x32, 0xb5, 0x0d, 0xe4, 0x51, 0x1f,
+  0x44, 0x6a, 0x8c, 0xf2, 0x9e, 0x03, 0x07, 0x85, 0xd1, 0x5b, 0x35, 0xe4, 0x8a, 0x0a, 0xca, 0x5a,
+  0xc1, 0x18, 0xab, 0x33, 0x6d, 0x23, 0xbb, 0x29, 0xd5, 0x7e, 0x68, 0xbb, 0x15, 0xec, 0xc0, 0xd3,
+  0x16, 0xbd, 0x9b, 0x6e, 0xb0, 0xc2, 0xfd, 0xdd, 0x32, 0xa7, 0x28, 0x87, 0xe8, 0x36, 0x2d, 0xe2,
+  0x47, 0x32, 0x64, 0x4f, 0x56, 0x5c, 0xa2, 0x41, 0xd6, 0xc1, 0x7b, 0xed, 0xd3, 0xef, 0xa5, 0xc6,
+  0x00, 0xe3, 0x16, 0xcc, 0x0d, 0x9d, 0x82, 0x9f, 0x89, 0x85, 0x3c, 0x9b, 0x0b, 0x5d, 0x0b, 0x75,
+  0x26, 0x94, 0xc2, 0x4e, 0x16, 0xf3, 0x19, 0x39, 0x90, 0xf3, 0x7c, 0xd8, 0xf7, 0xcc, 0xa4, 0x96,
+  0xaa, 0x1c, 0x47, 0x09, 0x69, 0x9b, 0xad, 0xe8, 0x40, 0x2f, 0xa4, 0x0e, 0xd6, 0x61, 0x7c, 0x8b,
+  0x4a, 0x68, 0x0d, 0xca, 0x1d, 0xaa, 0xd7, 0x63, 0x89, 0x6f, 0xcd, 0x4b, 0xb7, 0x23, 0x14, 0x16,
+  0x84, 0x87, 0xa6, 0xdd, 0x61, 0x89, 0xca, 0x25, 0x81, 0x22, 0x53, 0xaf, 0xa4, 0xb1, 0xfb, 0xbf,
+  0xf0, 0xe8, 0x52, 0x25, 0x26, 0xa0, 0x8e, 0x20, 0x84, 0x73, 0xc2, 0x08, 0x9b, 0xad, 0x1c, 0x8c,
+  0x23, 0x00, 0xfd, 0x15, 0xb1, 0x82, 0xcf, 0x8e, 0x60, 0x85, 0x73, 0xc2, 0x8a, 0xce, 0xf5, 0xd8,
+  0x2c, 0x83, 0x32, 0x42, 0xcf, 0x80, 0xb7, 0x54, 0xcc, 0xbb, 0x60, 0x79, 0xfb, 0x53, 0x7c, 0xc5,
+  0x9f, 0x3f, 0x9f, 0x9f, 0xb7, 0x84, 0xb6, 0x5a, 0x87, 0x51, 0x66, 0x2c, 0xcc, 0x23, 0x42, 0xdd,
+  0x42, 0x84, 0x46, 0xb8, 0xb7, 0x82, 0xb1, 0x16, 0xa3, 0x77, 0xb0, 0x61, 0x63, 0xc6, 0xdd, 0x54,
+  0x18, 0xac, 0x34, 0x58, 0x9a, 0xed, 0xd2, 0x83, 0xfc, 0x3d, 0xf4, 0x88, 0x8c, 0x07, 0x9b, 0xb0,
+  0xf6, 0x8e, 0x91, 0x3d, 0xdb, 0xdf, 0x55, 0x28, 0x93, 0xa3, 0xd3, 0x46, 0x71, 0x19, 0x34, 0xe6,
+  0x8c, 0x5a, 0xb3, 0xd6, 0xad, 0xd5, 0xa2, 0x2c, 0x6f, 0x97, 0xa8, 0xf3, 0x9d, 0x74, 0xa8, 0x3a,
+  0xd8, 0xd6, 0x99, 0x03, 0xd6, 0x29, 0x9c, 0x78, 0x69, 0x10, 0xb1, 0xba, 0x73, 0xac, 0x57, 0x5a,
+  0x9d, 0xb9, 0xea, 0x2d, 0x75, 0x9f, 0xbd, 0x9e, 0xe9, 0x38, 0x1b, 0x95, 0xef, 0x95, 0x37, 0xe6,
+  0x37, 0xfe, 0x67, 0x5b, 0xe2, 0xb2, 0xc3, 0xaa, 0x52, 0x7e, 0xcf, 0xe8, 0x49, 0x70, 0x50, 0x91,
+  0x66, 0xc0, 0xc7, 0x31, 0xd8, 0xa9, 0x1e, 0xf4, 0xa8, 0xc6, 0xe1, 0xb6, 0x29, 0x1c, 0x87, 0xbd,
+  0xaa, 0xa0, 0xe8, 0x6b, 0x78, 0x61, 0x41, 0xca, 0x38, 0x50, 0x9a, 0xaa, 0x04, 0xa2, 0x84, 0x32,
+  0x8a, 0x8c, 0xb9, 0xd1, 0x06, 0x03, 0x41, 0x02, 0x7a, 0x92, 0xb1, 0xe6, 0x9c, 0x17, 0xbe, 0x76,
+  0x3b, 0x5d, 0x95, 0xdf, 0xc9, 0x25, 0xe5, 0xe2, 0xba, 0x03, 0x01, 0xd6, 0x1a, 0xfb, 0x23, 0x18,
+  0x0f, 0xd0, 0xe8, 0x8d, 0xc6, 0xe5, 0x79, 0xde, 0x83, 0xdb, 0xf5, 0x4e, 0x98, 0xa0, 0x5d, 0xdf,
+  0x04, 0x2b, 0x42, 0x13, 0x6c, 0x9f, 0x01, 0xe1, 0xcd, 0x10, 0xfa, 0x55, 0x3c, 0xcc, 0x69, 0xf4,
+  0x66, 0x61, 0xd6, 0x67, 0xd1, 0x6b, 0x07, 0xd1, 0x43, 0x6f, 0x3a, 0x0c, 0x1f, 0x07, 0xf2, 0x7e,
+  0xfc, 0xef, 0x41, 0x87, 0xb1, 0x74, 0x10, 0x39, 0x0c, 0xb1, 0xa3, 0xc0, 0xeb, 0xa4, 0xdf, 0x1c,
+  0x63, 0x41, 0x93, 0x51, 0xd7, 0xff, 0xdb, 0x53, 0xa7, 0x83, 0xb6, 0xdd, 0x3d, 0x3b, 0x47, 0xf4,
+  0xb6, 0xd9, 0x93, 0xb6, 0xf8, 0x84, 0xfb, 0x67, 0x27, 0x6b, 0xbb, 0x43, 0x20, 0x46, 0xee, 0x35,
+  0x48, 0x19, 0x31, 0x5f, 0x49, 0x77, 0xe4, 0x89, 0xb4, 0xde, 0x98, 0xbd, 0xc9, 0xea, 0x8b, 0xff,
+  0x00, 0x6e, 0xdc, 0x13, 0x10, 0x97, 0x0b, 0x00, 0x00,
+};
+
+#endif // WEB_ASSETS_H
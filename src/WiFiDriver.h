@@ -0,0 +1,49 @@
+#ifndef WIFI_DRIVER_H
+#define WIFI_DRIVER_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Event bits posted by a driver (see WiFiDriver::post)
+#define WIFI_EVENT_AP_START   0x01  // Soft AP is up and beaconing
+#define WIFI_EVENT_AP_STOP    0x02  // Soft AP went down (not requested by us)
+#define WIFI_EVENT_STA_JOIN   0x04  // A station associated with the AP
+#define WIFI_EVENT_STA_LEAVE  0x08  // A station left the AP
+
+// Steps of a full driver reset, each followed by a settle delay
+enum WiFiResetStep : uint8_t {
+  WIFI_RESET_STOP,
+  WIFI_RESET_DEINIT,
+  WIFI_RESET_INIT,
+  WIFI_RESET_START,
+  WIFI_RESET_STEP_COUNT
+};
+
+// Radio operations used by WiFiLink. Every call returns immediately; the
+// settle time between steps is handled by WiFiLink's timers, not by delay().
+//
+// Implementations report asynchronous driver events with post(), which may
+// be called from any task (e.g. the ESP32 WiFi event task). WiFiLink drains
+// them from the network task with takeEvents().
+class WiFiDriver {
+private:
+  std::atomic<uint8_t> pendingEvents;
+
+public:
+  WiFiDriver() : pendingEvents(0) {}
+  virtual ~WiFiDriver() {}
+
+  void post(uint8_t events) { pendingEvents.fetch_or(events, std::memory_order_release); }
+  uint8_t takeEvents() { return pendingEvents.exchange(0, std::memory_order_acquire); }
+
+  virtual void shutdown() = 0;                                        // Disconnect, radio off
+  virtual void resetStep(WiFiResetStep step) = 0;                     // Low-level driver reset
+  virtual bool enableAP() = 0;                                        // Switch to AP mode
+  virtual bool configureAP() = 0;                                     // Static IP 192.168.4.1/24
+  virtual bool startAP(const char* ssid, const char* password) = 0;   // Begin beaconing
+  virtual bool addressValid() = 0;                                    // AP has the configured IP
+  virtual uint8_t stationCount() = 0;
+  virtual void log(const char* message) = 0;
+};
+
+#endif // WIFI_DRIVER_H
@@ -0,0 +1,171 @@
+#include "WiFiLink.h"
+#include "Metrics.h"
+#include <stdio.h>
+
+static const char* const STATE_NAMES[] = {
+  "idle", "shutdown", "driver reset", "enable AP", "starting", "verifying", "up", "backoff"
+};
+
+WiFiLink::WiFiLink(WiFiDriver* driver, const char* ssid, const char* password) : restartRequested(false) {
+  this->driver = driver;
+  this->ssid = ssid;
+  this->password = password;
+  this->state = WIFI_LINK_IDLE;
+  this->resetStep = 0;
+  this->deadline = 0;
+  this->startedAt = 0;
+  this->lastHealthCheck = 0;
+  this->failures = 0;
+  this->attempts = 0;
+  this->everUp = false;
+}
+
+void WiFiLink::start(uint32_t now) {
+  startedAt = now;
+  failures = 0;
+  beginAttempt(now);
+}
+
+void WiFiLink::enter(WiFiLinkState next, uint32_t now, uint32_t timeout) {
+  state = next;
+  deadline = now + timeout;
+}
+
+void WiFiLink::beginAttempt(uint32_t now) {
+  if (attempts > 0) {
+    metrics.apRestarts.add();
+  }
+  attempts++;
+
+  char message[64];
+  snprintf(message, sizeof(message), "WiFi: AP startup attempt %lu%s", (unsigned long)attempts,
+           failures >= WIFI_DRIVER_RESET_AFTER ? " (with driver reset)" : "");
+  driver->log(message);
+
+  // Event lama (mis. AP_STOP dari percobaan sebelumnya) tidak relevan lagi
+  driver->takeEvents();
+  driver->shutdown();
+  enter(WIFI_LINK_SHUTDOWN, now, WIFI_SHUTDOWN_SETTLE_MS);
+}
+
+void WiFiLink::fail(uint32_t now, const char* reason) {
+  if (failures < 0xFF) {
+    failures++;
+  }
+  uint32_t delayMs = retryDelay(now);
+
+  char message[96];
+  snprintf(message, sizeof(message), "WiFi: %s (in %s, failure %u), retry in %lu ms",
+           reason, STATE_NAMES[state], failures, (unsigned long)delayMs);
+  driver->log(message);
+
+  enter(WIFI_LINK_BACKOFF, now, delayMs);
+}
+
+uint32_t WiFiLink::retryDelay(uint32_t now) {
+  if (failures <= WIFI_BOOT_ATTEMPTS) {
+    return WIFI_RETRY_BOOT_MS;
+  }
+  return (now - startedAt < WIFI_EARLY_PERIOD_MS) ? WIFI_RETRY_EARLY_MS : WIFI_RETRY_LATE_MS;
+}
+
+void WiFiLink::update(uint32_t now) {
+  uint8_t events = driver->takeEvents();
+
+  if (restartRequested.exchange(false, std::memory_order_relaxed)) {
+    driver->log("WiFi: restart requested");
+    failures = 0;
+    beginAttempt(now);
+    return;
+  }
+
+  switch (state) {
+    case WIFI_LINK_IDLE:
+      break;
+
+    case WIFI_LINK_SHUTDOWN:
+      if (!expired(now)) break;
+      if (failures >= WIFI_DRIVER_RESET_AFTER) {
+        resetStep = WIFI_RESET_STOP;
+        driver->resetStep(WIFI_RESET_STOP);
+        enter(WIFI_LINK_DRIVER_RESET, now, WIFI_RESET_STEP_SETTLE_MS);
+        break;
+      }
+      if (!driver->enableAP()) {
+        fail(now, "AP mode not accepted");
+        break;
+      }
+      enter(WIFI_LINK_ENABLE_AP, now, WIFI_MODE_SETTLE_MS);
+      break;
+
+    case WIFI_LINK_DRIVER_RESET:
+      if (!expired(now)) break;
+      if (++resetStep < WIFI_RESET_STEP_COUNT) {
+        driver->resetStep((WiFiResetStep)resetStep);
+        enter(WIFI_LINK_DRIVER_RESET, now, WIFI_RESET_STEP_SETTLE_MS);
+        break;
+      }
+      if (!driver->enableAP()) {
+        fail(now, "AP mode not accepted");
+        break;
+      }
+      enter(WIFI_LINK_ENABLE_AP, now, WIFI_MODE_SETTLE_MS);
+      break;
+
+    case WIFI_LINK_ENABLE_AP:
+      if (!expired(now)) break;
+      if (!driver->configureAP()) {
+        driver->log("WiFi: AP IP configuration failed, using default");
+      }
+      if (!driver->startAP(ssid, password)) {
+        fail(now, "softAP() failed");
+        break;
+      }
+      enter(WIFI_LINK_STARTING, now, WIFI_AP_START_TIMEOUT_MS);
+      break;
+
+    case WIFI_LINK_STARTING:
+      if (events & WIFI_EVENT_AP_STOP) {
+        fail(now, "AP stopped while starting");
+      } else if (events & WIFI_EVENT_AP_START) {
+        enter(WIFI_LINK_VERIFYING, now, WIFI_VERIFY_MS);
+      } else if (expired(now)) {
+        fail(now, "no AP start event");
+      }
+      break;
+
+    case WIFI_LINK_VERIFYING:
+      // Pengganti polling 3-dari-5 yang lama: AP harus tetap hidup selama WIFI_VERIFY_MS
+      if (events & WIFI_EVENT_AP_STOP) {
+        fail(now, "AP stopped during verification");
+      } else if (expired(now)) {
+        if (!driver->addressValid()) {
+          fail(now, "AP IP address not as configured");
+          break;
+        }
+        failures = 0;
+        everUp = true;
+        lastHealthCheck = now;
+        enter(WIFI_LINK_UP, now, 0);
+        driver->log("WiFi: access point up");
+      }
+      break;
+
+    case WIFI_LINK_UP:
+      if (events & WIFI_EVENT_AP_STOP) {
+        fail(now, "AP stopped");
+      } else if (now - lastHealthCheck >= WIFI_HEALTH_CHECK_MS) {
+        lastHealthCheck = now;
+        if (!driver->addressValid()) {
+          fail(now, "AP IP address changed");
+        }
+      }
+      break;
+
+    case WIFI_LINK_BACKOFF:
+      if (expired(now)) {
+        beginAttempt(now);
+      }
+      break;
+  }
+}
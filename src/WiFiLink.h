@@ -0,0 +1,85 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdint.h>
+#include <atomic>
+#include "WiFiDriver.h"
+
+// Settle times between radio steps (previously delay() calls)
+#define WIFI_SHUTDOWN_SETTLE_MS    1000
+#define WIFI_RESET_STEP_SETTLE_MS  1000
+#define WIFI_MODE_SETTLE_MS        500
+#define WIFI_AP_START_TIMEOUT_MS   3000  // Wait for the AP_START event after softAP()
+#define WIFI_VERIFY_MS             1500  // AP must stay up this long to count as started
+
+// Retry / escalation policy
+#define WIFI_BOOT_ATTEMPTS         3       // Attempts before reporting failure at boot
+#define WIFI_RETRY_BOOT_MS         5000    // Delay between boot attempts and after losing the AP
+#define WIFI_RETRY_EARLY_MS        10000   // Later retries, first 5 minutes after start()
+#define WIFI_RETRY_LATE_MS         30000   // Later retries afterwards
+#define WIFI_EARLY_PERIOD_MS       300000
+#define WIFI_DRIVER_RESET_AFTER    1       // Consecutive failures before a full driver reset
+#define WIFI_HEALTH_CHECK_MS       60000   // Address check while the AP is up
+
+enum WiFiLinkState : uint8_t {
+  WIFI_LINK_IDLE,         // start() not called yet
+  WIFI_LINK_SHUTDOWN,     // Radio off, settling
+  WIFI_LINK_DRIVER_RESET, // Stepping through WiFiResetStep
+  WIFI_LINK_ENABLE_AP,    // AP mode selected, settling
+  WIFI_LINK_STARTING,     // softAP() called, waiting for AP_START
+  WIFI_LINK_VERIFYING,    // AP_START seen, waiting for it to stay up
+  WIFI_LINK_UP,
+  WIFI_LINK_BACKOFF       // Attempt failed, waiting to retry
+};
+
+// Timer-driven soft AP bring-up and recovery. update() is called from the
+// network task and never blocks: each state does at most one driver call and
+// sets a deadline for the next step. Driver events (AP start/stop) move the
+// machine on without polling the WiFi mode.
+//
+// Policy (same as the old delay()-based code):
+// - First attempt is a plain radio off -> AP mode cycle; every retry after a
+//   failure also resets the driver (esp_wifi stop/deinit/init/start).
+// - Retries are 5 s apart for the first WIFI_BOOT_ATTEMPTS failures and after
+//   the AP drops, then 10 s (first 5 minutes) or 30 s.
+// - After WIFI_BOOT_ATTEMPTS failed attempts without ever being up,
+//   hasGivenUp() is true; retries continue in the background.
+class WiFiLink {
+private:
+  WiFiDriver* driver;
+  const char* ssid;
+  const char* password;
+
+  WiFiLinkState state;
+  uint8_t resetStep;
+  uint32_t deadline;
+  uint32_t startedAt;
+  uint32_t lastHealthCheck;
+  uint8_t failures;        // Consecutive failed attempts
+  uint32_t attempts;       // All attempts since start()
+  bool everUp;
+  std::atomic<bool> restartRequested;
+
+  void enter(WiFiLinkState next, uint32_t now, uint32_t timeout);
+  void beginAttempt(uint32_t now);
+  void fail(uint32_t now, const char* reason);
+  uint32_t retryDelay(uint32_t now);
+  bool expired(uint32_t now) { return (int32_t)(now - deadline) >= 0; }
+
+public:
+  WiFiLink(WiFiDriver* driver, const char* ssid, const char* password);
+
+  void start(uint32_t now);
+  void update(uint32_t now);
+
+  // Safe to call from any task (e.g. an HTTP handler); applied on the next update()
+  void requestRestart() { restartRequested.store(true, std::memory_order_relaxed); }
+
+  WiFiLinkState getState() { return state; }
+  bool isUp() { return state == WIFI_LINK_UP; }
+  bool hasGivenUp() { return !everUp && failures >= WIFI_BOOT_ATTEMPTS; }
+  uint8_t getFailures() { return failures; }
+  uint32_t getAttempts() { return attempts; }
+};
+
+#endif // WIFI_LINK_H
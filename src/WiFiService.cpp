@@ -1,52 +1,184 @@
 #include "WiFiService.h"
-#include "esp_wifi.h"  // Untuk akses fungsi WiFi ESP-IDF level rendah
+#include "WebAssets.h"   // Dibuat oleh tools/embed_web.py dari folder web/
+#include "Metrics.h"
+#include "NvsWear.h"
+#include "Trace.h"
+#include "ScheduleSimulator.h"
+#include <esp_heap_caps.h>
 
-WiFiService::WiFiService(LedController* ledController, const char* ssid, const char* password) {
+// Buffer response bersama (JSON di-render dengan snprintf/serializeJson, tanpa String)
+static char responseBuffer[SCHEDULE_JSON_MAX_SIZE];
+
+// Kirim {"status":"error","message":"<prefix><detail>"} tanpa String
+static void sendJsonError(AsyncWebServerRequest* request, const char* prefix, const char* detail) {
+  char body[128];
+  snprintf(body, sizeof(body), "{\"status\":\"error\",\"message\":\"%s%s\"}", prefix, detail);
+  request->send(400, "application/json", body);
+}
+
+// Error dari parser ApiRequests, dikirim apa adanya
+static void sendApiError(AsyncWebServerRequest* request, const ApiError& error) {
+  request->send(error.status, error.contentType, error.body);
+}
+
+// Header CORS untuk semua response; juga ditulis langsung oleh DeferredCommandResponse
+static const char* const CORS_HEADERS[][2] = {
+  {"Access-Control-Allow-Origin", "*"},
+  {"Access-Control-Allow-Methods", "GET, POST, PUT, PATCH, OPTIONS"},
+  {"Access-Control-Allow-Headers", "Content-Type, Authorization"},
+  {"Access-Control-Allow-Credentials", "true"},
+  {"Access-Control-Allow-Private-Network", "true"},
+};
+static const size_t CORS_HEADER_COUNT = sizeof(CORS_HEADERS) / sizeof(CORS_HEADERS[0]);
+
+// Reason phrase untuk status yang bisa dihasilkan command queue
+static const char* commandStatusText(uint16_t status) {
+  switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 409: return "Conflict";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default:  return "Error";
+  }
+}
+
+// Response yang baru dikirim setelah command diterapkan oleh lighting loop.
+// Status dan body belum diketahui saat handler selesai, jadi header belum dikirim;
+// AsyncWebServerRequest memanggil _ack() pada setiap poll/ACK TCP dan response
+// dikirim utuh begitu hasil command tersedia. Semua akses tetap di task AsyncTCP.
+class DeferredCommandResponse : public AsyncWebServerResponse {
+private:
+  CommandQueue* queue;
+  uint32_t seq;
+  const char* message;
+  // Header + body, dirakit sekali saat hasil tersedia. Header ditulis sendiri
+  // (bukan _assembleHead) supaya tidak ada alokasi String per command.
+  char pending[640];
+  size_t pendingLength;
+  bool assembled;
+  
+  // Rakit status line, header, dan body ke pending; false jika buffer tidak cukup
+  bool assemble(uint8_t version, uint16_t status, uint32_t value) {
+    char body[160];
+    size_t bodyLength = formatCommandResult(body, sizeof(body), seq, status, value, message);
+    _code = status;
+    _contentLength = bodyLength;
+    
+    int n = snprintf(pending, sizeof(pending),
+                     "HTTP/1.%u %u %s\r\nContent-Length: %u\r\nContent-Type: application/json\r\n",
+                     version, status, commandStatusText(status), (unsigned)bodyLength);
+    if (n < 0 || (size_t)n >= sizeof(pending)) {
+      return false;
+    }
+    size_t used = n;
+    for (size_t i = 0; i < CORS_HEADER_COUNT; i++) {
+      n = snprintf(pending + used, sizeof(pending) - used, "%s: %s\r\n", CORS_HEADERS[i][0], CORS_HEADERS[i][1]);
+      if (n < 0 || (size_t)n >= sizeof(pending) - used) {
+        return false;
+      }
+      used += n;
+    }
+    n = snprintf(pending + used, sizeof(pending) - used, "Connection: close\r\n\r\n%s", body);
+    if (n < 0 || (size_t)n >= sizeof(pending) - used) {
+      return false;
+    }
+    pendingLength = used + n;
+    return true;
+  }
+  
+  void trySend(AsyncWebServerRequest* request) {
+    if (!assembled) {
+      uint16_t status;
+      uint32_t value;
+      if (!queue->result(seq, status, value)) {
+        return;
+      }
+      if (!assemble(request->version(), status, value)) {
+        // Tidak terjadi dengan ukuran di atas; tutup koneksi daripada kirim potongan
+        _state = RESPONSE_FAILED;
+        request->client()->close();
+        return;
+      }
+      assembled = true;
+    }
+    
+    if (request->client()->space() < pendingLength) {
+      return; // Coba lagi pada ACK/poll berikutnya
+    }
+    _writtenLength += request->client()->write(pending, pendingLength);
+    _state = RESPONSE_WAIT_ACK;
+  }
+  
+public:
+  DeferredCommandResponse(CommandQueue* queue, uint32_t seq, const char* message) {
+    this->queue = queue;
+    this->seq = seq;
+    this->message = message;
+    this->pendingLength = 0;
+    this->assembled = false;
+  }
+  
+  void _respond(AsyncWebServerRequest* request) override {
+    trySend(request);
+  }
+  
+  size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t /*time*/) override {
+    _ackedLength += len;
+    if (_state == RESPONSE_SETUP) {
+      trySend(request);
+    } else if (_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength) {
+      _state = RESPONSE_END;
+    }
+    return 0;
+  }
+  
+  bool _sourceValid() const override {
+    return true;
+  }
+};
+
+WiFiService::WiFiService(LedController* ledController, CommandQueue* commandQueue, const char* ssid, const char* password,
+                         uint16_t httpPort)
+  : link(&wifiDriver, ssid, password), dispatcher(commandQueue) {
   this->ledController = ledController;
+  this->commandQueue = commandQueue;
   this->ssid = ssid;
   this->password = password;
   this->deviceConnected = false;
-  this->server = new AsyncWebServer(80);
-  this->lastConnectAttempt = 0;
-  this->reconnectAttempts = 0;
-  this->apActive = false;
+  this->server = new AsyncWebServer(httpPort);
+  this->events = new AsyncEventSource("/api/events");
+  this->announcedUp = false;
+  this->reportedGiveUp = false;
+  this->health = nullptr;
+  this->healthLog = nullptr;
+  this->timeKeeper = nullptr;
+  this->ble = nullptr;
+  
+  this->eventId = 0;
+  this->lastEventMode = 0xFF; // Paksa event mode pertama
+  this->lastEventFrame = {0, 0, 0, 0, 0, 0, 0};
+  this->frameSequence = 0;
+  this->lastFrameEvent = 0;
+  this->lastEventScheduleVersion = 0;
+  this->lastTimeEvent = 0;
+  for (EventSubscriber& subscriber : subscribers) {
+    subscriber.client = nullptr;
+    subscriber.frameSequence = 0;
+  }
 }
 
 void WiFiService::begin() {
   // Initialize preferences
-  preferences.begin("wifi_config", false);
+  preferences.begin(WIFI_CONFIG_NAMESPACE, false);
   
-  // Start in Access Point mode directly
+  // AP dinyalakan bertahap oleh WiFiLink di update(); begin() tidak menunggu
   Serial.println("Starting Access Point mode...");
+  wifiDriver.begin();
+  link.start(millis());
   
-  // Mulai AP dengan beberapa percobaan
-  bool apStartSuccess = false;
-  for (int attempt = 0; attempt < 3; attempt++) {
-    Serial.print("AP startup attempt ");
-    Serial.print(attempt + 1);
-    Serial.println("/3");
-    
-    // Start AP
-    startAP();
-    
-    // Tunggu AP siap
-    delay(1000);
-    
-    // Verifikasi AP aktif dan berjalan
-    if (apActive && WiFi.getMode() == WIFI_AP) {
-      apStartSuccess = true;
-      break;
-    }
-    
-    // Jika gagal, tunggu sedikit sebelum mencoba lagi
-    Serial.println("AP startup attempt failed, retrying...");
-    delay(2000);
-  }
-  
-  if (!apStartSuccess) {
-    Serial.println("WARNING: Failed to start AP after multiple attempts!");
-    Serial.println("Continuing with setup, will retry AP startup later.");
-  }
+  // Setup SSE sebelum endpoint lain agar /api/events ditangani oleh AsyncEventSource
+  setupEvents();
   
   // Setup endpoint API
   setupApiEndpoints();
@@ -57,352 +189,558 @@ void WiFiService::begin() {
   deviceConnected = false; // Start with no connections
 }
 
-void WiFiService::startAP() {
-  // Shutdown WiFi completely first
-  WiFi.disconnect(true);
-  WiFi.mode(WIFI_OFF);
-  delay(1000); // Tunggu lebih lama (1 detik) untuk memastikan WiFi benar-benar mati
-  
-  // Force restart ESP32 WiFi drivers jika flag gagal sudah tinggi
-  if (reconnectAttempts >= 2) {
-    Serial.println("Performing WiFi driver reset...");
-    esp_wifi_stop();
-    delay(1000);
-    esp_wifi_deinit();
-    delay(1000);
-    esp_wifi_init(NULL);
-    delay(1000);
-    esp_wifi_start();
-    delay(1000);
-    reconnectAttempts = 0; // Reset counter setelah reset driver
-  }
-  
-  // Configure WiFi in AP mode explicitly
-  WiFi.mode(WIFI_OFF); // Pastikan mati dulu
-  delay(500);
-  WiFi.mode(WIFI_AP);
-  delay(500); // Beri waktu untuk mengatur mode
-  
-  // Set low-level parameters
-  WiFi.setTxPower(WIFI_POWER_19_5dBm); // Set TX power ke level maximum
-  
-  // Konfigurasi IP statis untuk AP 
-  IPAddress local_IP(192, 168, 4, 1);
-  IPAddress gateway(192, 168, 4, 1);
-  IPAddress subnet(255, 255, 255, 0);
-  
-  bool configSuccess = WiFi.softAPConfig(local_IP, gateway, subnet);
-  if (!configSuccess) {
-    Serial.println("AP IP configuration failed! Using default.");
-  } else {
-    Serial.println("AP IP configuration success.");
+void WiFiService::setHealth(HealthMonitor* health, HealthLog* healthLog) {
+  this->health = health;
+  this->healthLog = healthLog;
+}
+
+void WiFiService::setTimeKeeper(TimeKeeper* timeKeeper) {
+  this->timeKeeper = timeKeeper;
+}
+
+void WiFiService::setBle(BleService* ble) {
+  this->ble = ble;
+}
+
+void WiFiService::restartHttpServer() {
+  TRACE_SCOPE("wifi", "restartHttpServer");
+  Serial.println("Restarting HTTP server...");
+  // Client SSE memegang antrian pesan masing-masing; ditutup agar memori kembali
+  // (client akan reconnect sendiri). Request biasa selesai dengan sendirinya.
+  events->close();
+  server->end();
+  server->begin();
+  Serial.println("HTTP server started");
+}
+
+void WiFiService::restartAccessPoint() {
+  TRACE_INSTANT("wifi", "restartAccessPoint");
+  Serial.println("Restarting Access Point...");
+  link.requestRestart();
+}
+
+uint32_t WiFiService::getEventBacklog() {
+  return events->count() > 0 ? events->avgPacketsWaiting() : 0;
+}
+
+void WiFiService::restartWiFi() {
+  // Dipanggil dari handler HTTP: dijalankan oleh WiFiLink pada update() berikutnya
+  TRACE_INSTANT("wifi", "restartRequested");
+  Serial.println("Restarting WiFi...");
+  link.requestRestart();
+}
+
+// Tabel route API. Setiap endpoint didaftarkan di sini; parameter path ({hour})
+// diekstrak sekali oleh ApiRouter dan diteruskan ke handler sebagai angka.
+static constexpr ApiRoute API_ROUTES[] = {
+  {"/",                           ROUTE_GET,  API_ROOT},
+  {WEB_APP_JS_PATH,               ROUTE_GET,  API_WEB_APP},
+  {"/api/ping",                   ROUTE_GET,  API_PING},
+  {"/api/manual",                 ROUTE_POST, API_MANUAL},
+  {"/api/manual/all",             ROUTE_POST, API_MANUAL_ALL},
+  {"/api/time",                   ROUTE_GET,  API_TIME_GET},
+  {"/api/time",                   ROUTE_POST, API_TIME_SET},
+  {"/api/time/sync",              ROUTE_POST, API_TIME_SYNC},
+  {"/api/mode",                   ROUTE_GET,  API_MODE_GET},
+  {"/api/mode",                   ROUTE_POST, API_MODE_SET},
+  {"/api/wifi/restart",           ROUTE_GET,  API_WIFI_RESTART},
+  {"/api/schedule/hourly",        ROUTE_GET,  API_SCHEDULE_GET},
+  {"/api/schedule/hourly",        ROUTE_POST, API_SCHEDULE_SET},
+  {"/api/schedule/hourly",        ROUTE_PATCH, API_SCHEDULE_PATCH},
+  {"/api/schedule/hourly/{hour}", ROUTE_GET,  API_HOUR_GET},
+  {"/api/schedule/hourly/{hour}", ROUTE_POST, API_HOUR_SET},
+  {"/api/batch",                  ROUTE_POST, API_BATCH},
+  {"/api/metrics",                ROUTE_GET,  API_METRICS},
+  {"/api/health",                 ROUTE_GET,  API_HEALTH},
+  {"/api/command",                ROUTE_POST, API_COMMAND},
+  {"/api/trace",                  ROUTE_GET,  API_TRACE},
+  {"/api/schedule/preview",       ROUTE_GET,  API_PREVIEW_GET},
+  {"/api/schedule/preview",       ROUTE_POST, API_PREVIEW_SET},
+};
+
+static constexpr size_t API_ROUTE_COUNT = sizeof(API_ROUTES) / sizeof(API_ROUTES[0]);
+static_assert(API_ROUTE_COUNT <= ROUTER_MAX_ROUTES, "Too many API routes for ApiRouter");
+static_assert(API_ROUTE_COUNT <= METRICS_MAX_ROUTES, "Too many API routes for per-route metrics");
+static_assert(routeTableValid(API_ROUTES, API_ROUTE_COUNT), "API route patterns must start with '/'");
+
+// Kelas biaya per route untuk admission control
+static RouteClass routeClassFor(uint8_t id) {
+  switch (id) {
+    case API_MANUAL:
+    case API_MANUAL_ALL:
+    case API_TIME_SET:
+    case API_MODE_SET:
+    case API_HOUR_SET:
+    case API_COMMAND:
+    case API_WIFI_RESTART:
+    case API_PREVIEW_SET:
+      return ROUTE_CLASS_WRITE;
+    case API_SCHEDULE_GET:   // Response ~3 KB
+    case API_SCHEDULE_SET:
+    case API_SCHEDULE_PATCH:
+    case API_BATCH:
+      return ROUTE_CLASS_HEAVY;
+    case API_TIME_SYNC:      // Tidak lewat command queue
+      return ROUTE_CLASS_SYNC;
+    default:
+      return ROUTE_CLASS_LIGHT;
+  }
+}
+
+void WiFiService::setupApiEndpoints() {
+  // CORS handler
+  for (size_t i = 0; i < CORS_HEADER_COUNT; i++) {
+    DefaultHeaders::Instance().addHeader(CORS_HEADERS[i][0], CORS_HEADERS[i][1]);
   }
   
-  // Setup AP dengan parameter yang lebih eksplisit
-  // channel=1, ssid_hidden=0, max_connection=4, beacon_interval=100ms
-  bool result = WiFi.softAP(ssid, password, 1, 0, 4);
+  if (!router.begin(API_ROUTES, API_ROUTE_COUNT)) {
+    Serial.println("ERROR: API route table exceeds router limits!");
+  }
   
-  // Tunggu AP benar-benar siap
-  delay(500);
+  // Semua route API ditangani oleh satu handler berbasis tabel
+  server->addHandler(new ApiRequestHandler(this));
   
-  if (result) {
-    apActive = true;
-    IPAddress myIP = WiFi.softAPIP();
-    Serial.print("Access Point started. IP address: ");
-    Serial.println(myIP);
-    
-    // Verifikasi IP - restart jika bukan yang diharapkan
-    if (myIP != local_IP && configSuccess) {
-      Serial.println("Warning: IP address not as configured, will retry...");
-      WiFi.disconnect(true);
-      delay(500);
-      // Akan dicoba ulang di update berikutnya
-      apActive = false;
-      return;
-    }
-    
-    // Save status to preferences
-    preferences.putBool("ap_active", true);
-  } else {
-    apActive = false;
-    Serial.println("Failed to start Access Point!");
-    
-    // Try to restart WiFi in 5 seconds
-    lastConnectAttempt = millis() - 25000; // Will trigger reconnect in 5 seconds
+  // Path yang tidak ada di tabel (termasuk preflight OPTIONS untuk path tersebut)
+  server->onNotFound([this](AsyncWebServerRequest *request) {
+    this->handleNotFound(request);
+  });
+}
+
+void WiFiService::dispatchRequest(AsyncWebServerRequest* request, ApiRequestContext* context) {
+  const RouteMatch& match = context->match;
+  
+  if (context->admission != ADMISSION_OK) {
+    handleRejected(request, context);
+    return;
+  }
+  
+  // Preflight CORS untuk path yang terdaftar
+  if (request->method() == HTTP_OPTIONS) {
+    handleCors(request);
+    return;
+  }
+  
+  // Path ada tetapi method tidak terdaftar
+  if (match.route == ROUTER_NO_ROUTE) {
+    handleMethodNotAllowed(request, match.allowedMethods);
+    return;
   }
+  
+  if (context->bodyRejected) {
+    request->send(413, "application/json", "{\"status\":\"error\",\"message\":\"Request body too large\"}");
+    return;
+  }
+  
+  uint8_t* body = (uint8_t*)context->body;
+  size_t len = context->bodyLength;
+  uint32_t start = micros();
+  uint32_t heapBefore = ESP.getFreeHeap();
+  TRACE_SCOPE("http", API_ROUTES[match.route].pattern);
+  
+  switch (match.id) {
+    case API_ROOT:
+      // Halaman bisa berubah saat update firmware: selalu divalidasi ulang lewat ETag
+      sendWebAsset(request, "text/html", WEB_INDEX_GZ, WEB_INDEX_GZ_LEN, WEB_INDEX_ETAG, false);
+      break;
+    case API_WEB_APP:
+      // Path mengandung hash isi file, jadi aman di-cache selamanya
+      sendWebAsset(request, "application/javascript", WEB_APP_JS_GZ, WEB_APP_JS_GZ_LEN, WEB_APP_JS_ETAG, true);
+      break;
+    case API_PING:
+      handlePing(request);
+      break;
+    case API_MANUAL:
+      handleManualControl(request, body, len);
+      break;
+    case API_MANUAL_ALL:
+      handleManualControlAll(request, body, len);
+      break;
+    case API_TIME_GET:
+      handleGetCurrentTime(request);
+      break;
+    case API_TIME_SET:
+      handleSetTime(request, body, len);
+      break;
+    case API_TIME_SYNC:
+      handleTimeSync(request, body, len);
+      break;
+    case API_MODE_GET:
+      handleGetMode(request);
+      break;
+    case API_MODE_SET:
+      handleSetMode(request, body, len);
+      break;
+    case API_WIFI_RESTART:
+      restartWiFi();
+      request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"WiFi restarting\"}");
+      break;
+    case API_SCHEDULE_GET:
+      handleGetHourlySchedule(request);
+      break;
+    case API_SCHEDULE_SET:
+      handleSetHourlySchedule(request, body, len);
+      break;
+    case API_SCHEDULE_PATCH:
+      handlePatchHourlySchedule(request, body, len);
+      break;
+    case API_HOUR_GET:
+      handleGetHourProfile(request, match.params[0]);
+      break;
+    case API_HOUR_SET:
+      handleSetHourProfile(request, match.params[0], body, len);
+      break;
+    case API_BATCH:
+      handleBatch(request, body, len);
+      break;
+    case API_METRICS:
+      handleMetrics(request);
+      break;
+    case API_HEALTH:
+      handleHealth(request);
+      break;
+    case API_COMMAND:
+      handleBinaryCommand(request, body, len);
+      break;
+    case API_TRACE:
+      handleTrace(request);
+      break;
+    case API_PREVIEW_GET:
+      handleGetPreview(request);
+      break;
+    case API_PREVIEW_SET:
+      handleSetPreview(request, body, len);
+      break;
+    default:
+      handleNotFound(request);
+      break;
+  }
+  
+  // Waktu handler saja; response yang ditunda (DeferredCommandResponse) selesai belakangan
+  metrics.httpLatency[match.route].observe(micros() - start);
+  
+  // Perkiraan: heap yang masih terpakai saat handler selesai (termasuk response yang
+  // menunggu dikirim); dipengaruhi juga oleh alokasi task lain di waktu yang sama
+  int32_t heapHeld = (int32_t)(heapBefore - ESP.getFreeHeap());
+  metrics.requestHeap.observe(heapHeld > 0 ? heapHeld : 0);
+}
+
+void WiFiService::handleMethodNotAllowed(AsyncWebServerRequest* request, uint8_t allowedMethods) {
+  char allow[48];
+  ApiRouter::formatAllow(allowedMethods | ROUTE_OPTIONS, allow, sizeof(allow));
+  
+  AsyncWebServerResponse *response = request->beginResponse(405, "application/json",
+    "{\"status\":\"error\",\"message\":\"Method not allowed\"}");
+  response->addHeader("Allow", allow);
+  request->send(response);
+}
+
+void WiFiService::handleRejected(AsyncWebServerRequest* request, ApiRequestContext* context) {
+  AsyncWebServerResponse *response;
+  switch (context->admission) {
+    case ADMISSION_RATE_LIMITED:
+      metrics.rateLimited.add();
+      response = request->beginResponse(429, "application/json",
+        "{\"status\":\"error\",\"message\":\"Too many requests\"}");
+      break;
+    case ADMISSION_BUSY:
+      metrics.shedBusy.add();
+      response = request->beginResponse(503, "application/json",
+        "{\"status\":\"error\",\"message\":\"Controller busy, retry\"}");
+      break;
+    default:
+      metrics.shedLowMemory.add();
+      response = request->beginResponse(503, "application/json",
+        "{\"status\":\"error\",\"message\":\"Low memory, retry\"}");
+      break;
+  }
+  
+  char retryAfter[4];
+  snprintf(retryAfter, sizeof(retryAfter), "%u", context->retryAfter);
+  response->addHeader("Retry-After", retryAfter);
+  request->send(response);
+}
+
+// ========== API REQUEST HANDLER ==========
+
+ApiRequestHandler::ApiRequestHandler(WiFiService* service) {
+  this->service = service;
+}
+
+bool ApiRequestHandler::canHandle(AsyncWebServerRequest* request) {
+  RouteMatch match;
+  if (!service->router.match(request->url().c_str(), request->method(), match)) {
+    return false; // Tidak terdaftar - biarkan onNotFound yang menangani
+  }
+  
+  // Simpan hasil match agar parameter path tidak perlu diparse ulang
+  ApiRequestContext* context = (ApiRequestContext*)malloc(sizeof(ApiRequestContext));
+  if (context == nullptr) {
+    return false;
+  }
+  context->match = match;
+  context->bodyLength = 0;
+  context->bodyRejected = false;
+  context->body[0] = '\0';
+  request->_tempObject = context;
+  
+  // Admission diputuskan di sini, sebelum body dibuffer atau dokumen JSON dialokasikan
+  RouteClass routeClass = ROUTE_CLASS_LIGHT;
+  if (match.route != ROUTER_NO_ROUTE && request->method() != HTTP_OPTIONS) {
+    routeClass = routeClassFor(match.id);
+  }
+  uint32_t largestBlock = (routeClass == ROUTE_CLASS_LIGHT) ? 0 : heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  uint32_t retryAfter = 1;
+  context->routeClass = routeClass;
+  context->admission = service->admission.admit((uint32_t)request->client()->remoteIP(), routeClass,
+                                                request->contentLength(), millis(), ESP.getFreeHeap(),
+                                                largestBlock, retryAfter);
+  context->retryAfter = retryAfter > 255 ? 255 : retryAfter;
+  
+  if (context->admission == ADMISSION_OK && routeClass == ROUTE_CLASS_HEAVY) {
+    // Slot request berat dilepas saat koneksi ditutup (body dan response sudah dibebaskan).
+    // Handler route berat tidak boleh mengganti onDisconnect.
+    WiFiService* owner = service;
+    request->onDisconnect([owner]() {
+      owner->admission.release(ROUTE_CLASS_HEAVY);
+    });
+  }
+  
+  // Header lain dibuang oleh server; ini dibutuhkan untuk 304 pada aset web
+  request->addInterestingHeader("If-None-Match");
+  return true;
 }
 
-void WiFiService::checkWiFiStatus() {
-  static unsigned long lastFullCheck = 0;
+void ApiRequestHandler::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+  ApiRequestContext* context = (ApiRequestContext*)request->_tempObject;
+  if (context == nullptr || context->bodyRejected || context->match.route == ROUTER_NO_ROUTE ||
+      context->admission != ADMISSION_OK) {
+    return;
+  }
   
-  // Check if AP is active but no clients connected for a long time
-  if (apActive) {
-    // Verifikasi mode WiFi benar
-    if (WiFi.getMode() != WIFI_AP && WiFi.getMode() != WIFI_AP_STA) {
-      Serial.println("AP mode unexpectedly disabled, restarting AP...");
-      startAP();
+  if (index == 0) {
+    if (total > API_MAX_BODY_SIZE) {
+      context->bodyRejected = true;
       return;
     }
-    
-    // Verifikasi IP address benar
-    IPAddress expectedIP(192, 168, 4, 1);
-    if (WiFi.softAPIP() != expectedIP) {
-      Serial.println("AP IP address unexpected, reconfiguring...");
-      startAP();
+    // Satu alokasi sebesar Content-Length untuk seluruh body
+    ApiRequestContext* grown = (ApiRequestContext*)realloc(context, sizeof(ApiRequestContext) + total);
+    if (grown == nullptr) {
+      context->bodyRejected = true;
       return;
     }
-    
-    // Full periodic check (setiap 5 menit)
-    if (millis() - lastFullCheck > 300000) {
-      lastFullCheck = millis();
-      
-      // Verifikasi SSID aktif - ini bisa jadi mahal, jadi hanya lakukan secara periodik
-      wifi_ap_record_t apInfo;
-      esp_wifi_sta_get_ap_info(&apInfo);
-      if (strlen((char*)apInfo.ssid) == 0) {
-        Serial.println("AP SSID not broadcasting properly, restarting WiFi...");
-        startAP();
-        return;
-      }
-      
-      Serial.println("Full WiFi health check passed");
-    }
-  } else {
-    // Jika AP seharusnya tidak aktif tapi ternyata mode-nya AP, ada masalah
-    if (WiFi.getMode() == WIFI_AP || WiFi.getMode() == WIFI_AP_STA) {
-      Serial.println("WiFi in unexpected AP mode while flag disabled, fixing...");
-      apActive = true;
-    }
+    context = grown;
+    request->_tempObject = context;
   }
-}
-
-void WiFiService::restartWiFi() {
-  Serial.println("Restarting WiFi...");
-  
-  // Shutdown WiFi
-  WiFi.disconnect(true);
-  WiFi.mode(WIFI_OFF);
-  delay(1000);
   
-  // Start AP again
-  startAP();
+  if (index + len > total || index != context->bodyLength) {
+    context->bodyRejected = true;
+    return;
+  }
   
-  // Reset reconnect counter if successful
-  if (apActive) {
-    reconnectAttempts = 0;
-  } else {
-    reconnectAttempts++;
+  memcpy(context->body + index, data, len);
+  context->bodyLength = index + len;
+  context->body[context->bodyLength] = '\0';
+}
+
+void ApiRequestHandler::handleRequest(AsyncWebServerRequest* request) {
+  ApiRequestContext* context = (ApiRequestContext*)request->_tempObject;
+  if (context == nullptr) {
+    request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Request context missing\"}");
+    return;
   }
+  service->dispatchRequest(request, context);
 }
 
-void WiFiService::setupApiEndpoints() {
-  // CORS handler
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, OPTIONS");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Credentials", "true");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Private-Network", "true");
+// ========== SERVER-SENT EVENTS ==========
+
+void WiFiService::setupEvents() {
+  // Batasi jumlah subscriber, masing-masing memegang antrian pesan sendiri
+  // (antrian per client dibatasi oleh AsyncEventSource)
+  events->setFilter([this](AsyncWebServerRequest * /*request*/) {
+    return events->count() < EVENTS_MAX_CLIENTS;
+  });
   
-  // Handle OPTIONS method untuk CORS
-  server->onNotFound([this](AsyncWebServerRequest *request) {
-    String url = request->url();
+  events->onConnect([this](AsyncEventSourceClient *client) {
+    Serial.print("SSE: client subscribed (");
+    Serial.print(events->count());
+    Serial.println(" total)");
     
-    // Manual routing for /api/schedule/hourly/{hour}
-    if (url.startsWith("/api/schedule/hourly/")) {
-      String hourStr = url.substring(22); // Get everything after "/api/schedule/hourly/"
-      int hour = hourStr.toInt();
-      
-      if (hour >= 0 && hour <= 23) {
-        if (request->method() == HTTP_GET) {
-          this->handleGetHourProfile(request);
-          return;
-        } else if (request->method() == HTTP_POST) {
-          // For POST with body, we need to handle it differently
-          Serial.println("Received POST to per-hour endpoint via onNotFound");
-          request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"POST body handler not available in onNotFound. Use delegated handler.\"}");
-          return;
+    // Daftarkan sebelum snapshot dibaca: frame yang berubah sesudahnya tetap dikirim
+    {
+      std::lock_guard<std::mutex> guard(subscriberLock);
+      for (EventSubscriber& subscriber : subscribers) {
+        if (subscriber.client == nullptr) {
+          subscriber.client = client;
+          subscriber.frameSequence = frameSequence;
+          break;
         }
       }
     }
     
-    // Default not found handler
-    this->handleNotFound(request);
-  });
-  
-  // Root endpoint untuk testing
-  server->on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-    request->send(200, "text/html", "<html><body><h1>SLAB Aquarium LED Controller</h1><p>API is running</p></body></html>");
-  });
-  
-  // API ping untuk keep-alive
-  server->on("/api/ping", HTTP_GET, [this](AsyncWebServerRequest *request) {
-    this->handlePing(request);
+    // Kirim snapshot state lengkap ke client baru saja (bukan broadcast)
+    ControllerSnapshot state;
+    ledController->readSnapshot(state);
+    char buffer[160];
+    formatModeEvent(buffer, sizeof(buffer), state.mode);
+    client->send(buffer, "mode", eventId, 3000);
+    formatFrameEvent(buffer, sizeof(buffer), state.output);
+    client->send(buffer, "frame", eventId);
+    formatScheduleEvent(buffer, sizeof(buffer), state.scheduleVersion);
+    client->send(buffer, "schedule", eventId);
+    if (ledController->formatCurrentTimeJson(buffer, sizeof(buffer)) > 0) {
+      client->send(buffer, "time", eventId);
+    }
   });
   
-  // API untuk kontrol manual
-  server->on("/api/manual", HTTP_POST,
-    [](AsyncWebServerRequest *request) {},
-    NULL,
-    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      this->handleManualControl(request, data, len);
-    }
-  );
-  
-  // API untuk kontrol manual semua LED sekaligus
-  server->on("/api/manual/all", HTTP_POST,
-    [](AsyncWebServerRequest *request) {},
-    NULL,
-    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      this->handleManualControlAll(request, data, len);
+  // Dipanggil sebelum client dihapus oleh AsyncEventSource
+  events->onDisconnect([this](AsyncEventSourceClient *client) {
+    std::lock_guard<std::mutex> guard(subscriberLock);
+    for (EventSubscriber& subscriber : subscribers) {
+      if (subscriber.client == client) {
+        subscriber.client = nullptr;
+      }
     }
-  );
-  
-  // API untuk waktu saat ini
-  server->on("/api/time", HTTP_GET, [this](AsyncWebServerRequest *request) {
-    this->handleGetCurrentTime(request);
   });
   
-  server->on("/api/time", HTTP_POST,
-    [](AsyncWebServerRequest *request) {},
-    NULL,
-    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      this->handleSetTime(request, data, len);
-    }
-  );
+  server->addHandler(events);
+}
+
+size_t WiFiService::formatModeEvent(char* buffer, size_t size, uint8_t mode) {
+  static const char* const modeNames[] = {"auto", "manual", "off"};
+  return snprintf(buffer, size, "{\"mode\":\"%s\"}", modeNames[mode]);
+}
+
+size_t WiFiService::formatFrameEvent(char* buffer, size_t size, const LightProfile& frame) {
+  return snprintf(buffer, size,
+    "{\"royalBlue\":%u,\"blue\":%u,\"uv\":%u,\"violet\":%u,\"red\":%u,\"green\":%u,\"white\":%u}",
+    frame.royalBlue, frame.blue, frame.uv, frame.violet, frame.red, frame.green, frame.white);
+}
+
+size_t WiFiService::formatScheduleEvent(char* buffer, size_t size, uint32_t version) {
+  return snprintf(buffer, size, "{\"version\":%lu}", (unsigned long)version);
+}
+
+// Bandingkan state saat ini dengan snapshot terakhir dan push perubahan ke semua subscriber.
+// Setiap event diserialisasi sekali ke satu buffer lalu dibagikan ke semua client.
+// State dibaca dari snapshot LedController (network task, core 0): frame, mode dan
+// versi jadwal berasal dari satu publikasi, jadi perbandingan tidak pernah melihat
+// frame yang baru setengah ditulis oleh lighting task.
+void WiFiService::publishEvents() {
+  ControllerSnapshot state;
+  ledController->readSnapshot(state);
+  
+  if (events->count() == 0) {
+    // Tidak ada subscriber - cukup sinkronkan snapshot agar tidak ada burst saat ada yang connect
+    lastEventMode = state.mode;
+    lastEventFrame = state.output;
+    lastEventScheduleVersion = state.scheduleVersion;
+    return;
+  }
   
-  // API untuk mode operasi
-  server->on("/api/mode", HTTP_GET, [this](AsyncWebServerRequest *request) {
-    this->handleGetMode(request);
-  });
+  char buffer[160];
+  unsigned long now = millis();
   
-  server->on("/api/mode", HTTP_POST,
-    [](AsyncWebServerRequest *request) {},
-    NULL,
-    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      this->handleSetMode(request, data, len);
-    }
-  );
+  // Mode change (tidak pernah di-drop)
+  uint8_t mode = state.mode;
+  if (mode != lastEventMode) {
+    lastEventMode = mode;
+    formatModeEvent(buffer, sizeof(buffer), mode);
+    events->send(buffer, "mode", ++eventId);
+  }
   
-  // API untuk restart WiFi
-  server->on("/api/wifi/restart", HTTP_GET, [this](AsyncWebServerRequest *request) {
-    this->restartWiFi();
-    request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"WiFi restarting\"}");
-  });
+  // Schedule version bump (tidak pernah di-drop)
+  uint32_t version = state.scheduleVersion;
+  if (version != lastEventScheduleVersion) {
+    lastEventScheduleVersion = version;
+    formatScheduleEvent(buffer, sizeof(buffer), version);
+    events->send(buffer, "schedule", ++eventId);
+  }
   
-  // ========== NEW HOURLY SCHEDULE API ENDPOINTS ==========
+  // Output frame: rate-limited dan coalesced per client. Frame lama tidak pernah diantrikan -
+  // client yang antriannya penuh dilewati dan menerima frame terbaru begitu antriannya turun,
+  // tanpa menahan client lain.
+  if (memcmp(&state.output, &lastEventFrame, sizeof(LightProfile)) != 0) {
+    std::lock_guard<std::mutex> guard(subscriberLock);
+    lastEventFrame = state.output;
+    frameSequence++;
+  }
+  bool frameDue = now - lastFrameEvent >= EVENTS_FRAME_INTERVAL_MS;
+  bool timeDue = now - lastTimeEvent >= EVENTS_TIME_TICK_MS;
+  if (!frameDue && !timeDue) {
+    return;
+  }
+  if (frameDue) {
+    lastFrameEvent = now;
+    formatFrameEvent(buffer, sizeof(buffer), lastEventFrame);
+  }
   
-  // IMPORTANT: AsyncWebServer may not properly handle regex patterns with parameters
-  // So we use a single endpoint and do manual URL parsing inside the handler
+  // Time tick, juga berfungsi sebagai keep-alive untuk koneksi SSE
+  char timeJson[TIME_JSON_MAX_SIZE];
+  if (timeDue) {
+    lastTimeEvent = now;
+    timeDue = ledController->formatCurrentTimeJson(timeJson, sizeof(timeJson)) > 0;
+  }
   
-  // Get/Set hourly schedule (handles both /api/schedule/hourly and /api/schedule/hourly/17)
-  server->on("/api/schedule/hourly", HTTP_GET, [this](AsyncWebServerRequest *request) {
-    // Check if URL has hour parameter
-    String url = request->url();
-    if (url.length() > 22 && url.indexOf("/api/schedule/hourly/") >= 0) {
-      this->handleGetHourProfile(request);
-    } else {
-      this->handleGetHourlySchedule(request);
+  uint32_t frameId = 0;
+  uint32_t timeId = timeDue ? ++eventId : 0;
+  std::lock_guard<std::mutex> guard(subscriberLock);
+  for (EventSubscriber& subscriber : subscribers) {
+    if (subscriber.client == nullptr || subscriber.client->packetsWaiting() >= EVENTS_MAX_BACKLOG) {
+      continue;
     }
-  });
-  
-  server->on("/api/schedule/hourly", HTTP_POST,
-    [](AsyncWebServerRequest *request) {},
-    NULL,
-    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      // CRITICAL FIX: Check if this is a per-hour request FIRST
-      String url = request->url();
-      
-      Serial.println("========================================");
-      Serial.print("POST request received to URL: '");
-      Serial.print(url);
-      Serial.println("'");
-      Serial.print("URL length: ");
-      Serial.println(url.length());
-      
-      // Find the position of "/api/schedule/hourly/"
-      int basePos = url.indexOf("/api/schedule/hourly/");
-      
-      if (basePos >= 0) {
-        Serial.println(">>> Found '/api/schedule/hourly/' in URL");
-        
-        // Extract everything after "/api/schedule/hourly/"
-        // The base string "/api/schedule/hourly/" is 21 characters
-        String hourStr = url.substring(basePos + 21);
-        
-        // Remove query parameters if any
-        int queryPos = hourStr.indexOf('?');
-        if (queryPos > 0) {
-          hourStr = hourStr.substring(0, queryPos);
-        }
-        
-        // Remove trailing slash if present
-        if (hourStr.endsWith("/")) {
-          hourStr = hourStr.substring(0, hourStr.length() - 1);
-        }
-        
-        hourStr.trim();
-        
-        Serial.print(">>> Extracted hour string: '");
-        Serial.print(hourStr);
-        Serial.print("' (length: ");
-        Serial.print(hourStr.length());
-        Serial.println(")");
-        
-        // Validate that it's a valid number
-        if (hourStr.length() > 0 && hourStr.length() <= 2) {
-          bool isValidNumber = true;
-          for (unsigned int i = 0; i < hourStr.length(); i++) {
-            if (!isDigit(hourStr.charAt(i))) {
-              isValidNumber = false;
-              Serial.print(">>> Invalid character at position ");
-              Serial.print(i);
-              Serial.print(": '");
-              Serial.print(hourStr.charAt(i));
-              Serial.println("'");
-              break;
-            }
-          }
-          
-          if (isValidNumber) {
-            int hour = hourStr.toInt();
-            
-            Serial.print(">>> Parsed hour value: ");
-            Serial.println(hour);
-            
-            if (hour >= 0 && hour <= 23) {
-              Serial.print(">>> ROUTING to handleSetHourProfile for HOUR ");
-              Serial.println(hour);
-              Serial.println("========================================");
-              this->handleSetHourProfile(request, data, len);
-              return;
-            } else {
-              Serial.print(">>> Hour out of range (0-23): ");
-              Serial.println(hour);
-            }
-          } else {
-            Serial.println(">>> Hour string contains non-digit characters");
-          }
-        } else {
-          Serial.print(">>> Hour string length invalid: ");
-          Serial.println(hourStr.length());
-        }
-      } else {
-        Serial.println(">>> URL does not contain '/api/schedule/hourly/' - treating as full schedule");
+    if (frameDue && subscriber.frameSequence != frameSequence) {
+      if (frameId == 0) {
+        frameId = ++eventId;
       }
-      
-      // Otherwise, handle as full 24-hour schedule update
-      Serial.println(">>> ROUTING to handleSetHourlySchedule for ALL 24 HOURS");
-      Serial.println("========================================");
-      this->handleSetHourlySchedule(request, data, len);
+      subscriber.client->send(buffer, "frame", frameId);
+      subscriber.frameSequence = frameSequence;
     }
-  );
+    if (timeDue) {
+      subscriber.client->send(timeJson, "time", timeId);
+    }
+  }
+}
+
+// ========== COMMAND SUBMISSION ==========
+
+// Kirim command ke lighting loop. Handler tidak pernah menyentuh PWM/NVS secara langsung;
+// response dikirim segera jika command sudah diterapkan dalam COMMAND_RESPONSE_WAIT_MS,
+// jika belum, response diselesaikan secara asynchronous oleh DeferredCommandResponse.
+void WiFiService::submitCommand(AsyncWebServerRequest* request, ControlCommand& command, const char* message) {
+  uint32_t seq = commandQueue->push(command);
+  if (seq == 0) {
+    sendQueueFull(request);
+    return;
+  }
+  respondWhenApplied(request, seq, message);
+}
+
+void WiFiService::sendQueueFull(AsyncWebServerRequest* request) {
+  Serial.println("Command queue full, rejecting request");
+  AsyncWebServerResponse *response = request->beginResponse(503, "application/json",
+    "{\"status\":\"error\",\"message\":\"Controller busy, retry\"}");
+  response->addHeader("Retry-After", "1");
+  request->send(response);
+}
+
+void WiFiService::respondWhenApplied(AsyncWebServerRequest* request, uint32_t seq, const char* message) {
+  uint16_t status;
+  uint32_t value;
+  if (commandQueue->waitForResult(seq, COMMAND_RESPONSE_WAIT_MS, status, value)) {
+    char body[160];
+    formatCommandResult(body, sizeof(body), seq, status, value, message);
+    request->send(status, "application/json", body);
+    return;
+  }
+  
+  request->send(new DeferredCommandResponse(commandQueue, seq, message));
 }
 
 void WiFiService::handleCors(AsyncWebServerRequest* request) {
   if (request->method() == HTTP_OPTIONS) {
     AsyncWebServerResponse *response = request->beginResponse(204);
     response->addHeader("Access-Control-Allow-Origin", "*");
-    response->addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, OPTIONS");
+    response->addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, PATCH, OPTIONS");
     response->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
     response->addHeader("Access-Control-Allow-Credentials", "true");
     response->addHeader("Access-Control-Allow-Private-Network", "true");
@@ -411,212 +749,129 @@ void WiFiService::handleCors(AsyncWebServerRequest* request) {
   }
 }
 
+// Kirim aset web yang sudah di-gzip saat build. AsyncProgmemResponse membaca langsung
+// dari flash per potongan sebesar ruang buffer TCP, tanpa menyalin aset ke heap.
+void WiFiService::sendWebAsset(AsyncWebServerRequest* request, const char* contentType,
+                               const uint8_t* data, size_t length, const char* etag, bool immutable) {
+  const char* cacheControl = immutable ? "public, max-age=31536000, immutable" : "no-cache";
+  
+  const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+  if (ifNoneMatch != nullptr && ifNoneMatch->value().equals(etag)) {
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+    return;
+  }
+  
+  AsyncWebServerResponse *response = request->beginResponse_P(200, contentType, data, length);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+}
+
 void WiFiService::handleNotFound(AsyncWebServerRequest* request) {
   if (request->method() == HTTP_OPTIONS) {
     handleCors(request);
   } else {
-    Serial.print("Request not found: ");
-    Serial.println(request->url());
-    
-    // Untuk debugging, tampilkan informasi request
-    int headers = request->headers();
-    for (int i = 0; i < headers; i++) {
-      const AsyncWebHeader* h = request->getHeader(i);
-      Serial.printf("  %s: %s\n", h->name().c_str(), h->value().c_str());
-    }
-    
+    // Tanpa log: client mana pun bisa memicu ini, cukup dihitung
+    metrics.notFound.add();
     request->send(404, "text/plain", "Not found");
   }
 }
 
 void WiFiService::handleManualControl(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-  String jsonString = String((char*)data);
-  
-  Serial.print("Received manual control request: ");
-  Serial.println(jsonString);
-  
-  // Parse JSON
-  StaticJsonDocument<256> doc;
-  DeserializationError error = deserializeJson(doc, jsonString);
+  Serial.print("Received manual control request, payload size: ");
+  Serial.print(len);
+  Serial.println(" bytes");
   
-  // Check for parsing errors
-  if (error) {
-    Serial.print("JSON parsing failed: ");
-    Serial.println(error.c_str());
-    request->send(400, "text/plain", String("JSON parsing failed: ") + error.c_str());
+  ControlCommand command;
+  ApiError error;
+  if (!parseManualRequest(data, len, command, error)) {
+    sendApiError(request, error);
     return;
   }
-  
-  // Extract values with validation
-  String led = "";
-  int value = 0;
-  
-  // Get LED name
-  if (doc.containsKey("led")) {
-    led = doc["led"].as<String>();
+  submitCommand(request, command, nullptr);
+}
+
+void WiFiService::handleGetCurrentTime(AsyncWebServerRequest* request) {
+  // Dengan TimeKeeper: juga sumber waktu, status RTC dan estimasi error
+  if (timeKeeper != nullptr) {
+    timeKeeper->formatTimeJson(responseBuffer, sizeof(responseBuffer));
   } else {
-    Serial.println("Error: Missing 'led' property");
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Missing 'led' property\"}");
-    return;
+    ledController->formatCurrentTimeJson(responseBuffer, sizeof(responseBuffer));
   }
-  
-  // Get value
-  if (doc.containsKey("value")) {
-    value = doc["value"].as<int>();
-    
-    // Check for valid value range
-    if (value < 0 || value > 255) {
-      Serial.println("Error: Value out of range (0-255)");
-      request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Value out of range (0-255)\"}");
-      return;
-    }
-  } else {
-    Serial.println("Error: Missing 'value' property");
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Missing 'value' property\"}");
+  request->send(200, "application/json", responseBuffer);
+}
+
+// Tidak lewat command queue: t2/t3 harus diambil di sini, antrian akan masuk ke delay.
+// TimeKeeper punya lock sendiri; koreksi terbaca oleh tick lighting berikutnya.
+void WiFiService::handleTimeSync(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+  if (timeKeeper == nullptr) {
+    request->send(501, "application/json", "{\"status\":\"error\",\"message\":\"Time sync not available\"}");
     return;
   }
+  int64_t received = timeKeeper->syncTimestamp();
   
-  // Pastikan dalam mode manual
-  if (!ledController->isInManualMode()) {
-    ledController->enableManualMode(true);
-  }
-  
-  // Mengatur intensitas LED
-  if (led == "royalBlue") {
-    ledController->setRoyalBlue(value);
-  } else if (led == "blue") {
-    ledController->setBlue(value);
-  } else if (led == "uv") {
-    ledController->setUV(value);
-  } else if (led == "violet") {
-    ledController->setViolet(value);
-  } else if (led == "red") {
-    ledController->setRed(value);
-  } else if (led == "green") {
-    ledController->setGreen(value);
-  } else if (led == "white") {
-    ledController->setWhite(value);
-  } else {
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid LED type\"}");
+  TimeSyncRequest sync;
+  ApiError error;
+  if (!parseTimeSyncRequest(data, len, sync, error)) {
+    sendApiError(request, error);
     return;
   }
-  
-  request->send(200, "application/json", "{\"status\":\"success\"}");
-}
-
-void WiFiService::handleGetCurrentTime(AsyncWebServerRequest* request) {
-  String jsonResponse = ledController->getCurrentTimeJson();
-  request->send(200, "application/json", jsonResponse);
+  timeKeeper->sync(sync, received, responseBuffer, sizeof(responseBuffer));
+  request->send(200, "application/json", responseBuffer);
 }
 
 void WiFiService::handleSetTime(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-  String jsonString = String((char*)data);
-  Serial.print("Received time JSON: ");
-  Serial.println(jsonString);
-  
-  // Langsung kirim JSON string dari aplikasi ke LedController
-  if (ledController->setCurrentTime(jsonString)) {
-    Serial.println("Current time updated successfully");
-    request->send(200, "application/json", "{\"status\":\"success\"}");
-  } else {
-    Serial.println("Failed to update time, invalid format");
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid time format\"}");
+  Serial.print("Received time JSON, payload size: ");
+  Serial.print(len);
+  Serial.println(" bytes");
+  
+  ControlCommand command;
+  ApiError error;
+  if (!parseTimeRequest(data, len, command, error)) {
+    sendApiError(request, error);
+    return;
   }
+  submitCommand(request, command, nullptr);
 }
 
 void WiFiService::handleSetMode(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-  String jsonString = String((char*)data);
-  
-  Serial.println("========================================");
-  Serial.print("RECEIVED MODE CHANGE REQUEST: ");
-  Serial.println(jsonString);
-  Serial.println("========================================");
-  
-  // Parse JSON
-  StaticJsonDocument<100> doc;
-  DeserializationError error = deserializeJson(doc, jsonString);
-  
-  // Check for parsing errors
-  if (error) {
-    Serial.print("ERROR: JSON parsing failed: ");
-    Serial.println(error.c_str());
-    request->send(400, "text/plain", String("JSON parsing failed: ") + error.c_str());
-    return;
-  }
-  
-  String mode = "";
+  Serial.print("Received mode change request, payload size: ");
+  Serial.print(len);
+  Serial.println(" bytes");
   
-  // Extract mode value
-  if (doc.containsKey("mode")) {
-    mode = doc["mode"].as<String>();
-    Serial.print("Extracted mode value: ");
-    Serial.println(mode);
-  } else {
-    Serial.println("ERROR: Missing 'mode' key in JSON");
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Missing mode key\"}");
+  ControlCommand command;
+  ApiError error;
+  if (!parseModeRequest(data, len, command, error)) {
+    sendApiError(request, error);
     return;
   }
-  
-  if (mode == "manual") {
-    Serial.println(">>> Processing MANUAL mode request...");
-    ledController->setOffMode(false); // Disable off mode
-    ledController->enableManualMode(true);
-    Serial.println(">>> MANUAL mode activated");
-    request->send(200, "application/json", "{\"status\":\"success\"}");
-  } else if (mode == "auto") {
-    Serial.println(">>> Processing AUTO mode request...");
-    ledController->setOffMode(false); // Disable off mode first
-    Serial.println(">>> Off mode disabled");
-    ledController->enableManualMode(false); // This now triggers immediate LED update
-    Serial.println(">>> AUTO mode activated - LEDs should now follow schedule");
-    request->send(200, "application/json", "{\"status\":\"success\"}");
-  } else if (mode == "off") {
-    Serial.println(">>> Processing OFF mode request...");
-    // Turn off all LEDs and set off mode
-    ledController->setOffMode(true);
-    Serial.println(">>> OFF mode activated - all LEDs turned off");
-    request->send(200, "application/json", "{\"status\":\"success\"}");
-  } else {
-    Serial.print("ERROR: Invalid mode received: ");
-    Serial.println(mode);
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid mode. Valid modes: manual, auto, off\"}");
-  }
-  
-  Serial.println("========================================");
+  submitCommand(request, command, nullptr);
 }
 
 void WiFiService::handleGetMode(AsyncWebServerRequest* request) {
-  String mode;
-  if (ledController->isInOffMode()) {
-    mode = "off";
-  } else if (ledController->isInManualMode()) {
-    mode = "manual";
+  ControllerSnapshot state;
+  ledController->readSnapshot(state);
+  const char* response;
+  if (state.mode == MODE_OFF) {
+    response = "{\"mode\":\"off\"}";
+  } else if (state.mode == MODE_MANUAL) {
+    response = "{\"mode\":\"manual\"}";
   } else {
-    mode = "auto";
+    response = "{\"mode\":\"auto\"}";
   }
-  String jsonResponse = "{\"mode\":\"" + mode + "\"}";
-  request->send(200, "application/json", jsonResponse);
+  request->send(200, "application/json", response);
 }
 
 bool WiFiService::isConnected() {
-  // Dalam mode AP, kita cek kondisi AP lebih komprehensif
-  if (WiFi.getMode() == WIFI_AP || WiFi.getMode() == WIFI_AP_STA) {
-    // Jika flag internal sudah menunjukkan AP tidak aktif, kembalikan false
-    if (!apActive) return false;
-    
-    // Check if AP is running on expected IP
-    IPAddress expectedIP(192, 168, 4, 1);
-    IPAddress currentIP = WiFi.softAPIP();
-    
-    // Check for valid IP (not 0.0.0.0)
-    bool validIP = (currentIP[0] != 0 || currentIP[1] != 0 || 
-                   currentIP[2] != 0 || currentIP[3] != 0);
-                   
-    return validIP;
-  }
-  
-  // Dalam mode STA, periksa status koneksi
-  return WiFi.status() == WL_CONNECTED;
+  return link.isUp();
+}
+
+bool WiFiService::hasGivenUp() {
+  return link.hasGivenUp();
 }
 
 IPAddress WiFiService::getIP() {
@@ -628,51 +883,54 @@ IPAddress WiFiService::getIP() {
 }
 
 void WiFiService::update() {
-  static unsigned long lastWiFiCheck = 0;
   static unsigned long lastAPCheck = 0;
-  static unsigned long lastAutoRestart = 0;
-  static int failCount = 0;
   static unsigned long lastClientDisconnect = 0;
   static unsigned long startupTime = millis(); // Catat waktu startup
   
-  // Quick WiFi health check - lebih sering pada 5 menit pertama
-  unsigned long checkInterval = (millis() - startupTime < 300000) ? 5000 : 10000;
-  if (millis() - lastWiFiCheck > checkInterval) {
-    lastWiFiCheck = millis();
-    
-    // Check if WiFi mode is correct
-    if (!apActive && (WiFi.getMode() == WIFI_AP || WiFi.getMode() == WIFI_AP_STA)) {
-      apActive = true;
-      Serial.println("WiFi AP is now active");
-    } else if (apActive && WiFi.getMode() != WIFI_AP && WiFi.getMode() != WIFI_AP_STA) {
-      apActive = false;
-      Serial.println("WiFi AP is no longer active, will attempt to restart");
-      lastConnectAttempt = millis() - 25000; // Will trigger reconnect soon
-      failCount++;
-    }
+  // Langkah berikutnya dari bring-up / recovery AP (tidak pernah blocking)
+  link.update(millis());
+  
+  if (link.isUp() && !announcedUp) {
+    announcedUp = true;
+    metrics.markBootPhase(BOOT_PHASE_AP_UP, micros());
+    IPAddress ip = WiFi.softAPIP();
+    Serial.print("Access Point started. IP address: ");
+    Serial.println(ip);
+    Serial.print("Connect to WiFi network named '");
+    Serial.print(ssid);
+    Serial.print("' with password '");
+    Serial.print(password);
+    Serial.println("'");
+    Serial.print("Then access the control panel at http://");
+    Serial.print(ip);
+    Serial.println("/");
     
-    // Lebih agresif memulai AP pada 2 menit pertama jika belum active
-    if (!apActive && (millis() - startupTime < 120000)) {
-      Serial.println("WiFi not active during early startup, restarting AP...");
-      startAP();
+    // Save status to preferences (hanya jika berubah, hemat tulis NVS)
+    if (!preferences.getBool("ap_active", false)) {
+      preferences.putBool("ap_active", true);
+      nvsWear.recordWrite(WIFI_CONFIG_NAMESPACE, "ap_active", NVS_VALUE_PRIMITIVE, 1);
     }
+  } else if (!link.isUp()) {
+    announcedUp = false;
+  }
+  
+  if (link.hasGivenUp() && !reportedGiveUp) {
+    reportedGiveUp = true;
+    Serial.println("WARNING: WiFi initialization failed after multiple attempts!");
+    Serial.println("LED controller will still function; AP startup keeps retrying in the background.");
   }
   
-  // More detailed AP status check every 60 seconds (lebih pelan dari 30 detik)
-  // Tetapi lebih sering pada 3 menit pertama
+  // AP status check every 60 seconds, lebih sering pada 3 menit pertama
   unsigned long statusCheckInterval = (millis() - startupTime < 180000) ? 30000 : 60000;
   if (millis() - lastAPCheck > statusCheckInterval) {
     lastAPCheck = millis();
-    
-    // Check WiFi status thoroughly
-    checkWiFiStatus();
+    uint8_t stations = wifiDriver.stationCount();
     
     // Check if any clients are connected to the AP
-    if (WiFi.softAPgetStationNum() > 0) {
+    if (stations > 0) {
       if (!deviceConnected) {
         Serial.println("Client connected to AP");
         deviceConnected = true;
-        failCount = 0; // Reset fail counter when we have a connection
       }
       // Jika ada client terhubung, reset timer disconnect
       lastClientDisconnect = 0;
@@ -687,7 +945,7 @@ void WiFiService::update() {
         // Hanya ubah status setelah 3 menit tidak ada koneksi (mencegah reconnect yang berlebihan)
         else if (millis() - lastClientDisconnect > 180000) {
           Serial.println("No clients connected to AP for 3 minutes");
-        deviceConnected = false;
+          deviceConnected = false;
           lastClientDisconnect = 0;
         }
       }
@@ -695,348 +953,579 @@ void WiFiService::update() {
     
     // Print status info
     Serial.print("AP status: ");
-    Serial.print(apActive ? "Active" : "Inactive");
-    if (apActive) {
+    Serial.print(link.isUp() ? "Active" : "Inactive");
+    if (link.isUp()) {
       Serial.print(", IP: ");
-      Serial.print(WiFi.softAPIP().toString());
+      Serial.print(WiFi.softAPIP());
       Serial.print(", ");
-    Serial.print(WiFi.softAPgetStationNum());
+      Serial.print(stations);
       Serial.print(" client(s) connected");
       if (lastClientDisconnect > 0) {
         Serial.print(", Reconnection grace: ");
         Serial.print((millis() - lastClientDisconnect) / 1000);
         Serial.print("s/180s");
       }
+    } else {
+      Serial.print(", ");
+      Serial.print(link.getFailures());
+      Serial.print(" consecutive failure(s)");
     }
     Serial.println();
-    
-    // If we've had several failed attempts, try a full WiFi restart
-    // Hanya restart WiFi setelah 5 kegagalan berturut-turut
-    if (reconnectAttempts >= 3 || failCount >= 5) {
-      Serial.println("Multiple connection failures, performing full WiFi restart...");
-      failCount = 0;
-      reconnectAttempts = 0;
-      restartWiFi();
-    }
   }
   
-  // Auto-restart ESP32 once per day for maximum stability
-  // (86400000 ms = 24 hours)
-  if (millis() - lastAutoRestart > 86400000) {
-    lastAutoRestart = millis();
-    Serial.println("Performing daily auto-restart for stability...");
-    
-    // Give time for serial message to be transmitted
-    delay(1000);
-    
-    // Restart ESP32
-    ESP.restart();
-  }
-  
-  // Check if we need to attempt reconnection
-  // Lebih agresif pada startup
-  unsigned long reconnectInterval = (millis() - startupTime < 300000) ? 10000 : 30000;
-  if (!apActive && (millis() - lastConnectAttempt > reconnectInterval)) {
-    lastConnectAttempt = millis();
-    Serial.println("Attempting to restart AP...");
-    startAP();
-  }
+  // Push perubahan state ke subscriber SSE
+  publishEvents();
 }
 
 void WiFiService::handlePing(AsyncWebServerRequest* request) {
   // Buat JSON response yang berisi status server dan informasi
-  StaticJsonDocument<256> doc;
+  StaticJsonDocument<512> doc;
   doc["status"] = "active";
-  doc["clients"] = WiFi.softAPgetStationNum();
-  doc["ip"] = WiFi.softAPIP().toString();
+  doc["clients"] = wifiDriver.stationCount();
+  IPAddress ip = WiFi.softAPIP();
+  char ipText[16];
+  snprintf(ipText, sizeof(ipText), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  doc["ip"] = ipText;
   doc["uptime"] = millis() / 1000; // dalam detik
   doc["ssid"] = ssid;
   
   // Melaporkan memori
   doc["free_heap"] = ESP.getFreeHeap();
+  
+  // Statistik antrian command ke lighting loop
+  CommandQueueStats queueStats = commandQueue->stats();
+  JsonObject queue = doc.createNestedObject("command_queue");
+  queue["depth"] = queueStats.depth;
+  queue["max_depth"] = queueStats.maxDepth;
+  queue["applied"] = queueStats.applied;
+  queue["rejected"] = queueStats.rejected;
+  queue["latency_us"] = queueStats.lastLatencyUs;
+  queue["avg_latency_us"] = queueStats.avgLatencyUs;
+  queue["max_latency_us"] = queueStats.maxLatencyUs;
 
-  String jsonResponse;
-  serializeJson(doc, jsonResponse);
+  serializeJson(doc, responseBuffer, sizeof(responseBuffer));
   
   // Catat ping juga di serial untuk debugging
   Serial.println("Ping received from client");
   
   // Kirim respons
-  request->send(200, "application/json", jsonResponse);
+  request->send(200, "application/json", responseBuffer);
 }
 
-// Implementasi fungsi untuk mengontrol semua LED sekaligus
-void WiFiService::handleManualControlAll(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-  String jsonString = String((char*)data);
-  
-  Serial.print("Received manual control ALL request: ");
-  Serial.println(jsonString);
-  
-  // Validasi JSON sebelum memproses
-  StaticJsonDocument<512> doc;
-  DeserializationError error = deserializeJson(doc, jsonString);
-  
-  // Check for parsing errors
-  if (error) {
-    Serial.print("JSON parsing failed: ");
-    Serial.println(error.c_str());
-    String errorMsg = "{\"status\":\"error\",\"message\":\"JSON parsing failed: ";
-    errorMsg += error.c_str();
-    errorMsg += "\"}";
-    request->send(400, "application/json", errorMsg);
+// Ekspor metrics dalam format teks Prometheus. Dirender ke buffer statis dan dikirim
+// langsung dari buffer tersebut; selama response masih terkirim, scrape lain ditolak.
+static char metricsBuffer[METRICS_BUFFER_SIZE];
+static bool metricsBufferBusy = false;
+
+// Satu metric per key NVS, label namespace dan key
+static void writeNvsKeyMetric(MetricsWriter& writer, const char* name, const char* type, const char* help,
+                              const NvsKeyUsage* keys, uint8_t count, uint32_t NvsKeyUsage::*field) {
+  writer.header(name, type, help);
+  for (uint8_t i = 0; i < count; i++) {
+    char labels[64];
+    snprintf(labels, sizeof(labels), "namespace=\"%.15s\",key=\"%.15s\"", keys[i].space, keys[i].key);
+    writer.value(name, labels, keys[i].*field);
+  }
+}
+
+void WiFiService::handleMetrics(AsyncWebServerRequest* request) {
+  if (metricsBufferBusy) {
+    AsyncWebServerResponse *response = request->beginResponse(503, "text/plain", "Scrape in progress\n");
+    response->addHeader("Retry-After", "1");
+    request->send(response);
     return;
   }
   
-  // Periksa apakah semua properti diperlukan ada
-  bool isValid = true;
-  String errorMessage = "Missing properties: ";
+  MetricsWriter writer(metricsBuffer, sizeof(metricsBuffer));
+  
+  writer.header("slab_http_request_duration_seconds", "histogram", "HTTP handler time per route");
+  for (uint8_t i = 0; i < API_ROUTE_COUNT; i++) {
+    const Histogram& histogram = metrics.httpLatency[i];
+    if (histogram.count() == 0) continue; // Route yang belum pernah dipanggil tidak ditulis
+    char method[16];
+    ApiRouter::formatAllow(API_ROUTES[i].method, method, sizeof(method));
+    char labels[80];
+    snprintf(labels, sizeof(labels), "route=\"%s %s\"", method, API_ROUTES[i].pattern);
+    writer.histogram("slab_http_request_duration_seconds", labels, histogram);
+  }
   
-  if (!doc.containsKey("royalBlue")) {
-    errorMessage += "royalBlue, ";
-    isValid = false;
+  writer.header("slab_json_parse_duration_seconds", "histogram", "deserializeJson time in request handlers");
+  writer.histogram("slab_json_parse_duration_seconds", nullptr, metrics.jsonParse);
+  
+  writer.header("slab_lighting_tick_duration_seconds", "histogram", "LedController::update() duration");
+  writer.histogram("slab_lighting_tick_duration_seconds", nullptr, metrics.tickDuration);
+  
+  writer.header("slab_lighting_tick_jitter_seconds", "histogram", "Deviation of the lighting tick interval from nominal");
+  writer.histogram("slab_lighting_tick_jitter_seconds", nullptr, metrics.tickJitter);
+  
+  writer.header("slab_lighting_tick_heap_bytes", "histogram", "Free heap lost across one lighting tick (approximate)");
+  writer.histogram("slab_lighting_tick_heap_bytes", nullptr, metrics.tickHeap);
+  
+  writer.header("slab_http_request_heap_bytes", "histogram", "Heap still held when an API handler returns (approximate)");
+  writer.histogram("slab_http_request_heap_bytes", nullptr, metrics.requestHeap);
+  
+  // Pemakaian NVS per key (lihat NvsWear.h); proyeksi umur dari rata-rata sejak boot
+  static NvsKeyUsage nvsKeys[NVS_WEAR_MAX_KEYS];  // Tidak di stack AsyncTCP
+  uint8_t nvsKeyCount = nvsWear.snapshot(nvsKeys, NVS_WEAR_MAX_KEYS);
+  uint32_t nvsCalls = 0;
+  uint32_t nvsBytes = 0;
+  uint32_t nvsEntries = 0;
+  uint32_t nvsOverBudget = 0;
+  for (uint8_t i = 0; i < nvsKeyCount; i++) {
+    nvsCalls += nvsKeys[i].writes + nvsKeys[i].removes;
+    nvsBytes += nvsKeys[i].bytes;
+    nvsEntries += nvsKeys[i].entries;
+    if (nvsKeys[i].lastHourWrites > NVS_KEY_HOURLY_BUDGET || nvsKeys[i].hourWrites > NVS_KEY_HOURLY_BUDGET) {
+      nvsOverBudget++;
+    }
   }
-  if (!doc.containsKey("blue")) {
-    errorMessage += "blue, ";
-    isValid = false;
+  writer.header("slab_nvs_writes_total", "counter", "Preferences write and remove calls");
+  writer.value("slab_nvs_writes_total", nullptr, nvsCalls);
+  writer.header("slab_nvs_bytes_written_total", "counter", "Payload bytes written to NVS");
+  writer.value("slab_nvs_bytes_written_total", nullptr, nvsBytes);
+  writer.header("slab_nvs_entries_written_total", "counter", "32-byte NVS entries written");
+  writer.value("slab_nvs_entries_written_total", nullptr, nvsEntries);
+  writer.header("slab_nvs_page_erases_estimated_total", "counter", "Flash page erases implied by the entries written");
+  writer.value("slab_nvs_page_erases_estimated_total", nullptr, nvsEstimatedErases(nvsEntries));
+  uint32_t uptimeSeconds = millis() / 1000;
+  if (uptimeSeconds >= 3600) {
+    writer.header("slab_nvs_projected_lifetime_days", "gauge", "Days until the NVS partition reaches its rated erase cycles at the rate since boot");
+    writer.value("slab_nvs_projected_lifetime_days", nullptr, nvsProjectedLifetimeDays(nvsEntries * 3600.0f / uptimeSeconds));
   }
-  if (!doc.containsKey("uv")) {
-    errorMessage += "uv, ";
-    isValid = false;
+  writer.header("slab_nvs_key_writes_budget_per_hour", "gauge", "Writes per key per hour before the key counts as over budget");
+  writer.value("slab_nvs_key_writes_budget_per_hour", nullptr, NVS_KEY_HOURLY_BUDGET);
+  writer.header("slab_nvs_keys_over_budget", "gauge", "Keys written more than the budget in the current or last hour");
+  writer.value("slab_nvs_keys_over_budget", nullptr, nvsOverBudget);
+  if (nvsKeyCount > 0) {
+    writeNvsKeyMetric(writer, "slab_nvs_key_writes_total", "counter", "NVS writes per key",
+                      nvsKeys, nvsKeyCount, &NvsKeyUsage::writes);
+    writeNvsKeyMetric(writer, "slab_nvs_key_bytes_total", "counter", "Payload bytes written per key",
+                      nvsKeys, nvsKeyCount, &NvsKeyUsage::bytes);
+    writeNvsKeyMetric(writer, "slab_nvs_key_writes_last_hour", "gauge", "Writes per key in the last complete hour",
+                      nvsKeys, nvsKeyCount, &NvsKeyUsage::lastHourWrites);
+    writeNvsKeyMetric(writer, "slab_nvs_key_writes_peak_hour", "gauge", "Most writes per key in any complete hour since boot",
+                      nvsKeys, nvsKeyCount, &NvsKeyUsage::peakHourWrites);
+    writer.header("slab_nvs_key_value_bytes", "gauge", "Size of the last value written per key");
+    for (uint8_t i = 0; i < nvsKeyCount; i++) {
+      char labels[80];
+      snprintf(labels, sizeof(labels), "namespace=\"%.15s\",key=\"%.15s\",type=\"%s\"",
+               nvsKeys[i].space, nvsKeys[i].key, NVS_VALUE_KIND_NAMES[nvsKeys[i].kind]);
+      writer.value("slab_nvs_key_value_bytes", labels, nvsKeys[i].valueBytes);
+    }
   }
-  if (!doc.containsKey("violet")) {
-    errorMessage += "violet, ";
-    isValid = false;
+  
+  // Config record A/B: slot rusak hanya dihitung saat boot (load)
+  ConfigStore& config = ledController->getConfigStore();
+  writer.header("slab_config_sequence", "gauge", "Sequence number of the newest config record");
+  writer.value("slab_config_sequence", nullptr, config.getSequence());
+  writer.header("slab_config_invalid_slots", "gauge", "Config slots that failed the CRC or format check at boot");
+  writer.value("slab_config_invalid_slots", nullptr, config.getInvalidSlots());
+  writer.header("slab_config_write_failures_total", "counter", "Config record writes that failed");
+  writer.value("slab_config_write_failures_total", nullptr, config.getWriteFailures());
+  
+  if (timeKeeper != nullptr) {
+    TimeStatus time;
+    timeKeeper->status(time);
+    writer.header("slab_time_rtc_healthy", "gauge", "1 if the schedule clock is read from the DS3231");
+    writer.value("slab_time_rtc_healthy", nullptr, time.source == TIME_SOURCE_RTC ? 1 : 0);
+    writer.header("slab_time_rtc_state", "gauge", "DS3231 state (label), 1 for the current one");
+    for (uint8_t i = 0; i < 4; i++) {
+      char labels[32];
+      snprintf(labels, sizeof(labels), "state=\"%s\"", RTC_STATE_NAMES[i]);
+      writer.value("slab_time_rtc_state", labels, time.rtc == i ? 1 : 0);
+    }
+    // Tanpa referensi sejak padam tidak ada estimasi: metric dihilangkan
+    if (time.errorMs != TIME_ERROR_UNKNOWN) {
+      writer.header("slab_time_error_estimate_seconds", "gauge", "Estimated bound on the clock error");
+      writer.append("slab_time_error_estimate_seconds %.3f\n", time.errorMs / 1000.0);
+    }
+    writer.header("slab_time_timer_drift_ppm", "gauge", "Learned rate error of the uptime timer");
+    writer.append("slab_time_timer_drift_ppm %.3f\n", time.driftPpb / 1000.0);
+    if (time.syncAccuracyMs != TIME_ERROR_UNKNOWN) {
+      writer.header("slab_time_sync_accuracy_seconds", "gauge", "Half the round-trip delay of the last /api/time/sync correction");
+      writer.append("slab_time_sync_accuracy_seconds %.3f\n", time.syncAccuracyMs / 1000.0);
+      writer.header("slab_time_sync_offset_seconds", "gauge", "Offset corrected by the last sync (device minus client)");
+      writer.append("slab_time_sync_offset_seconds %.3f\n", time.syncOffsetMs / 1000.0);
+    }
+    writer.header("slab_time_sync_corrections_total", "counter", "Clock corrections from /api/time/sync");
+    writer.value("slab_time_sync_corrections_total", nullptr, time.syncCorrections);
+    writer.header("slab_time_slew_remaining_seconds", "gauge", "Part of the last correction not yet slewed in");
+    writer.append("slab_time_slew_remaining_seconds %.3f\n", time.slewMs / 1000.0);
+    writer.header("slab_time_rtc_drift_ppm", "gauge", "Fitted natural rate of the DS3231 crystal, positive: fast");
+    writer.append("slab_time_rtc_drift_ppm %.3f\n", time.rtcDriftPpb / 1000.0);
+    writer.header("slab_time_rtc_drift_samples", "gauge", "RTC rate measurements in the fit");
+    writer.value("slab_time_rtc_drift_samples", nullptr, time.rtcDriftSamples);
+    writer.header("slab_time_rtc_aging_offset", "gauge", "DS3231 aging offset register (+1: about 0.1 ppm slower)");
+    writer.append("slab_time_rtc_aging_offset %d\n", time.agingOffset);
+    writer.header("slab_time_rtc_correction_ppm", "gauge", "RTC rate left after the aging offset, corrected in software");
+    writer.append("slab_time_rtc_correction_ppm %.3f\n", time.rtcCorrectionPpb / 1000.0);
   }
-  if (!doc.containsKey("red")) {
-    errorMessage += "red, ";
-    isValid = false;
+  
+  // Gauge dibaca saat scrape saja
+  writer.header("slab_heap_free_bytes", "gauge", "Free heap");
+  writer.value("slab_heap_free_bytes", nullptr, ESP.getFreeHeap());
+  writer.header("slab_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+  writer.value("slab_heap_min_free_bytes", nullptr, ESP.getMinFreeHeap());
+  writer.header("slab_heap_largest_free_block_bytes", "gauge", "Largest allocatable block");
+  writer.value("slab_heap_largest_free_block_bytes", nullptr, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  
+  writer.header("slab_ap_clients", "gauge", "Stations connected to the access point");
+  writer.value("slab_ap_clients", nullptr, wifiDriver.stationCount());
+  writer.header("slab_ap_restarts_total", "counter", "Access point restarts after the initial start");
+  writer.value("slab_ap_restarts_total", nullptr, metrics.apRestarts.get());
+  writer.header("slab_http_rejected_total", "counter", "Requests shed by admission control");
+  writer.value("slab_http_rejected_total", "reason=\"rate_limit\"", metrics.rateLimited.get());
+  writer.value("slab_http_rejected_total", "reason=\"busy\"", metrics.shedBusy.get());
+  writer.value("slab_http_rejected_total", "reason=\"low_memory\"", metrics.shedLowMemory.get());
+  writer.header("slab_http_not_found_total", "counter", "Requests for paths with no route (404)");
+  writer.value("slab_http_not_found_total", nullptr, metrics.notFound.get());
+  writer.header("slab_http_heavy_in_flight", "gauge", "Heavy requests currently being processed");
+  writer.value("slab_http_heavy_in_flight", nullptr, admission.getHeavyInFlight());
+  
+  writer.header("slab_sse_clients", "gauge", "Subscribers on /api/events");
+  writer.value("slab_sse_clients", nullptr, events != nullptr ? events->count() : 0);
+  
+  CommandQueueStats queueStats = commandQueue->stats();
+  writer.header("slab_command_queue_depth", "gauge", "Commands waiting for the lighting loop");
+  writer.value("slab_command_queue_depth", nullptr, queueStats.depth);
+  writer.header("slab_command_queue_applied_total", "counter", "Commands applied by the lighting loop");
+  writer.value("slab_command_queue_applied_total", nullptr, queueStats.applied);
+  writer.header("slab_command_queue_rejected_total", "counter", "Commands rejected because the queue was full");
+  writer.value("slab_command_queue_rejected_total", nullptr, queueStats.rejected);
+  writer.header("slab_command_queue_max_latency_microseconds", "gauge", "Worst push-to-apply latency");
+  writer.value("slab_command_queue_max_latency_microseconds", nullptr, queueStats.maxLatencyUs);
+  
+  writer.header("slab_binary_commands_total", "counter", "Binary commands by transport and decode result");
+  for (uint8_t i = 0; i < CODEC_STATUS_COUNT; i++) {
+    char labels[48];
+    snprintf(labels, sizeof(labels), "transport=\"http\",result=\"%s\"", CODEC_STATUS_NAMES[i]);
+    writer.value("slab_binary_commands_total", labels, dispatcher.getCount((CodecStatus)i));
+#if defined(ESP_PLATFORM)
+    if (ble != nullptr) {
+      snprintf(labels, sizeof(labels), "transport=\"ble\",result=\"%s\"", CODEC_STATUS_NAMES[i]);
+      writer.value("slab_binary_commands_total", labels, ble->getDispatcher().getCount((CodecStatus)i));
+    }
+#endif
   }
-  if (!doc.containsKey("green")) {
-    errorMessage += "green, ";
-    isValid = false;
+  
+#if defined(ESP_PLATFORM)
+  if (ble != nullptr) {
+    writer.header("slab_ble_clients", "gauge", "Connected BLE centrals");
+    writer.value("slab_ble_clients", nullptr, ble->getClientCount());
+    writer.header("slab_ble_command_latency_seconds", "histogram", "BLE write received to result notified");
+    writer.histogram("slab_ble_command_latency_seconds", nullptr, metrics.bleLatency);
+    writer.header("slab_ble_results_dropped_total", "counter", "BLE commands applied without a result notification");
+    writer.value("slab_ble_results_dropped_total", nullptr, metrics.bleResultsDropped.get());
   }
-  if (!doc.containsKey("white")) {
-    errorMessage += "white, ";
-    isValid = false;
+#endif
+  
+  writer.header("slab_uptime_seconds", "counter", "Seconds since boot");
+  writer.value("slab_uptime_seconds", nullptr, millis() / 1000);
+  
+  if (health != nullptr) {
+    writer.header("slab_health_actions_total", "counter", "Recovery actions taken by the health monitor");
+    for (uint8_t i = HEALTH_ACTION_RESTART_HTTP; i < HEALTH_ACTION_COUNT; i++) {
+      char labels[32];
+      snprintf(labels, sizeof(labels), "action=\"%s\"", HEALTH_ACTION_NAMES[i]);
+      writer.value("slab_health_actions_total", labels, health->getActionCount((HealthAction)i));
+    }
+    const HealthSample& sample = health->getLastSample();
+    writer.header("slab_stack_free_bytes", "gauge", "Stack high-water mark per task (bytes never used)");
+    for (uint8_t i = 0; i < HEALTH_TASK_COUNT; i++) {
+      if (sample.stackFree[i] == 0) continue;  // Task tidak berjalan
+      char labels[32];
+      snprintf(labels, sizeof(labels), "task=\"%s\"", HEALTH_TASK_NAMES[i]);
+      writer.value("slab_stack_free_bytes", labels, sample.stackFree[i]);
+    }
+    writer.header("slab_heap_trend_bytes_per_minute", "gauge", "Free heap slope over the health window (0 until full)");
+    writer.append("slab_heap_trend_bytes_per_minute %ld\n", (long)health->getHeapTrend());
+  }
+
+  writer.header("slab_boot_warm", "gauge", "1 if this boot took over the LED output from before a software reset");
+  writer.value("slab_boot_warm", nullptr, ledController->isWarmBoot() ? 1 : 0);
+  
+  // Fase boot yang sudah tercapai (first_frame = waktu sampai output pertama yang benar)
+  writer.header("slab_boot_phase_seconds", "gauge", "Time from app start to each boot milestone");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    uint32_t us = metrics.bootPhaseUs[i].load(std::memory_order_relaxed);
+    if (us == 0) continue;
+    char labels[32];
+    snprintf(labels, sizeof(labels), "phase=\"%s\"", BOOT_PHASE_NAMES[i]);
+    writer.seconds("slab_boot_phase_seconds", labels, us);
   }
   
-  // Jika ada properti yang hilang, kirim error
-  if (!isValid) {
-    Serial.println(errorMessage);
-    String jsonError = "{\"status\":\"error\",\"message\":\"" + errorMessage + "\"}";
-    request->send(400, "application/json", jsonError);
+  if (writer.truncated()) {
+    Serial.println("WARNING: /api/metrics output truncated, increase METRICS_BUFFER_SIZE");
+  }
+  
+  // Buffer dipakai langsung oleh response (tanpa salinan) sampai koneksi ditutup
+  metricsBufferBusy = true;
+  request->onDisconnect([]() {
+    metricsBufferBusy = false;
+  });
+  request->send(request->beginResponse_P(200, "text/plain; version=0.0.4",
+                                         (const uint8_t*)metricsBuffer, writer.getLength()));
+}
+
+#if TRACE_ENABLED
+// Snapshot ring trace yang sedang dikirim; satu export pada satu waktu
+static TraceExport traceExport;
+static bool traceExportBusy = false;
+#endif
+
+// Ring trace sebagai Chrome trace_event JSON, dikirim chunked dari snapshot
+// (~30 KB untuk ring penuh) tanpa buffer response sebesar dokumen
+void WiFiService::handleTrace(AsyncWebServerRequest* request) {
+#if TRACE_ENABLED
+  if (traceExportBusy) {
+    AsyncWebServerResponse *response = request->beginResponse(503, "text/plain", "Trace export in progress\n");
+    response->addHeader("Retry-After", "1");
+    request->send(response);
     return;
   }
   
-  // Jika aplikasi mengirimkan data dengan format yang berbeda (misalnya dengan wrapper),
-  // coba periksa untuk wrapper umum
-  if (doc.containsKey("intensities") || doc.containsKey("values") || doc.containsKey("data") || doc.containsKey("leds")) {
-    Serial.println("Detected wrapper object, trying to extract LED values...");
-    JsonObject wrapper;
-    
-    if (doc.containsKey("intensities")) wrapper = doc["intensities"].as<JsonObject>();
-    else if (doc.containsKey("values")) wrapper = doc["values"].as<JsonObject>();
-    else if (doc.containsKey("data")) wrapper = doc["data"].as<JsonObject>();
-    else if (doc.containsKey("leds")) wrapper = doc["leds"].as<JsonObject>();
-    
-    // Re-create the correct JSON format expected by the controller
-    StaticJsonDocument<512> formattedDoc;
-    if (wrapper.containsKey("royalBlue")) formattedDoc["royalBlue"] = wrapper["royalBlue"];
-    if (wrapper.containsKey("blue")) formattedDoc["blue"] = wrapper["blue"];
-    if (wrapper.containsKey("uv")) formattedDoc["uv"] = wrapper["uv"];
-    if (wrapper.containsKey("violet")) formattedDoc["violet"] = wrapper["violet"];
-    if (wrapper.containsKey("red")) formattedDoc["red"] = wrapper["red"];
-    if (wrapper.containsKey("green")) formattedDoc["green"] = wrapper["green"];
-    if (wrapper.containsKey("white")) formattedDoc["white"] = wrapper["white"];
-    
-    // Serialize to string
-    String formattedJson;
-    serializeJson(formattedDoc, formattedJson);
-    
-    Serial.print("Reformatted JSON: ");
-    Serial.println(formattedJson);
-    
-    // Use the reformatted JSON
-    jsonString = formattedJson;
+  traceExportBusy = true;
+  traceExport.begin();
+  request->onDisconnect([]() {
+    traceExportBusy = false;
+  });
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+    [](uint8_t* buffer, size_t maxLen, size_t /*index*/) -> size_t {
+      return traceExport.read((char*)buffer, maxLen);
+    });
+  response->addHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+  request->send(response);
+#else
+  request->send(404, "application/json",
+    "{\"status\":\"error\",\"message\":\"Tracing is not enabled in this build (TRACE_ENABLED=0)\"}");
+#endif
+}
+
+// Status health monitor dan log keputusan recovery (termasuk dari boot sebelumnya).
+// Data ditulis oleh network task; pembacaan di sini bisa tertinggal satu sampel, tidak lebih.
+void WiFiService::handleHealth(AsyncWebServerRequest* request) {
+  if (health == nullptr || healthLog == nullptr) {
+    request->send(503, "application/json", "{\"status\":\"error\",\"message\":\"Health monitor not running\"}");
+    return;
+  }
+
+  // GET tanpa body: dokumen bersama sedang tidak dipakai
+  JsonDocument& requestDoc = apiRequestDocument();
+  requestDoc.clear();
+  const HealthSample& sample = health->getLastSample();
+  HealthDecision decision = health->getLastDecision();
+  requestDoc["status"] = HEALTH_CONDITION_NAMES[decision.condition];
+  requestDoc["last_action"] = HEALTH_ACTION_NAMES[decision.action];
+
+  JsonObject heap = requestDoc.createNestedObject("heap");
+  heap["free"] = sample.freeHeap;
+  heap["largest_block"] = sample.largestBlock;
+  heap["trend_bytes_per_min"] = health->getHeapTrend();
+
+  JsonObject stack = requestDoc.createNestedObject("stack_free");
+  for (uint8_t i = 0; i < HEALTH_TASK_COUNT; i++) {
+    stack[HEALTH_TASK_NAMES[i]] = sample.stackFree[i];
+  }
+
+  requestDoc["event_backlog"] = sample.eventBacklog;
+  requestDoc["ap_up"] = sample.apUp;
+  requestDoc["output_ok"] = sample.outputMatches;
+
+  JsonObject actions = requestDoc.createNestedObject("actions");
+  for (uint8_t i = HEALTH_ACTION_RESTART_HTTP; i < HEALTH_ACTION_COUNT; i++) {
+    actions[HEALTH_ACTION_NAMES[i]] = health->getActionCount((HealthAction)i);
   }
+
+  JsonArray log = requestDoc.createNestedArray("log");
+  HealthLogEntry entry;
+  for (uint8_t i = 0; healthLog->entry(i, entry); i++) {
+    JsonObject item = log.createNestedObject();
+    item["seq"] = entry.sequence;
+    item["uptime"] = entry.uptime;
+    item["action"] = entry.action < HEALTH_ACTION_COUNT ? HEALTH_ACTION_NAMES[entry.action] : "unknown";
+    item["condition"] = entry.condition < HEALTH_CONDITION_COUNT ? HEALTH_CONDITION_NAMES[entry.condition] : "unknown";
+    item["free_heap"] = entry.freeHeap;
+    item["largest_block"] = entry.largestBlock;
+    item["min_stack_free"] = entry.minStackFree;
+  }
+
+  if (requestDoc.overflowed() ||
+      serializeJson(requestDoc, responseBuffer, sizeof(responseBuffer)) >= sizeof(responseBuffer) - 1) {
+    request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Health report too large\"}");
+    return;
+  }
+  request->send(200, "application/json", responseBuffer);
+}
+
+// Implementasi fungsi untuk mengontrol semua LED sekaligus
+void WiFiService::handleManualControlAll(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+  Serial.print("Received manual control ALL request, payload size: ");
+  Serial.print(len);
+  Serial.println(" bytes");
   
-  // Pastikan mode manual aktif
-  if (!ledController->isInManualMode()) {
-    ledController->enableManualMode(true);
-    Serial.println("Switching to manual mode for controlling all LEDs");
+  ControlCommand command;
+  ApiError error;
+  if (!parseManualAllRequest(data, len, command, error)) {
+    sendApiError(request, error);
+    return;
   }
+  submitCommand(request, command, nullptr);
+}
+
+// ========== BATCH HANDLER ==========
+
+// Beberapa operasi dalam satu request, diterapkan sebagai satu transisi state
+// (lihat parseBatchRequest)
+void WiFiService::handleBatch(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+  Serial.print("Received batch request, payload size: ");
+  Serial.print(len);
+  Serial.println(" bytes");
   
-  // Terapkan pengaturan LED dari JSON
-  ledController->setAllLedsFromJson(jsonString);
+  ControlCommand command;
+  ApiError error;
+  if (!parseBatchRequest(data, len, command, error)) {
+    sendApiError(request, error);
+    return;
+  }
+  submitCommand(request, command, "Batch applied");
+}
+
+// Command biner: body application/octet-stream = opcode + payload (lihat CommandCodec.h).
+// Format yang sama dengan characteristic BLE, response JSON seperti endpoint lain.
+void WiFiService::handleBinaryCommand(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+  uint32_t seq;
+  CodecStatus status = dispatcher.dispatchMessage(data, len, seq);
+  
+  if (status == CODEC_BUSY) {
+    sendQueueFull(request);
+    return;
+  }
+  if (status != CODEC_OK) {
+    sendJsonError(request, "Invalid command: ", CODEC_STATUS_NAMES[status]);
+    return;
+  }
   
-  // Kirim respons sukses
-  request->send(200, "application/json", "{\"status\":\"success\"}");
+  // Command jadwal melaporkan versi jadwal baru (atau versi saat ini pada konflik)
+  uint8_t opcode = data[0];
+  bool schedule = opcode == OP_HOUR || opcode == OP_SCHEDULE || opcode == OP_PATCH;
+  respondWhenApplied(request, seq, schedule ? "Command applied" : nullptr);
 }
 
 // ========== HOURLY SCHEDULE HANDLERS ==========
 
 void WiFiService::handleGetHourlySchedule(AsyncWebServerRequest* request) {
-  String jsonResponse = ledController->getHourlyScheduleJson();
-  request->send(200, "application/json", jsonResponse);
+  if (ledController->formatHourlyScheduleJson(responseBuffer, sizeof(responseBuffer)) == 0) {
+    request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Schedule does not fit response buffer\"}");
+    return;
+  }
+  request->send(200, "application/json", responseBuffer);
 }
 
 void WiFiService::handleSetHourlySchedule(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-  String jsonString = String((char*)data);
-  String url = request->url();
-  
-  // Check if this is actually a per-hour request (e.g., /api/schedule/hourly/17)
-  // If so, delegate to handleSetHourProfile instead
-  if (url.indexOf("/api/schedule/hourly/") >= 0 && url.length() > 22) {
-    // Extract hour from URL manually
-    String afterBase = url.substring(22); // After "/api/schedule/hourly/"
-    int hour = afterBase.toInt();
-    
-    if (hour >= 0 && hour <= 23) {
-      Serial.println("========================================");
-      Serial.print(">>> DELEGATING TO handleSetHourProfile for HOUR ");
-      Serial.println(hour);
-      Serial.println("========================================");
-      
-      // Call the hour-specific handler directly
-      handleSetHourProfile(request, data, len);
-      return;
-    }
-  }
-  
-  Serial.print("Received hourly schedule update (ALL 24 HOURS): ");
-  Serial.println(jsonString);
-  Serial.print("Payload size: ");
+  Serial.print("Received hourly schedule update (ALL 24 HOURS), payload size: ");
   Serial.print(len);
   Serial.println(" bytes");
   
-  // Parse JSON to validate - INCREASED BUFFER SIZE to 6144 bytes for 24-hour schedule
-  DynamicJsonDocument doc(6144);
-  DeserializationError error = deserializeJson(doc, jsonString);
-  
-  if (error) {
-    Serial.print("JSON parsing failed: ");
-    Serial.println(error.c_str());
-    
-    String errorResponse = "{\"status\":\"error\",\"message\":\"Invalid JSON format: ";
-    errorResponse += error.c_str();
-    errorResponse += "\"}";
-    
-    request->send(400, "application/json", errorResponse);
+  ControlCommand command;
+  ApiError error;
+  if (!parseScheduleRequest(data, len, command, error)) {
+    sendApiError(request, error);
     return;
   }
-  
-  // Set the hourly schedule
-  ledController->setHourlySchedule(jsonString);
-  
-  Serial.println("Hourly schedule updated successfully");
-  request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"Hourly schedule updated\"}");
+  submitCommand(request, command, "Hourly schedule updated");
 }
 
-void WiFiService::handleGetHourProfile(AsyncWebServerRequest* request) {
-  // Extract hour from URL path
-  String path = request->url();
-  int lastSlash = path.lastIndexOf('/');
-  String hourStr = path.substring(lastSlash + 1);
-  
-  int hour = hourStr.toInt();
-  
-  if (hour < 0 || hour > 23) {
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid hour (must be 0-23)\"}");
+// Perubahan sparse terhadap versi jadwal milik client (lihat parseSchedulePatchRequest)
+void WiFiService::handlePatchHourlySchedule(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+  ControlCommand command;
+  ApiError error;
+  if (!parseSchedulePatchRequest(data, len, command, error)) {
+    sendApiError(request, error);
     return;
   }
-  
-  LightProfile profile = ledController->getHourlyProfile(hour);
-  
-  // Create JSON response
-  StaticJsonDocument<256> doc;
-  doc["hour"] = hour;
-  doc["royalBlue"] = profile.royalBlue;
-  doc["blue"] = profile.blue;
-  doc["uv"] = profile.uv;
-  doc["violet"] = profile.violet;
-  doc["red"] = profile.red;
-  doc["green"] = profile.green;
-  doc["white"] = profile.white;
-  
-  String output;
-  serializeJson(doc, output);
-  
-  request->send(200, "application/json", output);
+  submitCommand(request, command, "Hourly schedule patched");
 }
 
-void WiFiService::handleSetHourProfile(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-  // Extract hour from URL path
-  String path = request->url();
-  int lastSlash = path.lastIndexOf('/');
-  String hourStr = path.substring(lastSlash + 1);
-  
-  int hour = hourStr.toInt();
-  
-  Serial.println("========================================");
-  Serial.print(">>> RECEIVED HOUR PROFILE UPDATE for HOUR ");
-  Serial.println(hour);
-  Serial.println("========================================");
-  
-  if (hour < 0 || hour > 23) {
-    Serial.println("ERROR: Invalid hour value!");
+void WiFiService::handleGetHourProfile(AsyncWebServerRequest* request, uint16_t hour) {
+  if (hour > 23) {
     request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid hour (must be 0-23)\"}");
     return;
   }
   
-  String jsonString = String((char*)data);
-  
-  Serial.print("Raw JSON received (");
+  // Profil dan versi dari snapshot yang sama (tidak tercampur dengan PATCH yang sedang diterapkan)
+  ControllerSnapshot state;
+  ledController->readSnapshot(state);
+  formatHourProfileJson(responseBuffer, sizeof(responseBuffer), hour, state.profiles[hour], state.hourVersion[hour]);
+  request->send(200, "application/json", responseBuffer);
+}
+
+void WiFiService::handleSetHourProfile(AsyncWebServerRequest* request, uint16_t hour, uint8_t* data, size_t len) {
+  Serial.print("Received hour profile update for hour ");
+  Serial.print(hour);
+  Serial.print(", payload size: ");
   Serial.print(len);
-  Serial.print(" bytes): ");
-  Serial.println(jsonString);
-  
-  // Parse JSON
-  StaticJsonDocument<256> doc;
-  DeserializationError error = deserializeJson(doc, jsonString);
+  Serial.println(" bytes");
   
-  if (error) {
-    Serial.print("ERROR: JSON parsing failed: ");
-    Serial.println(error.c_str());
-    
-    String errorResponse = "{\"status\":\"error\",\"message\":\"Invalid JSON format: ";
-    errorResponse += error.c_str();
-    errorResponse += "\"}";
-    
-    request->send(400, "application/json", errorResponse);
+  ControlCommand command;
+  ApiError error;
+  if (!parseHourRequest(hour, data, len, command, error)) {
+    sendApiError(request, error);
+    return;
+  }
+  submitCommand(request, command, "Hour profile updated");
+}
+
+// Trace satu hari yang sedang dikirim; satu preview pada satu waktu
+static ScheduleSimulation previewExport;
+static bool previewExportBusy = false;
+
+// GET /api/schedule/preview?step=60&format=csv|bin: output jadwal satu hari pada jam
+// virtual, dihitung per potongan saat response dikirim (tanpa buffer sebesar trace)
+void WiFiService::handleGetPreview(AsyncWebServerRequest* request) {
+  if (previewExportBusy) {
+    AsyncWebServerResponse *response = request->beginResponse(503, "text/plain", "Preview export in progress\n");
+    response->addHeader("Retry-After", "1");
+    request->send(response);
     return;
   }
   
-  // Create LightProfile from JSON
-  LightProfile profile;
-  profile.royalBlue = doc.containsKey("royalBlue") ? (uint8_t)doc["royalBlue"] : 0;
-  profile.blue = doc.containsKey("blue") ? (uint8_t)doc["blue"] : 0;
-  profile.uv = doc.containsKey("uv") ? (uint8_t)doc["uv"] : 0;
-  profile.violet = doc.containsKey("violet") ? (uint8_t)doc["violet"] : 0;
-  profile.red = doc.containsKey("red") ? (uint8_t)doc["red"] : 0;
-  profile.green = doc.containsKey("green") ? (uint8_t)doc["green"] : 0;
-  profile.white = doc.containsKey("white") ? (uint8_t)doc["white"] : 0;
-  
-  Serial.println("Parsed profile values:");
-  Serial.print("  Royal Blue: "); Serial.println(profile.royalBlue);
-  Serial.print("  Blue: "); Serial.println(profile.blue);
-  Serial.print("  UV: "); Serial.println(profile.uv);
-  Serial.print("  Violet: "); Serial.println(profile.violet);
-  Serial.print("  Red: "); Serial.println(profile.red);
-  Serial.print("  Green: "); Serial.println(profile.green);
-  Serial.print("  White: "); Serial.println(profile.white);
-  
-  // Set the profile for this hour
-  Serial.print(">>> SAVING to hourlySchedule[");
-  Serial.print(hour);
-  Serial.println("]...");
-  ledController->setHourlyProfile(hour, profile);
-  
-  Serial.print(">>> Hour ");
-  Serial.print(hour);
-  Serial.println(" profile SAVED TO MEMORY successfully");
-  Serial.println("========================================");
+  long step = 60;
+  if (request->hasParam("step")) {
+    step = request->getParam("step")->value().toInt();
+    if (step < 1 || step > SIM_MAX_STEP_SECONDS) {
+      request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"step must be 1..3600 seconds\"}");
+      return;
+    }
+  }
+  SimFormat format = SIM_FORMAT_CSV;
+  if (request->hasParam("format") && request->getParam("format")->value() == "bin") {
+    format = SIM_FORMAT_BINARY;
+  }
   
-  request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"Hour profile updated\"}");
+  previewExportBusy = true;
+  previewExport.begin(ledController, format, (uint16_t)step);
+  request->onDisconnect([]() {
+    previewExportBusy = false;
+  });
+  AsyncWebServerResponse *response = request->beginChunkedResponse(
+    format == SIM_FORMAT_BINARY ? "application/octet-stream" : "text/csv",
+    [](uint8_t* buffer, size_t maxLen, size_t /*index*/) -> size_t {
+      return previewExport.read(buffer, maxLen);
+    });
+  response->addHeader("Content-Disposition", format == SIM_FORMAT_BINARY ?
+                      "attachment; filename=\"preview.bin\"" : "attachment; filename=\"preview.csv\"");
+  request->send(response);
+}
+
+// POST /api/schedule/preview {"minutes":5}: putar hari itu di lampu, lalu kembali ke mode
+void WiFiService::handleSetPreview(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+  ControlCommand command;
+  ApiError error;
+  if (!parsePreviewRequest(data, len, command, error)) {
+    sendApiError(request, error);
+    return;
+  }
+  submitCommand(request, command, nullptr);
 }
 
 // Destructor untuk membersihkan sumber daya
@@ -1048,6 +1537,7 @@ WiFiService::~WiFiService() {
   if (server) {
     // Tidak ada metode end() untuk AsyncWebServer, 
     // tetapi kita bisa membebaskan memori
+    // (AsyncEventSource ikut dihapus karena terdaftar sebagai handler server)
     delete server;
   }
 }
\ No newline at end of file
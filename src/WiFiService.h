@@ -7,12 +7,117 @@
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
+#include <mutex>
 #include "LedController.h"
+#include "ApiRouter.h"
+#include "ApiRequests.h"
+#include "ControlCommand.h"
+#include "CommandCodec.h"
+#include "AdmissionControl.h"
+#include "WiFiLink.h"
+#include "HealthMonitor.h"
+#include "HealthLog.h"
+#include "TimeKeeper.h"
+
+// Firmware memakai radio ESP32; build host (native-http) memakai driver simulasi
+#if defined(ESP_PLATFORM)
+#include "Esp32WiFiDriver.h"
+#include "BleService.h"
+typedef Esp32WiFiDriver PlatformWiFiDriver;
+#else
+#include "SimulatedWiFiDriver.h"
+class BleService;
+typedef SimulatedWiFiDriver PlatformWiFiDriver;
+#endif
+
+#ifndef HTTP_PORT
+#define HTTP_PORT 80
+#endif
+
+// Preferences namespace of the AP state
+#define WIFI_CONFIG_NAMESPACE "wifi_config"
+
+// Server-Sent Events (/api/events)
+#define EVENTS_MAX_CLIENTS        4     // Sama dengan batas station softAP
+#define EVENTS_FRAME_INTERVAL_MS  250   // Rate limit untuk event "frame"
+#define EVENTS_TIME_TICK_MS       10000 // Interval event "time"
+#define EVENTS_MAX_BACKLOG        4     // Pesan tertunda di satu client sebelum frame/time untuk client itu ditahan
+
+// Berapa lama handler menunggu command diterapkan sebelum response ditunda (async)
+#define COMMAND_RESPONSE_WAIT_MS 20
+
+// Ukuran maksimum body request API (jadwal 24 jam lengkap ~3 KB)
+#define API_MAX_BODY_SIZE 8192
+
+// Identitas route di tabel API_ROUTES (WiFiService.cpp)
+enum ApiRouteId : uint8_t {
+  API_ROOT,
+  API_WEB_APP,
+  API_PING,
+  API_MANUAL,
+  API_MANUAL_ALL,
+  API_TIME_GET,
+  API_TIME_SET,
+  API_TIME_SYNC,
+  API_MODE_GET,
+  API_MODE_SET,
+  API_WIFI_RESTART,
+  API_SCHEDULE_GET,
+  API_SCHEDULE_SET,
+  API_SCHEDULE_PATCH,
+  API_HOUR_GET,
+  API_HOUR_SET,
+  API_BATCH,
+  API_METRICS,
+  API_HEALTH,
+  API_COMMAND,
+  API_TRACE,
+  API_PREVIEW_GET,
+  API_PREVIEW_SET
+};
+
+// Subscriber SSE dan frame terakhir yang sudah diantrikan ke client itu
+struct EventSubscriber {
+  AsyncEventSourceClient* client;  // nullptr: slot kosong
+  uint32_t frameSequence;
+};
+
+// State per request yang disimpan di request->_tempObject (dibebaskan oleh AsyncWebServerRequest)
+struct ApiRequestContext {
+  RouteMatch match;
+  uint8_t routeClass;  // RouteClass
+  uint8_t admission;   // AdmissionResult, diputuskan di canHandle()
+  uint8_t retryAfter;  // Detik, untuk 429/503
+  size_t bodyLength;
+  bool bodyRejected;
+  char body[1]; // Body request, selalu diakhiri NUL
+};
+
+class WiFiService;
+
+// Satu handler untuk semua route API: route dicocokkan sekali di canHandle(),
+// body dikumpulkan, lalu request di-dispatch ke WiFiService
+class ApiRequestHandler : public AsyncWebHandler {
+private:
+  WiFiService* service;
+  
+public:
+  ApiRequestHandler(WiFiService* service);
+  
+  virtual bool canHandle(AsyncWebServerRequest* request) override;
+  virtual void handleRequest(AsyncWebServerRequest* request) override;
+  virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+  virtual bool isRequestHandlerTrivial() override { return false; }
+};
 
 class WiFiService {
+  friend class ApiRequestHandler;
+  
 private:
   LedController* ledController;
+  CommandQueue* commandQueue;
   AsyncWebServer* server;
+  AsyncEventSource* events;
   bool deviceConnected;
   
   // WiFi credentials
@@ -22,39 +127,97 @@ private:
   // Preferences untuk menyimpan konfigurasi
   Preferences preferences;
   
-  // Variabel untuk melacak status WiFi
-  unsigned long lastConnectAttempt;
-  int reconnectAttempts;
-  bool apActive;
+  // Bring-up dan recovery AP (state machine tanpa delay)
+  PlatformWiFiDriver wifiDriver;
+  WiFiLink link;
+  bool announcedUp;     // IP sudah dicetak untuk periode "up" ini
+  bool reportedGiveUp;
+  
+  // Snapshot state terakhir yang sudah dipush lewat SSE
+  uint32_t eventId;
+  uint8_t lastEventMode;
+  LightProfile lastEventFrame;
+  uint32_t frameSequence;  // Naik setiap lastEventFrame berubah
+  unsigned long lastFrameEvent;
+  uint32_t lastEventScheduleVersion;
+  unsigned long lastTimeEvent;
+  
+  // Diisi oleh onConnect/onDisconnect (task AsyncTCP), dibaca oleh publishEvents()
+  EventSubscriber subscribers[EVENTS_MAX_CLIENTS];
+  std::mutex subscriberLock;
+  
+  // Route table API
+  ApiRouter router;
+  
+  // Rate limit per client dan batas request berat (hanya diakses dari task AsyncTCP)
+  AdmissionControl admission;
+  
+  // Health monitor milik network task; dibaca oleh /api/health dan /api/metrics
+  HealthMonitor* health;
+  HealthLog* healthLog;
+  
+  // Sumber waktu dengan fallback; status di /api/time dan metrics (nullptr: jam LedController saja)
+  TimeKeeper* timeKeeper;
+  
+  // Command biner (/api/command), codec yang sama dengan BLE
+  CommandDispatcher dispatcher;
+  
+  // Layanan BLE, hanya untuk metrics (nullptr jika tidak berjalan)
+  BleService* ble;
   
   // Method for handling API endpoints
   void setupApiEndpoints();
+  void dispatchRequest(AsyncWebServerRequest* request, ApiRequestContext* context);
   void handleCors(AsyncWebServerRequest* request);
   void handleNotFound(AsyncWebServerRequest* request);
+  void handleMethodNotAllowed(AsyncWebServerRequest* request, uint8_t allowedMethods);
+  void handleRejected(AsyncWebServerRequest* request, ApiRequestContext* context);
+  void sendWebAsset(AsyncWebServerRequest* request, const char* contentType,
+                    const uint8_t* data, size_t length, const char* etag, bool immutable);
+  
+  // Server-Sent Events
+  void setupEvents();
+  void publishEvents();
+  size_t formatModeEvent(char* buffer, size_t size, uint8_t mode);
+  size_t formatFrameEvent(char* buffer, size_t size, const LightProfile& frame);
+  size_t formatScheduleEvent(char* buffer, size_t size, uint32_t version);
+  
+  // Kirim command ke lighting loop dan selesaikan response setelah diterapkan
+  void submitCommand(AsyncWebServerRequest* request, ControlCommand& command, const char* message);
+  void respondWhenApplied(AsyncWebServerRequest* request, uint32_t seq, const char* message);
+  void sendQueueFull(AsyncWebServerRequest* request);
   
   // API handlers
   void handleManualControl(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   void handleManualControlAll(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   void handleGetCurrentTime(AsyncWebServerRequest* request);
+  void handleTimeSync(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   void handleSetTime(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   void handleSetMode(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   void handleGetMode(AsyncWebServerRequest* request);
   void handlePing(AsyncWebServerRequest* request);
+  void handleMetrics(AsyncWebServerRequest* request);
+  void handleTrace(AsyncWebServerRequest* request);
+  void handleHealth(AsyncWebServerRequest* request);
+  void handleBatch(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+  void handleBinaryCommand(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   
   // Hourly schedule handlers
   void handleGetHourlySchedule(AsyncWebServerRequest* request);
   void handleSetHourlySchedule(AsyncWebServerRequest* request, uint8_t* data, size_t len);
-  void handleGetHourProfile(AsyncWebServerRequest* request);
-  void handleSetHourProfile(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+  void handlePatchHourlySchedule(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+  void handleGetHourProfile(AsyncWebServerRequest* request, uint16_t hour);
+  void handleSetHourProfile(AsyncWebServerRequest* request, uint16_t hour, uint8_t* data, size_t len);
+  void handleGetPreview(AsyncWebServerRequest* request);
+  void handleSetPreview(AsyncWebServerRequest* request, uint8_t* data, size_t len);
   
   // Helper methods untuk WiFi
-  void startAP();
-  void checkWiFiStatus();
   void restartWiFi();
   
 public:
   // Constructor
-  WiFiService(LedController* ledController, const char* ssid, const char* password);
+  WiFiService(LedController* ledController, CommandQueue* commandQueue, const char* ssid, const char* password,
+              uint16_t httpPort = HTTP_PORT);
   
   // Destructor
   ~WiFiService();
@@ -62,11 +225,26 @@ public:
   // Initialize WiFi service
   void begin();
   
+  // Health monitor untuk /api/health dan metrics (panggil sebelum begin())
+  void setHealth(HealthMonitor* health, HealthLog* healthLog);
+  
+  // Status waktu untuk /api/time dan /api/metrics (panggil sebelum begin())
+  void setTimeKeeper(TimeKeeper* timeKeeper);
+  
+  // Layanan BLE untuk /api/metrics (panggil sebelum begin())
+  void setBle(BleService* ble);
+  
+  // Recovery per subsistem, dipanggil dari network task atas keputusan HealthMonitor
+  void restartHttpServer();   // Tutup client SSE, listener ditutup dan dibuka lagi
+  void restartAccessPoint();  // Percobaan WiFiLink baru (dengan driver reset)
+  uint32_t getEventBacklog(); // Rata-rata pesan SSE tertunda per client
+  
   // Status methods
   bool isConnected();
+  bool hasGivenUp(); // Semua percobaan boot gagal dan AP belum pernah aktif
   IPAddress getIP();
   
-  // Update WiFi service (if needed for periodic tasks)
+  // Jalankan state machine WiFi dan tugas periodik; dipanggil dari network task, tidak blocking
   void update();
 };
 
@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+#include <Arduino.h>
+#include <stdio.h>
+
+#if defined(ESP_PLATFORM)
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#else
+#include <stdlib.h>
+#include <malloc.h>
+#include <chrono>
+#include <new>
+#endif
+
+// ========== PLATFORM ==========
+
+#if defined(ESP_PLATFORM)
+
+const char* benchTarget() {
+  return "esp32";
+}
+
+static uint32_t cpuMhz() {
+  return getCpuFrequencyMhz();
+}
+
+static uint64_t nowNs() {
+  return (uint64_t)esp_timer_get_time() * 1000;
+}
+
+static uint32_t heapUsed() {
+  return heap_caps_get_total_size(MALLOC_CAP_DEFAULT) - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+#else
+
+const char* benchTarget() {
+  return "native";
+}
+
+static uint32_t cpuMhz() {
+  return 0;
+}
+
+static uint64_t nowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Semua alokasi lewat operator new dihitung; ukuran dari malloc_usable_size
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+static int64_t liveBytes = 0;
+static int64_t peakLiveBytes = 0;
+
+static uint32_t heapUsed() {
+  return (uint32_t)liveBytes;
+}
+
+static void* countedAlloc(size_t size) {
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  size_t usable = malloc_usable_size(ptr);
+  allocCount++;
+  allocBytes += usable;
+  liveBytes += usable;
+  if (liveBytes > peakLiveBytes) peakLiveBytes = liveBytes;
+  return ptr;
+}
+
+static void countedFree(void* ptr) {
+  if (ptr == nullptr) return;
+  liveBytes -= malloc_usable_size(ptr);
+  free(ptr);
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr); }
+
+#endif
+
+// ========== RUNNER ==========
+
+BenchRunner::BenchRunner() {
+  resultCount = 0;
+}
+
+const BenchResult* BenchRunner::run(const BenchCase& benchCase) {
+  if (resultCount >= BENCH_MAX_CASES) {
+    return nullptr;
+  }
+
+  if (benchCase.prepare != nullptr) {
+    benchCase.prepare();
+  }
+
+#if defined(ESP_PLATFORM)
+  uint32_t iterations = benchCase.deviceIterations;
+#else
+  uint32_t iterations = benchCase.iterations;
+#endif
+  if (iterations == 0) iterations = 1;
+
+  // Satu iterasi pemanasan: cache, lazy init, dokumen JSON statis
+  benchCase.run();
+
+  BenchResult& result = results[resultCount++];
+  result.name = benchCase.name;
+  result.iterations = iterations;
+  result.cyclesPerOp = -1;
+  result.allocsPerOp = -1;
+  result.allocBytesPerOp = -1;
+
+  uint32_t heapBefore = heapUsed();
+  int32_t peak = 0;
+
+#if defined(ESP_PLATFORM)
+  // CCOUNT 32-bit (~18 s pada 240 MHz): dijumlah per iterasi agar tidak overflow
+  uint64_t cycles = 0;
+  uint64_t start = nowNs();
+  for (uint32_t i = 0; i < iterations; i++) {
+    uint32_t begin = ESP.getCycleCount();
+    benchCase.run();
+    cycles += ESP.getCycleCount() - begin;
+    int32_t held = (int32_t)(heapUsed() - heapBefore);
+    if (held > peak) peak = held;
+  }
+  uint64_t elapsed = nowNs() - start;
+  result.cyclesPerOp = (double)cycles / iterations;
+  // ns dari cycle counter: lebih presisi dari esp_timer untuk operasi < 1 us
+  result.nsPerOp = cpuMhz() > 0 ? result.cyclesPerOp * 1000.0 / cpuMhz() : (double)elapsed / iterations;
+#else
+  uint64_t allocsBefore = allocCount;
+  uint64_t bytesBefore = allocBytes;
+  peakLiveBytes = liveBytes;
+  uint64_t start = nowNs();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchCase.run();
+  }
+  uint64_t elapsed = nowNs() - start;
+  result.nsPerOp = (double)elapsed / iterations;
+  result.allocsPerOp = (double)(allocCount - allocsBefore) / iterations;
+  result.allocBytesPerOp = (double)(allocBytes - bytesBefore) / iterations;
+  peak = (int32_t)(peakLiveBytes - (int64_t)heapBefore);
+#endif
+
+  result.peakHeapBytes = peak;
+  result.heapDeltaBytes = (int32_t)(heapUsed() - heapBefore);
+  return &result;
+}
+
+static void writeNumber(char* buffer, size_t size, double value) {
+  if (value < 0) {
+    snprintf(buffer, size, "null");
+  } else {
+    snprintf(buffer, size, "%.2f", value);
+  }
+}
+
+void BenchRunner::writeJson(BenchWrite write, const char* label) {
+  char line[320];
+  snprintf(line, sizeof(line), "{\"target\":\"%s\",\"label\":\"%s\",\"cpu_mhz\":%lu,\"cases\":[",
+           benchTarget(), label, (unsigned long)cpuMhz());
+  write(line);
+
+  for (uint8_t i = 0; i < resultCount; i++) {
+    const BenchResult& r = results[i];
+    char cycles[24], allocs[24], bytes[24];
+    writeNumber(cycles, sizeof(cycles), r.cyclesPerOp);
+    writeNumber(allocs, sizeof(allocs), r.allocsPerOp);
+    writeNumber(bytes, sizeof(bytes), r.allocBytesPerOp);
+    snprintf(line, sizeof(line),
+      "%s{\"name\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.2f,\"cycles_per_op\":%s,"
+      "\"allocs_per_op\":%s,\"alloc_bytes_per_op\":%s,\"peak_heap_bytes\":%ld,\"heap_delta_bytes\":%ld}",
+      i == 0 ? "" : ",", r.name, (unsigned long)r.iterations, r.nsPerOp, cycles, allocs, bytes,
+      (long)r.peakHeapBytes, (long)r.heapDeltaBytes);
+    write(line);
+  }
+  write("]}\n");
+}
@@ -0,0 +1,61 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Microbenchmark harness shared by the host ([env:bench-native]) and the
+// device ([env:bench-esp32]). Each case runs a fixed number of iterations;
+// results are written as one JSON document so runs from two firmware
+// versions can be compared with tools/bench_compare.py.
+//
+// What is measured depends on the target:
+//   host   ns/op (steady clock), allocations/op and bytes/op (global operator
+//          new), peak live heap above the starting point
+//   ESP32  ns/op and cycles/op (CPU cycle counter, summed per iteration),
+//          free-heap drop (peak across iterations and left after the case)
+// Fields a target cannot measure are written as null.
+
+#define BENCH_MAX_CASES   24
+
+struct BenchCase {
+  const char* name;
+  uint32_t iterations;        // Host
+  uint32_t deviceIterations;  // ESP32 (lower where a case writes flash)
+  void (*prepare)();          // Optional, once before the timed loop
+  void (*run)();
+};
+
+struct BenchResult {
+  const char* name;
+  uint32_t iterations;
+  double nsPerOp;
+  double cyclesPerOp;         // < 0 if not measured
+  double allocsPerOp;         // < 0 if not measured
+  double allocBytesPerOp;     // < 0 if not measured
+  int32_t peakHeapBytes;
+  int32_t heapDeltaBytes;     // Still held after the case (leak/cache)
+};
+
+// Output sink for writeJson(): Serial on the device, stdout on the host
+typedef void (*BenchWrite)(const char* text);
+
+class BenchRunner {
+private:
+  BenchResult results[BENCH_MAX_CASES];
+  uint8_t resultCount;
+
+public:
+  BenchRunner();
+
+  const BenchResult* run(const BenchCase& benchCase);
+  uint8_t getResultCount() { return resultCount; }
+
+  // {"target":..,"label":..,"cpu_mhz":..,"cases":[{..}, ..]}
+  void writeJson(BenchWrite write, const char* label);
+};
+
+// Name of the build target ("native" or "esp32")
+const char* benchTarget();
+
+#endif // BENCHMARK_H
@@ -0,0 +1,234 @@
+// Benchmark cases for the lighting math, JSON/binary codecs and persistence
+// paths. The same cases run on the host and on the ESP32:
+//
+//   pio run -e bench-native && .pio/build/bench-native/program [label] > bench.json
+//   pio run -e bench-esp32 -t upload && pio device monitor   (JSON line on serial)
+//   python tools/bench_compare.py baseline.json bench.json
+//
+// PWM and clock are the in-memory HAL on both targets, so the cases measure
+// the controller and not LEDC/I2C. NVS is real on the device (namespace
+// "bench", removed afterwards) and a std::map on the host.
+
+#include <Arduino.h>
+#include "Benchmark.h"
+#include "LedController.h"
+#include "ControlCommand.h"
+#include "CommandCodec.h"
+#include "ApiRequests.h"
+#include "SimulatedLightingHal.h"
+#if defined(ESP_PLATFORM)
+#include "Esp32LightingHal.h"
+#endif
+
+#ifndef BENCH_LABEL
+#define BENCH_LABEL "dev"
+#endif
+
+#if defined(ESP_PLATFORM)
+// NVS asli, tetapi di namespace sendiri: pengaturan lampu tidak tersentuh
+class BenchStore : public Esp32KeyValueStore {
+public:
+  bool begin(const char* name) override {
+    (void)name;
+    return Esp32KeyValueStore::begin("bench");
+  }
+};
+static BenchStore store;
+#else
+static MemoryKeyValueStore store;
+#endif
+
+static SimulatedPwmSink pwm;
+static ManualClock benchClock;
+static LedController* controller;
+static CommandQueue queue;
+
+static char scheduleJson[SCHEDULE_JSON_MAX_SIZE];
+static size_t scheduleJsonLength;
+static char requestBody[SCHEDULE_JSON_MAX_SIZE];
+static uint8_t scheduleBinary[CODEC_SCHEDULE_SIZE];
+static char outputBuffer[SCHEDULE_JSON_MAX_SIZE];
+static ControlCommand scheduleCommand;
+
+static const char PROFILE_JSON[] =
+  "{\"royalBlue\":200,\"blue\":180,\"uv\":40,\"violet\":60,\"red\":20,\"green\":10,\"white\":120}";
+
+// Hasil yang dipakai agar compiler tidak membuang pemanggilan
+static volatile uint32_t sink;
+
+// Jadwal siang/malam yang realistis: setiap jam punya nilai berbeda
+static void fillSchedule() {
+  scheduleCommand.type = CMD_SET_SCHEDULE;
+  scheduleCommand.schedule.hourMask = 0xFFFFFF;
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    uint8_t level = hour >= 8 && hour <= 20 ? 40 + hour * 9 : hour;
+    scheduleCommand.schedule.profiles[hour] = {level, (uint8_t)(level / 2), 10, 20, hour, 5, (uint8_t)(255 - level)};
+  }
+  uint32_t value;
+  controller->applyCommand(scheduleCommand, value);
+  controller->flushPendingWrites();
+
+  scheduleJsonLength = controller->formatHourlyScheduleJson(scheduleJson, sizeof(scheduleJson));
+  scheduleBinary[0] = 0xFF;
+  scheduleBinary[1] = 0xFF;
+  scheduleBinary[2] = 0xFF;
+  scheduleBinary[3] = 0x00;
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    encodeFrame(scheduleCommand.schedule.profiles[hour], scheduleBinary + 4 + hour * CODEC_FRAME_SIZE);
+  }
+}
+
+// ========== CASES ==========
+
+static void benchInterpolate() {
+  static float ratio = 0;
+  ratio = ratio >= 1 ? 0 : ratio + 0.0167f;
+  LightProfile result = LedController::interpolateProfiles(
+    scheduleCommand.schedule.profiles[7], scheduleCommand.schedule.profiles[8], ratio);
+  sink = result.white;
+}
+
+static void benchCurrentProfile() {
+  sink = controller->getCurrentProfile().blue;
+}
+
+static void benchParseProfileJson() {
+  sink = controller->parseProfileJson(PROFILE_JSON).red;
+}
+
+static void benchFormatProfileJson() {
+  sink = controller->formatProfileJson(scheduleCommand.schedule.profiles[12], outputBuffer, sizeof(outputBuffer));
+}
+
+static void benchFormatScheduleJson() {
+  sink = controller->formatHourlyScheduleJson(outputBuffer, sizeof(outputBuffer));
+}
+
+// Body diparse in-place, jadi disalin dulu seperti body request HTTP
+static void benchParseScheduleRequest() {
+  memcpy(requestBody, scheduleJson, scheduleJsonLength);
+  ControlCommand command;
+  ApiError error;
+  sink = parseScheduleRequest((uint8_t*)requestBody, scheduleJsonLength, command, error);
+}
+
+static void benchDecodeSchedule() {
+  ControlCommand command;
+  sink = decodeCommand(OP_SCHEDULE, scheduleBinary, sizeof(scheduleBinary), command);
+}
+
+// Jadwal penuh ke RAM + satu frame PWM; penulisan NVS hanya di-stage
+static void benchApplySchedule() {
+  uint32_t value;
+  sink = controller->applyCommand(scheduleCommand, value);
+  controller->stagePendingWrites();
+}
+
+// Satu command dari HTTP/BLE sampai di-stage untuk NVS (tanpa tulis NVS)
+static void benchProcessCommand() {
+  static uint8_t value = 0;
+  ControlCommand command;
+  command.type = CMD_SET_CHANNEL;
+  command.channel.channel = LED_WHITE;
+  command.channel.value = value++;
+  queue.push(command);
+  sink = controller->processCommands(queue);
+}
+
+// Satu perubahan jam lalu config record (A/B, CRC) ditulis ke NVS
+static void benchPersistSchedule() {
+  static uint8_t value = 0;
+  ControlCommand command;
+  command.type = CMD_SET_HOUR;
+  command.hour.hour = 12;
+  command.hour.profile = scheduleCommand.schedule.profiles[12];
+  command.hour.profile.uv = value++;
+  uint32_t version;
+  controller->applyCommand(command, version);
+  controller->flushPendingWrites();
+  sink = version;
+}
+
+static void benchLoadConfig() {
+  controller->loadConfigRecord();
+  sink = controller->getScheduleVersion();
+}
+
+static void prepareWrites() {
+  // Sisa stage dari case sebelumnya tidak ikut dihitung
+  controller->flushPendingWrites();
+}
+
+static void prepareAuto() {
+  ControlCommand command;
+  command.type = CMD_SET_MODE;
+  command.mode.mode = MODE_AUTO;
+  uint32_t value;
+  controller->applyCommand(command, value);
+  controller->flushPendingWrites();
+  benchClock.set(12, 30);
+}
+
+//  name                         host      device  prepare        run
+static const BenchCase BENCH_CASES[] = {
+  {"interpolateProfiles",       1000000,  100000, nullptr,       benchInterpolate},
+  {"getCurrentProfile",         200000,   500,    prepareAuto,   benchCurrentProfile},
+  {"parseProfileJson",          200000,   5000,   nullptr,       benchParseProfileJson},
+  {"formatProfileJson",         500000,   10000,  nullptr,       benchFormatProfileJson},
+  {"formatHourlyScheduleJson",  20000,    1000,   nullptr,       benchFormatScheduleJson},
+  {"parseScheduleRequest",      20000,    500,    nullptr,       benchParseScheduleRequest},
+  {"decodeCommand.schedule",    500000,   20000,  nullptr,       benchDecodeSchedule},
+  {"applyCommand.schedule",     100000,   2000,   prepareAuto,   benchApplySchedule},
+  {"processCommands.channel",   200000,   5000,   prepareWrites, benchProcessCommand},
+  {"persist.configRecord",      20000,    20,     prepareWrites, benchPersistSchedule},
+  {"loadConfigRecord",          20000,    200,    nullptr,       benchLoadConfig},
+};
+
+// ========== ENTRY ==========
+
+static void runAll(BenchWrite write, const char* label) {
+  controller = new LedController(&pwm, &store, &benchClock);
+  controller->begin();
+  fillSchedule();
+
+  BenchRunner runner;
+  for (const BenchCase& benchCase : BENCH_CASES) {
+    runner.run(benchCase);
+  }
+  runner.writeJson(write, label);
+
+  for (uint8_t i = 0; i < CONFIG_SLOT_COUNT; i++) {
+    store.remove(CONFIG_SLOT_KEYS[i]);
+  }
+}
+
+#if defined(ESP_PLATFORM)
+
+static void writeSerial(const char* text) {
+  Serial.print(text);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);  // Waktu untuk membuka monitor serial
+  runAll(writeSerial, BENCH_LABEL);
+  Serial.flush();
+}
+
+void loop() {
+  delay(1000);
+}
+
+#else
+
+static void writeStdout(const char* text) {
+  fputs(text, stdout);
+}
+
+int main(int argc, char** argv) {
+  Serial.enabled = false;  // Log firmware tidak ikut diukur dan tidak mengotori JSON
+  runAll(writeStdout, argc > 1 ? argv[1] : BENCH_LABEL);
+  return 0;
+}
+
+#endif
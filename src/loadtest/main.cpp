@@ -0,0 +1,254 @@
+// Host build of the HTTP server for load tests. WiFiService runs unchanged on
+// the loopback stand-in for ESPAsyncWebServer (src/native/), LedController on
+// the in-memory HAL, with the same three loops as the firmware task plan:
+//
+//   lighting   every 5 ms: apply queued commands, schedule tick every 1 s
+//   persist    woken after commands are staged: NVS writes
+//   network    every 10 ms (or when commands were applied): wifiService->update()
+//
+//   pio run -e native-http && .pio/build/native-http/program [options]
+//   python tools/loadgen.py --mix sliders --rate 50 --duration 30
+//
+// Options:
+//   --port N        listen on 127.0.0.1:N (default 8080)
+//   --frames FILE   write every changed LED frame as CSV (t_ms + 7 channels)
+//   --nvs-ms N      make each NVS write take N ms (flash erase/write time)
+//   -v              show the firmware's Serial output
+//
+// Runs until SIGINT/SIGTERM, then prints a summary on stderr. Latency numbers
+// from this build reflect the request handling and queueing logic, not the
+// ESP32's CPU or radio; heap is the process heap in use above the baseline
+// taken once the server is up (see src/native/NativeHeap.cpp).
+
+#include <Arduino.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include "LedController.h"
+#include "ControlCommand.h"
+#include "WiFiService.h"
+#include "HealthMonitor.h"
+#include "HealthLog.h"
+#include "TimeKeeper.h"
+#include "SimulatedLightingHal.h"
+
+#define LIGHTING_UPDATE_INTERVAL 1000
+#define LOOP_INTERVAL_MS         5
+#define NETWORK_INTERVAL_MS      10
+
+#define AP_SSID "SLAB-Aquarium-LED"
+#define AP_PASSWORD "12345678"
+
+// NVS yang lambat seperti flash (tulis + erase sektor), opsional
+class SlowKeyValueStore : public MemoryKeyValueStore {
+public:
+  uint32_t writeDelayMs = 0;
+
+  size_t putBytes(const char* key, const void* value, size_t length) override {
+    if (writeDelayMs > 0) delay(writeDelayMs);
+    return MemoryKeyValueStore::putBytes(key, value, length);
+  }
+};
+
+// Jam dinding yang berjalan mengikuti waktu host; adjust() dari POST /api/time
+class HostClock : public WallClock {
+private:
+  std::mutex lock;
+  ManualClock base;
+  unsigned long baseMillis = 0;
+
+public:
+  CommandTime now() override {
+    std::lock_guard<std::mutex> guard(lock);
+    ManualClock clock = base;
+    clock.advance((millis() - baseMillis) / 1000);
+    return clock.time;
+  }
+
+  void adjust(const CommandTime& time) override {
+    std::lock_guard<std::mutex> guard(lock);
+    base.time = time;
+    baseMillis = millis();
+  }
+};
+
+// esp_timer: waktu sejak proses mulai
+class HostTimer : public MonotonicClock {
+public:
+  uint64_t uptimeUs() override {
+    return micros();
+  }
+};
+
+static SimulatedPwmSink pwm;
+static SlowKeyValueStore store;
+static HostClock wallClock;
+static HostTimer uptime;
+static MemoryKeyValueStore timeStore;
+static TimeKeeper timeKeeper(&wallClock, &uptime, &timeStore);
+
+static LedController* ledController;
+static WiFiService* wifiService;
+static CommandQueue commandQueue;
+static HealthMonitor healthMonitor;
+static HealthLog healthLog;
+
+static std::atomic<bool> running(true);
+
+// Notifikasi task (xTaskNotifyGive / ulTaskNotifyTake) dengan condition variable
+struct TaskNotify {
+  std::mutex lock;
+  std::condition_variable signal;
+  bool pending = false;
+
+  void give() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      pending = true;
+    }
+    signal.notify_one();
+  }
+
+  void take(unsigned long timeoutMs) {
+    std::unique_lock<std::mutex> guard(lock);
+    signal.wait_for(guard, std::chrono::milliseconds(timeoutMs), [this]() { return pending; });
+    pending = false;
+  }
+};
+
+static TaskNotify persistNotify;
+static TaskNotify networkNotify;
+
+static FILE* framesFile = nullptr;
+static uint32_t frameCount = 0;
+
+static void onSignal(int signal) {
+  (void)signal;
+  running = false;
+}
+
+// Frame dicatat hanya saat berubah, dengan waktu sejak server siap
+static void captureFrame(unsigned long startMillis) {
+  static LightProfile last;
+  static bool first = true;
+  LightProfile frame = pwm.frame();
+  if (!first && memcmp(&frame, &last, sizeof(frame)) == 0) return;
+  first = false;
+  last = frame;
+  frameCount++;
+  if (framesFile != nullptr) {
+    fprintf(framesFile, "%lu,%u,%u,%u,%u,%u,%u,%u\n", millis() - startMillis,
+            frame.royalBlue, frame.blue, frame.uv, frame.violet, frame.red, frame.green, frame.white);
+  }
+}
+
+static void lightingLoop(unsigned long startMillis) {
+  uint32_t iteration = 0;
+  auto next = std::chrono::steady_clock::now();
+  while (running) {
+    if (iteration++ % (LIGHTING_UPDATE_INTERVAL / LOOP_INTERVAL_MS) == 0) {
+      ledController->update();
+    }
+    bool hadCommands = commandQueue.depth() > 0;
+    if (ledController->processCommands(commandQueue)) {
+      persistNotify.give();
+    }
+    if (hadCommands) {
+      networkNotify.give();
+    }
+    ledController->updatePreview();
+    captureFrame(startMillis);
+
+    // Periode tetap seperti vTaskDelayUntil
+    next += std::chrono::milliseconds(LOOP_INTERVAL_MS);
+    std::this_thread::sleep_until(next);
+  }
+}
+
+// Debounce seperti persistTaskMain; sisa stage ditulis saat berhenti
+static void persistLoop() {
+  while (running) {
+    uint32_t waitMs = ledController->stagedWriteDelay(millis());
+    if (waitMs == 0) {
+      ledController->writeStagedState();
+      continue;
+    }
+    persistNotify.take(waitMs < 100 ? waitMs : 100);
+  }
+  ledController->writeStagedState();
+}
+
+static void networkLoop() {
+  while (running) {
+    wifiService->update();
+    timeKeeper.update();
+    networkNotify.take(NETWORK_INTERVAL_MS);
+  }
+}
+
+int main(int argc, char** argv) {
+  uint16_t port = 8080;
+  const char* framesPath = nullptr;
+  Serial.enabled = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = (uint16_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      framesPath = argv[++i];
+    } else if (strcmp(argv[i], "--nvs-ms") == 0 && i + 1 < argc) {
+      store.writeDelayMs = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-v") == 0) {
+      Serial.enabled = true;
+    } else {
+      fprintf(stderr, "usage: %s [--port N] [--frames FILE] [--nvs-ms N] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (framesPath != nullptr) {
+    framesFile = fopen(framesPath, "w");
+    if (framesFile == nullptr) {
+      fprintf(stderr, "cannot write %s\n", framesPath);
+      return 1;
+    }
+    fprintf(framesFile, "t_ms,royalBlue,blue,uv,violet,red,green,white\n");
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  wallClock.adjust({2024, 1, 1, 12, 0, 0});
+  timeKeeper.begin(RTC_STATE_OK, {2024, 1, 1, 0, 0, 0});
+  ledController = new LedController(&pwm, &store, &timeKeeper);
+  ledController->begin();
+  healthLog.begin();
+  wifiService = new WiFiService(ledController, &commandQueue, AP_SSID, AP_PASSWORD, port);
+  wifiService->setHealth(&healthMonitor, &healthLog);
+  wifiService->setTimeKeeper(&timeKeeper);
+  wifiService->begin();
+
+  // Alokasi saat boot tidak dihitung sebagai pemakaian heap selama load test
+  nativeHeapResetBaseline();
+  unsigned long startMillis = millis();
+  fprintf(stderr, "listening on http://127.0.0.1:%u\n", port);
+
+  std::thread lighting(lightingLoop, startMillis);
+  std::thread persist(persistLoop);
+  std::thread network(networkLoop);
+
+  lighting.join();
+  persist.join();
+  network.join();
+
+  if (framesFile != nullptr) {
+    fclose(framesFile);
+  }
+  CommandQueueStats queueStats = commandQueue.stats();
+  fprintf(stderr, "frames %lu, commands applied %lu, rejected %lu, heap min free %lu of %lu bytes\n",
+          (unsigned long)frameCount, (unsigned long)queueStats.applied, (unsigned long)queueStats.rejected,
+          (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getHeapSize());
+  return 0;
+}
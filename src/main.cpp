@@ -2,9 +2,20 @@
 #include <Wire.h>
 #include <RTClib.h>
 #include <ArduinoJson.h>
-#include <esp_wifi.h>  // Untuk akses low-level WiFi API
 #include "LedController.h"
+#include "Esp32LightingHal.h"
 #include "WiFiService.h"
+#include "ControlCommand.h"
+#include "Metrics.h"
+#include "HealthMonitor.h"
+#include "HealthLog.h"
+#include "TimeKeeper.h"
+#include "BleService.h"
+#include "Trace.h"
+#include <esp_heap_caps.h>
+#include <esp_task_wdt.h>
+#include <esp_system.h>
+#include <atomic>
 
 // Pin definitions
 #define PIN_ROYAL_BLUE 25  // Royal Blue LED
@@ -28,179 +39,429 @@
 #define PWM_FREQ      5000  // Frequency in Hz
 #define PWM_RESOLUTION    8  // 8-bit resolution (0-255)
 
+// Lighting loop timing
+#define LIGHTING_UPDATE_INTERVAL 1000  // Update jadwal auto mode setiap 1 detik
+#define LOOP_INTERVAL_MS         5     // Periode lighting task: seberapa cepat command dari HTTP diterapkan
+#define NETWORK_INTERVAL_MS      10    // Periode network task (WiFiLink, SSE)
+
+// Task plan. Jaringan di core 0 (bersama stack WiFi/lwIP dan AsyncTCP), lampu di core 1.
+// Prioritas lighting di atas semua task aplikasi lain di core 1, jadi tick jadwal
+// hanya tertunda oleh ISR dan operasi flash (NVS menghentikan cache kedua core sesaat).
+//
+//   Task        Core  Prio  Stack   Isi
+//   lighting     1     5    6144    Log status awal, command, tick jadwal 1 s, recovery LEDC, reboot
+//   persist      1     1    4096    Tulis NVS yang di-stage oleh lighting task (debounce)
+//   network      0     2    8192    Init health log, WiFi dan BLE, WiFiLink, SSE, notify BLE, health monitor
+//   async_tcp    0     3    16384   Handler HTTP (library; core diset di platformio.ini)
+//   nimble_host  0    21    4096    Callback GATT BLE (library)
+//   wifi, tcpip  0    18+   -       ESP-IDF (controller BT juga di core 0)
+//   loopTask     1     1    8192    Hanya setup(); dihapus setelah semua task berjalan
+//
+// Network task dibangunkan oleh lighting task setelah command diterapkan, jadi hasil
+// BLE dan event SSE tidak menunggu sisa periode NETWORK_INTERVAL_MS.
+//
+// Logging: Serial memakai TX buffer driver UART (SERIAL_TX_BUFFER_SIZE), sehingga
+// print dari task mana pun kembali tanpa menunggu FIFO UART 128 byte kosong.
+#define LIGHTING_TASK_CORE      1
+#define LIGHTING_TASK_PRIORITY  5
+#define LIGHTING_TASK_STACK     6144
+#define PERSIST_TASK_CORE       1
+#define PERSIST_TASK_PRIORITY   1
+#define PERSIST_TASK_STACK      4096
+#define NETWORK_TASK_CORE       0
+#define NETWORK_TASK_PRIORITY   2
+#define NETWORK_TASK_STACK      8192
+#define SERIAL_TX_BUFFER_SIZE   2048
+
 // WiFi AP mode settings
 #define AP_SSID "SLAB-Aquarium-LED"
 #define AP_PASSWORD "12345678"
 
+// BLE GATT control service (nama sama dengan SSID; passkey dimasukkan saat pairing pertama)
+#define BLE_NAME    AP_SSID
+#define BLE_PASSKEY 123456
+
+// Pin dan channel per LedChannel (urutan field LightProfile)
+static const uint8_t LED_PINS[LED_CHANNEL_COUNT] = {
+  PIN_ROYAL_BLUE, PIN_BLUE, PIN_UV, PIN_VIOLET, PIN_RED, PIN_GREEN, PIN_WHITE
+};
+static const uint8_t LED_PWM_CHANNELS[LED_CHANNEL_COUNT] = {
+  CHANNEL_ROYAL_BLUE, CHANNEL_BLUE, CHANNEL_UV, CHANNEL_VIOLET, CHANNEL_RED, CHANNEL_GREEN, CHANNEL_WHITE
+};
+
 // Global objects
 RTC_DS3231 rtc;  // RTC instance
+Esp32PwmSink ledPwm(LED_PINS, LED_PWM_CHANNELS, PWM_FREQ, PWM_RESOLUTION);
+Esp32KeyValueStore ledStore;  // Namespace "led_ctrl"
+Ds3231Clock rtcClock(&rtc);
+EspTimerClock uptimeClock;
+Esp32KeyValueStore timeStore;  // Namespace "time"
+TimeKeeper timeKeeper(&rtcClock, &uptimeClock, &timeStore);  // RTC, atau uptime jika RTC gagal
 LedController* ledController;  // LED controller
 WiFiService* wifiService;  // WiFi service
+BleService* bleService;  // Kontrol lewat BLE GATT
+CommandQueue commandQueue;  // Command dari HTTP handler ke lighting loop
+HealthMonitor healthMonitor;  // Tren heap/stack -> recovery per subsistem
+HealthLog healthLog;  // Keputusan recovery, disimpan di NVS
+
+// Task handles (nullptr = task tidak berjalan, pekerjaannya dijalankan dari loop())
+TaskHandle_t lightingTask = nullptr;
+TaskHandle_t persistTask = nullptr;
+TaskHandle_t networkTask = nullptr;
+
+// Diminta oleh health monitor (network task), dijalankan oleh lighting task
+std::atomic<bool> lightingRecoveryRequested(false);
+std::atomic<bool> rebootRequested(false);
 
-// Flag to indicate if WiFi initialization was successful
-bool wifiInitialized = false;
+// Hasil outputMatches() terakhir, diperiksa oleh lighting task di antara dua penulisan
+std::atomic<bool> outputHealthy(true);
 
-// Function to initialize WiFi with retry
+// Sisa inisialisasi LedController (logging status awal). Output sudah benar sejak
+// setup(), jadi ini berjalan di awal lighting task, bukan sebelum task dibuat.
+static void initializeLighting() {
+  ledController->begin();
+  metrics.markBootPhase(BOOT_PHASE_CONTROLLER, micros());
+}
+
+// Start the WiFi service. AP dinyalakan bertahap oleh state machine di
+// wifiService->update(); tidak ada yang menunggu di sini.
 void initializeWiFi() {
-  int lastAttemptMillis = 0;
-  
-  for (int attempt = 0; attempt < 3; attempt++) {
-    Serial.print("WiFi initialization attempt ");
-    Serial.print(attempt + 1);
-    Serial.println("/3...");
-    
-    // Hard reset WiFi drivers pada percobaan ke-2 atau ke-3
-    if (attempt > 0) {
-      Serial.println("Resetting WiFi hardware more aggressively...");
-      WiFi.disconnect(true);
-      WiFi.mode(WIFI_OFF);
-      delay(1000);
-      
-      // Gunakan esp_wifi_* API untuk reset hardware yang lebih menyeluruh
-      esp_wifi_stop();
-      delay(500);
-      esp_wifi_deinit();
-      delay(1000);
-      esp_wifi_init(NULL);
-      delay(500);
-      esp_wifi_start();
-      delay(1000);
-    }
-    
-    // Create and initialize WiFi service in AP mode
-    wifiService = new WiFiService(ledController, AP_SSID, AP_PASSWORD);
-    wifiService->begin();
-    
-    // Wait longer for AP to initialize properly (progressively longer)
-    int waitTime = (attempt + 1) * 2000; // 2s, 4s, 6s untuk tiap percobaan
-    Serial.print("Waiting for WiFi startup (");
-    Serial.print(waitTime / 1000);
-    Serial.println(" seconds)...");
-    
-    for (int i = 0; i < waitTime / 500; i++) {
-      Serial.print(".");
-      delay(500);
-    }
-    Serial.println();
-    
-    // Polling beberapa kali untuk memastikan status
-    int successCount = 0;
-    for (int check = 0; check < 5; check++) {
-      if (wifiService->isConnected()) {
-        successCount++;
-      }
-      // Jeda antara polling
-      delay(300);
-    }
-    
-    // Hanya anggap berhasil jika 3+ polling berhasil (melindungi dari false positive)
-    if (successCount >= 3) {
-      wifiInitialized = true;
-      Serial.println("WiFi initialized successfully");
-      
-      IPAddress ip = wifiService->getIP();
-      Serial.print("AP IP Address: ");
-      Serial.println(ip);
-      
-      Serial.println("Connect to WiFi network named '" AP_SSID "' with password '" AP_PASSWORD "'");
-      Serial.println("Then access the control panel at http://" + ip.toString() + "/");
+  wifiService = new WiFiService(ledController, &commandQueue, AP_SSID, AP_PASSWORD);
+  wifiService->setHealth(&healthMonitor, &healthLog);
+  wifiService->setTimeKeeper(&timeKeeper);
+  wifiService->setBle(bleService);
+  wifiService->begin();
+  metrics.markBootPhase(BOOT_PHASE_NETWORK, micros());
+}
+
+// Stack BLE dimulai setelah HTTP, di network task (init controller ~100 ms)
+void initializeBle() {
+  if (!bleService->begin()) {
+    Serial.println("ERROR: BLE service not available, HTTP only");
+  }
+}
+
+// Reset yang mempertahankan RTC memory (bukan power-on atau brownout)
+static bool resetKeepsRtcMemory() {
+  esp_reset_reason_t reason = esp_reset_reason();
+  return reason == ESP_RST_SW || reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+         reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+}
+
+static void printBootTimeline() {
+  Serial.print("Boot timeline (ms since app start):");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    uint32_t us = metrics.bootPhaseUs[i].load(std::memory_order_relaxed);
+    if (us == 0) continue;
+    Serial.print(' ');
+    Serial.print(BOOT_PHASE_NAMES[i]);
+    Serial.print('=');
+    Serial.print(us / 1000.0, 1);
+  }
+  Serial.println();
+}
+
+static uint32_t stackFree(TaskHandle_t task) {
+  return task != nullptr ? uxTaskGetStackHighWaterMark(task) : 0;  // Byte di ESP32
+}
+
+// Dipanggil dari network step (wifiService sudah dibuat)
+static HealthSample sampleHealth() {
+  static TaskHandle_t asyncTcpTask = nullptr;
+  static TaskHandle_t bleHostTask = nullptr;
+  if (asyncTcpTask == nullptr) {
+    // Task AsyncTCP dibuat saat server pertama kali listen
+    asyncTcpTask = xTaskGetHandle("async_tcp");
+  }
+  if (bleHostTask == nullptr) {
+    bleHostTask = xTaskGetHandle("nimble_host");
+  }
+  
+  HealthSample sample;
+  sample.freeHeap = ESP.getFreeHeap();
+  sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  sample.stackFree[HEALTH_TASK_LIGHTING] = stackFree(lightingTask);
+  sample.stackFree[HEALTH_TASK_NETWORK] = uxTaskGetStackHighWaterMark(NULL);
+  sample.stackFree[HEALTH_TASK_ASYNC_TCP] = stackFree(asyncTcpTask);
+  sample.stackFree[HEALTH_TASK_PERSIST] = stackFree(persistTask);
+  sample.stackFree[HEALTH_TASK_BLE] = stackFree(bleHostTask);
+  sample.eventBacklog = wifiService->getEventBacklog();
+  sample.apUp = wifiService->isConnected();
+  sample.outputMatches = outputHealthy.load(std::memory_order_relaxed);
+  return sample;
+}
+
+// Ambil sampel, lalu jalankan tindakan yang diputuskan HealthMonitor.
+// Menggantikan restart harian dan restart per jam saat AP gagal: reboot hanya
+// jika restart subsistem tidak menolong.
+static void runHealthCheck() {
+  HealthSample sample = sampleHealth();
+  HealthDecision decision = healthMonitor.update(sample, millis());
+  
+  static HealthCondition reportedCondition = HEALTH_OK;
+  if (decision.condition != reportedCondition) {
+    reportedCondition = decision.condition;
+    Serial.print("Health: ");
+    Serial.println(HEALTH_CONDITION_NAMES[decision.condition]);
+  }
+  if (decision.action == HEALTH_ACTION_NONE) {
+    return;
+  }
+  
+  Serial.print("Health: ");
+  Serial.print(HEALTH_ACTION_NAMES[decision.action]);
+  Serial.print(" (");
+  Serial.print(HEALTH_CONDITION_NAMES[decision.condition]);
+  Serial.print("), free heap ");
+  Serial.print(sample.freeHeap);
+  Serial.print(", largest block ");
+  Serial.println(sample.largestBlock);
+  healthLog.record(decision, sample, millis() / 1000);
+  
+  switch (decision.action) {
+    case HEALTH_ACTION_RESTART_HTTP:
+      wifiService->restartHttpServer();
+      break;
+    case HEALTH_ACTION_RESTART_AP:
+      wifiService->restartAccessPoint();
+      break;
+    case HEALTH_ACTION_RESTART_LIGHTING:
+      // LEDC hanya disentuh oleh lighting task
+      lightingRecoveryRequested.store(true, std::memory_order_relaxed);
+      break;
+    case HEALTH_ACTION_REBOOT:
+      rebootRequested.store(true, std::memory_order_relaxed);
+      break;
+    default:
       break;
+  }
+}
+
+// Satu tick jadwal: update output dan catat durasi, jitter dan heap
+static void runLightingTick() {
+  static uint32_t lastTickStart = 0;
+  uint32_t tickStart = micros();
+  if (lastTickStart != 0) {
+    int32_t deviation = (int32_t)(tickStart - lastTickStart) - LIGHTING_UPDATE_INTERVAL * 1000L;
+    metrics.tickJitter.observe(deviation < 0 ? -deviation : deviation);
+  }
+  lastTickStart = tickStart;
+  
+  uint32_t heapBefore = ESP.getFreeHeap();
+  {
+    TRACE_SCOPE("lighting", "tick");
+    ledController->update();
+  }
+  metrics.tickDuration.observe(micros() - tickStart);
+  int32_t heapLost = (int32_t)(heapBefore - ESP.getFreeHeap());
+  metrics.tickHeap.observe(heapLost > 0 ? heapLost : 0);
+  
+  outputHealthy.store(ledController->outputMatches(), std::memory_order_relaxed);
+}
+
+// Satu iterasi lighting (setiap LOOP_INTERVAL_MS). Tick jadwal jatuh pada setiap
+// iterasi ke-N, jadi periodenya mengikuti tick FreeRTOS, bukan waktu kerja iterasi.
+static void lightingStep() {
+  static uint32_t iteration = 0;
+  if (iteration++ % (LIGHTING_UPDATE_INTERVAL / LOOP_INTERVAL_MS) == 0) {
+    runLightingTick();
+  }
+  
+  // Terapkan command dari HTTP/BLE secepatnya; NVS ditulis oleh persist task
+  bool hadCommands = commandQueue.depth() > 0;
+  if (ledController->processCommands(commandQueue)) {
+    if (persistTask != nullptr) {
+      xTaskNotifyGive(persistTask);
     } else {
-      Serial.print("WiFi initialization unstable (");
-      Serial.print(successCount);
-      Serial.println("/5 checks passed)");
-      delete wifiService;
-      wifiService = nullptr;
-      
-      // Wait longer before retry to give WiFi hardware waktu untuk reset sepenuhnya
-      Serial.println("Waiting for WiFi hardware to reset...");
-      delay(5000);
-      lastAttemptMillis = millis();
+      ledController->writeStagedState();
     }
   }
+  if (hadCommands && networkTask != nullptr) {
+    xTaskNotifyGive(networkTask);
+  }
+  
+  // Preview jadwal (POST /api/schedule/preview) berjalan per iterasi, bukan per tick
+  ledController->updatePreview();
+  
+  if (lightingRecoveryRequested.exchange(false, std::memory_order_relaxed)) {
+    ledController->recoverOutput();
+  }
+  
+  if (rebootRequested.load(std::memory_order_relaxed)) {
+    Serial.println("Restarting device...");
+    TRACE_INSTANT("system", "restart");
+    Serial.flush();
+    // Output LED ditahan selama reset, lihat prepareForRestart
+    ledController->prepareForRestart();
+    timeKeeper.save();
+    ESP.restart();
+  }
+}
+
+// Satu iterasi network: WiFi bring-up/recovery, housekeeping HTTP, SSE, health check
+static void networkStep() {
+  wifiService->update();
+  bleService->update();
+  timeKeeper.update();
+  
+  static bool timelinePrinted = false;
+  if (!timelinePrinted && wifiService->isConnected()) {
+    timelinePrinted = true;
+    printBootTimeline();
+  }
   
-  if (!wifiInitialized) {
-    Serial.println("WARNING: WiFi initialization failed after multiple attempts!");
-    Serial.println("LED controller will still function, but remote control won't be available.");
-    Serial.println("Device will auto-restart in 1 hour to try again.");
-    
-    // Catat waktu percobaan terakhir di memori global
-    lastAttemptMillis = millis();
+  static unsigned long lastHealthCheck = 0;
+  if (millis() - lastHealthCheck >= HEALTH_SAMPLE_INTERVAL_MS) {
+    lastHealthCheck = millis();
+    runHealthCheck();
+  }
+}
+
+static void lightingTaskMain(void* parameter) {
+  initializeLighting();
+  
+  // Lighting task yang macet direset oleh task watchdog; warm restart menjaga output
+  esp_task_wdt_add(NULL);
+  metrics.markBootPhase(BOOT_PHASE_LOOP, micros());
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    lightingStep();
+    esp_task_wdt_reset();
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(LOOP_INTERVAL_MS));
+  }
+}
+
+// Perubahan beruntun (slider) digabung: record ditulis setelah PERSIST_DEBOUNCE_MS
+// tanpa perubahan baru, paling lambat PERSIST_MAX_DELAY_MS setelah perubahan pertama
+static void persistTaskMain(void* parameter) {
+  for (;;) {
+    uint32_t waitMs = ledController->stagedWriteDelay(millis());
+    if (waitMs == 0) {
+      ledController->writeStagedState();
+      continue;
+    }
+    ulTaskNotifyTake(pdTRUE, waitMs == PERSIST_IDLE ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+  }
+}
+
+static void networkTaskMain(void* parameter) {
+  healthLog.begin();  // Dibaca NVS sebelum health monitor dan API memakainya
+  initializeWiFi();
+  initializeBle();
+  for (;;) {
+    networkStep();
+    // Bangun lebih awal jika lighting task baru menerapkan command
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NETWORK_INTERVAL_MS));
   }
 }
 
 void setup() {
-  // Start serial communication
+  metrics.markBootPhase(BOOT_PHASE_SETUP, micros());
+  
+  // Create LED controller instance (hanya menyimpan konfigurasi)
+  ledController = new LedController(&ledPwm, &ledStore, &timeKeeper);
+  
+  // Warm restart (ESP.restart, panic, watchdog): frame sebelum reset langsung dipakai lagi
+  bool warmOutput = ledController->restoreWarmOutput(resetKeepsRtcMemory());
+  if (warmOutput) {
+    metrics.markBootPhase(BOOT_PHASE_FIRST_FRAME, micros());
+  }
+  
+  // Start serial communication (TX buffer: print tidak memblokir task pemanggil)
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER_SIZE);
   Serial.begin(115200);
-  Serial.println("Initializing SLAB IoT Aquarium Controller...");
   
   // Initialize I2C communication for RTC
   Wire.begin();
   
-  // Initialize RTC
+  // RTC yang tidak ada atau kehilangan daya tidak menghentikan boot: TimeKeeper
+  // melanjutkan waktu terakhir yang diketahui dengan esp_timer sampai waktu diset
+  RtcState rtcState = RTC_STATE_OK;
   if (!rtc.begin()) {
-    Serial.println("Couldn't find RTC! Check wiring and try again.");
-    while (1);
+    rtcState = RTC_STATE_MISSING;
+  } else if (rtc.lostPower()) {
+    rtcState = RTC_STATE_LOST_POWER;
   }
+  DateTime built(F(__DATE__), F(__TIME__));
+  CommandTime buildTime = {built.year(), built.month(), built.day(), built.hour(), built.minute(), built.second()};
+  timeKeeper.begin(rtcState, buildTime);
+  metrics.markBootPhase(BOOT_PHASE_RTC, micros());
   
-  // Set RTC time if it was lost (e.g., when the battery was removed)
-  if (rtc.lostPower()) {
-    Serial.println("RTC lost power, setting time to compile time!");
-    // Following line sets the RTC to the date & time this sketch was compiled
-    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+  // Cold boot: output yang benar dari snapshot di NVS, sebelum logging dan jaringan.
+  // Setelah warm restart ini memuat mode/jadwal dan memperbarui frame bila perlu;
+  // first_frame tetap waktu frame warm di atas.
+  ledController->restoreOutput();
+  if (!warmOutput) {
+    metrics.markBootPhase(BOOT_PHASE_FIRST_FRAME, micros());
   }
   
-  // Create LED controller instance
-  ledController = new LedController(
-    PIN_ROYAL_BLUE, PIN_BLUE, PIN_UV, PIN_VIOLET, PIN_RED, PIN_GREEN, PIN_WHITE,
-    CHANNEL_ROYAL_BLUE, CHANNEL_BLUE, CHANNEL_UV, CHANNEL_VIOLET, CHANNEL_RED, CHANNEL_GREEN, CHANNEL_WHITE,
-    PWM_FREQ, PWM_RESOLUTION,
-    &rtc
-  );
+  Serial.println("Initializing SLAB IoT Aquarium Controller...");
+  if (rtcState == RTC_STATE_MISSING) {
+    Serial.println("Couldn't find RTC! Check wiring. Lights keep running on the last known time.");
+  } else if (rtcState == RTC_STATE_LOST_POWER) {
+    Serial.println("RTC lost power! Lights keep running on the last known time until the time is set.");
+  }
   
-  // Initialize LED controller
-  ledController->begin();
+  // LedController::begin() dan HealthLog::begin() berjalan di awal task masing-masing
+  bleService = new BleService(ledController, &commandQueue, BLE_NAME, BLE_PASSKEY);
   
-  // Initialize WiFi with retry
-  initializeWiFi();
+  // Task sesuai task plan di atas. Jika sebuah task gagal dibuat (heap habis),
+  // pekerjaannya dijalankan dari loop() seperti sebelumnya.
+  if (xTaskCreatePinnedToCore(persistTaskMain, "persist", PERSIST_TASK_STACK, NULL,
+                              PERSIST_TASK_PRIORITY, &persistTask, PERSIST_TASK_CORE) != pdPASS) {
+    persistTask = nullptr;
+    Serial.println("ERROR: Could not start persist task, writing NVS from the lighting loop");
+  }
+  if (xTaskCreatePinnedToCore(lightingTaskMain, "lighting", LIGHTING_TASK_STACK, NULL,
+                              LIGHTING_TASK_PRIORITY, &lightingTask, LIGHTING_TASK_CORE) != pdPASS) {
+    lightingTask = nullptr;
+    Serial.println("ERROR: Could not start lighting task, running it from loop()");
+    initializeLighting();
+    enableLoopWDT();
+  }
+  if (xTaskCreatePinnedToCore(networkTaskMain, "network", NETWORK_TASK_STACK, NULL,
+                              NETWORK_TASK_PRIORITY, &networkTask, NETWORK_TASK_CORE) != pdPASS) {
+    networkTask = nullptr;
+    Serial.println("ERROR: Could not start network task, running it from loop()");
+    healthLog.begin();
+    initializeWiFi();
+    initializeBle();
+  }
   
   // Print current time
-  DateTime now = rtc.now();
+  CommandTime now = timeKeeper.now();
   Serial.print("Current time: ");
-  Serial.print(now.year(), DEC);
+  Serial.print(now.year, DEC);
   Serial.print('/');
-  Serial.print(now.month(), DEC);
+  Serial.print(now.month, DEC);
   Serial.print('/');
-  Serial.print(now.day(), DEC);
+  Serial.print(now.day, DEC);
   Serial.print(' ');
-  Serial.print(now.hour(), DEC);
+  Serial.print(now.hour, DEC);
   Serial.print(':');
-  Serial.print(now.minute(), DEC);
+  Serial.print(now.minute, DEC);
   Serial.print(':');
-  Serial.print(now.second(), DEC);
+  Serial.print(now.second, DEC);
   Serial.println();
   
   Serial.println("Setup complete.");
 }
 
 void loop() {
-  // Update LED controller
-  ledController->update();
-  
-  // Update WiFi service if initialized
-  if (wifiInitialized && wifiService != nullptr) {
-    wifiService->update();
-  } else {
-    // Check if it's time to retry WiFi (every hour)
-    static unsigned long lastWiFiRetry = 0;
-    if (millis() - lastWiFiRetry > 3600000) { // 1 hour
-      lastWiFiRetry = millis();
-      Serial.println("Restarting device to retry WiFi initialization...");
-      delay(1000);
-      ESP.restart();
-    }
+  // Semua pekerjaan berjalan di task sendiri; loopTask tidak dibutuhkan lagi
+  if (lightingTask != nullptr && networkTask != nullptr) {
+    vTaskDelete(NULL);
+  }
+  
+  // Fallback jika task tidak bisa dibuat saat setup()
+  if (lightingTask == nullptr) {
+    metrics.markBootPhase(BOOT_PHASE_LOOP, micros());
+    lightingStep();
+  }
+  if (networkTask == nullptr) {
+    networkStep();
   }
   
   // Short delay to prevent overwhelming the system
-  delay(1000);
+  delay(LOOP_INTERVAL_MS);
 }
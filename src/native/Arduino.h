@@ -0,0 +1,164 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Arduino core subset for the native (Linux) build: Serial to stdout, the
+// timing functions, String, IPAddress and the ESP heap queries. Only on the
+// include path of the native environments; the firmware build uses the real
+// Arduino.h.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+
+inline unsigned long micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+  return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Arduino String on std::string, with the members the firmware uses
+class String {
+private:
+  std::string text;
+
+public:
+  String() {}
+  String(const char* value) : text(value != nullptr ? value : "") {}
+  String(const std::string& value) : text(value) {}
+
+  const char* c_str() const { return text.c_str(); }
+  size_t length() const { return text.size(); }
+  bool isEmpty() const { return text.empty(); }
+  bool equals(const char* other) const { return text == other; }
+  bool equals(const String& other) const { return text == other.text; }
+  bool equalsIgnoreCase(const String& other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+  bool operator==(const char* other) const { return equals(other); }
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator!=(const char* other) const { return !equals(other); }
+  long toInt() const { return strtol(text.c_str(), nullptr, 10); }
+
+  bool concat(const char* value) { text += value; return true; }
+  bool concat(const char* value, size_t length) { text.append(value, length); return true; }
+  bool concat(const String& value) { text += value.text; return true; }
+  String& operator+=(const char* value) { text += value; return *this; }
+  String& operator+=(const String& value) { text += value.text; return *this; }
+  String& operator+=(char value) { text += value; return *this; }
+};
+
+// IPv4 address; bytes in network order, like the ESP32 core
+class IPAddress {
+private:
+  uint8_t bytes[4];
+
+public:
+  IPAddress() : bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+  explicit IPAddress(uint32_t address) { memcpy(bytes, &address, 4); }
+
+  uint8_t operator[](int index) const { return bytes[index]; }
+  operator uint32_t() const { uint32_t address; memcpy(&address, bytes, 4); return address; }
+  bool operator==(const IPAddress& other) const { return memcmp(bytes, other.bytes, 4) == 0; }
+
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return String(text);
+  }
+};
+
+// Print/println overloads used by the firmware. Output can be switched off
+// (enabled = false) so a host program only shows its own results.
+class NativeSerial {
+private:
+  void number(unsigned long long value, int base, bool negative) {
+    if (!enabled) return;
+    if (base == HEX) {
+      fprintf(stdout, "%llX", value);
+    } else {
+      fprintf(stdout, negative ? "-%llu" : "%llu", value);
+    }
+  }
+
+public:
+  bool enabled = true;
+
+  void begin(unsigned long baud) { (void)baud; }
+
+  void print(const char* text) { if (enabled) fputs(text, stdout); }
+  void print(char c) { if (enabled) fputc(c, stdout); }
+  void print(unsigned char value, int base = DEC) { number(value, base, false); }
+  void print(int value, int base = DEC) { print((long)value, base); }
+  void print(unsigned int value, int base = DEC) { number(value, base, false); }
+  void print(unsigned long value, int base = DEC) { number(value, base, false); }
+  void print(long value, int base = DEC) {
+    if (value < 0 && base == DEC) {
+      number(0ULL - (unsigned long long)value, base, true);
+    } else {
+      number((unsigned long)value, base, false);
+    }
+  }
+  void print(double value, int digits = 2) { if (enabled) fprintf(stdout, "%.*f", digits, value); }
+  void print(const String& text) { print(text.c_str()); }
+  void print(const IPAddress& address) { print(address.toString()); }
+
+  template <typename T>
+  void println(T value) { print(value); println(); }
+  template <typename T>
+  void println(T value, int format) { print(value, format); println(); }
+  void println() { print("\n"); }
+
+  void printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    if (!enabled) return;
+    va_list args;
+    va_start(args, format);
+    vfprintf(stdout, format, args);
+    va_end(args);
+  }
+
+  void flush() { fflush(stdout); }
+};
+
+inline NativeSerial Serial;
+
+// Heap as seen by the firmware. Only linked where src/native/NativeHeap.cpp
+// is built: it counts every malloc in the process and reports the bytes in
+// use on top of a baseline as used from NATIVE_FREE_HEAP.
+#ifndef NATIVE_FREE_HEAP
+#define NATIVE_FREE_HEAP (200 * 1024)  // Typical free heap after boot with WiFi and BLE
+#endif
+
+uint32_t nativeHeapFree();
+uint32_t nativeHeapMinFree();
+void nativeHeapResetBaseline();
+
+class NativeEsp {
+public:
+  uint32_t getFreeHeap() { return nativeHeapFree(); }
+  uint32_t getMinFreeHeap() { return nativeHeapMinFree(); }
+  uint32_t getHeapSize() { return NATIVE_FREE_HEAP; }
+  uint32_t getCycleCount() { return (uint32_t)micros(); }
+};
+
+inline NativeEsp ESP;
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,48 @@
+#ifndef NATIVE_ASYNC_TCP_H
+#define NATIVE_ASYNC_TCP_H
+
+// AsyncClient subset for the native web server (ESPAsyncWebServer.h). One
+// event-loop thread plays the AsyncTCP task; write() only queues, like lwIP,
+// and the loop sends and reports the bytes as acknowledged.
+
+#include <Arduino.h>
+#include <mutex>
+#include <string>
+
+// lwIP TCP_SND_BUF in the ESP32 Arduino core
+#define NATIVE_TCP_SND_BUF  5744
+
+// AsyncTCP polls idle connections every 500 ms (lwIP tcp_poll interval 1)
+#define NATIVE_TCP_POLL_MS  500
+
+// Held by the event loop while it runs callbacks; other threads that touch
+// server objects (AsyncEventSource::send) take it too
+std::recursive_mutex& nativeAsyncLock();
+
+class AsyncClient {
+private:
+  friend class NativeHttpLoop;
+  int fd;
+  IPAddress remote;
+  std::string output;  // Written, not yet sent
+  bool closing;
+
+public:
+  AsyncClient(int fd, IPAddress remote) : fd(fd), remote(remote), closing(false) {}
+
+  IPAddress remoteIP() const { return remote; }
+  size_t space() const { return output.size() >= NATIVE_TCP_SND_BUF ? 0 : NATIVE_TCP_SND_BUF - output.size(); }
+  bool canSend() const { return space() > 0; }
+
+  size_t write(const char* data, size_t len) {
+    size_t accepted = len < space() ? len : space();
+    output.append(data, accepted);
+    return accepted;
+  }
+  size_t write(const char* data) { return write(data, strlen(data)); }
+
+  // Closed once the queued output is sent
+  void close() { closing = true; }
+};
+
+#endif // NATIVE_ASYNC_TCP_H
@@ -0,0 +1,783 @@
+// Loopback implementation of the ESPAsyncWebServer stand-in (see
+// ESPAsyncWebServer.h). A poll() loop on one thread accepts connections on
+// 127.0.0.1, parses HTTP/1.1 requests and drives the handlers and responses
+// the way the library does on top of AsyncTCP.
+
+#include <ESPAsyncWebServer.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#define NATIVE_HTTP_MAX_HEADER   8192  // Larger request heads are answered with 431
+#define NATIVE_HTTP_SEGMENT      1460  // Content written per step (one TCP segment)
+#define NATIVE_SSE_MAX_QUEUE     32    // AsyncEventSource drops messages beyond this
+
+std::recursive_mutex& nativeAsyncLock() {
+  static std::recursive_mutex lock;
+  return lock;
+}
+
+// ========== RESPONSES ==========
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+AsyncWebServerResponse::AsyncWebServerResponse() {
+  _code = 0;
+  _contentLength = 0;
+  _sendContentLength = true;
+  _chunked = false;
+  _headLength = 0;
+  _sentLength = 0;
+  _ackedLength = 0;
+  _writtenLength = 0;
+  _state = RESPONSE_SETUP;
+  _headOffset = 0;
+  _contentDone = false;
+  for (const AsyncWebHeader& header : DefaultHeaders::Instance().all()) {
+    _headers.push_back(header);
+  }
+}
+
+String AsyncWebServerResponse::_assembleHead(uint8_t version) {
+  char line[160];
+  snprintf(line, sizeof(line), "HTTP/1.%u %d %s\r\n", version, _code, statusText(_code));
+  String head(line);
+  if (_chunked) {
+    head += "Transfer-Encoding: chunked\r\n";
+  } else if (_sendContentLength) {
+    snprintf(line, sizeof(line), "Content-Length: %u\r\n", (unsigned)_contentLength);
+    head += line;
+  }
+  if (!_contentType.isEmpty()) {
+    head += "Content-Type: ";
+    head += _contentType;
+    head += "\r\n";
+  }
+  for (const AsyncWebHeader& header : _headers) {
+    head += header.name();
+    head += ": ";
+    head += header.value();
+    head += "\r\n";
+  }
+  head += "Connection: close\r\n\r\n";
+  _headLength = head.length();
+  return head;
+}
+
+void AsyncWebServerResponse::_respond(AsyncWebServerRequest* request) {
+  _head = _assembleHead(request->version());
+  _headOffset = 0;
+  _state = RESPONSE_HEADERS;
+  _pump(request);
+}
+
+// Schreibt so viel wie das Sendefenster zulässt; der Rest folgt beim nächsten ACK
+void AsyncWebServerResponse::_pump(AsyncWebServerRequest* request) {
+  AsyncClient* client = request->client();
+
+  if (_state == RESPONSE_HEADERS) {
+    size_t written = client->write(_head.c_str() + _headOffset, _head.length() - _headOffset);
+    _headOffset += written;
+    _writtenLength += written;
+    if (_headOffset < _head.length()) return;
+    _head = String();
+    _state = RESPONSE_CONTENT;
+  }
+
+  uint8_t buffer[NATIVE_HTTP_SEGMENT];
+  while (_state == RESPONSE_CONTENT) {
+    size_t space = client->space();
+    if (_chunked) {
+      // Platz für "<hex>\r\n" vor und "\r\n" nach den Daten
+      if (space <= 16) return;
+      size_t maxData = std::min(space - 16, (size_t)NATIVE_HTTP_SEGMENT);
+      size_t length = _fillBuffer(buffer, maxData);
+      char header[12];
+      if (length == 0) {
+        _writtenLength += client->write("0\r\n\r\n", 5);
+        _state = RESPONSE_WAIT_ACK;
+        break;
+      }
+      snprintf(header, sizeof(header), "%x\r\n", (unsigned)length);
+      _writtenLength += client->write(header, strlen(header));
+      _writtenLength += client->write((const char*)buffer, length);
+      _writtenLength += client->write("\r\n", 2);
+      _sentLength += length;
+    } else {
+      if (_sentLength >= _contentLength) {
+        _state = RESPONSE_WAIT_ACK;
+        break;
+      }
+      if (space == 0) return;
+      size_t maxData = std::min(std::min(space, (size_t)NATIVE_HTTP_SEGMENT), _contentLength - _sentLength);
+      size_t length = _fillBuffer(buffer, maxData);
+      if (length == 0) {
+        _state = RESPONSE_WAIT_ACK;  // Sumber habis sebelum Content-Length
+        break;
+      }
+      _writtenLength += client->write((const char*)buffer, length);
+      _sentLength += length;
+    }
+  }
+}
+
+size_t AsyncWebServerResponse::_ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+  (void)time;
+  _ackedLength += len;
+  if (_state == RESPONSE_HEADERS || _state == RESPONSE_CONTENT) {
+    _pump(request);
+  }
+  if (_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength) {
+    _state = RESPONSE_END;
+  }
+  return 0;
+}
+
+// Isi dari String (beginResponse) atau dari memori konstan (beginResponse_P)
+class NativeBasicResponse : public AsyncWebServerResponse {
+private:
+  String content;
+  const uint8_t* data;
+
+protected:
+  size_t _fillBuffer(uint8_t* buffer, size_t maxLen) override {
+    size_t length = std::min(maxLen, _contentLength - _sentLength);
+    memcpy(buffer, (data != nullptr ? data : (const uint8_t*)content.c_str()) + _sentLength, length);
+    return length;
+  }
+
+public:
+  NativeBasicResponse(int code, const char* contentType, const char* text, const uint8_t* data, size_t length)
+    : content(data == nullptr ? text : ""), data(data) {
+    _code = code;
+    _contentType = contentType;
+    _contentLength = data != nullptr ? length : content.length();
+  }
+
+  bool _sourceValid() const override { return true; }
+};
+
+class NativeChunkedResponse : public AsyncWebServerResponse {
+private:
+  AwsResponseFiller filler;
+
+protected:
+  size_t _fillBuffer(uint8_t* buffer, size_t maxLen) override {
+    return filler(buffer, maxLen, _sentLength);
+  }
+
+public:
+  NativeChunkedResponse(const char* contentType, AwsResponseFiller filler) : filler(filler) {
+    _code = 200;
+    _contentType = contentType;
+    _chunked = true;
+    _sendContentLength = false;
+  }
+
+  bool _sourceValid() const override { return true; }
+};
+
+// ========== REQUEST ==========
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client) {
+  _server = server;
+  _client = client;
+  _response = nullptr;
+  _method = HTTP_GET;
+  _contentLength = 0;
+  _tempObject = nullptr;
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  delete _response;
+  free(_tempObject);
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(const char* name) const {
+  for (const AsyncWebHeader& header : _headerList) {
+    if (strcasecmp(header.name().c_str(), name) == 0) return &header;
+  }
+  return nullptr;
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(size_t index) const {
+  return index < _headerList.size() ? &_headerList[index] : nullptr;
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(const char* name) const {
+  for (const AsyncWebParameter& param : _params) {
+    if (param.name() == name) return &param;
+  }
+  return nullptr;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+  if (_response != nullptr) {
+    delete response;  // Satu response per request, seperti library
+    return;
+  }
+  if (!response->_sourceValid()) {
+    delete response;
+    response = new NativeBasicResponse(500, "", "", nullptr, 0);
+  }
+  _response = response;
+  _response->_respond(this);
+}
+
+void AsyncWebServerRequest::send(int code, const char* contentType, const char* content) {
+  send(beginResponse(code, contentType, content));
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const char* contentType, const char* content) {
+  return new NativeBasicResponse(code, contentType, content, nullptr, 0);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const char* contentType,
+                                                               const uint8_t* content, size_t len) {
+  return new NativeBasicResponse(code, contentType, "", content, len);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const char* contentType, AwsResponseFiller callback) {
+  return new NativeChunkedResponse(contentType, callback);
+}
+
+// ========== SERVER-SENT EVENTS ==========
+
+static String formatEvent(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+  char line[32];
+  String text;
+  if (reconnect != 0) {
+    snprintf(line, sizeof(line), "retry: %lu\n", (unsigned long)reconnect);
+    text += line;
+  }
+  if (id != 0) {
+    snprintf(line, sizeof(line), "id: %lu\n", (unsigned long)id);
+    text += line;
+  }
+  if (event != nullptr) {
+    text += "event: ";
+    text += event;
+    text += "\n";
+  }
+  text += "data: ";
+  text += message;
+  text += "\n\n";
+  return text;
+}
+
+void AsyncEventSourceClient::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+  std::lock_guard<std::mutex> guard(queueLock);
+  if (queue.size() >= NATIVE_SSE_MAX_QUEUE) {
+    return;
+  }
+  queue.push_back(formatEvent(message, event, id, reconnect));
+}
+
+AsyncEventSource::~AsyncEventSource() {
+  for (AsyncEventSourceClient* client : clients) {
+    delete client;
+  }
+}
+
+void AsyncEventSource::close() {
+  std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+  for (AsyncEventSourceClient* client : clients) {
+    client->client->close();
+  }
+}
+
+void AsyncEventSource::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+  std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+  for (AsyncEventSourceClient* client : clients) {
+    client->send(message, event, id, reconnect);
+  }
+}
+
+size_t AsyncEventSource::count() const {
+  std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+  return clients.size();
+}
+
+size_t AsyncEventSource::avgPacketsWaiting() const {
+  std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+  if (clients.empty()) return 0;
+  size_t waiting = 0;
+  for (AsyncEventSourceClient* client : clients) {
+    waiting += client->packetsWaiting();
+  }
+  return (waiting + clients.size() - 1) / clients.size();
+}
+
+bool AsyncEventSource::canHandle(AsyncWebServerRequest* request) {
+  if (request->method() != HTTP_GET || !request->url().equals(url)) return false;
+  return !filter || filter(request);
+}
+
+void AsyncEventSource::handleRequest(AsyncWebServerRequest* request) {
+  AsyncClient* connection = request->client();
+  String head("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n");
+  for (const AsyncWebHeader& header : DefaultHeaders::Instance().all()) {
+    head += header.name();
+    head += ": ";
+    head += header.value();
+    head += "\r\n";
+  }
+  head += "Connection: keep-alive\r\n\r\n";
+  connection->write(head.c_str(), head.length());
+
+  AsyncEventSourceClient* client = new AsyncEventSourceClient(this, connection);
+  clients.push_back(client);
+  if (connectHandler) {
+    connectHandler(client);
+  }
+}
+
+void AsyncEventSource::_removeClient(AsyncClient* connection) {
+  for (size_t i = 0; i < clients.size(); i++) {
+    if (clients[i]->client == connection) {
+      if (disconnectHandler) {
+        disconnectHandler(clients[i]);
+      }
+      delete clients[i];
+      clients.erase(clients.begin() + i);
+      return;
+    }
+  }
+}
+
+// ========== EVENT LOOP ==========
+
+struct NativeConnection {
+  AsyncClient* client;
+  AsyncWebServerRequest* request;
+  AsyncWebHandler* handler;
+  std::string input;
+  bool headersDone;
+  bool requestDone;
+  bool stream;          // Diambil alih oleh AsyncEventSource
+  size_t bodyReceived;
+  unsigned long lastPoll;
+};
+
+class NativeHttpLoop {
+private:
+  AsyncWebServer* server;
+  int listener;
+  std::thread thread;
+  std::atomic<bool> running;
+  std::vector<NativeConnection*> connections;
+
+  void run();
+  void accept();
+  void receive(NativeConnection* connection);
+  void parseHead(NativeConnection* connection);
+  void parseQuery(AsyncWebServerRequest* request, const std::string& query);
+  void deliverBody(NativeConnection* connection, const char* data, size_t length);
+  void completeRequest(NativeConnection* connection);
+  void flushEvents(NativeConnection* connection);
+  void send(NativeConnection* connection);
+  void close(NativeConnection* connection);
+
+public:
+  explicit NativeHttpLoop(AsyncWebServer* server) : server(server), listener(-1), running(false) {}
+
+  bool start(uint16_t port);
+  void stop();
+};
+
+bool NativeHttpLoop::start(uint16_t port) {
+  listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+    fprintf(stderr, "web server: cannot listen on 127.0.0.1:%u (%s)\n", port, strerror(errno));
+    ::close(listener);
+    listener = -1;
+    return false;
+  }
+  running = true;
+  thread = std::thread([this]() { run(); });
+  return true;
+}
+
+void NativeHttpLoop::stop() {
+  if (!running) return;
+  running = false;
+  if (thread.joinable()) {
+    thread.join();
+  }
+  std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+  for (NativeConnection* connection : connections) {
+    close(connection);
+  }
+  connections.clear();
+  ::close(listener);
+  listener = -1;
+}
+
+void NativeHttpLoop::run() {
+  std::vector<pollfd> fds;
+  while (running) {
+    fds.clear();
+    fds.push_back({listener, POLLIN, 0});
+    {
+      std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+      for (NativeConnection* connection : connections) {
+        short events = POLLIN;
+        if (!connection->client->output.empty()) events |= POLLOUT;
+        fds.push_back({connection->client->fd, events, 0});
+      }
+    }
+    // Timeout pendek: pesan SSE dari thread lain dan poll 500 ms tetap berjalan
+    poll(fds.data(), fds.size(), 5);
+
+    std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+    if (fds[0].revents & POLLIN) {
+      accept();
+    }
+
+    unsigned long now = millis();
+    for (size_t i = 0; i < connections.size(); i++) {
+      NativeConnection* connection = connections[i];
+      if (i + 1 < fds.size() && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+        receive(connection);
+      }
+      AsyncWebServerRequest* request = connection->request;
+      AsyncWebServerResponse* response = request != nullptr ? request->_response : nullptr;
+
+      // Poll AsyncTCP: response yang belum bisa menulis dicoba lagi
+      if (now - connection->lastPoll >= NATIVE_TCP_POLL_MS) {
+        connection->lastPoll = now;
+        if (response != nullptr && !response->_finished() && connection->client->canSend()) {
+          response->_ack(request, 0, 0);
+        }
+      }
+      if (connection->stream) {
+        flushEvents(connection);
+      }
+      send(connection);
+      if (response != nullptr && response->_finished()) {
+        connection->client->close();
+      }
+    }
+
+    for (size_t i = 0; i < connections.size();) {
+      NativeConnection* connection = connections[i];
+      if (connection->client->closing && connection->client->output.empty()) {
+        close(connection);
+        connections.erase(connections.begin() + i);
+      } else {
+        i++;
+      }
+    }
+  }
+}
+
+void NativeHttpLoop::accept() {
+  for (;;) {
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    int fd = accept4(listener, (sockaddr*)&address, &length, SOCK_NONBLOCK);
+    if (fd < 0) return;
+    NativeConnection* connection = new NativeConnection();
+    connection->client = new AsyncClient(fd, IPAddress((uint32_t)address.sin_addr.s_addr));
+    connection->request = nullptr;
+    connection->handler = nullptr;
+    connection->headersDone = false;
+    connection->requestDone = false;
+    connection->stream = false;
+    connection->bodyReceived = 0;
+    connection->lastPoll = millis();
+    connections.push_back(connection);
+  }
+}
+
+void NativeHttpLoop::receive(NativeConnection* connection) {
+  char buffer[4096];
+  for (;;) {
+    ssize_t received = recv(connection->client->fd, buffer, sizeof(buffer), 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      // Client menutup koneksi: sisa output dibuang
+      connection->client->output.clear();
+      connection->client->closing = true;
+      return;
+    }
+    if (received < 0) return;
+    if (connection->requestDone) continue;  // Satu request per koneksi
+
+    if (!connection->headersDone) {
+      connection->input.append(buffer, received);
+      parseHead(connection);
+    } else {
+      deliverBody(connection, buffer, received);
+    }
+  }
+}
+
+static std::string urlDecode(const std::string& text) {
+  std::string decoded;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '+') {
+      decoded += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size()) {
+      decoded += (char)strtoul(text.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return decoded;
+}
+
+static WebRequestMethodComposite methodFromName(const std::string& name) {
+  if (name == "GET") return HTTP_GET;
+  if (name == "POST") return HTTP_POST;
+  if (name == "DELETE") return HTTP_DELETE;
+  if (name == "PUT") return HTTP_PUT;
+  if (name == "PATCH") return HTTP_PATCH;
+  if (name == "HEAD") return HTTP_HEAD;
+  if (name == "OPTIONS") return HTTP_OPTIONS;
+  return 0;
+}
+
+void NativeHttpLoop::parseHead(NativeConnection* connection) {
+  size_t end = connection->input.find("\r\n\r\n");
+  if (end == std::string::npos) {
+    if (connection->input.size() > NATIVE_HTTP_MAX_HEADER) {
+      connection->requestDone = true;
+      connection->client->write("HTTP/1.1 431 Request Header Fields Too Large\r\nConnection: close\r\n\r\n");
+      connection->client->close();
+    }
+    return;
+  }
+
+  AsyncWebServerRequest* request = new AsyncWebServerRequest(server, connection->client);
+  connection->request = request;
+  connection->headersDone = true;
+
+  std::string head = connection->input.substr(0, end);
+  std::string body = connection->input.substr(end + 4);
+  connection->input.clear();
+
+  size_t lineEnd = head.find("\r\n");
+  std::string requestLine = head.substr(0, lineEnd);
+  size_t firstSpace = requestLine.find(' ');
+  size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+  request->_method = methodFromName(requestLine.substr(0, firstSpace));
+  std::string url = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+  size_t query = url.find('?');
+  request->_url = String(url.substr(0, query));
+  if (query != std::string::npos) {
+    parseQuery(request, url.substr(query + 1));
+  }
+
+  size_t position = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+  while (position < head.size()) {
+    size_t next = head.find("\r\n", position);
+    if (next == std::string::npos) next = head.size();
+    std::string line = head.substr(position, next - position);
+    size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+      std::string name = line.substr(0, colon);
+      size_t valueStart = line.find_first_not_of(' ', colon + 1);
+      std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+      request->_headerList.emplace_back(String(name), String(value));
+      if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+        request->_contentLength = strtoul(value.c_str(), nullptr, 10);
+      }
+    }
+    position = next + 2;
+  }
+
+  // Handler dipilih setelah header, sebelum body (sama dengan library)
+  for (AsyncWebHandler* handler : server->getHandlers()) {
+    if (handler->canHandle(request)) {
+      connection->handler = handler;
+      break;
+    }
+  }
+
+  if (request->_contentLength == 0) {
+    completeRequest(connection);
+  } else if (!body.empty()) {
+    deliverBody(connection, body.data(), body.size());
+  }
+}
+
+void NativeHttpLoop::parseQuery(AsyncWebServerRequest* request, const std::string& query) {
+  size_t position = 0;
+  while (position <= query.size()) {
+    size_t end = query.find('&', position);
+    if (end == std::string::npos) end = query.size();
+    std::string pair = query.substr(position, end - position);
+    if (!pair.empty()) {
+      size_t equals = pair.find('=');
+      std::string name = urlDecode(pair.substr(0, equals));
+      std::string value = equals == std::string::npos ? "" : urlDecode(pair.substr(equals + 1));
+      request->_params.emplace_back(String(name), String(value));
+    }
+    position = end + 1;
+  }
+}
+
+void NativeHttpLoop::deliverBody(NativeConnection* connection, const char* data, size_t length) {
+  AsyncWebServerRequest* request = connection->request;
+  size_t total = request->_contentLength;
+  if (connection->bodyReceived + length > total) {
+    length = total - connection->bodyReceived;
+  }
+  if (length > 0 && connection->handler != nullptr) {
+    std::string piece(data, length);  // handleBody() boleh menulis ke data
+    connection->handler->handleBody(request, (uint8_t*)&piece[0], length, connection->bodyReceived, total);
+  }
+  connection->bodyReceived += length;
+  if (connection->bodyReceived >= total) {
+    completeRequest(connection);
+  }
+}
+
+void NativeHttpLoop::completeRequest(NativeConnection* connection) {
+  connection->requestDone = true;
+  AsyncWebServerRequest* request = connection->request;
+  if (connection->handler != nullptr) {
+    connection->handler->handleRequest(request);
+  } else {
+    server->handleNotFound(request);
+  }
+
+  // AsyncEventSource mengambil alih koneksi: tetap terbuka tanpa request
+  for (AsyncWebHandler* handler : server->getHandlers()) {
+    AsyncEventSource* source = dynamic_cast<AsyncEventSource*>(handler);
+    if (source == nullptr) continue;
+    for (AsyncEventSourceClient* client : source->clients) {
+      if (client->client == connection->client) {
+        connection->stream = true;
+      }
+    }
+  }
+  if (connection->stream) {
+    if (request->_onDisconnect) {
+      request->_onDisconnect();
+    }
+    delete request;
+    connection->request = nullptr;
+  }
+}
+
+void NativeHttpLoop::flushEvents(NativeConnection* connection) {
+  for (AsyncWebHandler* handler : server->getHandlers()) {
+    AsyncEventSource* source = dynamic_cast<AsyncEventSource*>(handler);
+    if (source == nullptr) continue;
+    for (AsyncEventSourceClient* client : source->clients) {
+      if (client->client != connection->client) continue;
+      std::lock_guard<std::mutex> guard(client->queueLock);
+      while (!client->queue.empty() && client->queue.front().length() <= connection->client->space()) {
+        connection->client->write(client->queue.front().c_str(), client->queue.front().length());
+        client->queue.erase(client->queue.begin());
+      }
+    }
+  }
+}
+
+void NativeHttpLoop::send(NativeConnection* connection) {
+  AsyncClient* client = connection->client;
+  if (client->output.empty()) return;
+  ssize_t sent = ::send(client->fd, client->output.data(), client->output.size(), MSG_NOSIGNAL);
+  if (sent < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      client->output.clear();
+      client->closing = true;
+    }
+    return;
+  }
+  client->output.erase(0, sent);
+  // Byte yang diterima kernel dianggap sudah di-ACK
+  AsyncWebServerRequest* request = connection->request;
+  if (request != nullptr && request->_response != nullptr && sent > 0) {
+    request->_response->_ack(request, sent, millis());
+  }
+}
+
+void NativeHttpLoop::close(NativeConnection* connection) {
+  if (connection->request != nullptr) {
+    if (connection->request->_onDisconnect) {
+      connection->request->_onDisconnect();
+    }
+    delete connection->request;
+  }
+  if (connection->stream) {
+    for (AsyncWebHandler* handler : server->getHandlers()) {
+      AsyncEventSource* source = dynamic_cast<AsyncEventSource*>(handler);
+      if (source != nullptr) source->_removeClient(connection->client);
+    }
+  }
+  ::close(connection->client->fd);
+  delete connection->client;
+  delete connection;
+}
+
+// ========== SERVER ==========
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : port(port), loop(nullptr) {}
+
+AsyncWebServer::~AsyncWebServer() {
+  end();
+  delete loop;
+  for (AsyncWebHandler* handler : handlers) {
+    delete handler;
+  }
+}
+
+void AsyncWebServer::begin() {
+  if (loop == nullptr) {
+    loop = new NativeHttpLoop(this);
+  }
+  loop->start(port);
+}
+
+void AsyncWebServer::end() {
+  if (loop != nullptr) {
+    loop->stop();
+  }
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+  std::lock_guard<std::recursive_mutex> guard(nativeAsyncLock());
+  handlers.push_back(handler);
+  return *handler;
+}
+
+void AsyncWebServer::handleNotFound(AsyncWebServerRequest* request) {
+  if (notFound) {
+    notFound(request);
+  } else {
+    request->send(404);
+  }
+}
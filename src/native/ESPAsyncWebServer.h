@@ -0,0 +1,265 @@
+#ifndef NATIVE_ESP_ASYNC_WEB_SERVER_H
+#define NATIVE_ESP_ASYNC_WEB_SERVER_H
+
+// Loopback stand-in for ESPAsyncWebServer, enough to run WiFiService on
+// Linux ([env:native-http]). It keeps the parts of the library's behaviour
+// that matter for load tests:
+//   - one thread runs every handler, body callback and response (AsyncTCP)
+//   - handlers are tried in registration order, canHandle() after the
+//     headers, handleBody() per received piece, then handleRequest()
+//   - responses are written into a 5744-byte send window and continued on
+//     each acknowledgement; a response that has nothing to send is polled
+//     every 500 ms
+//   - one request per connection ("Connection: close")
+//   - AsyncEventSource with per-client message queues
+// Only the members the firmware uses are provided.
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+typedef uint8_t WebRequestMethodComposite;
+
+enum WebRequestMethod : uint8_t {
+  HTTP_GET     = 0b00000001,
+  HTTP_POST    = 0b00000010,
+  HTTP_DELETE  = 0b00000100,
+  HTTP_PUT     = 0b00001000,
+  HTTP_PATCH   = 0b00010000,
+  HTTP_HEAD    = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY     = 0b01111111
+};
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncEventSourceClient;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<void()> ArDisconnectHandler;
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebHeader {
+private:
+  String headerName;
+  String headerValue;
+
+public:
+  AsyncWebHeader(const String& name, const String& value) : headerName(name), headerValue(value) {}
+  const String& name() const { return headerName; }
+  const String& value() const { return headerValue; }
+};
+
+// Query string parameter (?name=value)
+class AsyncWebParameter {
+private:
+  String paramName;
+  String paramValue;
+
+public:
+  AsyncWebParameter(const String& name, const String& value) : paramName(name), paramValue(value) {}
+  const String& name() const { return paramName; }
+  const String& value() const { return paramValue; }
+};
+
+// Headers added to every response
+class DefaultHeaders {
+private:
+  std::vector<AsyncWebHeader> headers;
+  DefaultHeaders() {}
+
+public:
+  static DefaultHeaders& Instance() {
+    static DefaultHeaders instance;
+    return instance;
+  }
+  void addHeader(const String& name, const String& value) { headers.emplace_back(name, value); }
+  const std::vector<AsyncWebHeader>& all() const { return headers; }
+};
+
+enum WebResponseState : uint8_t {
+  RESPONSE_SETUP,
+  RESPONSE_HEADERS,
+  RESPONSE_CONTENT,
+  RESPONSE_WAIT_ACK,
+  RESPONSE_END,
+  RESPONSE_FAILED
+};
+
+// Base response. Subclasses either provide content through _fillBuffer()
+// (basic, PROGMEM and chunked responses) or override _respond()/_ack() and
+// write to the client themselves, as the library allows.
+class AsyncWebServerResponse {
+protected:
+  int _code;
+  std::vector<AsyncWebHeader> _headers;
+  String _contentType;
+  size_t _contentLength;
+  bool _sendContentLength;
+  bool _chunked;
+  size_t _headLength;
+  size_t _sentLength;
+  size_t _ackedLength;
+  size_t _writtenLength;
+  WebResponseState _state;
+  String _head;          // Assembled head not yet written
+  size_t _headOffset;
+  bool _contentDone;
+
+  virtual size_t _fillBuffer(uint8_t* buffer, size_t maxLen) { (void)buffer; (void)maxLen; return 0; }
+  void _pump(AsyncWebServerRequest* request);
+
+public:
+  AsyncWebServerResponse();
+  virtual ~AsyncWebServerResponse() {}
+
+  void setCode(int code) { _code = code; }
+  void setContentLength(size_t len) { _contentLength = len; }
+  void setContentType(const String& type) { _contentType = type; }
+  void addHeader(const String& name, const String& value) { _headers.emplace_back(name, value); }
+
+  String _assembleHead(uint8_t version);
+  int getCode() const { return _code; }
+  bool _started() const { return _state > RESPONSE_SETUP; }
+  bool _finished() const { return _state > RESPONSE_WAIT_ACK; }
+  bool _failed() const { return _state == RESPONSE_FAILED; }
+
+  virtual bool _sourceValid() const { return false; }
+  virtual void _respond(AsyncWebServerRequest* request);
+  virtual size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time);
+};
+
+class AsyncWebServerRequest {
+private:
+  friend class NativeHttpLoop;
+  AsyncClient* _client;
+  AsyncWebServer* _server;
+  AsyncWebServerResponse* _response;
+  String _url;
+  WebRequestMethodComposite _method;
+  size_t _contentLength;
+  std::vector<AsyncWebHeader> _headerList;
+  std::vector<AsyncWebParameter> _params;
+  ArDisconnectHandler _onDisconnect;
+
+public:
+  void* _tempObject;  // Freed with free() when the request ends
+
+  AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client);
+  ~AsyncWebServerRequest();
+
+  AsyncClient* client() { return _client; }
+  uint8_t version() const { return 1; }  // HTTP/1.1
+  WebRequestMethodComposite method() const { return _method; }
+  const String& url() const { return _url; }
+  size_t contentLength() const { return _contentLength; }
+
+  int headers() const { return (int)_headerList.size(); }
+  const AsyncWebHeader* getHeader(const char* name) const;
+  const AsyncWebHeader* getHeader(size_t index) const;
+  void addInterestingHeader(const char* name) { (void)name; }  // All headers are kept
+
+  bool hasParam(const char* name) const { return getParam(name) != nullptr; }
+  const AsyncWebParameter* getParam(const char* name) const;
+
+  // One handler per request; a later call replaces the earlier one
+  void onDisconnect(ArDisconnectHandler handler) { _onDisconnect = handler; }
+
+  void send(AsyncWebServerResponse* response);
+  void send(int code, const char* contentType = "", const char* content = "");
+  void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content.c_str()); }
+
+  AsyncWebServerResponse* beginResponse(int code, const char* contentType = "", const char* content = "");
+  AsyncWebServerResponse* beginResponse_P(int code, const char* contentType, const uint8_t* content, size_t len);
+  AsyncWebServerResponse* beginChunkedResponse(const char* contentType, AwsResponseFiller callback);
+};
+
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() {}
+  virtual bool canHandle(AsyncWebServerRequest* request) { (void)request; return false; }
+  virtual void handleRequest(AsyncWebServerRequest* request) { (void)request; }
+  virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    (void)request; (void)data; (void)len; (void)index; (void)total;
+  }
+  virtual bool isRequestHandlerTrivial() { return true; }
+};
+
+class AsyncEventSource;
+
+class AsyncEventSourceClient {
+private:
+  friend class AsyncEventSource;
+  friend class NativeHttpLoop;
+  AsyncEventSource* source;
+  AsyncClient* client;
+  std::vector<String> queue;  // Messages not yet written to the client
+  mutable std::mutex queueLock;
+
+public:
+  AsyncEventSourceClient(AsyncEventSource* source, AsyncClient* client) : source(source), client(client) {}
+
+  void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0);
+  size_t packetsWaiting() const {
+    std::lock_guard<std::mutex> guard(queueLock);
+    return queue.size();
+  }
+};
+
+// Server-Sent Events endpoint. send() may be called from any thread.
+class AsyncEventSource : public AsyncWebHandler {
+private:
+  friend class NativeHttpLoop;
+  String url;
+  std::vector<AsyncEventSourceClient*> clients;
+  ArEventHandlerFunction connectHandler;
+  ArEventHandlerFunction disconnectHandler;
+  ArRequestFilterFunction filter;
+
+public:
+  explicit AsyncEventSource(const String& url) : url(url) {}
+  ~AsyncEventSource();
+
+  void onConnect(ArEventHandlerFunction handler) { connectHandler = handler; }
+  // Called before the client is deleted
+  void onDisconnect(ArEventHandlerFunction handler) { disconnectHandler = handler; }
+  void setFilter(ArRequestFilterFunction fn) { filter = fn; }
+  void close();
+  void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0);
+  size_t count() const;
+  size_t avgPacketsWaiting() const;
+
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+
+  void _removeClient(AsyncClient* client);
+};
+
+class NativeHttpLoop;
+
+class AsyncWebServer {
+private:
+  uint16_t port;
+  std::vector<AsyncWebHandler*> handlers;
+  ArRequestHandlerFunction notFound;
+  NativeHttpLoop* loop;
+
+public:
+  explicit AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+
+  void begin();
+  void end();
+  AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+  void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+
+  // Stand-in only: used by the event loop
+  const std::vector<AsyncWebHandler*>& getHandlers() const { return handlers; }
+  void handleNotFound(AsyncWebServerRequest* request);
+};
+
+#endif // NATIVE_ESP_ASYNC_WEB_SERVER_H
@@ -0,0 +1,78 @@
+// Heap accounting for the native builds that report ESP.getFreeHeap().
+// malloc/free/realloc/calloc are interposed (glibc __libc_* underneath), so
+// operator new, the firmware's own malloc calls and the web server stand-in
+// are all counted. "Free heap" is NATIVE_FREE_HEAP minus the bytes in use
+// above the baseline, and the low-water mark follows every allocation, like
+// the ESP-IDF minimum free heap.
+
+#include <Arduino.h>
+#include <malloc.h>
+#include <atomic>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+static std::atomic<int64_t> inUse(0);
+static std::atomic<int64_t> baseline(0);
+static std::atomic<int64_t> peakInUse(0);
+
+static void account(int64_t delta) {
+  int64_t now = inUse.fetch_add(delta, std::memory_order_relaxed) + delta;
+  int64_t peak = peakInUse.load(std::memory_order_relaxed);
+  while (now > peak && !peakInUse.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+  }
+}
+
+extern "C" void* malloc(size_t size) {
+  void* ptr = __libc_malloc(size);
+  if (ptr != nullptr) account((int64_t)malloc_usable_size(ptr));
+  return ptr;
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  void* ptr = __libc_calloc(count, size);
+  if (ptr != nullptr) account((int64_t)malloc_usable_size(ptr));
+  return ptr;
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+  int64_t before = ptr != nullptr ? (int64_t)malloc_usable_size(ptr) : 0;
+  void* grown = __libc_realloc(ptr, size);
+  if (grown != nullptr) {
+    account((int64_t)malloc_usable_size(grown) - before);
+  } else if (size == 0) {
+    account(-before);
+  }
+  return grown;
+}
+
+extern "C" void free(void* ptr) {
+  if (ptr == nullptr) return;
+  account(-(int64_t)malloc_usable_size(ptr));
+  __libc_free(ptr);
+}
+
+static uint32_t freeFor(int64_t used) {
+  int64_t held = used - baseline.load(std::memory_order_relaxed);
+  if (held < 0) held = 0;
+  return held >= NATIVE_FREE_HEAP ? 0 : (uint32_t)(NATIVE_FREE_HEAP - held);
+}
+
+uint32_t nativeHeapFree() {
+  return freeFor(inUse.load(std::memory_order_relaxed));
+}
+
+uint32_t nativeHeapMinFree() {
+  return freeFor(peakInUse.load(std::memory_order_relaxed));
+}
+
+// Start of the measured run: what is allocated now counts as "before boot"
+void nativeHeapResetBaseline() {
+  int64_t now = inUse.load(std::memory_order_relaxed);
+  baseline.store(now, std::memory_order_relaxed);
+  peakInUse.store(now, std::memory_order_relaxed);
+}
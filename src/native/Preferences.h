@@ -0,0 +1,81 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+// In-memory Preferences for the native build (HealthLog, WiFiService).
+// Namespaces live for the life of the process.
+
+#include <Arduino.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Preferences {
+private:
+  std::string prefix;
+  bool opened = false;
+
+  static std::map<std::string, std::vector<uint8_t>>& entries() {
+    static std::map<std::string, std::vector<uint8_t>> values;
+    return values;
+  }
+  static std::mutex& lock() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  size_t put(const char* key, const void* value, size_t len) {
+    if (!opened) return 0;
+    std::lock_guard<std::mutex> guard(lock());
+    const uint8_t* bytes = (const uint8_t*)value;
+    entries()[prefix + key].assign(bytes, bytes + len);
+    return len;
+  }
+  const std::vector<uint8_t>* find(const char* key) {
+    auto it = entries().find(prefix + key);
+    return it == entries().end() ? nullptr : &it->second;
+  }
+
+public:
+  bool begin(const char* name, bool readOnly = false) {
+    (void)readOnly;
+    prefix = std::string(name) + "/";
+    opened = true;
+    return true;
+  }
+  void end() { opened = false; }
+
+  bool isKey(const char* key) {
+    std::lock_guard<std::mutex> guard(lock());
+    return opened && find(key) != nullptr;
+  }
+  bool remove(const char* key) {
+    std::lock_guard<std::mutex> guard(lock());
+    return opened && entries().erase(prefix + key) > 0;
+  }
+
+  size_t getBytesLength(const char* key) {
+    std::lock_guard<std::mutex> guard(lock());
+    const std::vector<uint8_t>* value = opened ? find(key) : nullptr;
+    return value != nullptr ? value->size() : 0;
+  }
+  size_t getBytes(const char* key, void* buffer, size_t maxLen) {
+    std::lock_guard<std::mutex> guard(lock());
+    const std::vector<uint8_t>* value = opened ? find(key) : nullptr;
+    if (value == nullptr || value->size() > maxLen) return 0;
+    memcpy(buffer, value->data(), value->size());
+    return value->size();
+  }
+  size_t putBytes(const char* key, const void* value, size_t len) { return put(key, value, len); }
+
+  bool getBool(const char* key, bool defaultValue = false) {
+    uint8_t value;
+    return getBytes(key, &value, 1) == 1 ? value != 0 : defaultValue;
+  }
+  size_t putBool(const char* key, bool value) {
+    uint8_t byte = value ? 1 : 0;
+    return put(key, &byte, 1);
+  }
+};
+
+#endif // NATIVE_PREFERENCES_H
@@ -0,0 +1,24 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+// WiFi class subset for the native build of WiFiService. The access point
+// itself is SimulatedWiFiDriver; this only answers the address queries.
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class NativeWiFi {
+public:
+  wl_status_t status() { return WL_DISCONNECTED; }
+  IPAddress localIP() { return IPAddress(); }
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+};
+
+inline NativeWiFi WiFi;
+
+#endif // NATIVE_WIFI_H
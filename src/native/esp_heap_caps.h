@@ -0,0 +1,16 @@
+#ifndef NATIVE_ESP_HEAP_CAPS_H
+#define NATIVE_ESP_HEAP_CAPS_H
+
+// heap_caps_* on the native heap accounting (NativeHeap.cpp). There is no
+// fragmentation on the host, so the largest block is the free heap.
+
+#include <Arduino.h>
+
+#define MALLOC_CAP_8BIT    (1 << 2)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline size_t heap_caps_get_free_size(uint32_t caps) { (void)caps; return nativeHeapFree(); }
+inline size_t heap_caps_get_total_size(uint32_t caps) { (void)caps; return NATIVE_FREE_HEAP; }
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { (void)caps; return nativeHeapFree(); }
+
+#endif // NATIVE_ESP_HEAP_CAPS_H
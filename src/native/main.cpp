@@ -0,0 +1,667 @@
+// Native (Linux) driver for LedController and the JSON/binary API parsing.
+// Reads one command per line from a script file or stdin and prints the
+// result, using the in-memory HAL from SimulatedLightingHal.h:
+//
+//   GET /api/mode                         API requests, same routes and
+//   POST /api/mode {"mode":"manual"}      bodies as the firmware
+//   PATCH /api/schedule/hourly {...}
+//   POST /api/command 0301                Binary command (hex)
+//   GET /api/trace                        Trace ring (-DTRACE_ENABLED=1)
+//   clock 2024-06-01 06:30:00             Set the wall clock
+//   advance 90                            Move the clock (seconds) and tick
+//   rtc fail|ok|lostpower                 RTC stops answering, answers again,
+//                                         or loses its time (battery removed)
+//   rtc rate 5                            RTC oscillator runs 5 ppm fast
+//   sync 250 8                            8 POST /api/time/sync exchanges from a
+//                                         client 250 ms ahead (later: "sync" on
+//                                         the same client clock)
+//   settime                               POST /api/time from the sync client's
+//                                         clock, on its next whole second
+//   tick                                  One lighting tick (update())
+//   simulate 60 day.csv                   Whole day of the current schedule,
+//                                         a frame every 60 s (.bin = binary)
+//   pwm                                   Duty of each channel
+//   nvs                                   Stored keys and write count
+//   wear                                  NVS writes per key (NvsWear)
+//   wear metrics.txt 5                    Flash wear over 5 years at the write
+//                                         rates in a /api/metrics scrape
+//   reboot [warm]                         New controller on the same NVS
+//
+//   pio run -e native && .pio/build/native/program [-v] [script]
+//
+// -v shows the firmware's Serial output. Lines starting with # are skipped.
+//
+// Left out of `pio test -e native` builds (the Unity runner in test/ has its
+// own main()).
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <memory>
+#include "LedController.h"
+#include "ControlCommand.h"
+#include "CommandCodec.h"
+#include "ApiRequests.h"
+#include "ApiRouter.h"
+#include "SimulatedLightingHal.h"
+#include "Trace.h"
+#include "ScheduleSimulator.h"
+#include "NvsWear.h"
+#include "SimulatedNvsFlash.h"
+#include "TimeKeeper.h"
+
+#define LINE_MAX_SIZE   8192
+
+// Page-model run length for "wear"; longer periods are extrapolated
+#define WEAR_MAX_SIMULATED_WRITES 5000000
+
+enum NativeRouteId : uint8_t {
+  NATIVE_MANUAL,
+  NATIVE_MANUAL_ALL,
+  NATIVE_TIME_GET,
+  NATIVE_TIME_SET,
+  NATIVE_TIME_SYNC,
+  NATIVE_MODE_GET,
+  NATIVE_MODE_SET,
+  NATIVE_SCHEDULE_GET,
+  NATIVE_SCHEDULE_SET,
+  NATIVE_SCHEDULE_PATCH,
+  NATIVE_HOUR_GET,
+  NATIVE_HOUR_SET,
+  NATIVE_BATCH,
+  NATIVE_COMMAND,
+  NATIVE_TRACE
+};
+
+// Route yang diproses tanpa WiFi (subset tabel API_ROUTES di WiFiService.cpp)
+static constexpr ApiRoute NATIVE_ROUTES[] = {
+  {"/api/manual",                 ROUTE_POST,  NATIVE_MANUAL},
+  {"/api/manual/all",             ROUTE_POST,  NATIVE_MANUAL_ALL},
+  {"/api/time",                   ROUTE_GET,   NATIVE_TIME_GET},
+  {"/api/time",                   ROUTE_POST,  NATIVE_TIME_SET},
+  {"/api/time/sync",              ROUTE_POST,  NATIVE_TIME_SYNC},
+  {"/api/mode",                   ROUTE_GET,   NATIVE_MODE_GET},
+  {"/api/mode",                   ROUTE_POST,  NATIVE_MODE_SET},
+  {"/api/schedule/hourly",        ROUTE_GET,   NATIVE_SCHEDULE_GET},
+  {"/api/schedule/hourly",        ROUTE_POST,  NATIVE_SCHEDULE_SET},
+  {"/api/schedule/hourly",        ROUTE_PATCH, NATIVE_SCHEDULE_PATCH},
+  {"/api/schedule/hourly/{hour}", ROUTE_GET,   NATIVE_HOUR_GET},
+  {"/api/schedule/hourly/{hour}", ROUTE_POST,  NATIVE_HOUR_SET},
+  {"/api/batch",                  ROUTE_POST,  NATIVE_BATCH},
+  {"/api/command",                ROUTE_POST,  NATIVE_COMMAND},
+  {"/api/trace",                  ROUTE_GET,   NATIVE_TRACE},
+};
+static_assert(routeTableValid(NATIVE_ROUTES, sizeof(NATIVE_ROUTES) / sizeof(NATIVE_ROUTES[0])),
+              "API route patterns must start with '/'");
+
+// Hardware palsu; store dan clock tetap ada melewati "reboot"
+static SimulatedPwmSink pwm;
+static MemoryKeyValueStore store;
+static ManualClock wallClock;  // DS3231
+static ManualTimer uptime;     // esp_timer, mulai dari 0 setiap boot
+static MemoryKeyValueStore timeStore;
+static TimeKeeper timeKeeper(&wallClock, &uptime, &timeStore);
+
+static std::unique_ptr<LedController> ledController;
+static CommandQueue commandQueue;
+static CommandDispatcher dispatcher(&commandQueue);
+static ApiRouter router;
+static char responseBuffer[SCHEDULE_JSON_MAX_SIZE];
+
+// Client sync: jamnya berjalan bersama uptime, tanpa drift
+static bool syncClientSet = false;
+static int64_t syncClientBaseMs;
+static uint64_t syncClientBaseUs;
+static uint32_t syncClientSeed = 1;
+
+static int64_t syncClientMs() {
+  return syncClientBaseMs + (int64_t)((uptime.us - syncClientBaseUs) / 1000);
+}
+
+// warm: ESP.restart() (output di-latch, RTC memory tetap); selain itu power cycle
+static void startController(bool warm) {
+  if (ledController && warm) {
+    ledController->prepareForRestart();
+    timeKeeper.save();
+  } else {
+    pwm = SimulatedPwmSink();
+  }
+  // Seperti setup(): status RTC dari begin()/lostPower(), waktu build = default ManualClock
+  RtcState rtcState = RTC_STATE_OK;
+  if (wallClock.failed) {
+    rtcState = RTC_STATE_MISSING;
+  } else if (wallClock.lostPower) {
+    rtcState = RTC_STATE_LOST_POWER;
+  }
+  // Uptime mulai dari 0 lagi; jam client berjalan terus
+  syncClientBaseMs = syncClientMs();
+  syncClientBaseUs = 0;
+  uptime.us = 0;
+  timeKeeper.begin(rtcState, ManualClock().time);
+  ledController.reset(new LedController(&pwm, &store, &timeKeeper));
+  ledController->restoreWarmOutput(warm);
+  ledController->begin();
+}
+
+// Lighting task dan persist task dijalankan berurutan di sini
+static void applyQueued() {
+  if (ledController->processCommands(commandQueue)) {
+    ledController->writeStagedState();
+  }
+  timeKeeper.update();
+}
+
+static void printResponse(uint16_t status, const char* body) {
+  printf("%u %s\n", status, body);
+}
+
+// Dokumen trace ditulis per potongan, seperti response chunked di firmware
+static void printTrace() {
+#if TRACE_ENABLED
+  static TraceExport traceExport;
+  traceExport.begin();
+  printf("200 ");
+  size_t length;
+  while ((length = traceExport.read(responseBuffer, sizeof(responseBuffer))) > 0) {
+    fwrite(responseBuffer, 1, length, stdout);
+  }
+  printf("\n");
+#else
+  printResponse(404, "{\"status\":\"error\",\"message\":\"Tracing is not enabled in this build (TRACE_ENABLED=0)\"}");
+#endif
+}
+
+static void submit(ControlCommand& command, const char* message) {
+  uint32_t seq = commandQueue.push(command);
+  if (seq == 0) {
+    printResponse(503, "{\"status\":\"error\",\"message\":\"Controller busy, retry\"}");
+    return;
+  }
+  applyQueued();
+
+  uint16_t status;
+  uint32_t value;
+  if (!commandQueue.result(seq, status, value)) {
+    printResponse(500, "{\"status\":\"error\",\"message\":\"Command not applied\"}");
+    return;
+  }
+  formatCommandResult(responseBuffer, sizeof(responseBuffer), seq, status, value, message);
+  printResponse(status, responseBuffer);
+}
+
+static size_t parseHex(const char* text, uint8_t* out, size_t size) {
+  size_t length = 0;
+  while (text[0] != '\0' && text[1] != '\0' && length < size) {
+    char byte[3] = {text[0], text[1], '\0'};
+    out[length++] = (uint8_t)strtoul(byte, nullptr, 16);
+    text += 2;
+  }
+  return length;
+}
+
+static void handleBinary(char* hex) {
+  uint8_t message[CODEC_MESSAGE_MAX_SIZE];
+  size_t length = parseHex(hex, message, sizeof(message));
+  uint32_t seq;
+  CodecStatus status = dispatcher.dispatchMessage(message, length, seq);
+  if (status != CODEC_OK) {
+    snprintf(responseBuffer, sizeof(responseBuffer), "{\"status\":\"error\",\"message\":\"Invalid command: %s\"}",
+             CODEC_STATUS_NAMES[status]);
+    printResponse(codecHttpStatus(status), responseBuffer);
+    return;
+  }
+
+  applyQueued();
+  uint16_t result;
+  uint32_t value;
+  commandQueue.result(seq, result, value);
+  uint8_t opcode = message[0];
+  bool schedule = opcode == OP_HOUR || opcode == OP_SCHEDULE || opcode == OP_PATCH;
+  formatCommandResult(responseBuffer, sizeof(responseBuffer), seq, result, value, schedule ? "Command applied" : nullptr);
+  printResponse(result, responseBuffer);
+}
+
+static uint8_t methodFromName(const char* name) {
+  if (strcmp(name, "GET") == 0) return ROUTE_GET;
+  if (strcmp(name, "POST") == 0) return ROUTE_POST;
+  if (strcmp(name, "PATCH") == 0) return ROUTE_PATCH;
+  if (strcmp(name, "PUT") == 0) return ROUTE_PUT;
+  return 0;
+}
+
+static void handleRequest(const char* methodName, const char* path, char* body) {
+  RouteMatch match;
+  uint8_t method = methodFromName(methodName);
+  if (!router.match(path, method, match)) {
+    printResponse(404, "Not found");
+    return;
+  }
+  if (match.route == ROUTER_NO_ROUTE) {
+    printResponse(405, "{\"status\":\"error\",\"message\":\"Method not allowed\"}");
+    return;
+  }
+
+  uint8_t* data = (uint8_t*)body;
+  size_t len = strlen(body);
+  ControlCommand command;
+  ApiError error;
+  bool parsed = true;
+  const char* message = nullptr;
+
+  switch (match.id) {
+    case NATIVE_TIME_GET:
+      timeKeeper.formatTimeJson(responseBuffer, sizeof(responseBuffer));
+      printResponse(200, responseBuffer);
+      return;
+    case NATIVE_TIME_SYNC: {
+      int64_t received = timeKeeper.syncTimestamp();
+      TimeSyncRequest sync;
+      if (!parseTimeSyncRequest(data, len, sync, error)) {
+        printResponse(error.status, error.body);
+        return;
+      }
+      timeKeeper.sync(sync, received, responseBuffer, sizeof(responseBuffer));
+      printResponse(200, responseBuffer);
+      return;
+    }
+    case NATIVE_MODE_GET: {
+      static const char* const names[] = {"auto", "manual", "off"};
+      snprintf(responseBuffer, sizeof(responseBuffer), "{\"mode\":\"%s\"}", names[ledController->getMode()]);
+      printResponse(200, responseBuffer);
+      return;
+    }
+    case NATIVE_SCHEDULE_GET:
+      ledController->formatHourlyScheduleJson(responseBuffer, sizeof(responseBuffer));
+      printResponse(200, responseBuffer);
+      return;
+    case NATIVE_HOUR_GET:
+      if (match.params[0] > 23) {
+        printResponse(400, "{\"status\":\"error\",\"message\":\"Invalid hour (must be 0-23)\"}");
+        return;
+      }
+      formatHourProfileJson(responseBuffer, sizeof(responseBuffer), match.params[0],
+                            ledController->getHourlyProfile(match.params[0]),
+                            ledController->getHourVersion(match.params[0]));
+      printResponse(200, responseBuffer);
+      return;
+    case NATIVE_COMMAND:
+      handleBinary(body);
+      return;
+    case NATIVE_TRACE:
+      printTrace();
+      return;
+
+    case NATIVE_MANUAL:
+      parsed = parseManualRequest(data, len, command, error);
+      break;
+    case NATIVE_MANUAL_ALL:
+      parsed = parseManualAllRequest(data, len, command, error);
+      break;
+    case NATIVE_TIME_SET:
+      parsed = parseTimeRequest(data, len, command, error);
+      break;
+    case NATIVE_MODE_SET:
+      parsed = parseModeRequest(data, len, command, error);
+      break;
+    case NATIVE_SCHEDULE_SET:
+      parsed = parseScheduleRequest(data, len, command, error);
+      message = "Hourly schedule updated";
+      break;
+    case NATIVE_SCHEDULE_PATCH:
+      parsed = parseSchedulePatchRequest(data, len, command, error);
+      message = "Hourly schedule patched";
+      break;
+    case NATIVE_HOUR_SET:
+      parsed = parseHourRequest(match.params[0], data, len, command, error);
+      message = "Hour profile updated";
+      break;
+    case NATIVE_BATCH:
+      parsed = parseBatchRequest(data, len, command, error);
+      message = "Batch applied";
+      break;
+  }
+
+  if (!parsed) {
+    printResponse(error.status, error.body);
+    return;
+  }
+  submit(command, message);
+}
+
+static void printPwm() {
+  printf("pwm");
+  for (uint8_t i = 0; i < LED_CHANNEL_COUNT; i++) {
+    printf(" %u", pwm.duty[i]);
+  }
+  printf("%s\n", pwm.latched ? " (latched)" : "");
+}
+
+static void printStore() {
+  printf("nvs writes=%u\n", store.writes);
+  for (const auto& entry : store.values) {
+    printf("  %-15s %zu bytes\n", entry.first.c_str(), entry.second.size());
+  }
+}
+
+static void printWear() {
+  NvsKeyUsage keys[NVS_WEAR_MAX_KEYS];
+  uint8_t count = nvsWear.snapshot(keys, NVS_WEAR_MAX_KEYS);
+  for (uint8_t i = 0; i < count; i++) {
+    printf("  %s/%-12s writes=%u removes=%u bytes=%u entries=%u (%s, %u bytes)\n", keys[i].space, keys[i].key,
+           keys[i].writes, keys[i].removes, keys[i].bytes, keys[i].entries,
+           NVS_VALUE_KIND_NAMES[keys[i].kind], keys[i].valueBytes);
+  }
+}
+
+// Laju tulis satu key dari scrape /api/metrics
+struct WearRate {
+  std::string key;
+  NvsValueKind kind;
+  size_t bytes;
+  double perHour;
+  double pending;
+};
+
+// Baca slab_nvs_key_writes_total, slab_nvs_key_value_bytes dan slab_uptime_seconds
+static bool readWearRates(const char* path, std::vector<WearRate>& rates) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    printf("cannot open %s\n", path);
+    return false;
+  }
+  std::map<std::string, double> writes;
+  double uptime = 0;
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    char space[16], key[16], type[16];
+    double value;
+    if (sscanf(line, "slab_nvs_key_writes_total{namespace=\"%15[^\"]\",key=\"%15[^\"]\"} %lf",
+               space, key, &value) == 3) {
+      writes[std::string(space) + "/" + key] = value;
+    } else if (sscanf(line, "slab_nvs_key_value_bytes{namespace=\"%15[^\"]\",key=\"%15[^\"]\",type=\"%15[^\"]\"} %lf",
+                      space, key, type, &value) == 4) {
+      NvsValueKind kind = NVS_VALUE_BLOB;
+      if (strcmp(type, "primitive") == 0) kind = NVS_VALUE_PRIMITIVE;
+      if (strcmp(type, "string") == 0) kind = NVS_VALUE_STRING;
+      rates.push_back({std::string(space) + "/" + key, kind, (size_t)value, 0, 0});
+    } else {
+      sscanf(line, "slab_uptime_seconds %lf", &uptime);
+    }
+  }
+  fclose(file);
+
+  if (uptime <= 0 || rates.empty()) {
+    printf("no NVS key metrics or uptime in %s\n", path);
+    return false;
+  }
+  for (WearRate& rate : rates) {
+    rate.perHour = writes[rate.key] * 3600.0 / uptime;
+  }
+  return true;
+}
+
+// Putar laju tulis dari device pada model halaman NVS, lalu ekstrapolasi ke batas erase
+static void projectWear(char* args) {
+  char* years = args + strcspn(args, " ");
+  if (*years != '\0') *years++ = '\0';
+  double simulatedYears = *years != '\0' ? strtod(years, nullptr) : 1.0;
+  if (simulatedYears <= 0) simulatedYears = 1.0;
+
+  std::vector<WearRate> rates;
+  if (!readWearRates(args, rates)) return;
+
+  SimulatedNvsFlash flash;
+  double entriesPerHour = 0;
+  for (const WearRate& rate : rates) {
+    flash.write(rate.key, rate.kind, rate.bytes);  // Nilai yang sudah ada di flash
+    entriesPerHour += rate.perHour * nvsEntriesFor(rate.kind, rate.bytes);
+    printf("  %-22s %10.2f writes/h  %4zu bytes %s\n", rate.key.c_str(), rate.perHour, rate.bytes,
+           NVS_VALUE_KIND_NAMES[rate.kind]);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  uint32_t hours = (uint32_t)(simulatedYears * 8766);
+  uint32_t writes = 0;
+  uint32_t hour = 0;
+  for (; hour < hours && writes < WEAR_MAX_SIMULATED_WRITES; hour++) {
+    // Tulis tiap key bergantian dalam satu jam, seperti urutan di device
+    bool wrote = true;
+    for (WearRate& rate : rates) rate.pending += rate.perHour;
+    while (wrote) {
+      wrote = false;
+      for (WearRate& rate : rates) {
+        if (rate.pending >= 1) {
+          flash.write(rate.key, rate.kind, rate.bytes);
+          rate.pending -= 1;
+          writes++;
+          wrote = true;
+        }
+      }
+    }
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  simulatedYears = hour / 8766.0;
+
+  printf("simulated %.3f years (%u writes) in %.0f ms: %u entries, %u copied by garbage collection, %u page erases\n",
+         simulatedYears, writes, ms, flash.entries, flash.copies, flash.erases);
+  printf("erases per page:");
+  for (uint8_t i = 0; i < flash.pageCount(); i++) {
+    printf(" %u", flash.pageErases(i));
+  }
+  printf("%s\n", flash.failures > 0 ? " (NVS full: writes failed)" : "");
+
+  double perPageYear = flash.maxPageErases() / simulatedYears;
+  if (perPageYear > 0) {
+    double lifetimeYears = NVS_FLASH_ENDURANCE / perPageYear;
+    printf("projected lifetime %.2f years, %.0f days (most-erased page, %u cycles rated)\n",
+           lifetimeYears, lifetimeYears * 365.25, NVS_FLASH_ENDURANCE);
+  } else {
+    printf("projected lifetime: no page erased in the simulated time\n");
+  }
+  uint32_t estimateDays = nvsProjectedLifetimeDays((float)entriesPerHour);
+  printf("estimate with even wear (slab_nvs_projected_lifetime_days): %.2f years, %u days\n",
+         estimateDays / 365.25, estimateDays);
+}
+
+// Satu hari jadwal pada jam virtual, ditulis per potongan seperti GET /api/schedule/preview
+static void simulateDay(char* args) {
+  char* path = args + strcspn(args, " ");
+  if (*path != '\0') *path++ = '\0';
+  while (*path == ' ') path++;
+  long step = strtol(args, nullptr, 10);
+  size_t pathLength = strlen(path);
+  if (step < 1 || step > SIM_MAX_STEP_SECONDS || pathLength == 0) {
+    printf("usage: simulate <step 1..3600> <file.csv|file.bin|->\n");
+    return;
+  }
+
+  bool binary = pathLength > 4 && strcmp(path + pathLength - 4, ".bin") == 0;
+  FILE* output = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+  if (output == nullptr) {
+    printf("cannot write %s\n", path);
+    return;
+  }
+
+  static ScheduleSimulation simulation;
+  auto start = std::chrono::steady_clock::now();
+  simulation.begin(ledController.get(), binary ? SIM_FORMAT_BINARY : SIM_FORMAT_CSV, (uint16_t)step);
+  uint8_t buffer[4096];
+  size_t length;
+  size_t total = 0;
+  while ((length = simulation.read(buffer, sizeof(buffer))) > 0) {
+    fwrite(buffer, 1, length, output);
+    total += length;
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (output != stdout) {
+    fclose(output);
+    printf("simulate %lu frames, step %lds, %zu bytes in %.1f ms\n",
+           (unsigned long)simulation.getFrameCount(), step, total, ms);
+  }
+}
+
+// Network task: TimeKeeper::update() setiap 10 ms (RTC ditulis tepat setelah batas detik)
+static void advanceMs(uint32_t ms) {
+  while (ms > 0) {
+    uint32_t step = ms < 10 ? ms : 10;
+    wallClock.advanceMs(step);
+    uptime.advanceMs(step);
+    timeKeeper.update();
+    ms -= step;
+  }
+}
+
+// Set waktu biasa (detik penuh) dari jam client, tepat pada batas detiknya
+static void simulateSetTime() {
+  if (!syncClientSet) {
+    syncClientBaseMs = timeKeeper.syncTimestamp();
+    syncClientBaseUs = uptime.us;
+    syncClientSet = true;
+  }
+  int64_t phase = syncClientMs() % 1000;
+  if (phase != 0) advanceMs((uint32_t)(1000 - phase));
+  CommandTime time = epochMsToTime(syncClientMs() - TIME_UNIX_OFFSET_MS);
+  char body[128];
+  snprintf(body, sizeof(body),
+           "{\"year\":%u,\"month\":%u,\"day\":%u,\"hour\":%u,\"minute\":%u,\"second\":%u}",
+           time.year, time.month, time.day, time.hour, time.minute, time.second);
+  handleRequest("POST", "/api/time", body);
+}
+
+
+// Exchange POST /api/time/sync setiap 250 ms, delay jaringan acak 5..44 ms per arah
+static void simulateSync(char* args) {
+  char* count = args + strcspn(args, " ");
+  if (*count != '\0') *count++ = '\0';
+  long exchanges = *count != '\0' ? strtol(count, nullptr, 10) : 8;
+  if (exchanges < 1 || exchanges > 100 || (*args == '\0' && !syncClientSet)) {
+    printf("usage: sync [offset ms] [exchanges 1..100]\n");
+    return;
+  }
+  if (*args != '\0') {
+    syncClientBaseMs = timeKeeper.syncTimestamp() + strtol(args, nullptr, 10);
+    syncClientBaseUs = uptime.us;
+    syncClientSet = true;
+  }
+
+  unsigned long id = 0;
+  long long t4 = 0;
+  for (long i = 0; i < exchanges; i++) {
+    syncClientSeed = syncClientSeed * 1103515245 + 12345;
+    uint32_t up = 5 + (syncClientSeed >> 16) % 40;
+    syncClientSeed = syncClientSeed * 1103515245 + 12345;
+    uint32_t down = 5 + (syncClientSeed >> 16) % 40;
+
+    char body[96];
+    if (id != 0) {
+      snprintf(body, sizeof(body), "{\"t1\":%lld,\"id\":%lu,\"t4\":%lld}", (long long)syncClientMs(), id, t4);
+    } else {
+      snprintf(body, sizeof(body), "{\"t1\":%lld}", (long long)syncClientMs());
+    }
+    advanceMs(up);
+    handleRequest("POST", "/api/time/sync", body);
+    sscanf(responseBuffer, "{\"id\":%lu", &id);
+    advanceMs(down);
+    t4 = syncClientMs();
+    advanceMs(250 - up - down);
+  }
+  printf("client - device %lld ms\n", (long long)(syncClientMs() - timeKeeper.syncTimestamp()));
+}
+
+static bool runLine(char* line) {
+  line[strcspn(line, "\r\n")] = '\0';
+  while (*line == ' ') line++;
+  if (*line == '\0' || *line == '#') return true;
+
+  char* rest = line + strcspn(line, " ");
+  if (*rest != '\0') *rest++ = '\0';
+  while (*rest == ' ') rest++;
+
+  if (line[0] >= 'A' && line[0] <= 'Z') {
+    // METHOD PATH [BODY]
+    char* body = rest + strcspn(rest, " ");
+    if (*body != '\0') *body++ = '\0';
+    handleRequest(line, rest, body);
+  } else if (strcmp(line, "clock") == 0) {
+    CommandTime time;
+    unsigned year, month, day, hour, minute, second;
+    if (sscanf(rest, "%u-%u-%u %u:%u:%u", &year, &month, &day, &hour, &minute, &second) != 6) {
+      printf("usage: clock YYYY-MM-DD HH:MM:SS\n");
+      return true;
+    }
+    time = {(uint16_t)year, (uint8_t)month, (uint8_t)day, (uint8_t)hour, (uint8_t)minute, (uint8_t)second};
+    wallClock.adjust(time);
+  } else if (strcmp(line, "advance") == 0) {
+    // Seluruhnya dengan langkah network task: slew, penulisan RTC dan tepi detik berjalan
+    advanceMs(strtoul(rest, nullptr, 10) * 1000);
+    timeKeeper.update();
+    ledController->update();
+    printPwm();
+  } else if (strcmp(line, "tick") == 0) {
+    timeKeeper.update();
+    ledController->update();
+    printPwm();
+  } else if (strcmp(line, "rtc") == 0) {
+    if (strcmp(rest, "fail") == 0) {
+      wallClock.failed = true;
+    } else if (strcmp(rest, "ok") == 0) {
+      wallClock.failed = false;
+    } else if (strcmp(rest, "lostpower") == 0) {
+      wallClock.losePower();
+    } else if (strncmp(rest, "rate ", 5) == 0) {
+      wallClock.ratePpb = (int32_t)(strtod(rest + 5, nullptr) * 1000);
+    } else {
+      printf("usage: rtc fail|ok|lostpower|rate <ppm>\n");
+    }
+  } else if (strcmp(line, "sync") == 0) {
+    simulateSync(rest);
+  } else if (strcmp(line, "settime") == 0) {
+    simulateSetTime();
+  } else if (strcmp(line, "simulate") == 0) {
+    simulateDay(rest);
+  } else if (strcmp(line, "pwm") == 0) {
+    printPwm();
+  } else if (strcmp(line, "nvs") == 0) {
+    printStore();
+  } else if (strcmp(line, "wear") == 0) {
+    if (*rest != '\0') {
+      projectWear(rest);
+    } else {
+      printWear();
+    }
+  } else if (strcmp(line, "reboot") == 0) {
+    startController(strcmp(rest, "warm") == 0);
+    printPwm();
+  } else if (strcmp(line, "quit") == 0) {
+    return false;
+  } else {
+    printf("unknown command: %s\n", line);
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  FILE* input = stdin;
+  Serial.enabled = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) {
+      Serial.enabled = true;
+    } else if ((input = fopen(argv[i], "r")) == nullptr) {
+      fprintf(stderr, "cannot open %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  router.begin(NATIVE_ROUTES, sizeof(NATIVE_ROUTES) / sizeof(NATIVE_ROUTES[0]));
+  startController(false);
+
+  static char line[LINE_MAX_SIZE];
+  while (fgets(line, sizeof(line), input) != nullptr) {
+    if (!runLine(line)) break;
+    fflush(stdout);
+  }
+  return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,362 @@
+// JSON request parsers (ApiRequests.h): a valid body for each route and every
+// path that answers 400 before a command is queued.
+//
+//   pio test -e native -f test_api_requests
+
+#include <Arduino.h>
+#include <unity.h>
+#include "ApiRequests.h"
+
+typedef bool (*Parser)(uint8_t* data, size_t len, ControlCommand& command, ApiError& error);
+
+// Parser menulis ke body (parse in-place), jadi setiap kasus memakai salinan
+static char body[4096];
+static ControlCommand command;
+static ApiError error;
+
+void setUp(void) {
+  memset(&command, 0, sizeof(command));
+  memset(&error, 0, sizeof(error));
+}
+
+void tearDown(void) {}
+
+static bool run(Parser parser, const char* json) {
+  size_t len = strlen(json);
+  memcpy(body, json, len + 1);
+  return parser((uint8_t*)body, len, command, error);
+}
+
+static bool runHour(uint16_t hour, const char* json) {
+  size_t len = strlen(json);
+  memcpy(body, json, len + 1);
+  return parseHourRequest(hour, (uint8_t*)body, len, command, error);
+}
+
+static void assertRejected(bool ok, const char* fragment) {
+  TEST_ASSERT_FALSE(ok);
+  TEST_ASSERT_EQUAL_UINT16(400, error.status);
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(error.body, fragment), error.body);
+}
+
+static void assertJsonRejected(bool ok, const char* fragment) {
+  assertRejected(ok, fragment);
+  TEST_ASSERT_EQUAL_STRING("application/json", error.contentType);
+}
+
+// ---------- POST /api/manual ----------
+
+static void test_manual_valid(void) {
+  TEST_ASSERT_TRUE(run(parseManualRequest, "{\"led\":\"violet\",\"value\":255}"));
+  TEST_ASSERT_EQUAL(CMD_SET_CHANNEL, command.type);
+  TEST_ASSERT_EQUAL_UINT8(LED_VIOLET, command.channel.channel);
+  TEST_ASSERT_EQUAL_UINT8(255, command.channel.value);
+}
+
+static void test_manual_rejects(void) {
+  assertRejected(run(parseManualRequest, "{\"led\":"), "JSON parsing failed: ");
+  TEST_ASSERT_EQUAL_STRING("text/plain", error.contentType);
+  assertJsonRejected(run(parseManualRequest, "{\"value\":10}"), "Missing 'led' property");
+  assertJsonRejected(run(parseManualRequest, "{\"led\":\"blue\"}"), "Missing 'value' property");
+  assertJsonRejected(run(parseManualRequest, "{\"led\":\"blue\",\"value\":256}"), "Value out of range (0-255)");
+  assertJsonRejected(run(parseManualRequest, "{\"led\":\"blue\",\"value\":-1}"), "Value out of range (0-255)");
+  assertJsonRejected(run(parseManualRequest, "{\"led\":\"blue\",\"value\":12.5}"), "Value out of range (0-255)");
+  assertJsonRejected(run(parseManualRequest, "{\"led\":\"blue\",\"value\":\"100\"}"), "Value out of range (0-255)");
+  assertJsonRejected(run(parseManualRequest, "{\"led\":\"infrared\",\"value\":10}"), "Invalid LED type");
+}
+
+// ---------- POST /api/manual/all ----------
+
+static const char* const ALL_CHANNELS =
+  "{\"royalBlue\":1,\"blue\":2,\"uv\":3,\"violet\":4,\"red\":5,\"green\":6,\"white\":255}";
+
+static void test_manual_all_valid(void) {
+  TEST_ASSERT_TRUE(run(parseManualAllRequest, ALL_CHANNELS));
+  TEST_ASSERT_EQUAL(CMD_SET_ALL, command.type);
+  const LightProfile expected = {1, 2, 3, 4, 5, 6, 255};
+  TEST_ASSERT_EQUAL_MEMORY(&expected, &command.frame, sizeof(expected));
+}
+
+static void test_manual_all_accepts_wrapper(void) {
+  TEST_ASSERT_TRUE(run(parseManualAllRequest,
+    "{\"values\":{\"royalBlue\":9,\"blue\":8,\"uv\":7,\"violet\":6,\"red\":5,\"green\":4,\"white\":3}}"));
+  const LightProfile expected = {9, 8, 7, 6, 5, 4, 3};
+  TEST_ASSERT_EQUAL_MEMORY(&expected, &command.frame, sizeof(expected));
+}
+
+static void test_manual_all_rejects(void) {
+  assertJsonRejected(run(parseManualAllRequest, "[1,"), "JSON parsing failed: ");
+  assertJsonRejected(run(parseManualAllRequest, "{\"royalBlue\":1,\"blue\":2,\"uv\":3,\"violet\":4,\"red\":5}"),
+                     "Missing properties: green, white");
+  assertJsonRejected(run(parseManualAllRequest,
+    "{\"royalBlue\":1,\"blue\":2,\"uv\":3,\"violet\":4,\"red\":5,\"green\":6,\"white\":256}"),
+    "\"channel\":\"white\"");
+  assertJsonRejected(run(parseManualAllRequest,
+    "{\"royalBlue\":-1,\"blue\":2,\"uv\":3,\"violet\":4,\"red\":5,\"green\":6,\"white\":7}"),
+    "Channel value must be an integer 0-255");
+  assertJsonRejected(run(parseManualAllRequest,
+    "{\"royalBlue\":1,\"blue\":2.5,\"uv\":3,\"violet\":4,\"red\":5,\"green\":6,\"white\":7}"),
+    "\"channel\":\"blue\"");
+}
+
+// ---------- POST /api/time, /api/time/sync ----------
+
+static void test_time_valid(void) {
+  TEST_ASSERT_TRUE(run(parseTimeRequest,
+    "{\"year\":2024,\"month\":2,\"day\":29,\"hour\":23,\"minute\":59,\"second\":58}"));
+  TEST_ASSERT_EQUAL(CMD_SET_TIME, command.type);
+  TEST_ASSERT_EQUAL_UINT16(2024, command.time.year);
+  TEST_ASSERT_EQUAL_UINT8(23, command.time.hour);
+  TEST_ASSERT_EQUAL_UINT8(58, command.time.second);
+}
+
+static void test_time_rejects(void) {
+  assertJsonRejected(run(parseTimeRequest, "{"), "Invalid time format");
+  assertJsonRejected(run(parseTimeRequest, "{\"year\":2024,\"month\":2,\"day\":1,\"hour\":1,\"minute\":1}"),
+                     "Invalid time format");
+  assertJsonRejected(run(parseTimeRequest,
+    "{\"year\":2024,\"month\":13,\"day\":1,\"hour\":1,\"minute\":1,\"second\":1}"), "Invalid time format");
+  assertJsonRejected(run(parseTimeRequest,
+    "{\"year\":1999,\"month\":1,\"day\":1,\"hour\":1,\"minute\":1,\"second\":1}"), "Invalid time format");
+  assertJsonRejected(run(parseTimeRequest,
+    "{\"year\":2024,\"month\":1,\"day\":1,\"hour\":24,\"minute\":1,\"second\":1}"), "Invalid time format");
+}
+
+static bool runSync(const char* json, TimeSyncRequest& request) {
+  size_t len = strlen(json);
+  memcpy(body, json, len + 1);
+  return parseTimeSyncRequest((uint8_t*)body, len, request, error);
+}
+
+static void test_time_sync_valid(void) {
+  TimeSyncRequest request;
+  TEST_ASSERT_TRUE(runSync("{\"t1\":1718000000000}", request));
+  TEST_ASSERT_TRUE(request.t1 == 1718000000000LL);
+  TEST_ASSERT_EQUAL_UINT32(0, request.id);
+
+  TEST_ASSERT_TRUE(runSync("{\"t1\":1718000000500,\"id\":7,\"t4\":1718000000020}", request));
+  TEST_ASSERT_EQUAL_UINT32(7, request.id);
+  TEST_ASSERT_TRUE(request.t4 == 1718000000020LL);
+}
+
+static void test_time_sync_rejects(void) {
+  TimeSyncRequest request;
+  assertJsonRejected(runSync("{\"t1\":", request), "JSON parsing failed: ");
+  assertJsonRejected(runSync("{}", request), "Missing t1");
+  assertJsonRejected(runSync("{\"t1\":\"now\"}", request), "Missing t1");
+  assertJsonRejected(runSync("{\"t1\":1,\"id\":7}", request), "id needs t4");
+}
+
+// ---------- POST /api/mode, /api/schedule/preview ----------
+
+static void test_mode_valid(void) {
+  TEST_ASSERT_TRUE(run(parseModeRequest, "{\"mode\":\"off\"}"));
+  TEST_ASSERT_EQUAL(CMD_SET_MODE, command.type);
+  TEST_ASSERT_EQUAL_UINT8(MODE_OFF, command.mode.mode);
+}
+
+static void test_mode_rejects(void) {
+  assertRejected(run(parseModeRequest, "mode=auto"), "JSON parsing failed: ");
+  TEST_ASSERT_EQUAL_STRING("text/plain", error.contentType);
+  assertJsonRejected(run(parseModeRequest, "{\"state\":\"auto\"}"), "Missing mode key");
+  assertJsonRejected(run(parseModeRequest, "{\"mode\":\"party\"}"), "Invalid mode");
+  assertJsonRejected(run(parseModeRequest, "{\"mode\":1}"), "Invalid mode");
+}
+
+static void test_preview_valid(void) {
+  TEST_ASSERT_TRUE(run(parsePreviewRequest, "{\"minutes\":2}"));
+  TEST_ASSERT_EQUAL(CMD_PREVIEW, command.type);
+  TEST_ASSERT_EQUAL_UINT32(120000, command.preview.durationMs);
+  TEST_ASSERT_TRUE(run(parsePreviewRequest, "{\"minutes\":0}"));
+  TEST_ASSERT_EQUAL_UINT32(0, command.preview.durationMs);
+}
+
+static void test_preview_rejects(void) {
+  assertJsonRejected(run(parsePreviewRequest, "{"), "JSON parsing failed: ");
+  assertJsonRejected(run(parsePreviewRequest, "{\"seconds\":30}"), "Missing 'minutes' property");
+  assertJsonRejected(run(parsePreviewRequest, "{\"minutes\":0.05}"), "minutes must be 0 (stop)");
+  assertJsonRejected(run(parsePreviewRequest, "{\"minutes\":1441}"), "minutes must be 0 (stop)");
+  assertJsonRejected(run(parsePreviewRequest, "{\"minutes\":-5}"), "minutes must be 0 (stop)");
+}
+
+// ---------- POST /api/batch ----------
+
+static void test_batch_valid(void) {
+  TEST_ASSERT_TRUE(run(parseBatchRequest,
+    "{\"ops\":[{\"op\":\"hour\",\"hour\":6,\"blue\":40},"
+    "{\"op\":\"time\",\"year\":2024,\"month\":6,\"day\":1,\"hour\":6,\"minute\":0,\"second\":0},"
+    "{\"op\":\"mode\",\"mode\":\"auto\"}]}"));
+  TEST_ASSERT_EQUAL(CMD_TRANSITION, command.type);
+  TEST_ASSERT_EQUAL_HEX32(1UL << 6, command.transition.hourMask);
+  TEST_ASSERT_EQUAL_UINT8(40, command.transition.profiles[6].blue);
+  TEST_ASSERT_EQUAL_UINT8(TRANSITION_MODE | TRANSITION_TIME, command.transition.flags);
+  TEST_ASSERT_EQUAL_UINT8(MODE_AUTO, command.transition.mode);
+
+  // Array langsung; frame manual juga berarti mode manual
+  TEST_ASSERT_TRUE(run(parseBatchRequest, "[{\"op\":\"manual\",\"red\":200}]"));
+  TEST_ASSERT_EQUAL_UINT8(TRANSITION_FRAME | TRANSITION_MODE, command.transition.flags);
+  TEST_ASSERT_EQUAL_UINT8(MODE_MANUAL, command.transition.mode);
+  TEST_ASSERT_EQUAL_UINT8(200, command.transition.frame.red);
+}
+
+static void test_batch_rejects(void) {
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":"), "Invalid JSON format: ");
+  assertJsonRejected(run(parseBatchRequest, "{\"ops\":{}}"), "Expected an 'ops' array");
+  assertJsonRejected(run(parseBatchRequest, "[]"), "Empty batch");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"mode\",\"mode\":\"auto\"},{\"op\":\"dance\"}]"),
+                     "\"message\":\"Invalid operation\",\"index\":1");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"mode\",\"mode\":\"party\"}]"),
+                     "\"message\":\"Invalid operation\",\"index\":0");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"hour\",\"hour\":24,\"blue\":1}]"),
+                     "\"message\":\"Invalid operation\",\"index\":0");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"hour\",\"blue\":1}]"),
+                     "\"message\":\"Invalid operation\",\"index\":0");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"time\",\"year\":2024}]"),
+                     "\"message\":\"Invalid operation\",\"index\":0");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"mode\",\"mode\":\"off\"},{\"op\":\"manual\",\"uv\":300}]"),
+                     "\"index\":1,\"channel\":\"uv\"");
+  assertJsonRejected(run(parseBatchRequest, "[{\"op\":\"hour\",\"hour\":3,\"green\":-4}]"),
+                     "\"index\":0,\"channel\":\"green\"");
+}
+
+// ---------- POST /api/schedule/hourly ----------
+
+static void test_schedule_valid(void) {
+  TEST_ASSERT_TRUE(run(parseScheduleRequest,
+    "{\"schedule\":[{\"hour\":0,\"white\":5},{\"hour\":23,\"royalBlue\":255},"
+    "{\"hour\":24,\"blue\":1},{\"blue\":2}]}"));
+  TEST_ASSERT_EQUAL(CMD_SET_SCHEDULE, command.type);
+  // Jam di luar 0-23 dan entri tanpa "hour" dilewati
+  TEST_ASSERT_EQUAL_HEX32((1UL << 0) | (1UL << 23), command.schedule.hourMask);
+  TEST_ASSERT_EQUAL_UINT8(5, command.schedule.profiles[0].white);
+  TEST_ASSERT_EQUAL_UINT8(255, command.schedule.profiles[23].royalBlue);
+
+  TEST_ASSERT_TRUE(run(parseScheduleRequest, "[{\"hour\":12,\"red\":9}]"));
+  TEST_ASSERT_EQUAL_HEX32(1UL << 12, command.schedule.hourMask);
+}
+
+static void test_schedule_rejects(void) {
+  assertJsonRejected(run(parseScheduleRequest, "{\"schedule\":["), "Invalid JSON format: ");
+  assertJsonRejected(run(parseScheduleRequest, "{\"hours\":[]}"), "Invalid JSON format for hourly schedule");
+  assertJsonRejected(run(parseScheduleRequest, "[{\"hour\":5,\"blue\":1},{\"hour\":6,\"violet\":999}]"),
+                     "\"hour\":6,\"channel\":\"violet\"");
+}
+
+// ---------- PATCH /api/schedule/hourly ----------
+
+static void test_patch_valid(void) {
+  TEST_ASSERT_TRUE(run(parseSchedulePatchRequest,
+    "{\"baseVersion\":12,\"changes\":[{\"hour\":6,\"channel\":\"blue\",\"value\":120},"
+    "{\"hour\":23,\"channel\":\"white\",\"value\":0}]}"));
+  TEST_ASSERT_EQUAL(CMD_PATCH_SCHEDULE, command.type);
+  TEST_ASSERT_EQUAL_UINT32(12, command.patch.baseVersion);
+  TEST_ASSERT_EQUAL_UINT8(2, command.patch.count);
+  TEST_ASSERT_EQUAL_UINT8(6, command.patch.deltas[0].hour);
+  TEST_ASSERT_EQUAL_UINT8(LED_BLUE, command.patch.deltas[0].channel);
+  TEST_ASSERT_EQUAL_UINT8(120, command.patch.deltas[0].value);
+  TEST_ASSERT_EQUAL_UINT8(LED_WHITE, command.patch.deltas[1].channel);
+}
+
+// {"baseVersion":1,"changes":[count x {"hour":1,"channel":"red","value":1}]}
+static const char* patchWithChanges(uint8_t count) {
+  static char json[4096];
+  size_t length = snprintf(json, sizeof(json), "{\"baseVersion\":1,\"changes\":[");
+  for (uint8_t i = 0; i < count; i++) {
+    length += snprintf(json + length, sizeof(json) - length, "%s{\"hour\":1,\"channel\":\"red\",\"value\":1}",
+                       i == 0 ? "" : ",");
+  }
+  snprintf(json + length, sizeof(json) - length, "]}");
+  return json;
+}
+
+static void test_patch_count_bounds(void) {
+  TEST_ASSERT_TRUE(run(parseSchedulePatchRequest, patchWithChanges(SCHEDULE_PATCH_MAX)));
+  TEST_ASSERT_EQUAL_UINT8(SCHEDULE_PATCH_MAX, command.patch.count);
+  assertJsonRejected(run(parseSchedulePatchRequest, patchWithChanges(SCHEDULE_PATCH_MAX + 1)),
+                     "'changes' must hold 1-48 entries");
+  assertJsonRejected(run(parseSchedulePatchRequest, patchWithChanges(0)), "'changes' must hold 1-48 entries");
+}
+
+static void test_patch_rejects(void) {
+  assertJsonRejected(run(parseSchedulePatchRequest, "{\"baseVersion\":"), "Invalid JSON format: ");
+  assertJsonRejected(run(parseSchedulePatchRequest, "{\"changes\":[]}"),
+                     "Expected 'baseVersion' and a 'changes' array");
+  assertJsonRejected(run(parseSchedulePatchRequest, "{\"baseVersion\":-1,\"changes\":[]}"),
+                     "Expected 'baseVersion' and a 'changes' array");
+  assertJsonRejected(run(parseSchedulePatchRequest, "{\"baseVersion\":1,\"changes\":{}}"),
+                     "Expected 'baseVersion' and a 'changes' array");
+  assertJsonRejected(run(parseSchedulePatchRequest,
+    "{\"baseVersion\":1,\"changes\":[{\"hour\":1,\"channel\":\"red\",\"value\":1},"
+    "{\"hour\":24,\"channel\":\"red\",\"value\":1}]}"), "\"message\":\"Invalid change\",\"index\":1");
+  assertJsonRejected(run(parseSchedulePatchRequest,
+    "{\"baseVersion\":1,\"changes\":[{\"hour\":1,\"channel\":\"amber\",\"value\":1}]}"),
+    "\"message\":\"Invalid change\",\"index\":0");
+  assertJsonRejected(run(parseSchedulePatchRequest,
+    "{\"baseVersion\":1,\"changes\":[{\"hour\":1,\"channel\":\"red\",\"value\":256}]}"),
+    "\"message\":\"Invalid change\",\"index\":0");
+  assertJsonRejected(run(parseSchedulePatchRequest,
+    "{\"baseVersion\":1,\"changes\":[{\"hour\":1,\"channel\":\"red\"}]}"),
+    "\"message\":\"Invalid change\",\"index\":0");
+}
+
+// ---------- POST /api/schedule/hourly/{hour} ----------
+
+static void test_hour_valid(void) {
+  TEST_ASSERT_TRUE(runHour(23, "{\"royalBlue\":200,\"white\":0}"));
+  TEST_ASSERT_EQUAL(CMD_SET_HOUR, command.type);
+  TEST_ASSERT_EQUAL_UINT8(23, command.hour.hour);
+  TEST_ASSERT_EQUAL_UINT8(200, command.hour.profile.royalBlue);
+  TEST_ASSERT_EQUAL_UINT8(0, command.hour.profile.blue);  // Key yang tidak ada = 0
+}
+
+static void test_hour_rejects(void) {
+  assertJsonRejected(runHour(24, "{\"blue\":1}"), "Invalid hour (must be 0-23)");
+  assertJsonRejected(runHour(65535, "{\"blue\":1}"), "Invalid hour (must be 0-23)");
+  assertJsonRejected(runHour(5, "{\"blue\":"), "Invalid JSON format: ");
+  assertJsonRejected(runHour(5, "{\"red\":1,\"green\":1000}"), "\"hour\":5,\"channel\":\"green\"");
+}
+
+// ---------- Response bodies ----------
+
+static void test_command_result_bodies(void) {
+  char buffer[160];
+  formatCommandResult(buffer, sizeof(buffer), 4, 200, 9, "Hour profile updated");
+  TEST_ASSERT_EQUAL_STRING("{\"status\":\"success\",\"message\":\"Hour profile updated\",\"seq\":4,\"version\":9}", buffer);
+  formatCommandResult(buffer, sizeof(buffer), 5, 200, 0, nullptr);
+  TEST_ASSERT_EQUAL_STRING("{\"status\":\"success\",\"seq\":5}", buffer);
+  formatCommandResult(buffer, sizeof(buffer), 6, 409, 11, nullptr);
+  TEST_ASSERT_EQUAL_STRING("{\"status\":\"error\",\"message\":\"Schedule version conflict\",\"seq\":6,\"version\":11}", buffer);
+  formatCommandResult(buffer, sizeof(buffer), 7, COMMAND_STATUS_RESULT_EVICTED, 0, nullptr);
+  TEST_ASSERT_NOT_NULL(strstr(buffer, "\"error\":\"result_evicted\""));
+  formatCommandResult(buffer, sizeof(buffer), 8, 400, 0, nullptr);
+  TEST_ASSERT_EQUAL_STRING("{\"status\":\"error\",\"message\":\"Command rejected\",\"seq\":8}", buffer);
+}
+
+int main() {
+  Serial.enabled = false;
+  UNITY_BEGIN();
+  RUN_TEST(test_manual_valid);
+  RUN_TEST(test_manual_rejects);
+  RUN_TEST(test_manual_all_valid);
+  RUN_TEST(test_manual_all_accepts_wrapper);
+  RUN_TEST(test_manual_all_rejects);
+  RUN_TEST(test_time_valid);
+  RUN_TEST(test_time_rejects);
+  RUN_TEST(test_time_sync_valid);
+  RUN_TEST(test_time_sync_rejects);
+  RUN_TEST(test_mode_valid);
+  RUN_TEST(test_mode_rejects);
+  RUN_TEST(test_preview_valid);
+  RUN_TEST(test_preview_rejects);
+  RUN_TEST(test_batch_valid);
+  RUN_TEST(test_batch_rejects);
+  RUN_TEST(test_schedule_valid);
+  RUN_TEST(test_schedule_rejects);
+  RUN_TEST(test_patch_valid);
+  RUN_TEST(test_patch_count_bounds);
+  RUN_TEST(test_patch_rejects);
+  RUN_TEST(test_hour_valid);
+  RUN_TEST(test_hour_rejects);
+  RUN_TEST(test_command_result_bodies);
+  return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// ApiRouter segment trie: literal and numeric segments, parameter bounds,
+// unknown paths (404) and method mismatches (405 with the Allow set).
+//
+//   pio test -e native -f test_api_router
+
+#include <unity.h>
+#include <string.h>
+#include "ApiRouter.h"
+
+enum TestRouteId : uint8_t {
+  ROUTE_MODE_GET,
+  ROUTE_MODE_SET,
+  ROUTE_SCHEDULE_GET,
+  ROUTE_SCHEDULE_PATCH,
+  ROUTE_PREVIEW_GET,
+  ROUTE_HOUR_GET,
+  ROUTE_HOUR_SET,
+  ROUTE_CELL_GET
+};
+
+// Bentuk sama dengan API_ROUTES di WiFiService.cpp, ditambah route dua parameter
+static constexpr ApiRoute ROUTES[] = {
+  {"/api/mode",                           ROUTE_GET,   ROUTE_MODE_GET},
+  {"/api/mode",                           ROUTE_POST,  ROUTE_MODE_SET},
+  {"/api/schedule/hourly",                ROUTE_GET,   ROUTE_SCHEDULE_GET},
+  {"/api/schedule/hourly",                ROUTE_PATCH, ROUTE_SCHEDULE_PATCH},
+  {"/api/schedule/preview",               ROUTE_GET,   ROUTE_PREVIEW_GET},
+  {"/api/schedule/hourly/{hour}",         ROUTE_GET,   ROUTE_HOUR_GET},
+  {"/api/schedule/hourly/{hour}",         ROUTE_POST,  ROUTE_HOUR_SET},
+  {"/api/schedule/hourly/{hour}/{chan}",  ROUTE_GET,   ROUTE_CELL_GET},
+};
+static const size_t ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+static_assert(routeTableValid(ROUTES, ROUTE_COUNT), "API route patterns must start with '/'");
+
+static ApiRouter router;
+static RouteMatch match;
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(router.begin(ROUTES, ROUTE_COUNT));
+  memset(&match, 0xAA, sizeof(match));
+}
+
+void tearDown(void) {}
+
+static void assertRoute(const char* path, uint8_t method, uint8_t id) {
+  TEST_ASSERT_TRUE_MESSAGE(router.match(path, method, match), path);
+  TEST_ASSERT_NOT_EQUAL(ROUTER_NO_ROUTE, match.route);
+  TEST_ASSERT_EQUAL_UINT8(id, match.id);
+}
+
+static void assertNotFound(const char* path) {
+  TEST_ASSERT_FALSE_MESSAGE(router.match(path, ROUTE_GET, match), path);
+}
+
+static void test_literal_routes(void) {
+  assertRoute("/api/mode", ROUTE_GET, ROUTE_MODE_GET);
+  assertRoute("/api/mode", ROUTE_POST, ROUTE_MODE_SET);
+  assertRoute("/api/schedule/hourly", ROUTE_PATCH, ROUTE_SCHEDULE_PATCH);
+  TEST_ASSERT_EQUAL_UINT8(0, match.paramCount);
+}
+
+static void test_separators_are_tolerated(void) {
+  assertRoute("/api/mode/", ROUTE_GET, ROUTE_MODE_GET);
+  assertRoute("//api//schedule/hourly", ROUTE_GET, ROUTE_SCHEDULE_GET);
+}
+
+static void test_literal_wins_over_parameter(void) {
+  assertRoute("/api/schedule/preview", ROUTE_GET, ROUTE_PREVIEW_GET);
+  TEST_ASSERT_EQUAL_UINT8(0, match.paramCount);
+}
+
+static void test_hour_parameter_values(void) {
+  assertRoute("/api/schedule/hourly/0", ROUTE_GET, ROUTE_HOUR_GET);
+  TEST_ASSERT_EQUAL_UINT8(1, match.paramCount);
+  TEST_ASSERT_EQUAL_UINT16(0, match.params[0]);
+
+  assertRoute("/api/schedule/hourly/23", ROUTE_POST, ROUTE_HOUR_SET);
+  TEST_ASSERT_EQUAL_UINT16(23, match.params[0]);
+
+  assertRoute("/api/schedule/hourly/007", ROUTE_GET, ROUTE_HOUR_GET);
+  TEST_ASSERT_EQUAL_UINT16(7, match.params[0]);
+}
+
+// Router hanya memeriksa format angka; jam > 23 ditolak oleh handler (400), bukan 404
+static void test_hour_parameter_bounds(void) {
+  assertRoute("/api/schedule/hourly/24", ROUTE_GET, ROUTE_HOUR_GET);
+  TEST_ASSERT_EQUAL_UINT16(24, match.params[0]);
+  assertRoute("/api/schedule/hourly/65535", ROUTE_GET, ROUTE_HOUR_GET);
+  TEST_ASSERT_EQUAL_UINT16(65535, match.params[0]);
+
+  // Di luar uint16_t atau lebih dari 5 digit: tidak ada route
+  assertNotFound("/api/schedule/hourly/65536");
+  assertNotFound("/api/schedule/hourly/123456");
+  assertNotFound("/api/schedule/hourly/-1");
+  assertNotFound("/api/schedule/hourly/6a");
+  assertNotFound("/api/schedule/hourly/+6");
+  assertNotFound("/api/schedule/hourly/six");
+}
+
+static void test_two_parameters(void) {
+  assertRoute("/api/schedule/hourly/6/3", ROUTE_GET, ROUTE_CELL_GET);
+  TEST_ASSERT_EQUAL_UINT8(2, match.paramCount);
+  TEST_ASSERT_EQUAL_UINT16(6, match.params[0]);
+  TEST_ASSERT_EQUAL_UINT16(3, match.params[1]);
+}
+
+static void test_unknown_paths(void) {
+  assertNotFound("/");
+  assertNotFound("");
+  assertNotFound("/api");                         // Node antara tanpa route
+  assertNotFound("/api/schedule");
+  assertNotFound("/api/modes");
+  assertNotFound("/api/mod");
+  assertNotFound("/API/mode");
+  assertNotFound("/api/mode/extra");
+  assertNotFound("/api/schedule/hourly/6/3/1");
+  assertNotFound("/favicon.ico");
+  TEST_ASSERT_FALSE(router.match(nullptr, ROUTE_GET, match));
+}
+
+static void test_method_not_allowed(void) {
+  TEST_ASSERT_TRUE(router.match("/api/mode", ROUTE_PATCH, match));
+  TEST_ASSERT_EQUAL_UINT8(ROUTER_NO_ROUTE, match.route);
+  TEST_ASSERT_EQUAL_HEX8(ROUTE_GET | ROUTE_POST, match.allowedMethods);
+
+  TEST_ASSERT_TRUE(router.match("/api/schedule/hourly/5", ROUTE_PATCH, match));
+  TEST_ASSERT_EQUAL_UINT8(ROUTER_NO_ROUTE, match.route);
+  TEST_ASSERT_EQUAL_HEX8(ROUTE_GET | ROUTE_POST, match.allowedMethods);
+
+  char allow[48];
+  ApiRouter::formatAllow(match.allowedMethods, allow, sizeof(allow));
+  TEST_ASSERT_EQUAL_STRING("GET, POST", allow);
+}
+
+static void test_unbuilt_router_matches_nothing(void) {
+  ApiRouter empty;
+  TEST_ASSERT_FALSE(empty.match("/api/mode", ROUTE_GET, match));
+}
+
+static void test_table_limits(void) {
+  ApiRoute tooMany[ROUTER_MAX_ROUTES + 1];
+  for (size_t i = 0; i < ROUTER_MAX_ROUTES + 1; i++) {
+    tooMany[i] = {"/api/mode", ROUTE_GET, 0};
+  }
+  ApiRouter limited;
+  TEST_ASSERT_FALSE(limited.begin(tooMany, ROUTER_MAX_ROUTES + 1));
+  TEST_ASSERT_TRUE(limited.begin(tooMany, ROUTER_MAX_ROUTES));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_literal_routes);
+  RUN_TEST(test_separators_are_tolerated);
+  RUN_TEST(test_literal_wins_over_parameter);
+  RUN_TEST(test_hour_parameter_values);
+  RUN_TEST(test_hour_parameter_bounds);
+  RUN_TEST(test_two_parameters);
+  RUN_TEST(test_unknown_paths);
+  RUN_TEST(test_method_not_allowed);
+  RUN_TEST(test_unbuilt_router_matches_nothing);
+  RUN_TEST(test_table_limits);
+  return UNITY_END();
+}
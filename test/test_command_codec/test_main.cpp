@@ -0,0 +1,381 @@
+// Binary command codec and dispatcher: length and value checks for every
+// opcode, the schedule hour mask, PATCH entry counts, BUSY from the sink
+// and encoder round trips.
+//
+//   pio test -e native -f test_command_codec
+
+#include <unity.h>
+#include <string.h>
+#include "CommandCodec.h"
+
+// Records submitted commands; seq 0 (queue full) when accept is false
+class RecordingSink : public CommandSink {
+public:
+  bool accept = true;
+  uint32_t nextSeq = 1;
+  uint32_t submitted = 0;
+  ControlCommand last = {};
+
+  uint32_t submit(ControlCommand& command) override {
+    submitted++;
+    last = command;
+    return accept ? nextSeq++ : 0;
+  }
+};
+
+static ControlCommand command;
+static uint8_t payload[CODEC_MESSAGE_MAX_SIZE];
+
+static const LightProfile FRAME = {1, 2, 3, 4, 5, 6, 7};
+
+void setUp(void) {
+  memset(&command, 0, sizeof(command));
+  memset(payload, 0, sizeof(payload));
+}
+
+void tearDown(void) {}
+
+static CodecStatus decode(uint8_t opcode, size_t length) {
+  return decodeCommand(opcode, payload, length, command);
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = value >> 24;
+}
+
+static uint32_t readU32(const uint8_t* data) {
+  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// Waktu valid: 2024-03-15 06:30:45
+static void fillTime(uint8_t* out) {
+  out[0] = 2024 & 0xFF;
+  out[1] = 2024 >> 8;
+  out[2] = 3;
+  out[3] = 15;
+  out[4] = 6;
+  out[5] = 30;
+  out[6] = 45;
+}
+
+static void test_frame_opcode(void) {
+  encodeFrame(FRAME, payload);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_FRAME, CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CMD_SET_ALL, command.type);
+  TEST_ASSERT_EQUAL_MEMORY(&FRAME, &command.frame, sizeof(FRAME));
+
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_FRAME, 0));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_FRAME, CODEC_FRAME_SIZE - 1));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_FRAME, CODEC_FRAME_SIZE + 1));
+}
+
+static void test_channel_opcode(void) {
+  payload[0] = LED_WHITE;
+  payload[1] = 200;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_CHANNEL, 2));
+  TEST_ASSERT_EQUAL_UINT8(CMD_SET_CHANNEL, command.type);
+  TEST_ASSERT_EQUAL_UINT8(LED_WHITE, command.channel.channel);
+  TEST_ASSERT_EQUAL_UINT8(200, command.channel.value);
+
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_CHANNEL, 1));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_CHANNEL, 3));
+
+  payload[0] = LED_CHANNEL_COUNT;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_CHANNEL, 2));
+  payload[0] = 0xFF;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_CHANNEL, 2));
+}
+
+static void test_mode_opcode(void) {
+  for (uint8_t mode = MODE_AUTO; mode <= MODE_OFF; mode++) {
+    payload[0] = mode;
+    TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_MODE, 1));
+    TEST_ASSERT_EQUAL_UINT8(CMD_SET_MODE, command.type);
+    TEST_ASSERT_EQUAL_UINT8(mode, command.mode.mode);
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_MODE, 0));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_MODE, 2));
+
+  payload[0] = MODE_OFF + 1;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_MODE, 1));
+}
+
+static void test_time_opcode(void) {
+  fillTime(payload);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_TIME, CODEC_TIME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CMD_SET_TIME, command.type);
+  TEST_ASSERT_EQUAL_UINT16(2024, command.time.year);
+  TEST_ASSERT_EQUAL_UINT8(3, command.time.month);
+  TEST_ASSERT_EQUAL_UINT8(15, command.time.day);
+  TEST_ASSERT_EQUAL_UINT8(6, command.time.hour);
+  TEST_ASSERT_EQUAL_UINT8(30, command.time.minute);
+  TEST_ASSERT_EQUAL_UINT8(45, command.time.second);
+
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_TIME, CODEC_TIME_SIZE - 1));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_TIME, CODEC_TIME_SIZE + 1));
+
+  // Satu field di luar rentang per kasus: offset dalam payload dan nilainya
+  const struct { uint8_t offset; uint16_t value; } invalid[] = {
+    {0, 1999}, {0, 2101}, {2, 0}, {2, 13}, {3, 0}, {3, 32}, {4, 24}, {5, 60}, {6, 60}
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    fillTime(payload);
+    if (invalid[i].offset == 0) {
+      payload[0] = invalid[i].value & 0xFF;
+      payload[1] = invalid[i].value >> 8;
+    } else {
+      payload[invalid[i].offset] = (uint8_t)invalid[i].value;
+    }
+    TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_TIME, CODEC_TIME_SIZE));
+  }
+}
+
+static void test_hour_opcode(void) {
+  payload[0] = 23;
+  encodeFrame(FRAME, payload + 1);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_HOUR, 1 + CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CMD_SET_HOUR, command.type);
+  TEST_ASSERT_EQUAL_UINT8(23, command.hour.hour);
+  TEST_ASSERT_EQUAL_MEMORY(&FRAME, &command.hour.profile, sizeof(FRAME));
+
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_HOUR, CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_HOUR, CODEC_FRAME_SIZE + 2));
+
+  payload[0] = 24;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_HOUR, 1 + CODEC_FRAME_SIZE));
+}
+
+static void test_schedule_frames_follow_hour_mask(void) {
+  // Jam 0, 6 dan 23: tiga frame berurutan
+  writeU32(payload, (1UL << 0) | (1UL << 6) | (1UL << 23));
+  for (uint8_t i = 0; i < 3; i++) {
+    memset(payload + 4 + i * CODEC_FRAME_SIZE, 10 * (i + 1), CODEC_FRAME_SIZE);
+  }
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_SCHEDULE, 4 + 3 * CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CMD_SET_SCHEDULE, command.type);
+  TEST_ASSERT_EQUAL_HEX32(0x800041, command.schedule.hourMask);
+  TEST_ASSERT_EACH_EQUAL_UINT8(10, (const uint8_t*)&command.schedule.profiles[0], CODEC_FRAME_SIZE);
+  TEST_ASSERT_EACH_EQUAL_UINT8(20, (const uint8_t*)&command.schedule.profiles[6], CODEC_FRAME_SIZE);
+  TEST_ASSERT_EACH_EQUAL_UINT8(30, (const uint8_t*)&command.schedule.profiles[23], CODEC_FRAME_SIZE);
+
+  // Panjang harus tepat popcount(mask) frame
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, 4 + 2 * CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, 4 + 4 * CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, 4 + 3 * CODEC_FRAME_SIZE - 1));
+}
+
+static void test_schedule_mask_and_length_checks(void) {
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, 0));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, 3));
+
+  // Mask kosong atau bit di atas jam 23
+  writeU32(payload, 0);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_SCHEDULE, 4));
+  writeU32(payload, 1UL << 24);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_SCHEDULE, 4 + CODEC_FRAME_SIZE));
+  writeU32(payload, 0xFFFFFFFFUL);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_SCHEDULE, CODEC_SCHEDULE_SIZE));
+
+  // Jadwal penuh = ukuran maksimum
+  writeU32(payload, 0xFFFFFF);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_SCHEDULE, CODEC_SCHEDULE_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, CODEC_SCHEDULE_SIZE - 1));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_SCHEDULE, CODEC_SCHEDULE_SIZE + 1));
+}
+
+static size_t fillPatch(uint32_t baseVersion, uint8_t count) {
+  writeU32(payload, baseVersion);
+  payload[4] = count;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t* entry = payload + 5 + i * 3;
+    entry[0] = i % 24;
+    entry[1] = i % LED_CHANNEL_COUNT;
+    entry[2] = i;
+  }
+  return 5 + (size_t)count * 3;
+}
+
+static void test_patch_count_bounds(void) {
+  size_t length = fillPatch(0x01020304, 2);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_PATCH, length));
+  TEST_ASSERT_EQUAL_UINT8(CMD_PATCH_SCHEDULE, command.type);
+  TEST_ASSERT_EQUAL_HEX32(0x01020304, command.patch.baseVersion);
+  TEST_ASSERT_EQUAL_UINT8(2, command.patch.count);
+  TEST_ASSERT_EQUAL_UINT8(1, command.patch.deltas[1].hour);
+  TEST_ASSERT_EQUAL_UINT8(1, command.patch.deltas[1].channel);
+  TEST_ASSERT_EQUAL_UINT8(1, command.patch.deltas[1].value);
+
+  length = fillPatch(7, SCHEDULE_PATCH_MAX);
+  TEST_ASSERT_TRUE(length <= CODEC_PATCH_MAX_SIZE);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_PATCH, length));
+  TEST_ASSERT_EQUAL_UINT8(SCHEDULE_PATCH_MAX, command.patch.count);
+
+  // count 0 dan count > SCHEDULE_PATCH_MAX ditolak sebelum panjang diperiksa
+  length = fillPatch(7, 0);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_PATCH, length));
+  length = fillPatch(7, SCHEDULE_PATCH_MAX);
+  payload[4] = SCHEDULE_PATCH_MAX + 1;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_PATCH, length + 3));
+}
+
+static void test_patch_length_and_entry_checks(void) {
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_PATCH, 4));
+
+  size_t length = fillPatch(1, 3);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_PATCH, length - 1));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decode(OP_PATCH, length + 3));
+
+  payload[5 + 2 * 3] = 24;                 // Jam entry ketiga
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_PATCH, length));
+  fillPatch(1, 3);
+  payload[5 + 2 * 3 + 1] = LED_CHANNEL_COUNT;  // Channel entry ketiga
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, decode(OP_PATCH, length));
+}
+
+static void test_unknown_opcodes_and_messages(void) {
+  TEST_ASSERT_EQUAL_UINT8(CODEC_UNKNOWN_OPCODE, decode(0x00, 0));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_UNKNOWN_OPCODE, decode(OP_PATCH + 1, 1));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_UNKNOWN_OPCODE, decode(0xFF, CODEC_FRAME_SIZE));
+
+  uint8_t message[1 + 1] = {OP_MODE, MODE_OFF};
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decodeCommandMessage(message, sizeof(message), command));
+  TEST_ASSERT_EQUAL_UINT8(MODE_OFF, command.mode.mode);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decodeCommandMessage(message, 1, command));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, decodeCommandMessage(message, 0, command));
+}
+
+static void test_http_status_mapping(void) {
+  TEST_ASSERT_EQUAL_UINT16(200, codecHttpStatus(CODEC_OK));
+  TEST_ASSERT_EQUAL_UINT16(503, codecHttpStatus(CODEC_BUSY));
+  TEST_ASSERT_EQUAL_UINT16(400, codecHttpStatus(CODEC_UNKNOWN_OPCODE));
+  TEST_ASSERT_EQUAL_UINT16(400, codecHttpStatus(CODEC_BAD_LENGTH));
+  TEST_ASSERT_EQUAL_UINT16(400, codecHttpStatus(CODEC_BAD_VALUE));
+}
+
+static void test_dispatcher_submits_valid_commands(void) {
+  RecordingSink sink;
+  sink.nextSeq = 41;
+  CommandDispatcher dispatcher(&sink);
+
+  uint32_t seq = 0;
+  payload[0] = MODE_MANUAL;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, dispatcher.dispatch(OP_MODE, payload, 1, seq));
+  TEST_ASSERT_EQUAL_UINT32(41, seq);
+  TEST_ASSERT_EQUAL_UINT32(1, sink.submitted);
+  TEST_ASSERT_EQUAL_UINT8(CMD_SET_MODE, sink.last.type);
+  TEST_ASSERT_EQUAL_UINT8(MODE_MANUAL, sink.last.mode.mode);
+
+  // Gagal decode: tidak pernah sampai ke sink, seq 0
+  seq = 99;
+  payload[0] = 9;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_VALUE, dispatcher.dispatch(OP_MODE, payload, 1, seq));
+  TEST_ASSERT_EQUAL_UINT32(0, seq);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_UNKNOWN_OPCODE, dispatcher.dispatch(0x42, payload, 1, seq));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BAD_LENGTH, dispatcher.dispatchMessage(payload, 0, seq));
+  TEST_ASSERT_EQUAL_UINT32(1, sink.submitted);
+
+  TEST_ASSERT_EQUAL_UINT32(1, dispatcher.getCount(CODEC_OK));
+  TEST_ASSERT_EQUAL_UINT32(1, dispatcher.getCount(CODEC_BAD_VALUE));
+  TEST_ASSERT_EQUAL_UINT32(1, dispatcher.getCount(CODEC_UNKNOWN_OPCODE));
+  TEST_ASSERT_EQUAL_UINT32(1, dispatcher.getCount(CODEC_BAD_LENGTH));
+  TEST_ASSERT_EQUAL_UINT32(0, dispatcher.getCount(CODEC_BUSY));
+}
+
+static void test_dispatcher_reports_busy_when_sink_refuses(void) {
+  RecordingSink sink;
+  sink.accept = false;
+  CommandDispatcher dispatcher(&sink);
+
+  uint8_t message[1 + CODEC_FRAME_SIZE] = {OP_FRAME};
+  encodeFrame(FRAME, message + 1);
+  uint32_t seq = 99;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_BUSY, dispatcher.dispatchMessage(message, sizeof(message), seq));
+  TEST_ASSERT_EQUAL_UINT32(0, seq);
+  TEST_ASSERT_EQUAL_UINT32(1, sink.submitted);
+  TEST_ASSERT_EQUAL_UINT32(1, dispatcher.getCount(CODEC_BUSY));
+  TEST_ASSERT_EQUAL_UINT32(0, dispatcher.getCount(CODEC_OK));
+  TEST_ASSERT_EQUAL_UINT16(503, codecHttpStatus(CODEC_BUSY));
+
+  // Antrian kosong lagi: perintah yang sama diterima
+  sink.accept = true;
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, dispatcher.dispatchMessage(message, sizeof(message), seq));
+  TEST_ASSERT_EQUAL_UINT32(1, seq);
+}
+
+static void test_encode_result_round_trip(void) {
+  uint8_t out[CODEC_RESULT_SIZE];
+  memset(out, 0xEE, sizeof(out));
+  TEST_ASSERT_EQUAL_UINT32(CODEC_RESULT_SIZE, encodeResult(OP_PATCH, 409, 0x11223344, 0xA1B2C3D4, out));
+
+  const uint8_t expected[CODEC_RESULT_SIZE] = {
+    OP_PATCH, 0x00, 0x99, 0x01, 0x44, 0x33, 0x22, 0x11, 0xD4, 0xC3, 0xB2, 0xA1
+  };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, CODEC_RESULT_SIZE);
+
+  TEST_ASSERT_EQUAL_UINT8(OP_PATCH, out[0]);
+  TEST_ASSERT_EQUAL_UINT16(409, (uint16_t)(out[2] | (out[3] << 8)));
+  TEST_ASSERT_EQUAL_UINT32(0x11223344, readU32(out + 4));
+  TEST_ASSERT_EQUAL_UINT32(0xA1B2C3D4, readU32(out + 8));
+}
+
+static void test_encode_schedule_read_round_trip(void) {
+  LightProfile profiles[24];
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    uint8_t* channels = (uint8_t*)&profiles[hour];
+    for (uint8_t channel = 0; channel < LED_CHANNEL_COUNT; channel++) {
+      channels[channel] = hour * 10 + channel;
+    }
+  }
+
+  uint8_t out[CODEC_SCHEDULE_SIZE];
+  TEST_ASSERT_EQUAL_UINT32(CODEC_SCHEDULE_SIZE, encodeScheduleRead(0xCAFE0042, profiles, out));
+  TEST_ASSERT_EQUAL_UINT32(0xCAFE0042, readU32(out));
+
+  // Bentuk baca = bentuk tulis dengan versi di tempat mask: tulis kembali semua jam
+  writeU32(out, 0xFFFFFF);
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decodeCommand(OP_SCHEDULE, out, sizeof(out), command));
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    TEST_ASSERT_EQUAL_MEMORY(&profiles[hour], &command.schedule.profiles[hour], sizeof(LightProfile));
+  }
+}
+
+static void test_encode_time_and_frame_round_trip(void) {
+  CommandTime time = {2099, 12, 31, 23, 59, 58};
+  TEST_ASSERT_EQUAL_UINT32(CODEC_TIME_SIZE, encodeTime(time, payload));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_TIME, CODEC_TIME_SIZE));
+  TEST_ASSERT_EQUAL_UINT16(2099, command.time.year);
+  TEST_ASSERT_EQUAL_UINT8(12, command.time.month);
+  TEST_ASSERT_EQUAL_UINT8(31, command.time.day);
+  TEST_ASSERT_EQUAL_UINT8(23, command.time.hour);
+  TEST_ASSERT_EQUAL_UINT8(59, command.time.minute);
+  TEST_ASSERT_EQUAL_UINT8(58, command.time.second);
+
+  TEST_ASSERT_EQUAL_UINT32(CODEC_FRAME_SIZE, encodeFrame(FRAME, payload));
+  TEST_ASSERT_EQUAL_UINT8(CODEC_OK, decode(OP_FRAME, CODEC_FRAME_SIZE));
+  TEST_ASSERT_EQUAL_MEMORY(&FRAME, &command.frame, sizeof(FRAME));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_opcode);
+  RUN_TEST(test_channel_opcode);
+  RUN_TEST(test_mode_opcode);
+  RUN_TEST(test_time_opcode);
+  RUN_TEST(test_hour_opcode);
+  RUN_TEST(test_schedule_frames_follow_hour_mask);
+  RUN_TEST(test_schedule_mask_and_length_checks);
+  RUN_TEST(test_patch_count_bounds);
+  RUN_TEST(test_patch_length_and_entry_checks);
+  RUN_TEST(test_unknown_opcodes_and_messages);
+  RUN_TEST(test_http_status_mapping);
+  RUN_TEST(test_dispatcher_submits_valid_commands);
+  RUN_TEST(test_dispatcher_reports_busy_when_sink_refuses);
+  RUN_TEST(test_encode_result_round_trip);
+  RUN_TEST(test_encode_schedule_read_round_trip);
+  RUN_TEST(test_encode_time_and_frame_round_trip);
+  return UNITY_END();
+}
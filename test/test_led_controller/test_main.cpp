@@ -0,0 +1,281 @@
+// LedController on the in-memory HAL: schedule interpolation, the auto tick
+// and mode changes through queued commands.
+//
+//   pio test -e native -f test_led_controller
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LedController.h"
+#include "ControlCommand.h"
+#include "SimulatedLightingHal.h"
+
+static SimulatedPwmSink pwm;
+static MemoryKeyValueStore store;
+static ManualClock wallClock;
+static LedController* controller;
+
+static const LightProfile DAWN = {10, 20, 30, 40, 50, 60, 70};
+static const LightProfile NOON = {110, 220, 130, 40, 250, 0, 255};
+static const LightProfile NIGHT = {0, 0, 0, 0, 0, 0, 0};
+
+void setUp(void) {
+  pwm = SimulatedPwmSink();
+  store = MemoryKeyValueStore();
+  wallClock = ManualClock();
+  wallClock.set(6, 0);
+  controller = new LedController(&pwm, &store, &wallClock);
+  controller->restoreOutput();
+}
+
+void tearDown(void) {
+  delete controller;
+  controller = nullptr;
+}
+
+static uint16_t apply(const ControlCommand& command) {
+  uint32_t value;
+  return controller->applyCommand(command, value);
+}
+
+static uint16_t setMode(LightMode mode) {
+  ControlCommand command = {};
+  command.type = CMD_SET_MODE;
+  command.mode.mode = mode;
+  return apply(command);
+}
+
+// Jam 6 = DAWN, jam 7 = NOON, sisanya NIGHT
+static void loadSchedule() {
+  ControlCommand command = {};
+  command.type = CMD_SET_SCHEDULE;
+  command.schedule.hourMask = 0xFFFFFF;
+  for (uint8_t hour = 0; hour < 24; hour++) {
+    command.schedule.profiles[hour] = NIGHT;
+  }
+  command.schedule.profiles[6] = DAWN;
+  command.schedule.profiles[7] = NOON;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+}
+
+static void assertOutput(const LightProfile& expected) {
+  TEST_ASSERT_EQUAL_UINT8_ARRAY((const uint8_t*)&expected, pwm.duty, LED_CHANNEL_COUNT);
+  LightProfile output = controller->getOutputProfile();
+  TEST_ASSERT_EQUAL_MEMORY(&expected, &output, sizeof(output));
+}
+
+static void test_interpolate_endpoints_and_midpoint(void) {
+  LightProfile start = controller->interpolateProfiles(DAWN, NOON, 0.0f);
+  TEST_ASSERT_EQUAL_MEMORY(&DAWN, &start, sizeof(start));
+  LightProfile end = controller->interpolateProfiles(DAWN, NOON, 1.0f);
+  TEST_ASSERT_EQUAL_MEMORY(&NOON, &end, sizeof(end));
+
+  LightProfile mid = LedController::interpolateProfiles(DAWN, NOON, 0.5f);
+  TEST_ASSERT_EQUAL_UINT8(60, mid.royalBlue);
+  TEST_ASSERT_EQUAL_UINT8(120, mid.blue);
+  TEST_ASSERT_EQUAL_UINT8(80, mid.uv);
+  TEST_ASSERT_EQUAL_UINT8(40, mid.violet);   // Sama di kedua ujung
+  TEST_ASSERT_EQUAL_UINT8(150, mid.red);
+  TEST_ASSERT_EQUAL_UINT8(30, mid.green);    // Turun: 60 -> 0
+  TEST_ASSERT_EQUAL_UINT8(162, mid.white);
+}
+
+static void test_interpolate_clamps_ratio(void) {
+  LightProfile below = LedController::interpolateProfiles(DAWN, NOON, -0.5f);
+  TEST_ASSERT_EQUAL_MEMORY(&DAWN, &below, sizeof(below));
+  LightProfile above = LedController::interpolateProfiles(DAWN, NOON, 1.5f);
+  TEST_ASSERT_EQUAL_MEMORY(&NOON, &above, sizeof(above));
+}
+
+static void test_schedule_frame_wraps_at_midnight(void) {
+  HourlyProfile schedule[24] = {};
+  schedule[23].profile = NOON;
+  schedule[0].profile = NIGHT;
+
+  LightProfile late = LedController::scheduleFrame(schedule, 23, 0);
+  TEST_ASSERT_EQUAL_MEMORY(&NOON, &late, sizeof(late));
+  LightProfile half = LedController::scheduleFrame(schedule, 23, 30);
+  TEST_ASSERT_EQUAL_UINT8(55, half.royalBlue);
+  TEST_ASSERT_EQUAL_UINT8(127, half.white);
+}
+
+static void test_auto_tick_interpolates_current_hour(void) {
+  loadSchedule();
+
+  wallClock.set(6, 0);
+  controller->update();
+  assertOutput(DAWN);
+
+  wallClock.set(6, 30);
+  controller->update();
+  assertOutput(LedController::interpolateProfiles(DAWN, NOON, 0.5f));
+
+  wallClock.set(7, 0);
+  controller->update();
+  assertOutput(NOON);
+}
+
+static void test_schedule_change_refreshes_auto_output(void) {
+  loadSchedule();
+  wallClock.set(6, 0);
+
+  ControlCommand command = {};
+  command.type = CMD_SET_HOUR;
+  command.hour.hour = 6;
+  command.hour.profile = NOON;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+  assertOutput(NOON);  // Tanpa menunggu tick berikutnya
+}
+
+static void test_manual_mode_starts_from_scheduled_frame(void) {
+  loadSchedule();
+  wallClock.set(7, 0);
+
+  TEST_ASSERT_EQUAL_UINT16(200, setMode(MODE_MANUAL));
+  TEST_ASSERT_EQUAL(MODE_MANUAL, controller->getMode());
+  assertOutput(NOON);
+
+  // Tick jadwal tidak mengubah output manual
+  wallClock.set(12, 0);
+  controller->update();
+  assertOutput(NOON);
+}
+
+static void test_set_channel_enters_manual_mode(void) {
+  loadSchedule();
+  wallClock.set(6, 0);
+
+  ControlCommand command = {};
+  command.type = CMD_SET_CHANNEL;
+  command.channel.channel = LED_BLUE;
+  command.channel.value = 77;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+
+  TEST_ASSERT_EQUAL(MODE_MANUAL, controller->getMode());
+  LightProfile expected = DAWN;
+  expected.blue = 77;
+  assertOutput(expected);
+}
+
+static void test_off_mode_blanks_and_keeps_manual_frame(void) {
+  ControlCommand command = {};
+  command.type = CMD_SET_ALL;
+  command.frame = NOON;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+  assertOutput(NOON);
+
+  TEST_ASSERT_EQUAL_UINT16(200, setMode(MODE_OFF));
+  TEST_ASSERT_EQUAL(MODE_OFF, controller->getMode());
+  assertOutput(NIGHT);
+
+  TEST_ASSERT_EQUAL_UINT16(200, setMode(MODE_MANUAL));
+  assertOutput(NOON);
+}
+
+static void test_auto_mode_returns_to_schedule(void) {
+  loadSchedule();
+  wallClock.set(6, 30);
+
+  ControlCommand command = {};
+  command.type = CMD_SET_ALL;
+  command.frame = {1, 2, 3, 4, 5, 6, 7};
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+
+  TEST_ASSERT_EQUAL_UINT16(200, setMode(MODE_AUTO));
+  TEST_ASSERT_EQUAL(MODE_AUTO, controller->getMode());
+  assertOutput(LedController::interpolateProfiles(DAWN, NOON, 0.5f));
+}
+
+static void test_invalid_commands_change_nothing(void) {
+  loadSchedule();
+  wallClock.set(6, 0);
+  controller->update();
+  uint32_t writes = pwm.writes;
+
+  TEST_ASSERT_EQUAL_UINT16(400, setMode((LightMode)3));
+
+  ControlCommand command = {};
+  command.type = CMD_SET_CHANNEL;
+  command.channel.channel = LED_CHANNEL_COUNT;
+  command.channel.value = 10;
+  TEST_ASSERT_EQUAL_UINT16(400, apply(command));
+
+  command = {};
+  command.type = CMD_SET_HOUR;
+  command.hour.hour = 24;
+  TEST_ASSERT_EQUAL_UINT16(400, apply(command));
+
+  TEST_ASSERT_EQUAL(MODE_AUTO, controller->getMode());
+  TEST_ASSERT_EQUAL_UINT32(writes, pwm.writes);
+  assertOutput(DAWN);
+}
+
+static void test_snapshot_matches_applied_state(void) {
+  loadSchedule();
+  ControlCommand command = {};
+  command.type = CMD_SET_ALL;
+  command.frame = DAWN;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+
+  ControllerSnapshot state;
+  controller->readSnapshot(state);
+  TEST_ASSERT_EQUAL(MODE_MANUAL, state.mode);
+  TEST_ASSERT_EQUAL_MEMORY(&DAWN, &state.output, sizeof(state.output));
+  TEST_ASSERT_EQUAL_UINT32(controller->getScheduleVersion(), state.scheduleVersion);
+  TEST_ASSERT_EQUAL_MEMORY(&NOON, &state.profiles[7], sizeof(LightProfile));
+  TEST_ASSERT_EQUAL_UINT32(controller->getHourVersion(7), state.hourVersion[7]);
+}
+
+static void test_queued_commands_complete_with_status(void) {
+  CommandQueue queue;
+  ControlCommand command = {};
+  command.type = CMD_SET_MODE;
+  command.mode.mode = MODE_OFF;
+  uint32_t good = queue.push(command);
+  command.mode.mode = 7;
+  uint32_t bad = queue.push(command);
+
+  TEST_ASSERT_TRUE(controller->processCommands(queue));
+
+  uint16_t status;
+  uint32_t value;
+  TEST_ASSERT_TRUE(queue.result(good, status, value));
+  TEST_ASSERT_EQUAL_UINT16(200, status);
+  TEST_ASSERT_TRUE(queue.result(bad, status, value));
+  TEST_ASSERT_EQUAL_UINT16(400, status);
+  TEST_ASSERT_EQUAL(MODE_OFF, controller->getMode());
+}
+
+static void test_mode_survives_restart(void) {
+  ControlCommand command = {};
+  command.type = CMD_SET_ALL;
+  command.frame = NOON;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+  controller->flushPendingWrites();
+
+  delete controller;
+  pwm = SimulatedPwmSink();
+  controller = new LedController(&pwm, &store, &wallClock);
+  controller->restoreOutput();
+
+  TEST_ASSERT_EQUAL(MODE_MANUAL, controller->getMode());
+  assertOutput(NOON);
+}
+
+int main() {
+  Serial.enabled = false;  // Hanya hasil Unity di output
+  UNITY_BEGIN();
+  RUN_TEST(test_interpolate_endpoints_and_midpoint);
+  RUN_TEST(test_interpolate_clamps_ratio);
+  RUN_TEST(test_schedule_frame_wraps_at_midnight);
+  RUN_TEST(test_auto_tick_interpolates_current_hour);
+  RUN_TEST(test_schedule_change_refreshes_auto_output);
+  RUN_TEST(test_manual_mode_starts_from_scheduled_frame);
+  RUN_TEST(test_set_channel_enters_manual_mode);
+  RUN_TEST(test_off_mode_blanks_and_keeps_manual_frame);
+  RUN_TEST(test_auto_mode_returns_to_schedule);
+  RUN_TEST(test_invalid_commands_change_nothing);
+  RUN_TEST(test_snapshot_matches_applied_state);
+  RUN_TEST(test_queued_commands_complete_with_status);
+  RUN_TEST(test_mode_survives_restart);
+  return UNITY_END();
+}
@@ -0,0 +1,195 @@
+// TimeKeeper DS3231 rate learning and aging trim: an RTC running at +N ppm
+// is synced once a day for several simulated days. The fitted rate must
+// converge on N and the aging offset written to the RTC must be N / 0.1 ppm,
+// rounded and clamped to the register range.
+//
+//   pio test -e native -f test_time_keeper
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include "TimeKeeper.h"
+#include "SimulatedLightingHal.h"
+
+#define SIM_DAY_MS          86400000ULL
+#define SIM_FINE_PERIOD_MS  120000ULL  // Update every 1 ms before a sync: an RTC second edge is
+                                       // located to 1 ms (10 ms would bias the fit by ~60 ppb)
+#define SIM_SETTLE_MS       1200000ULL // Slew (up to 500 ms at 500 ppm) and RTC write after a sync
+#define MAX_AGING_WRITES    8
+
+// Records every aging offset written by TimeKeeper
+class TrimmedClock : public ManualClock {
+public:
+  int8_t agingWrites[MAX_AGING_WRITES];
+  uint8_t agingWriteCount = 0;
+
+  bool writeAgingOffset(int8_t value) override {
+    if (agingWriteCount < MAX_AGING_WRITES) {
+      agingWrites[agingWriteCount] = value;
+    }
+    agingWriteCount++;
+    return ManualClock::writeAgingOffset(value);
+  }
+};
+
+static TrimmedClock rtc;
+static ManualTimer timer;
+static MemoryKeyValueStore store;
+static TimeKeeper* keeper;
+static int64_t trueMs;  // Reference time (TimeKeeper epoch); the timer has no drift
+
+static const CommandTime BUILD_TIME = {2023, 6, 1, 0, 0, 0};
+
+static void startKeeper() {
+  keeper = new TimeKeeper(&rtc, &timer, &store);
+  keeper->begin(RTC_STATE_OK, BUILD_TIME);
+}
+
+void setUp(void) {
+  rtc = TrimmedClock();
+  rtc.time = {2024, 1, 1, 0, 0, 0};
+  timer = ManualTimer();
+  store = MemoryKeyValueStore();
+  trueMs = timeToEpochMs(rtc.time);
+  startKeeper();
+}
+
+void tearDown(void) {
+  delete keeper;
+  keeper = nullptr;
+}
+
+// Network task: update() setiap stepMs, RTC berjalan dengan ratePpb-nya
+static void advance(uint64_t ms, uint32_t stepMs) {
+  while (ms > 0) {
+    uint32_t step = ms < stepMs ? (uint32_t)ms : stepMs;
+    rtc.advanceMs(step);
+    timer.advanceMs(step);
+    trueMs += step;
+    keeper->update();
+    ms -= step;
+  }
+}
+
+// Client dengan jam referensi, 8 exchange POST /api/time/sync, 5 ms per arah
+static void syncSession() {
+  char response[256];
+  unsigned long id = 0;
+  int64_t t4 = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    TimeSyncRequest request = {trueMs + TIME_UNIX_OFFSET_MS, (uint32_t)id, t4};
+    advance(5, 5);
+    int64_t t2 = keeper->syncTimestamp();
+    TEST_ASSERT_GREATER_THAN(0, keeper->sync(request, t2, response, sizeof(response)));
+    TEST_ASSERT_EQUAL(1, sscanf(response, "{\"id\":%lu", &id));
+    advance(5, 5);
+    t4 = trueMs + TIME_UNIX_OFFSET_MS;
+    advance(240, 10);
+  }
+  advance(SIM_SETTLE_MS, 10);
+}
+
+static void runDays(uint8_t days) {
+  for (uint8_t day = 0; day < days; day++) {
+    advance(SIM_DAY_MS - SIM_FINE_PERIOD_MS, 1000);
+    advance(SIM_FINE_PERIOD_MS, 1);
+    syncSession();
+  }
+}
+
+static int64_t clockErrorMs() {
+  return keeper->syncTimestamp() - TIME_UNIX_OFFSET_MS - trueMs;
+}
+
+// Jalankan satu RTC pada ratePpb selama beberapa hari dan periksa trim-nya
+static void assertConverges(int32_t ratePpb, int8_t expectedAging) {
+  rtc.ratePpb = ratePpb;
+  syncSession();  // RTC pertama kali ditulis: belum ada interval untuk dipelajari
+  runDays(5);
+
+  TimeStatus status;
+  keeper->status(status);
+  TEST_ASSERT_GREATER_OR_EQUAL(5, status.rtcDriftSamples);
+  TEST_ASSERT_INT32_WITHIN(20, ratePpb, status.rtcDriftPpb);
+
+  // Satu kali tulis, sesudah sampel pertama; laju tetap sama sehingga tidak ditulis ulang
+  TEST_ASSERT_EQUAL_UINT8(1, rtc.agingWriteCount);
+  TEST_ASSERT_EQUAL_INT8(expectedAging, rtc.agingWrites[0]);
+  TEST_ASSERT_EQUAL_INT8(expectedAging, rtc.aging);
+  TEST_ASSERT_EQUAL_INT8(expectedAging, status.agingOffset);
+
+  // Sisa setelah register aging dikoreksi di software
+  TEST_ASSERT_INT32_WITHIN(20, ratePpb - expectedAging * TIME_AGING_STEP_PPB, status.rtcCorrectionPpb);
+
+  // Sehari tanpa sync: jam tetap dekat referensi
+  advance(SIM_DAY_MS, 1000);
+  TEST_ASSERT_INT32_WITHIN(50, 0, (int32_t)clockErrorMs());
+}
+
+static void test_no_trim_before_rate_is_known(void) {
+  rtc.ratePpb = 3000;
+  syncSession();
+
+  TimeStatus status;
+  keeper->status(status);
+  TEST_ASSERT_EQUAL_UINT8(0, status.rtcDriftSamples);
+  TEST_ASSERT_EQUAL_INT32(0, status.rtcCorrectionPpb);
+  TEST_ASSERT_EQUAL_UINT8(0, rtc.agingWriteCount);
+  TEST_ASSERT_EQUAL_INT8(0, rtc.aging);
+  TEST_ASSERT_TRUE(rtc.adjustments > 0);  // RTC ditulis pada batas detik
+}
+
+static void test_fast_rtc_trims_positive(void) {
+  assertConverges(3000, 30);
+}
+
+static void test_slow_rtc_trims_negative_rounded(void) {
+  assertConverges(-4280, -43);  // -42.8 langkah dibulatkan ke -43
+}
+
+static void test_small_rate_rounds_to_nearest_step(void) {
+  assertConverges(1220, 12);
+}
+
+static void test_large_rate_clamps_to_register_range(void) {
+  assertConverges(20000, INT8_MAX);
+}
+
+static void test_large_negative_rate_clamps_to_register_range(void) {
+  assertConverges(-15000, INT8_MIN);
+}
+
+static void test_learned_rate_survives_restart(void) {
+  rtc.ratePpb = 3000;
+  syncSession();
+  runDays(3);
+  keeper->save();
+
+  TimeStatus before;
+  keeper->status(before);
+  delete keeper;
+  startKeeper();
+
+  TimeStatus after;
+  keeper->status(after);
+  TEST_ASSERT_EQUAL_INT32(before.rtcDriftPpb, after.rtcDriftPpb);
+  TEST_ASSERT_EQUAL_UINT8(before.rtcDriftSamples, after.rtcDriftSamples);
+  TEST_ASSERT_EQUAL_INT8(30, after.agingOffset);
+
+  // Tidak ada trim baru setelah restart dengan laju yang sama
+  runDays(1);
+  TEST_ASSERT_EQUAL_UINT8(1, rtc.agingWriteCount);
+}
+
+int main() {
+  Serial.enabled = false;  // Hanya hasil Unity di output
+  UNITY_BEGIN();
+  RUN_TEST(test_no_trim_before_rate_is_known);
+  RUN_TEST(test_fast_rtc_trims_positive);
+  RUN_TEST(test_slow_rtc_trims_negative_rounded);
+  RUN_TEST(test_small_rate_rounds_to_nearest_step);
+  RUN_TEST(test_large_rate_clamps_to_register_range);
+  RUN_TEST(test_large_negative_rate_clamps_to_register_range);
+  RUN_TEST(test_learned_rate_survives_restart);
+  return UNITY_END();
+}
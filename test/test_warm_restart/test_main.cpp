@@ -0,0 +1,247 @@
+// Warm restart handoff: the frame and mode saved in RTC memory, the latch
+// across the reset and the new controller driving the saved frame before
+// its config is loaded, without a zero or partial frame in between.
+//
+//   pio test -e native -f test_warm_restart
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LedController.h"
+#include "ControlCommand.h"
+#include "WarmRestart.h"
+#include "SimulatedLightingHal.h"
+
+#define MAX_RECORDED_WRITES 64
+
+// Records every duty write so the frames between reset and config load can be checked
+class RecordingPwmSink : public SimulatedPwmSink {
+public:
+  uint8_t channels[MAX_RECORDED_WRITES];
+  uint8_t values[MAX_RECORDED_WRITES];
+  size_t recorded = 0;
+
+  void write(uint8_t channel, uint8_t value) override {
+    if (recorded < MAX_RECORDED_WRITES) {
+      channels[recorded] = channel;
+      values[recorded] = value;
+      recorded++;
+    }
+    SimulatedPwmSink::write(channel, value);
+  }
+
+  void clearHistory() {
+    recorded = 0;
+  }
+};
+
+static RecordingPwmSink pwm;
+static MemoryKeyValueStore store;
+static ManualClock wallClock;
+static LedController* controller;
+
+// Nilai < 128 di-latch ke 0: frame ini pasti terlihat bila ada glitch
+static const LightProfile MANUAL_FRAME = {40, 90, 130, 200, 10, 250, 77};
+static const LightProfile DAWN = {12, 24, 36, 48, 60, 72, 84};
+
+void setUp(void) {
+  pwm = RecordingPwmSink();
+  store = MemoryKeyValueStore();
+  wallClock = ManualClock();
+  wallClock.set(6, 0);
+  warmRestartInvalidate(warmRestartMemory());
+  controller = new LedController(&pwm, &store, &wallClock);
+  controller->restoreWarmOutput(false);
+  controller->restoreOutput();
+}
+
+void tearDown(void) {
+  delete controller;
+  controller = nullptr;
+}
+
+static uint16_t apply(const ControlCommand& command) {
+  uint32_t value;
+  return controller->applyCommand(command, value);
+}
+
+static void setManualFrame(const LightProfile& frame) {
+  ControlCommand command = {};
+  command.type = CMD_SET_ALL;
+  command.frame = frame;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+}
+
+static void loadDawnSchedule() {
+  ControlCommand command = {};
+  command.type = CMD_SET_SCHEDULE;
+  command.schedule.hourMask = 0xFFFFFF;
+  command.schedule.profiles[6] = DAWN;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+}
+
+// ESP.restart(): NVS di-flush dan output di-latch; PWM sink (pin) tetap sama
+static void restartController() {
+  controller->prepareForRestart();
+  TEST_ASSERT_TRUE(pwm.latched);
+  delete controller;
+  pwm.clearHistory();
+  controller = new LedController(&pwm, &store, &wallClock);
+  TEST_ASSERT_EQUAL_UINT32(0, pwm.recorded);  // Konstruktor tidak menyentuh pin
+}
+
+// Setiap write sejak restart langsung ke nilai akhir channel: tidak ada 0 atau frame parsial
+static void assertOnlyWritesTo(const LightProfile& frame) {
+  const uint8_t* target = (const uint8_t*)&frame;
+  for (size_t i = 0; i < pwm.recorded; i++) {
+    TEST_ASSERT_EQUAL_UINT8(target[pwm.channels[i]], pwm.values[i]);
+  }
+}
+
+static void assertDuty(const LightProfile& frame) {
+  TEST_ASSERT_EQUAL_UINT8_ARRAY((const uint8_t*)&frame, pwm.duty, LED_CHANNEL_COUNT);
+}
+
+static void test_record_follows_output_and_mode(void) {
+  setManualFrame(MANUAL_FRAME);
+
+  WarmRestartState& state = warmRestartMemory();
+  TEST_ASSERT_TRUE(warmRestartValid(state));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY((const uint8_t*)&MANUAL_FRAME, state.frame, WARM_RESTART_CHANNELS);
+  TEST_ASSERT_EQUAL_UINT8(MODE_MANUAL, state.mode);
+  TEST_ASSERT_EQUAL_UINT8(0, state.held);
+}
+
+static void test_latch_holds_nearest_level_across_reset(void) {
+  setManualFrame(MANUAL_FRAME);
+  controller->prepareForRestart();
+
+  const uint8_t expected[LED_CHANNEL_COUNT] = {0, 0, 255, 255, 0, 255, 0};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, pwm.duty, LED_CHANNEL_COUNT);
+  TEST_ASSERT_EQUAL_UINT8(1, warmRestartMemory().held);
+  TEST_ASSERT_TRUE(warmRestartValid(warmRestartMemory()));
+}
+
+static void test_warm_frame_applied_before_config_loads(void) {
+  setManualFrame(MANUAL_FRAME);
+  restartController();
+
+  TEST_ASSERT_TRUE(controller->restoreWarmOutput(true));
+  TEST_ASSERT_TRUE(controller->isWarmBoot());
+  TEST_ASSERT_FALSE(pwm.latched);
+  assertDuty(MANUAL_FRAME);
+
+  // Tepat satu frame lengkap, tiap channel sekali, langsung ke nilai sebelum reset
+  TEST_ASSERT_EQUAL_UINT32(LED_CHANNEL_COUNT, pwm.recorded);
+  uint8_t writesPerChannel[LED_CHANNEL_COUNT] = {};
+  for (size_t i = 0; i < pwm.recorded; i++) {
+    writesPerChannel[pwm.channels[i]]++;
+  }
+  TEST_ASSERT_EACH_EQUAL_UINT8(1, writesPerChannel, LED_CHANNEL_COUNT);
+  assertOnlyWritesTo(MANUAL_FRAME);
+
+  WarmRestartState& state = warmRestartMemory();
+  TEST_ASSERT_EQUAL_UINT32(1, state.warmBoots);
+  TEST_ASSERT_EQUAL_UINT8(0, state.held);
+}
+
+static void test_warm_record_keeps_mode_until_config_loads(void) {
+  setManualFrame(MANUAL_FRAME);
+  restartController();
+
+  // Konstruktor baru default ke AUTO; record RTC tetap MANUAL
+  TEST_ASSERT_TRUE(controller->restoreWarmOutput(true));
+  TEST_ASSERT_TRUE(warmRestartValid(warmRestartMemory()));
+  TEST_ASSERT_EQUAL_UINT8(MODE_MANUAL, warmRestartMemory().mode);
+
+  controller->restoreOutput();
+  TEST_ASSERT_EQUAL(MODE_MANUAL, controller->getMode());
+  TEST_ASSERT_EQUAL_UINT8(MODE_MANUAL, warmRestartMemory().mode);
+}
+
+static void test_config_load_keeps_frame_without_glitch(void) {
+  setManualFrame(MANUAL_FRAME);
+  restartController();
+  TEST_ASSERT_TRUE(controller->restoreWarmOutput(true));
+  uint32_t begins = pwm.begins;
+
+  // PWM sudah berjalan: restoreOutput() tidak menginisialisasi ulang pin
+  controller->restoreOutput();
+  TEST_ASSERT_EQUAL_UINT32(begins, pwm.begins);
+  assertDuty(MANUAL_FRAME);
+  assertOnlyWritesTo(MANUAL_FRAME);
+}
+
+static void test_auto_mode_moves_straight_to_schedule(void) {
+  loadDawnSchedule();
+  wallClock.set(6, 0);
+  controller->update();
+  assertDuty(DAWN);
+
+  // Reset di jam 6, jadwal sudah tersimpan: frame warm = DAWN, mode AUTO
+  restartController();
+  TEST_ASSERT_TRUE(controller->restoreWarmOutput(true));
+  assertDuty(DAWN);
+  TEST_ASSERT_EQUAL_UINT8(MODE_AUTO, warmRestartMemory().mode);
+
+  controller->restoreOutput();
+  assertDuty(DAWN);
+  assertOnlyWritesTo(DAWN);
+}
+
+static void test_off_mode_survives_warm_restart(void) {
+  setManualFrame(MANUAL_FRAME);
+  ControlCommand command = {};
+  command.type = CMD_SET_MODE;
+  command.mode.mode = MODE_OFF;
+  TEST_ASSERT_EQUAL_UINT16(200, apply(command));
+
+  restartController();
+  TEST_ASSERT_TRUE(controller->restoreWarmOutput(true));
+  TEST_ASSERT_EQUAL_UINT8(MODE_OFF, warmRestartMemory().mode);
+
+  controller->restoreOutput();
+  TEST_ASSERT_EQUAL(MODE_OFF, controller->getMode());
+  const LightProfile off = {0, 0, 0, 0, 0, 0, 0};
+  assertDuty(off);
+}
+
+static void test_cold_reset_ignores_record(void) {
+  setManualFrame(MANUAL_FRAME);
+  restartController();
+
+  // Reset yang tidak menjaga RTC memory (power/brownout): record dibuang
+  TEST_ASSERT_FALSE(controller->restoreWarmOutput(false));
+  TEST_ASSERT_FALSE(controller->isWarmBoot());
+  TEST_ASSERT_EQUAL_UINT32(0, pwm.recorded);
+  TEST_ASSERT_FALSE(warmRestartValid(warmRestartMemory()));
+
+  // Config dari NVS tetap mengembalikan frame manual
+  controller->restoreOutput();
+  TEST_ASSERT_EQUAL(MODE_MANUAL, controller->getMode());
+  assertDuty(MANUAL_FRAME);
+}
+
+static void test_corrupt_record_is_not_applied(void) {
+  setManualFrame(MANUAL_FRAME);
+  restartController();
+  warmRestartMemory().frame[2] ^= 0x01;  // CRC tidak cocok lagi
+
+  TEST_ASSERT_FALSE(controller->restoreWarmOutput(true));
+  TEST_ASSERT_EQUAL_UINT32(0, pwm.recorded);
+  TEST_ASSERT_TRUE(pwm.latched);
+}
+
+int main() {
+  Serial.enabled = false;  // Hanya hasil Unity di output
+  UNITY_BEGIN();
+  RUN_TEST(test_record_follows_output_and_mode);
+  RUN_TEST(test_latch_holds_nearest_level_across_reset);
+  RUN_TEST(test_warm_frame_applied_before_config_loads);
+  RUN_TEST(test_warm_record_keeps_mode_until_config_loads);
+  RUN_TEST(test_config_load_keeps_frame_without_glitch);
+  RUN_TEST(test_auto_mode_moves_straight_to_schedule);
+  RUN_TEST(test_off_mode_survives_warm_restart);
+  RUN_TEST(test_cold_reset_ignores_record);
+  RUN_TEST(test_corrupt_record_is_not_applied);
+  return UNITY_END();
+}
@@ -0,0 +1,302 @@
+// WiFiLink state machine against SimulatedWiFiDriver: the first bring-up,
+// start timeouts, backoff growth, the AP dropping after it was up and the
+// reconnect with a driver reset. Time is simulated; every update() call is
+// also timed on the host clock to catch anything that waits inside it.
+//
+//   pio test -e native -f test_wifi_link
+
+#include <unity.h>
+#include <chrono>
+#include "WiFiLink.h"
+#include "SimulatedWiFiDriver.h"
+
+#define STEP_MS          10     // Update period of the simulated network task
+#define MAX_UPDATE_US    50000  // Far below the shortest settle time (500 ms)
+#define MAX_TRANSITIONS  256
+
+struct Transition {
+  uint32_t at;
+  WiFiLinkState state;
+};
+
+static SimulatedWiFiDriver* driver;
+static WiFiLink* wifiLink;
+static uint32_t now;
+static Transition transitions[MAX_TRANSITIONS];
+static size_t transitionCount;
+static WiFiLinkState lastState;
+static int64_t slowestUpdateUs;
+
+static void record(WiFiLinkState state) {
+  if (state == lastState) return;
+  lastState = state;
+  if (transitionCount < MAX_TRANSITIONS) {
+    transitions[transitionCount++] = {now, state};
+  }
+}
+
+void setUp(void) {
+  driver = new SimulatedWiFiDriver();
+  wifiLink = new WiFiLink(driver, "test-ap", "password");
+  now = 0;
+  transitionCount = 0;
+  lastState = WIFI_LINK_IDLE;
+  slowestUpdateUs = 0;
+}
+
+void tearDown(void) {
+  delete wifiLink;
+  delete driver;
+}
+
+static void start() {
+  wifiLink->start(now);
+  record(wifiLink->getState());
+}
+
+// Jalankan update() tiap STEP_MS sampai `until` (waktu simulasi)
+static void runUntil(uint32_t until) {
+  while ((int32_t)(until - now) > 0) {
+    now += STEP_MS;
+    auto begin = std::chrono::steady_clock::now();
+    wifiLink->update(now);
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - begin).count();
+    if (elapsed > slowestUpdateUs) {
+      slowestUpdateUs = elapsed;
+    }
+    record(wifiLink->getState());
+  }
+}
+
+// Jalankan sampai state tercapai atau batas waktu habis
+static bool runUntilState(WiFiLinkState target, uint32_t limitMs) {
+  uint32_t until = now + limitMs;
+  while (wifiLink->getState() != target && (int32_t)(until - now) > 0) {
+    runUntil(now + STEP_MS);
+  }
+  return wifiLink->getState() == target;
+}
+
+static void assertNeverBlocked() {
+  TEST_ASSERT_LESS_THAN(MAX_UPDATE_US, slowestUpdateUs);
+}
+
+static void assertTransition(size_t index, WiFiLinkState state, uint32_t at) {
+  TEST_ASSERT_TRUE(index < transitionCount);
+  TEST_ASSERT_EQUAL_UINT8(state, transitions[index].state);
+  TEST_ASSERT_EQUAL_UINT32(at, transitions[index].at);
+}
+
+// Lama tiap BACKOFF yang sudah selesai, berurutan
+static size_t backoffDurations(uint32_t* durations, size_t capacity) {
+  size_t count = 0;
+  for (size_t i = 0; i + 1 < transitionCount && count < capacity; i++) {
+    if (transitions[i].state == WIFI_LINK_BACKOFF) {
+      durations[count++] = transitions[i + 1].at - transitions[i].at;
+    }
+  }
+  return count;
+}
+
+static void test_first_attempt_brings_ap_up(void) {
+  start();
+  runUntil(5000);
+
+  // Tanpa kegagalan: radio off -> mode AP -> softAP() -> event -> verifikasi
+  assertTransition(0, WIFI_LINK_SHUTDOWN, 0);
+  assertTransition(1, WIFI_LINK_ENABLE_AP, WIFI_SHUTDOWN_SETTLE_MS);
+  assertTransition(2, WIFI_LINK_STARTING, WIFI_SHUTDOWN_SETTLE_MS + WIFI_MODE_SETTLE_MS);
+  assertTransition(3, WIFI_LINK_VERIFYING, WIFI_SHUTDOWN_SETTLE_MS + WIFI_MODE_SETTLE_MS + STEP_MS);
+  assertTransition(4, WIFI_LINK_UP,
+                   WIFI_SHUTDOWN_SETTLE_MS + WIFI_MODE_SETTLE_MS + STEP_MS + WIFI_VERIFY_MS);
+  TEST_ASSERT_EQUAL_UINT32(5, transitionCount);
+
+  TEST_ASSERT_TRUE(wifiLink->isUp());
+  TEST_ASSERT_EQUAL_UINT32(1, wifiLink->getAttempts());
+  TEST_ASSERT_EQUAL_UINT8(0, wifiLink->getFailures());
+  TEST_ASSERT_EQUAL_UINT32(0, driver->resetSteps);
+  TEST_ASSERT_EQUAL_UINT32(1, driver->apStarts);
+  assertNeverBlocked();
+}
+
+static void test_steps_wait_for_their_deadline(void) {
+  start();
+  uint32_t shutdowns = driver->shutdowns;
+
+  // Sebelum settle time habis, update() tidak memanggil driver sama sekali
+  runUntil(WIFI_SHUTDOWN_SETTLE_MS - STEP_MS);
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_SHUTDOWN, wifiLink->getState());
+  TEST_ASSERT_EQUAL_UINT32(shutdowns, driver->shutdowns);
+  TEST_ASSERT_EQUAL_UINT32(0, driver->apStarts);
+
+  runUntil(WIFI_SHUTDOWN_SETTLE_MS);
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_ENABLE_AP, wifiLink->getState());
+  assertNeverBlocked();
+}
+
+static void test_start_timeout_retries_with_driver_reset(void) {
+  driver->dropStartEvent = 1;
+  start();
+
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_BACKOFF, 10000));
+  uint32_t started = WIFI_SHUTDOWN_SETTLE_MS + WIFI_MODE_SETTLE_MS;
+  TEST_ASSERT_EQUAL_UINT32(started + WIFI_AP_START_TIMEOUT_MS, now);
+  TEST_ASSERT_EQUAL_UINT8(1, wifiLink->getFailures());
+  TEST_ASSERT_FALSE(wifiLink->hasGivenUp());
+
+  // Percobaan kedua melewati keempat langkah reset driver
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 30000));
+  TEST_ASSERT_EQUAL_UINT32(WIFI_RESET_STEP_COUNT, driver->resetSteps);
+  TEST_ASSERT_EQUAL_UINT32(2, wifiLink->getAttempts());
+  TEST_ASSERT_EQUAL_UINT8(0, wifiLink->getFailures());
+
+  uint32_t backoff[1];
+  TEST_ASSERT_EQUAL_UINT32(1, backoffDurations(backoff, 1));
+  TEST_ASSERT_EQUAL_UINT32(WIFI_RETRY_BOOT_MS, backoff[0]);
+  assertNeverBlocked();
+}
+
+static void test_backoff_grows_after_boot_attempts(void) {
+  driver->failStartAP = 0xFF;
+  start();
+  runUntil(WIFI_EARLY_PERIOD_MS + 120000);
+
+  uint32_t backoff[64];
+  size_t count = backoffDurations(backoff, 64);
+  TEST_ASSERT_GREATER_THAN(WIFI_BOOT_ATTEMPTS + 4, count);
+
+  // 5 s untuk percobaan boot, lalu 10 s, lalu 30 s setelah 5 menit sejak start()
+  uint32_t entered = 0;
+  size_t seen = 0;
+  for (size_t i = 0; i < transitionCount && seen < count; i++) {
+    if (transitions[i].state != WIFI_LINK_BACKOFF) continue;
+    entered = transitions[i].at;
+    uint32_t expected;
+    if (seen < WIFI_BOOT_ATTEMPTS) {
+      expected = WIFI_RETRY_BOOT_MS;
+    } else if (entered < WIFI_EARLY_PERIOD_MS) {
+      expected = WIFI_RETRY_EARLY_MS;
+    } else {
+      expected = WIFI_RETRY_LATE_MS;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, backoff[seen]);
+    seen++;
+  }
+  TEST_ASSERT_GREATER_THAN(WIFI_EARLY_PERIOD_MS, entered);
+
+  TEST_ASSERT_TRUE(wifiLink->hasGivenUp());
+  TEST_ASSERT_EQUAL_UINT32(0, driver->apStarts);
+  TEST_ASSERT_FALSE(wifiLink->isUp());
+  assertNeverBlocked();
+}
+
+static void test_gives_up_after_boot_attempts_but_keeps_retrying(void) {
+  driver->failEnableAP = WIFI_BOOT_ATTEMPTS;
+  start();
+
+  for (uint8_t failure = 1; failure <= WIFI_BOOT_ATTEMPTS; failure++) {
+    TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_BACKOFF, 30000));
+    TEST_ASSERT_EQUAL_UINT8(failure, wifiLink->getFailures());
+    TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_SHUTDOWN, 30000));
+  }
+  TEST_ASSERT_TRUE(wifiLink->hasGivenUp());
+
+  // Retry di latar belakang tetap berjalan dan akhirnya berhasil
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 30000));
+  TEST_ASSERT_FALSE(wifiLink->hasGivenUp());
+  TEST_ASSERT_EQUAL_UINT32(WIFI_BOOT_ATTEMPTS + 1, wifiLink->getAttempts());
+  assertNeverBlocked();
+}
+
+static void test_drop_after_up_reconnects(void) {
+  start();
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 10000));
+  size_t upIndex = transitionCount - 1;
+
+  driver->dropAP();
+  uint32_t dropped = now;
+  runUntil(now + STEP_MS);
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_BACKOFF, wifiLink->getState());
+  TEST_ASSERT_EQUAL_UINT8(1, wifiLink->getFailures());
+
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 30000));
+  TEST_ASSERT_EQUAL_UINT32(2, wifiLink->getAttempts());
+  TEST_ASSERT_EQUAL_UINT32(2, driver->apStarts);
+  TEST_ASSERT_EQUAL_UINT32(WIFI_RESET_STEP_COUNT, driver->resetSteps);
+  TEST_ASSERT_TRUE(driver->apRunning);
+
+  // UP -> BACKOFF (5 s) -> SHUTDOWN -> DRIVER_RESET -> ENABLE_AP -> STARTING -> VERIFYING -> UP
+  const WiFiLinkState expected[] = {
+    WIFI_LINK_UP, WIFI_LINK_BACKOFF, WIFI_LINK_SHUTDOWN, WIFI_LINK_DRIVER_RESET,
+    WIFI_LINK_ENABLE_AP, WIFI_LINK_STARTING, WIFI_LINK_VERIFYING, WIFI_LINK_UP
+  };
+  const size_t expectedCount = sizeof(expected) / sizeof(expected[0]);
+  TEST_ASSERT_EQUAL_UINT32(upIndex + expectedCount, transitionCount);
+  for (size_t i = 0; i < expectedCount; i++) {
+    TEST_ASSERT_EQUAL_UINT8(expected[i], transitions[upIndex + i].state);
+  }
+  TEST_ASSERT_EQUAL_UINT32(dropped + STEP_MS, transitions[upIndex + 1].at);
+  TEST_ASSERT_EQUAL_UINT32(dropped + STEP_MS + WIFI_RETRY_BOOT_MS, transitions[upIndex + 2].at);
+  assertNeverBlocked();
+}
+
+static void test_stop_during_start_or_verification_fails_attempt(void) {
+  driver->stopAfterStart = 1;
+  start();
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_BACKOFF, 10000));
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_STARTING, transitions[transitionCount - 2].state);
+
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_VERIFYING, 30000));
+  driver->dropAP();
+  runUntil(now + STEP_MS);
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_BACKOFF, wifiLink->getState());
+  TEST_ASSERT_EQUAL_UINT8(2, wifiLink->getFailures());
+
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 30000));
+  assertNeverBlocked();
+}
+
+static void test_health_check_catches_address_change(void) {
+  start();
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 10000));
+
+  driver->wrongAddress = 1;
+  runUntil(now + WIFI_HEALTH_CHECK_MS - STEP_MS);
+  TEST_ASSERT_TRUE(wifiLink->isUp());
+  runUntil(now + STEP_MS);
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_BACKOFF, wifiLink->getState());
+
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 30000));
+  assertNeverBlocked();
+}
+
+static void test_restart_request_starts_plain_attempt(void) {
+  start();
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 10000));
+
+  wifiLink->requestRestart();
+  runUntil(now + STEP_MS);
+  TEST_ASSERT_EQUAL_UINT8(WIFI_LINK_SHUTDOWN, wifiLink->getState());
+  TEST_ASSERT_FALSE(driver->apRunning);
+
+  // Restart manual bukan kegagalan: tanpa reset driver
+  TEST_ASSERT_TRUE(runUntilState(WIFI_LINK_UP, 10000));
+  TEST_ASSERT_EQUAL_UINT32(0, driver->resetSteps);
+  TEST_ASSERT_EQUAL_UINT32(2, wifiLink->getAttempts());
+  assertNeverBlocked();
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_attempt_brings_ap_up);
+  RUN_TEST(test_steps_wait_for_their_deadline);
+  RUN_TEST(test_start_timeout_retries_with_driver_reset);
+  RUN_TEST(test_backoff_grows_after_boot_attempts);
+  RUN_TEST(test_gives_up_after_boot_attempts_but_keeps_retrying);
+  RUN_TEST(test_drop_after_up_reconnects);
+  RUN_TEST(test_stop_during_start_or_verification_fails_attempt);
+  RUN_TEST(test_health_check_catches_address_change);
+  RUN_TEST(test_restart_request_starts_plain_attempt);
+  return UNITY_END();
+}
@@ -0,0 +1,83 @@
+"""
+Compare two microbenchmark runs.
+
+Reads the JSON written by the bench-native or bench-esp32 environment (a
+file, or a serial log containing the JSON line) for a baseline and a current
+run, prints a table per case and exits with status 1 when a case got slower
+than the threshold or started allocating more.
+
+    python tools/bench_compare.py baseline.json current.json --threshold 10
+
+Runs from different targets (native vs esp32) are refused; cycles/op is
+compared instead of ns/op when both runs have it. Requires only the
+standard library.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, encoding="utf-8", errors="replace") as source:
+        for line in source:
+            line = line.strip()
+            start = line.find('{"target"')
+            if start >= 0:
+                return json.loads(line[start:])
+    sys.exit("%s: no benchmark JSON found" % path)
+
+
+def cost(case):
+    if case.get("cycles_per_op") is not None:
+        return case["cycles_per_op"], "cyc"
+    return case["ns_per_op"], "ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown per case in percent")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    if baseline["target"] != current["target"]:
+        sys.exit("targets differ: %s vs %s" % (baseline["target"], current["target"]))
+
+    before = {case["name"]: case for case in baseline["cases"]}
+    regressions = []
+    print("%-36s %12s %12s %8s %9s" % ("case", baseline["label"], current["label"], "change", "allocs"))
+    for case in current["cases"]:
+        name = case["name"]
+        if name not in before:
+            print("%-36s %12s %12.1f %8s" % (name, "-", cost(case)[0], "new"))
+            continue
+        old, unit = cost(before[name])
+        new, _ = cost(case)
+        change = (new - old) / old * 100 if old > 0 else 0.0
+        allocs = ""
+        if case.get("allocs_per_op") is not None and before[name].get("allocs_per_op") is not None:
+            allocs = "%+.1f" % (case["allocs_per_op"] - before[name]["allocs_per_op"])
+            if case["allocs_per_op"] > before[name]["allocs_per_op"]:
+                regressions.append("%s: allocations/op %s" % (name, allocs))
+        if change > args.threshold:
+            regressions.append("%s: %+.1f%% %s/op" % (name, change, unit))
+        print("%-36s %12.1f %12.1f %+7.1f%% %9s" % (name, old, new, change, allocs))
+
+    missing = set(before) - {case["name"] for case in current["cases"]}
+    for name in sorted(missing):
+        print("%-36s missing in %s" % (name, current["label"]))
+
+    if regressions:
+        print("\nregressions (threshold %.1f%%):" % args.threshold)
+        for line in regressions:
+            print("  " + line)
+        sys.exit(1)
+    print("\nno regressions (threshold %.1f%%)" % args.threshold)
+
+
+if __name__ == "__main__":
+    main()
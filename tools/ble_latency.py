@@ -0,0 +1,116 @@
+"""
+End-to-end BLE command latency.
+
+Connects to the controller's GATT service, subscribes to the result
+characteristic and writes manual frames to the frame characteristic one at a
+time. Each round trip is timed from the write call to the matching result
+notification, i.e. radio + NimBLE + command queue + lighting loop + notify.
+Passes when the 99th percentile is within the bound.
+
+    python tools/ble_latency.py --name SLAB-Aquarium-LED --count 200 --bound-ms 50
+
+Writes need an encrypted link: pair with the controller once through the
+operating system (passkey from BLE_PASSKEY in main.cpp) before running this.
+The mode and frame read at the start are restored at the end. Requires bleak
+(pip install bleak).
+"""
+
+import argparse
+import asyncio
+import struct
+import sys
+import time
+
+try:
+    from bleak import BleakClient, BleakScanner
+except ImportError:
+    sys.exit("bleak is required: pip install bleak")
+
+FRAME_UUID = "8f3e0002-6b2a-4c1d-9e57-5a1b0c2d3e4f"
+MODE_UUID = "8f3e0003-6b2a-4c1d-9e57-5a1b0c2d3e4f"
+RESULT_UUID = "8f3e0007-6b2a-4c1d-9e57-5a1b0c2d3e4f"
+
+OP_FRAME = 0x01
+OP_MODE = 0x03
+MODE_MANUAL = 1
+
+
+def parse_result(data):
+    """opcode, reserved, status u16, seq u32, value u32 (little-endian)."""
+    opcode, _, status, seq, value = struct.unpack("<BBHII", bytes(data))
+    return opcode, status, seq, value
+
+
+def percentile(sorted_values, fraction):
+    index = min(len(sorted_values) - 1, int(fraction * len(sorted_values)))
+    return sorted_values[index]
+
+
+async def run(args):
+    device = await BleakScanner.find_device_by_name(args.name, timeout=args.scan_seconds)
+    if device is None:
+        sys.exit("controller '%s' not found" % args.name)
+
+    async with BleakClient(device) as client:
+        results = asyncio.Queue()
+        await client.start_notify(RESULT_UUID, lambda _, data: results.put_nowait(
+            (time.perf_counter(), parse_result(data))))
+
+        original_mode = (await client.read_gatt_char(MODE_UUID))[0]
+        original_frame = bytes(await client.read_gatt_char(FRAME_UUID))
+
+        async def round_trip(uuid, payload, opcode):
+            started = time.perf_counter()
+            await client.write_gatt_char(uuid, payload, response=not args.no_response)
+            while True:
+                received, (result_opcode, status, _, _) = await asyncio.wait_for(results.get(), 2.0)
+                if result_opcode == opcode:
+                    return (received - started) * 1000.0, status
+
+        latencies = []
+        errors = 0
+        try:
+            for i in range(args.count):
+                # Alternate frames so every write changes the output
+                level = i % 2 * 8
+                payload = bytes([level] * 7)
+                latency, status = await round_trip(FRAME_UUID, payload, OP_FRAME)
+                if status == 200:
+                    latencies.append(latency)
+                else:
+                    errors += 1
+        finally:
+            await round_trip(FRAME_UUID, original_frame, OP_FRAME)
+            if original_mode != MODE_MANUAL:
+                await round_trip(MODE_UUID, bytes([original_mode]), OP_MODE)
+
+    if not latencies:
+        sys.exit("no successful round trips (%d errors)" % errors)
+
+    latencies.sort()
+    p50 = percentile(latencies, 0.50)
+    p99 = percentile(latencies, 0.99)
+    print("Round trips: %d ok, %d errors" % (len(latencies), errors))
+    print("Latency ms: min %.1f, p50 %.1f, p99 %.1f, max %.1f"
+          % (latencies[0], p50, p99, latencies[-1]))
+    print("Device-side share: slab_ble_command_latency_seconds in /api/metrics")
+
+    if p99 > args.bound_ms:
+        print("FAIL: p99 latency above %.1f ms" % args.bound_ms)
+        sys.exit(1)
+    print("PASS: p99 latency within %.1f ms" % args.bound_ms)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--name", default="SLAB-Aquarium-LED")
+    parser.add_argument("--count", type=int, default=200)
+    parser.add_argument("--bound-ms", type=float, default=50.0, help="p99 round-trip bound")
+    parser.add_argument("--scan-seconds", type=float, default=10.0)
+    parser.add_argument("--no-response", action="store_true",
+                        help="write without response (lower latency, no ATT ack)")
+    asyncio.run(run(parser.parse_args()))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,136 @@
+"""
+Minify and gzip the web UI in web/ into src/WebAssets.h.
+
+Runs automatically before every PlatformIO build (extra_scripts = pre:...)
+and can also be run by hand: python tools/embed_web.py
+
+- app.js is served under a content-hashed path (/assets/app.<hash>.js) so it
+  can be cached forever; index.html references that path.
+- index.html is served at / and revalidated with its ETag.
+- The header is only rewritten when its content changes, so unchanged
+  assets do not trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "WebAssets.h")
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{}:;,>])\s*", r"\1", css)
+    return css.replace(";}", "}").strip()
+
+
+def minify_js(js):
+    # Conservative: drop whole-line comments and indentation only.
+    # Line breaks are kept so automatic semicolon insertion is unaffected.
+    lines = []
+    for line in js.splitlines():
+        line = line.strip()
+        if not line or line.startswith("//"):
+            continue
+        lines.append(line)
+    return "\n".join(lines)
+
+
+def minify_html(html):
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    html = re.sub(r"(<style>)(.*?)(</style>)",
+                  lambda m: m.group(1) + minify_css(m.group(2)) + m.group(3),
+                  html, flags=re.S)
+    html = "".join(line.strip() for line in html.splitlines())
+    return html
+
+
+def compress(data):
+    # mtime=0 keeps the output (and the hash) reproducible
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def short_hash(data):
+    return hashlib.sha256(data).hexdigest()[:12]
+
+
+def c_array(name, data):
+    lines = []
+    for offset in range(0, len(data), 16):
+        chunk = data[offset:offset + 16]
+        lines.append("  " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    return ("alignas(4) static constexpr uint8_t %s[] PROGMEM = {\n%s\n};\n"
+            % (name, "\n".join(lines)))
+
+
+def read(name):
+    with open(os.path.join(WEB_DIR, name), "r", encoding="utf-8") as f:
+        return f.read()
+
+
+def build():
+    js_source = read("app.js")
+    js_min = minify_js(js_source).encode("utf-8")
+    js_gz = compress(js_min)
+    js_hash = short_hash(js_gz)
+    js_path = "/assets/app.%s.js" % js_hash
+
+    html_source = read("index.html").replace("{{APP_JS}}", js_path)
+    html_min = minify_html(html_source).encode("utf-8")
+    html_gz = compress(html_min)
+    html_hash = short_hash(html_gz)
+
+    assets = [
+        ("index.html", len(html_source.encode("utf-8")), len(html_min), len(html_gz)),
+        ("app.js", len(js_source.encode("utf-8")), len(js_min), len(js_gz)),
+    ]
+
+    out = []
+    out.append("// Generated by tools/embed_web.py from web/ - do not edit.\n")
+    out.append("#ifndef WEB_ASSETS_H\n#define WEB_ASSETS_H\n\n")
+    out.append("#include <Arduino.h>\n\n")
+    out.append("// %-10s source / minified / gzip bytes\n" % "Asset")
+    for name, raw, mini, gz in assets:
+        out.append("// %-10s %6d / %6d / %6d\n" % (name, raw, mini, gz))
+    out.append("\n")
+    out.append("#define WEB_INDEX_ETAG \"\\\"%s\\\"\"\n" % html_hash)
+    out.append("#define WEB_INDEX_RAW_LEN %d\n" % len(html_min))
+    out.append("#define WEB_INDEX_GZ_LEN %d\n" % len(html_gz))
+    out.append(c_array("WEB_INDEX_GZ", html_gz))
+    out.append("\n")
+    out.append("#define WEB_APP_JS_PATH \"%s\"\n" % js_path)
+    out.append("#define WEB_APP_JS_ETAG \"\\\"%s\\\"\"\n" % js_hash)
+    out.append("#define WEB_APP_JS_RAW_LEN %d\n" % len(js_min))
+    out.append("#define WEB_APP_JS_GZ_LEN %d\n" % len(js_gz))
+    out.append(c_array("WEB_APP_JS_GZ", js_gz))
+    out.append("\n#endif // WEB_ASSETS_H\n")
+    content = "".join(out)
+
+    previous = None
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, "r", encoding="utf-8") as f:
+            previous = f.read()
+    if content != previous:
+        with open(OUTPUT, "w", encoding="utf-8") as f:
+            f.write(content)
+
+    print("Web UI assets (bytes):")
+    print("  %-10s %8s %8s %8s" % ("asset", "source", "minified", "gzip"))
+    for name, raw, mini, gz in assets:
+        print("  %-10s %8d %8d %8d" % (name, raw, mini, gz))
+    total_raw = sum(a[1] for a in assets)
+    total_gz = sum(a[3] for a in assets)
+    print("  first load transfers %d bytes instead of %d (%.0f%%)"
+          % (total_gz, total_raw, 100.0 * total_gz / total_raw))
+
+
+build()
@@ -0,0 +1,144 @@
+"""
+Lighting jitter under API load.
+
+Saturates the controller's HTTP API from several threads (schedule uploads,
+schedule reads, mode reads, pings) and reads the lighting tick jitter
+histogram from /api/metrics before and after. Passes when the 99th
+percentile of the ticks observed during the run is within the bound.
+
+    python tools/latency_test.py --host 192.168.4.1 --seconds 60 --bound-ms 1
+
+Schedule uploads re-send the schedule read at the start, so the lighting
+state does not change, but each accepted upload is one NVS blob write. Use
+--no-uploads to keep the run read-only. Requires only the standard library.
+"""
+
+import argparse
+import json
+import re
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+
+JITTER_METRIC = "slab_lighting_tick_jitter_seconds"
+BUCKET_RE = re.compile(r'^' + JITTER_METRIC + r'_bucket\{le="([^"]+)"\} (\d+)$')
+
+
+def request(base, method, path, body=None, timeout=5):
+    data = body.encode() if body is not None else None
+    req = urllib.request.Request(base + path, data=data, method=method)
+    if data is not None:
+        req.add_header("Content-Type", "application/json")
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as response:
+            return response.status, response.read()
+    except urllib.error.HTTPError as error:
+        return error.code, error.read()
+
+
+def read_jitter_buckets(base):
+    """Cumulative bucket counts keyed by upper bound in seconds (inf last)."""
+    for _ in range(5):
+        status, body = request(base, "GET", "/api/metrics")
+        if status == 200:
+            break
+        time.sleep(1)  # 503 while another scrape is being sent
+    else:
+        raise RuntimeError("could not read /api/metrics (status %d)" % status)
+
+    buckets = {}
+    for line in body.decode().splitlines():
+        match = BUCKET_RE.match(line)
+        if match:
+            bound = float("inf") if match.group(1) == "+Inf" else float(match.group(1))
+            buckets[bound] = int(match.group(2))
+    if not buckets:
+        raise RuntimeError(JITTER_METRIC + " not found in /api/metrics")
+    return buckets
+
+
+def percentile_bound(before, after, fraction):
+    """Smallest bucket bound that holds `fraction` of the ticks in the window."""
+    total = after[float("inf")] - before.get(float("inf"), 0)
+    if total == 0:
+        return None, 0
+    for bound in sorted(after):
+        if after[bound] - before.get(bound, 0) >= fraction * total:
+            return bound, total
+    return float("inf"), total
+
+
+def worker(base, schedule_body, stop, stats, lock):
+    # Mix dominated by heavy requests, the case that used to delay the lighting tick
+    plan = ["/api/schedule/hourly", "/api/mode", "/api/ping", "/api/schedule/hourly"]
+    step = 0
+    while not stop.is_set():
+        path = plan[step % len(plan)]
+        upload = schedule_body is not None and step % 2 == 0 and path == "/api/schedule/hourly"
+        step += 1
+        try:
+            if upload:
+                status, _ = request(base, "POST", path, schedule_body)
+            else:
+                status, _ = request(base, "GET", path)
+        except OSError:
+            status = "error"
+        with lock:
+            stats[status] = stats.get(status, 0) + 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--seconds", type=int, default=60)
+    parser.add_argument("--workers", type=int, default=6)
+    parser.add_argument("--bound-ms", type=float, default=1.0,
+                        help="p99 tick jitter bound (a histogram bucket: 0.5, 1, 2.5, 5, 10 ...)")
+    parser.add_argument("--no-uploads", action="store_true", help="read-only load")
+    args = parser.parse_args()
+
+    base = "http://" + args.host
+    schedule_body = None
+    if not args.no_uploads:
+        status, body = request(base, "GET", "/api/schedule/hourly")
+        if status != 200:
+            sys.exit("could not read the current schedule (status %d)" % status)
+        schedule_body = json.dumps(json.loads(body))
+
+    before = read_jitter_buckets(base)
+    stop = threading.Event()
+    stats = {}
+    lock = threading.Lock()
+    threads = [threading.Thread(target=worker, args=(base, schedule_body, stop, stats, lock))
+               for _ in range(args.workers)]
+    started = time.time()
+    for thread in threads:
+        thread.start()
+    time.sleep(args.seconds)
+    stop.set()
+    for thread in threads:
+        thread.join()
+    elapsed = time.time() - started
+    after = read_jitter_buckets(base)
+
+    requests = sum(stats.values())
+    print("Load: %d requests in %.0f s (%.1f/s)" % (requests, elapsed, requests / elapsed))
+    print("Responses: " + ", ".join("%s=%d" % (k, v) for k, v in sorted(stats.items(), key=str)))
+
+    p99, ticks = percentile_bound(before, after, 0.99)
+    worst, _ = percentile_bound(before, after, 1.0)
+    if ticks == 0:
+        sys.exit("no lighting ticks recorded during the run")
+    print("Lighting ticks: %d, p99 jitter <= %s ms, max jitter <= %s ms"
+          % (ticks, p99 * 1000, worst * 1000))
+
+    if p99 > args.bound_ms / 1000.0:
+        print("FAIL: p99 jitter above %.2f ms" % args.bound_ms)
+        sys.exit(1)
+    print("PASS: p99 jitter within %.2f ms" % args.bound_ms)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,380 @@
+"""
+HTTP load generator and replay harness.
+
+Sends requests at a fixed rate (open loop: the schedule does not wait for
+slow responses) from several worker threads and source addresses, then
+reports throughput, latency percentiles, status codes, heap low-water mark
+and command queue rejects. Latency is measured from the scheduled send time,
+so queueing in front of a slow server is counted.
+
+Built for the host server (src/loadtest/, [env:native-http]) but works
+against the device as well:
+
+    pio run -e native-http
+    python tools/loadgen.py --spawn .pio/build/native-http/program --mix sliders --rate 100
+    python tools/loadgen.py --host http://192.168.4.1 --replay session.txt
+
+Traffic:
+    --mix sliders   POST /api/manual, random channel and value (slider drags)
+    --mix upload    POST /api/schedule/hourly with the schedule read at start
+    --mix reads     GET mode, time, ping, one hour of the schedule
+    --mix mixed     mostly sliders and reads, some uploads and mode changes
+    --replay FILE   one request per line, as in the native driver scripts:
+                        [@ms] METHOD PATH [body]
+                    @ms is the send time from the start of the run (scaled
+                    by --speed); lines without it are paced at --rate.
+
+--clients N spreads requests over N source addresses (127.0.0.10 ...) so the
+per-client rate limit sees N clients; only meaningful on loopback.
+
+With --spawn the server is started with --frames; the LED frame sequence is
+summarized and the final frame is checked against the last accepted
+/api/manual write per channel (highest seq). Requires only the standard
+library.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import random
+import re
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.parse
+
+CHANNELS = ["royalBlue", "blue", "uv", "violet", "red", "green", "white"]
+METRIC_RE = re.compile(r'^(slab_[a-z_]+)(\{[^}]*\})? (\S+)$')
+
+
+class Target:
+    def __init__(self, base, clients, timeout):
+        url = urllib.parse.urlsplit(base)
+        self.host = url.hostname
+        self.port = url.port or 80
+        self.clients = clients
+        self.timeout = timeout
+
+    def send(self, method, path, body=None, client=0):
+        source = None
+        if self.clients > 1:
+            source = ("127.0.0.%d" % (10 + client % self.clients), 0)
+        connection = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout,
+                                                source_address=source)
+        try:
+            headers = {"Content-Type": "application/json"} if body is not None else {}
+            connection.request(method, path, body=body, headers=headers)
+            response = connection.getresponse()
+            return response.status, response.read()
+        finally:
+            connection.close()
+
+
+def read_metrics(target):
+    """slab_* samples without labels from /api/metrics, {} if unavailable."""
+    for _ in range(5):
+        try:
+            status, body = target.send("GET", "/api/metrics")
+        except OSError:
+            status = 0
+        if status == 200:
+            break
+        time.sleep(0.5)  # 503 while another scrape is being sent
+    else:
+        return {}
+    values = {}
+    for line in body.decode().splitlines():
+        match = METRIC_RE.match(line)
+        if match and match.group(2) is None:
+            values[match.group(1)] = float(match.group(3))
+    return values
+
+
+# ========== TRAFFIC ==========
+
+def parse_replay(path, speed):
+    """List of (offset seconds or None, method, path, body)."""
+    plan = []
+    with open(path) as source:
+        for line in source:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            offset = None
+            if line.startswith("@"):
+                stamp, _, line = line.partition(" ")
+                offset = float(stamp[1:]) / 1000.0 / speed
+            parts = line.split(" ", 2)
+            if len(parts) < 2:
+                raise ValueError("bad replay line: " + line)
+            body = parts[2] if len(parts) > 2 else None
+            plan.append((offset, parts[0].upper(), parts[1], body))
+    return plan
+
+
+def mix_generator(name, schedule_body, rng):
+    def slider():
+        channel = rng.choice(CHANNELS)
+        return "POST", "/api/manual", json.dumps({"led": channel, "value": rng.randrange(256)})
+
+    def read():
+        path = rng.choice(["/api/mode", "/api/time", "/api/ping", "/api/schedule/hourly/%d" % rng.randrange(24)])
+        return "GET", path, None
+
+    def upload():
+        return "POST", "/api/schedule/hourly", schedule_body
+
+    def mode():
+        return "POST", "/api/mode", json.dumps({"mode": "manual"})
+
+    if name == "sliders":
+        return slider
+    if name == "reads":
+        return read
+    if name == "upload":
+        if schedule_body is None:
+            raise RuntimeError("could not read /api/schedule/hourly for the upload mix")
+        return upload
+    weighted = [(slider, 60), (read, 30), (mode, 5)]
+    if schedule_body is not None:
+        weighted.append((upload, 5))
+
+    def mixed():
+        return rng.choices([f for f, _ in weighted], [w for _, w in weighted])[0]()
+    return mixed
+
+
+# ========== RUN ==========
+
+class Results:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = []
+        self.statuses = {}
+        self.errors = 0
+        self.writes = {}  # channel -> (seq, value) of the newest accepted write
+
+    def record(self, status, latency, method, path, body, response):
+        with self.lock:
+            self.latencies.append(latency)
+            self.statuses[status] = self.statuses.get(status, 0) + 1
+            if status != 200 or path != "/api/manual" or body is None:
+                return
+            try:
+                request = json.loads(body)
+                seq = json.loads(response).get("seq")
+            except ValueError:
+                return
+            if seq is None:
+                return
+            current = self.writes.get(request.get("led"))
+            if current is None or seq > current[0]:
+                self.writes[request.get("led")] = (seq, request.get("value"))
+
+    def error(self, latency):
+        with self.lock:
+            self.errors += 1
+            self.latencies.append(latency)
+
+
+def run(target, plan, rate, duration, concurrency, results):
+    """plan(index) -> (offset or None, method, path, body) or None when done."""
+    tasks = []
+    condition = threading.Condition()
+    done = [False]
+    start = time.monotonic()
+
+    def worker(number):
+        while True:
+            with condition:
+                while not tasks and not done[0]:
+                    condition.wait()
+                if not tasks:
+                    return
+                scheduled, method, path, body, client = tasks.pop(0)
+            try:
+                status, response = target.send(method, path, body, client)
+                results.record(status, time.monotonic() - scheduled, method, path, body, response)
+            except OSError:
+                results.error(time.monotonic() - scheduled)
+
+    workers = [threading.Thread(target=worker, args=(i,), daemon=True) for i in range(concurrency)]
+    for thread in workers:
+        thread.start()
+
+    index = 0
+    while True:
+        item = plan(index)
+        if item is None:
+            break
+        offset, method, path, body = item
+        if offset is None:
+            offset = index / rate
+        if duration is not None and offset >= duration:
+            break
+        scheduled = start + offset
+        delay = scheduled - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        with condition:
+            tasks.append((scheduled, method, path, body, index))
+            condition.notify()
+        index += 1
+
+    with condition:
+        done[0] = True
+        condition.notify_all()
+    for thread in workers:
+        thread.join()
+    return index, time.monotonic() - start
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def read_frames(path):
+    with open(path) as source:
+        rows = [line.strip().split(",") for line in source.readlines()[1:] if line.strip()]
+    return [(int(row[0]), [int(value) for value in row[1:]]) for row in rows]
+
+
+def check_final_frame(frames, writes, mode):
+    """None if consistent, otherwise a description of the mismatch."""
+    if not frames or not writes:
+        return None
+    if mode != "manual":
+        return None  # Schedule output, nothing to compare
+    last = frames[-1][1]
+    wrong = []
+    for channel, (seq, value) in writes.items():
+        index = CHANNELS.index(channel)
+        if last[index] != value:
+            wrong.append("%s=%d (expected %d from seq %d)" % (channel, last[index], value, seq))
+    return ", ".join(wrong) or None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP load generator and replay harness")
+    parser.add_argument("--host", default=None, help="base URL (default http://127.0.0.1:PORT)")
+    parser.add_argument("--port", type=int, default=8080, help="port of the host server")
+    parser.add_argument("--spawn", metavar="PROGRAM", help="start this host server for the run")
+    traffic = parser.add_mutually_exclusive_group()
+    traffic.add_argument("--mix", choices=["sliders", "upload", "reads", "mixed"], default="mixed")
+    traffic.add_argument("--replay", metavar="FILE", help="request log to replay")
+    parser.add_argument("--rate", type=float, default=50.0, help="requests per second")
+    parser.add_argument("--duration", type=float, default=None,
+                        help="seconds (default 10 for mixes, whole log for replay)")
+    parser.add_argument("--speed", type=float, default=1.0, help="replay time scale for @ms lines")
+    parser.add_argument("--concurrency", type=int, default=8, help="requests in flight")
+    parser.add_argument("--clients", type=int, default=1, help="distinct source addresses")
+    parser.add_argument("--timeout", type=float, default=10.0, help="per-request timeout (s)")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--json", action="store_true", help="print the summary as JSON")
+    args = parser.parse_args()
+
+    base = args.host or "http://127.0.0.1:%d" % args.port
+    target = Target(base, args.clients, args.timeout)
+
+    server = None
+    frames_path = None
+    if args.spawn:
+        frames_path = tempfile.mktemp(suffix=".csv", prefix="frames-")
+        server = subprocess.Popen([args.spawn, "--port", str(args.port), "--frames", frames_path],
+                                  stderr=subprocess.PIPE, text=True)
+        server.stderr.readline()  # "listening on ..."
+
+    try:
+        schedule_body = None
+        try:
+            status, body = target.send("GET", "/api/schedule/hourly")
+            if status == 200:
+                schedule_body = body.decode()
+        except OSError as error:
+            print("server not reachable at %s: %s" % (base, error), file=sys.stderr)
+            return 2
+
+        if args.replay:
+            entries = parse_replay(args.replay, args.speed)
+            plan = lambda index: entries[index] if index < len(entries) else None
+            duration = args.duration
+        else:
+            generate = mix_generator(args.mix, schedule_body, random.Random(args.seed))
+            plan = lambda index: (None,) + generate()
+            duration = args.duration if args.duration is not None else 10.0
+
+        before = read_metrics(target)
+        results = Results()
+        sent, elapsed = run(target, plan, args.rate, duration, args.concurrency, results)
+        after = read_metrics(target)
+
+        mode = None
+        try:
+            status, body = target.send("GET", "/api/mode")
+            mode = json.loads(body).get("mode") if status == 200 else None
+        except (OSError, ValueError):
+            pass
+    finally:
+        server_summary = None
+        if server is not None:
+            server.send_signal(signal.SIGINT)
+            server_summary = server.communicate(timeout=10)[1].strip()
+
+    latencies = results.latencies
+    summary = {
+        "sent": sent,
+        "seconds": round(elapsed, 3),
+        "throughput_rps": round(len(latencies) / elapsed, 1) if elapsed > 0 else 0.0,
+        "status": {str(code): count for code, count in sorted(results.statuses.items())},
+        "errors": results.errors,
+        "latency_ms": {
+            "p50": round(percentile(latencies, 0.50) * 1000, 2),
+            "p90": round(percentile(latencies, 0.90) * 1000, 2),
+            "p99": round(percentile(latencies, 0.99) * 1000, 2),
+            "max": round(max(latencies) * 1000, 2) if latencies else 0.0,
+        },
+    }
+    if "slab_heap_min_free_bytes" in after:
+        summary["heap_min_free_bytes"] = int(after["slab_heap_min_free_bytes"])
+    if "slab_command_queue_rejected_total" in after:
+        summary["queue_rejected"] = int(after["slab_command_queue_rejected_total"] -
+                                        before.get("slab_command_queue_rejected_total", 0))
+    if frames_path is not None and os.path.exists(frames_path):
+        frames = read_frames(frames_path)
+        os.remove(frames_path)
+        summary["frames"] = len(frames)
+        mismatch = check_final_frame(frames, results.writes, mode)
+        summary["final_frame"] = "mismatch: " + mismatch if mismatch else "ok"
+    if server_summary:
+        summary["server"] = server_summary
+
+    if args.json:
+        print(json.dumps(summary, indent=2))
+    else:
+        print("%d requests in %.1f s, %.1f req/s" % (len(latencies), elapsed, summary["throughput_rps"]))
+        print("status  " + "  ".join("%s: %d" % item for item in summary["status"].items()) +
+              ("  errors: %d" % results.errors if results.errors else ""))
+        print("latency p50 %(p50).2f ms  p90 %(p90).2f ms  p99 %(p99).2f ms  max %(max).2f ms"
+              % summary["latency_ms"])
+        if "heap_min_free_bytes" in summary:
+            print("heap min free %d bytes" % summary["heap_min_free_bytes"])
+        if "queue_rejected" in summary:
+            print("command queue rejects %d" % summary["queue_rejected"])
+        if "frames" in summary:
+            print("LED frames %d, final frame %s" % (summary["frames"], summary["final_frame"]))
+        if server_summary:
+            print("server: " + server_summary)
+
+    bad = results.errors > 0 or summary.get("final_frame", "ok") != "ok"
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,78 @@
+"""
+Sync the controller's clock to this computer over POST /api/time/sync.
+
+Runs NTP-style exchanges on one keep-alive connection: each request carries
+t1 (when it was sent) and the t4 (when the previous response arrived) of the
+previous exchange, so the controller can work out offset and round-trip
+delay itself. Timestamps are local wall-clock milliseconds since 1970, the
+same wall clock POST /api/time sets.
+
+    python tools/timesync.py --host 192.168.4.1 --samples 8
+
+The controller corrects its clock after 4 exchanges, from the one with the
+lowest delay; later exchanges refine it. Prints each exchange and the
+achieved accuracy. Requires only the standard library.
+"""
+
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def local_ms():
+    """Local wall-clock time in ms since 1970 (UTC plus the UTC offset)."""
+    now = time.time()
+    return int(now * 1000) + time.localtime(now).tm_gmtoff * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--samples", type=int, default=8, help="exchanges (at least 5 to correct)")
+    parser.add_argument("--interval", type=float, default=0.25, help="seconds between exchanges")
+    args = parser.parse_args()
+
+    connection = http.client.HTTPConnection(args.host, args.port, timeout=5)
+    previous = None
+    result = None
+    corrected = 0
+    for _ in range(args.samples):
+        body = {"t1": local_ms()}
+        if previous is not None:
+            body.update(previous)
+        connection.request("POST", "/api/time/sync", json.dumps(body),
+                           {"Content-Type": "application/json"})
+        response = connection.getresponse()
+        payload = response.read()
+        t4 = local_ms()
+        if response.status != 200:
+            print("%d %s" % (response.status, payload.decode(errors="replace")))
+            return 1
+        result = json.loads(payload)
+        previous = {"id": result["id"], "t4": t4}
+        if result["sample"] == "accepted" and result["samples"] >= 4:
+            corrected -= result["offsetMs"]  # Each accepted sample from the 4th on corrects
+
+        # Offset of this exchange as seen from here (the controller computes it on the next one)
+        offset = ((result["t2"] - result["t1"]) + (result["t3"] - t4)) / 2
+        delay = (t4 - result["t1"]) - (result["t3"] - result["t2"])
+        print("id %-5d offset %+8.0f ms  delay %4d ms  %-10s samples %d  slew %+d ms" % (
+            result["id"], offset, delay, result["state"], result["samples"], result["slewMs"]))
+        time.sleep(args.interval)
+
+    # The last exchange completes the previous one; its own t4 is not sent
+    connection.close()
+    if result["accuracyMs"] is None:
+        print("not synced: fewer than 4 usable exchanges")
+        return 1
+    print("corrected %+d ms, accuracy +/-%d ms%s" % (
+        corrected, result["accuracyMs"],
+        ", slewing %+d ms" % result["slewMs"] if result["slewMs"] else ""))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,124 @@
+// Halaman kontrol minimal: state live dari /api/events, perubahan dikirim ke API yang sama
+// dengan aplikasi Flutter.
+var CHANNELS = ["royalBlue", "blue", "uv", "violet", "red", "green", "white"];
+var LABELS = ["Royal Blue", "Blue", "UV", "Violet", "Red", "Green", "White"];
+var sliders = {};
+var dragging = false;
+var sendTimer = null;
+
+function $(id) {
+  return document.getElementById(id);
+}
+
+function post(path, body) {
+  return fetch(path, {
+    method: "POST",
+    headers: { "Content-Type": "application/json" },
+    body: JSON.stringify(body)
+  });
+}
+
+function showMode(mode) {
+  var buttons = document.querySelectorAll(".modes button");
+  for (var i = 0; i < buttons.length; i++) {
+    buttons[i].className = buttons[i].getAttribute("data-mode") === mode ? "on" : "";
+  }
+}
+
+function showFrame(frame) {
+  if (dragging) {
+    return;
+  }
+  for (var i = 0; i < CHANNELS.length; i++) {
+    var value = frame[CHANNELS[i]] || 0;
+    sliders[CHANNELS[i]].input.value = value;
+    sliders[CHANNELS[i]].output.textContent = value;
+  }
+}
+
+function pad(value) {
+  return (value < 10 ? "0" : "") + value;
+}
+
+function showTime(time) {
+  $("time").textContent = time.year + "-" + pad(time.month) + "-" + pad(time.day) + " " +
+    pad(time.hour) + ":" + pad(time.minute) + ":" + pad(time.second);
+}
+
+// Kirim semua channel sekaligus, dibatasi maksimal ~6 request per detik saat slider digeser
+function scheduleSend() {
+  if (sendTimer) {
+    return;
+  }
+  sendTimer = setTimeout(function () {
+    sendTimer = null;
+    var frame = {};
+    for (var i = 0; i < CHANNELS.length; i++) {
+      frame[CHANNELS[i]] = parseInt(sliders[CHANNELS[i]].input.value, 10);
+    }
+    post("/api/manual/all", frame);
+  }, 150);
+}
+
+function buildSliders() {
+  var container = $("channels");
+  for (var i = 0; i < CHANNELS.length; i++) {
+    var row = document.createElement("div");
+    row.className = "row";
+    var label = document.createElement("label");
+    label.textContent = LABELS[i];
+    var input = document.createElement("input");
+    input.type = "range";
+    input.min = 0;
+    input.max = 255;
+    input.value = 0;
+    var output = document.createElement("span");
+    output.textContent = "0";
+    row.appendChild(label);
+    row.appendChild(input);
+    row.appendChild(output);
+    container.appendChild(row);
+    sliders[CHANNELS[i]] = { input: input, output: output };
+
+    input.addEventListener("input", (function (output, input) {
+      return function () {
+        dragging = true;
+        output.textContent = input.value;
+        scheduleSend();
+      };
+    })(output, input));
+    input.addEventListener("change", function () {
+      dragging = false;
+    });
+  }
+}
+
+function connect() {
+  var source = new EventSource("/api/events");
+  source.onopen = function () {
+    $("status").textContent = "Live";
+  };
+  source.onerror = function () {
+    $("status").textContent = "Reconnecting...";
+  };
+  source.addEventListener("mode", function (event) {
+    showMode(JSON.parse(event.data).mode);
+  });
+  source.addEventListener("frame", function (event) {
+    showFrame(JSON.parse(event.data));
+  });
+  source.addEventListener("time", function (event) {
+    showTime(JSON.parse(event.data));
+  });
+}
+
+buildSliders();
+
+var modeButtons = document.querySelectorAll(".modes button");
+for (var i = 0; i < modeButtons.length; i++) {
+  modeButtons[i].addEventListener("click", function () {
+    post("/api/mode", { mode: this.getAttribute("data-mode") });
+  });
+}
+
+connect();